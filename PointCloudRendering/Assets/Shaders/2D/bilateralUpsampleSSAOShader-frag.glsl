@@ -0,0 +1,67 @@
+#version 450
+
+// ********** PARAMETERS & VARIABLES ***********
+
+#define DEPTH_SHARPNESS 32.0f
+#define NORMAL_SHARPNESS 8.0f
+#define MIN_WEIGHT 1e-4f
+
+in vec2 textCoord;
+
+uniform sampler2D texAlbedo;
+uniform sampler2D texSSAO;				// Lower resolution than the G-buffer
+uniform sampler2D texPosition;
+uniform sampler2D texNormal;
+
+layout (location = 0) out vec4 fColor;
+
+void main(void)
+{
+	ivec2 ssaoSize = textureSize(texSSAO, 0), gBufferSize = textureSize(texPosition, 0);
+	ivec2 gBufferTexel = ivec2(textCoord * vec2(gBufferSize));
+
+	vec4 position = texelFetch(texPosition, gBufferTexel, 0);
+
+	// Background: no normal to compare with, nor occlusion to apply
+	if (position.w == 0.0f)
+	{
+		fColor = vec4(texture(texAlbedo, textCoord).rgb, 1.0f);
+		return;
+	}
+
+	vec3 normal = normalize(texelFetch(texNormal, gBufferTexel, 0).xyz);
+
+	// 4 x 4 low-resolution neighborhood: blur and upsampling in a single pass. Each tap is weighted by its similarity with the
+	// full-resolution pixel, so that occlusion does not bleed across depth discontinuities
+	ivec2 firstTexel = ivec2(floor(textCoord * vec2(ssaoSize) - 0.5f)) - 1;
+	float result = 0.0f, boxResult = 0.0f, weightSum = 0.0f;
+	int numTaps = 0;
+
+	for (int x = 0; x < 4; ++x)
+	{
+		for (int y = 0; y < 4; ++y)
+		{
+			ivec2 ssaoTexel = clamp(firstTexel + ivec2(x, y), ivec2(0), ssaoSize - 1);
+			vec2 sampleCoord = (vec2(ssaoTexel) + 0.5f) / vec2(ssaoSize);
+			ivec2 sampleGBufferTexel = ivec2(sampleCoord * vec2(gBufferSize));
+
+			vec4 samplePosition = texelFetch(texPosition, sampleGBufferTexel, 0);
+			if (samplePosition.w == 0.0f) continue;										// Background taps have a null normal
+
+			float occlusion = texelFetch(texSSAO, ssaoTexel, 0).r;
+			vec3 sampleNormal = normalize(texelFetch(texNormal, sampleGBufferTexel, 0).xyz);
+
+			float depthDifference = abs(samplePosition.z - position.z) / max(abs(position.z), 1e-3f);
+			float weight = exp(-depthDifference * DEPTH_SHARPNESS) * pow(max(dot(sampleNormal, normal), 0.0f), NORMAL_SHARPNESS);
+
+			result += occlusion * weight;
+			boxResult += occlusion;
+			weightSum += weight;
+			++numTaps;
+		}
+	}
+
+	result = weightSum > MIN_WEIGHT ? result / weightSum : (numTaps > 0 ? boxResult / float(numTaps) : 1.0f);			// No similar neighbour, e.g. thin geometry
+
+	fColor = vec4(texture(texAlbedo, textCoord).rgb * result, 1.0f);
+}
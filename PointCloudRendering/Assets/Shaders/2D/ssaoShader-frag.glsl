@@ -10,10 +10,11 @@ uniform sampler2D texKernels;
 uniform sampler2D texNoise;
 
 uniform mat4 mProjMatrix;
-uniform vec2 windowSize;
+uniform vec2 windowSize;				// Size of the occlusion texture, which may be lower than the G-buffer
+uniform int kernelSize;					// Up to MAX_KERNEL_SIZE
 
 #define BIAS 0.01f
-#define KERNEL_SIZE 64
+#define MAX_KERNEL_SIZE 64
 #define NOISE_SCALE 4.0f
 #define RADIUS 0.2f
 
@@ -23,18 +24,23 @@ layout (location = 0) out vec4 fColor;
 
 void main(void)
 {
-	vec3 fragPos   = texture(texPosition, textCoord).xyz;
-	vec3 normal    = normalize(texture(texNormal, textCoord).rgb);
+	// Nearest G-buffer texel, so that positions and normals are not blended across edges at lower resolutions
+	ivec2 gBufferTexel = ivec2(textCoord * vec2(textureSize(texPosition, 0)));
+
+	vec3 fragPos   = texelFetch(texPosition, gBufferTexel, 0).xyz;
+	vec3 normal    = normalize(texelFetch(texNormal, gBufferTexel, 0).rgb);
 	vec3 randomVec = normalize(texture(texNoise, textCoord * windowSize / NOISE_SCALE).xyz);
 
 	vec3 tangent   = normalize(randomVec - normal * dot(randomVec, normal));
 	vec3 bitangent = normalize(cross(normal, tangent));
 	mat3 TBN       = mat3(tangent, bitangent, normal); 
 
+	int kernelStride = MAX_KERNEL_SIZE / kernelSize;			// Smaller kernels are spread over the whole hemisphere
+
 	float occlusion = 0.0;
-	for(int i = 0; i < KERNEL_SIZE; ++i)
+	for(int i = 0; i < kernelSize; ++i)
 	{
-		vec3 currentSample = texture(texKernels, vec2(float(i) / 64.0f + 0.5f / 64.0f, .5f)).xyz;
+		vec3 currentSample = texelFetch(texKernels, ivec2(i * kernelStride, 0), 0).xyz;
 		vec3 samplePos = TBN * currentSample;			// From tangent to view-space
 		samplePos = fragPos + samplePos * RADIUS;		// Sample position
     
@@ -49,7 +55,7 @@ void main(void)
 		occlusion += (sampleDepth >= samplePos.z + BIAS ? 1.0 : 0.0) * rangeCheck;
 	}  
 
-	occlusion = (1.0 - (occlusion / KERNEL_SIZE)) * (1.0f - MIN_OCCLUSION) + MIN_OCCLUSION;
+	occlusion = (1.0 - (occlusion / kernelSize)) * (1.0f - MIN_OCCLUSION) + MIN_OCCLUSION;
 
 	fColor = vec4(vec3(occlusion), 1.0f);
 }
@@ -7,8 +7,8 @@ layout (local_size_variable) in;
 
 #include <Assets/Shaders/Compute/Templates/modelStructs.glsl>
 
-layout (std430, binding = 0) buffer FaceBuffer { FaceGPUData faceBuffer[]; };
-layout (std430, binding = 1) buffer SortedIndices { uint indices[]; };
+layout (std430, binding = 0) readonly buffer FaceBuffer { FaceGPUData faceBuffer[]; };
+layout (std430, binding = 1) readonly buffer SortedIndices { uint indices[]; };
 layout (std430, binding = 2) buffer ClusterBuffer { BVHCluster cluster[]; };
 layout (std430, binding = 3) buffer TempClusterBuffer { BVHCluster tempCluster[]; };
 
@@ -9,15 +9,13 @@ layout (local_size_variable) in;
 
 layout (std430, binding = 0) buffer TempClusterBuffer		{ BVHCluster tempCluster[]; };
 layout (std430, binding = 1) buffer ClusterBuffer			{ BVHCluster cluster[]; };
-layout (std430, binding = 2) buffer NeighborBuffer			{ uint neighbor[]; };
+layout (std430, binding = 2) readonly buffer NeighborBuffer			{ uint neighbor[]; };
 layout (std430, binding = 3) buffer ValidClusterBuffer		{ uint validCluster[]; };
 layout (std430, binding = 4) buffer MergedClusterBuffer		{ uint mergedCluster[]; };
 layout (std430, binding = 5) buffer PrefixScanBuffer		{ uint prefixScan[]; };
 layout (std430, binding = 6) buffer CurrentPositionBuffer	{ uint currentPosition[]; };
 layout (std430, binding = 7) buffer NumNodesBuffer			{ uint numNodes; };
-
-
-uniform uint arraySize;
+layout (std430, binding = 8) readonly buffer ArraySizeBuffer	{ uint arraySize; };
 
 
 // ********* FUNCTIONS ************
@@ -42,7 +40,7 @@ void buildCluster(const uint index1, const uint index2)
 void main()
 {
 	const uint index = gl_GlobalInvocationID.x;
-	if (index >= arraySize) return;
+	if (index >= arraySize || arraySize <= 1) return;				// A single cluster is the root, though iterations may be dispatched before knowing it
 
 	if (neighbor[neighbor[index]] == index)
 	{
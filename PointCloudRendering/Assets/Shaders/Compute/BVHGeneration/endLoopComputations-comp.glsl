@@ -4,14 +4,14 @@
 layout (local_size_variable) in;
 
 layout (std430, binding = 0) buffer ArraySizeBuffer { uint arraySizeCount; };
-layout (std430, binding = 1) buffer PrefixScanBuffer { uint prefixScan[]; };
-layout (std430, binding = 2) buffer ValidClusterBuffer { uint validCluster[]; };
-
-
-uniform uint arraySize;
+layout (std430, binding = 1) readonly buffer PrefixScanBuffer { uint prefixScan[]; };
+layout (std430, binding = 2) readonly buffer ValidClusterBuffer { uint validCluster[]; };
 
 
 void main()
 {
+	const uint arraySize = arraySizeCount;
+	if (arraySize <= 1) return;
+
 	arraySizeCount = prefixScan[arraySize - 1] + validCluster[arraySize - 1];
 }
\ No newline at end of file
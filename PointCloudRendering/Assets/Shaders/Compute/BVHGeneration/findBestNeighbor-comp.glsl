@@ -7,11 +7,11 @@ layout (local_size_variable) in;
 
 #include <Assets/Shaders/Compute/Templates/modelStructs.glsl>
 
-layout (std430, binding = 0) buffer ClusterBuffer { BVHCluster cluster[]; };
+layout (std430, binding = 0) readonly buffer ClusterBuffer { BVHCluster cluster[]; };
 layout (std430, binding = 1) buffer NeighborBuffer{ uint neighbor[]; };
+layout (std430, binding = 2) readonly buffer ArraySizeBuffer { uint arraySize; };
 
 
-uniform uint arraySize;
 uniform uint radius;
 
 
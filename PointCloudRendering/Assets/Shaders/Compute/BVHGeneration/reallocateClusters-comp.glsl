@@ -5,15 +5,13 @@ layout (local_size_variable) in;
 
 #include <Assets/Shaders/Compute/Templates/modelStructs.glsl>
 
-layout (std430, binding = 0) buffer InClusterBuffer { BVHCluster inCluster[]; };
+layout (std430, binding = 0) readonly buffer InClusterBuffer { BVHCluster inCluster[]; };
 layout (std430, binding = 1) buffer OutClusterBuffer { BVHCluster outCluster[]; };
-layout (std430, binding = 2) buffer ValidClusterBuffer { uint validCluster[]; };
-layout (std430, binding = 3) buffer PrefixScanBuffer { uint prefixScan[]; };
-layout (std430, binding = 4) buffer InGlobalPositionBuffer { uint inPosition[]; };
+layout (std430, binding = 2) readonly buffer ValidClusterBuffer { uint validCluster[]; };
+layout (std430, binding = 3) readonly buffer PrefixScanBuffer { uint prefixScan[]; };
+layout (std430, binding = 4) readonly buffer InGlobalPositionBuffer { uint inPosition[]; };
 layout (std430, binding = 5) buffer OutGlobalPositionBuffer { uint outPosition[]; };
-
-
-uniform uint arraySize;
+layout (std430, binding = 6) readonly buffer ArraySizeBuffer { uint arraySize; };
 
 
 void main()
@@ -0,0 +1,46 @@
+#version 450
+
+#extension GL_ARB_compute_variable_group_size: enable
+layout (local_size_variable) in;
+
+#define FAR_DEPTH 1e30f							// Background pixels cannot occlude anything
+
+uniform sampler2D texPosition;					// View-space positions of the G-buffer, whose alpha is zero for the background
+uniform layout (r32f) readonly image2D previousLevel;
+uniform layout (r32f) writeonly image2D currentLevel;
+
+uniform ivec2 previousSize;
+uniform ivec2 currentSize;
+uniform int level;
+
+
+void main()
+{
+	const uint index = gl_GlobalInvocationID.x;
+	if (index >= currentSize.x * currentSize.y) return;
+
+	const ivec2 texel = ivec2(index % currentSize.x, index / currentSize.x);
+	float depth = .0f;
+
+	if (level == 0)
+	{
+		const vec4 position = texelFetch(texPosition, texel, 0);
+		depth = position.w > .0f ? -position.z : FAR_DEPTH;
+	}
+	else
+	{
+		// Farthest depth of the 2 x 2 footprint. The last texel of an odd row or column also covers the remaining one
+		const ivec2 firstTexel = texel * 2;
+		const ivec2 lastTexel = min(firstTexel + 1 + ivec2(equal(texel, currentSize - 1)) * (previousSize & 1), previousSize - 1);
+
+		for (int y = firstTexel.y; y <= lastTexel.y; ++y)
+		{
+			for (int x = firstTexel.x; x <= lastTexel.x; ++x)
+			{
+				depth = max(depth, imageLoad(previousLevel, ivec2(x, y)).r);
+			}
+		}
+	}
+
+	imageStore(currentLevel, texel, vec4(depth));
+}
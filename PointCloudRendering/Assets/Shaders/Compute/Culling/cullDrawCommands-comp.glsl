@@ -0,0 +1,173 @@
+#version 450
+
+#extension GL_ARB_compute_variable_group_size: enable
+layout (local_size_variable) in;
+
+#include <Assets/Shaders/Compute/Templates/constraints.glsl>
+
+struct DrawCommand
+{
+	uint	count;
+	uint	instanceCount;
+	uint	firstIndex;
+	int		baseVertex;
+	uint	baseInstance;
+};
+
+struct DrawData
+{
+	mat4	transform;
+	vec4	kad;
+	vec4	ks;
+	float	shininess;
+	uint	useTextures;
+	vec2	padding;
+};
+
+struct DrawBounds
+{
+	vec4	minPoint;						// W is zero if the component has no bounds, so that it is never culled
+	vec4	maxPoint;
+	vec4	cone;							// Normal cone of meshlets: axis and cutoff (greater than one if it cannot be culled)
+};
+
+layout (std430, binding = 0) readonly buffer CommandBuffer			{ DrawCommand command[]; };
+layout (std430, binding = 1) readonly buffer DrawBuffer				{ DrawData drawData[]; };
+layout (std430, binding = 2) readonly buffer BoundsBuffer			{ DrawBounds bounds[]; };
+layout (std430, binding = 3) writeonly buffer CulledCommandBuffer	{ DrawCommand culledCommand[]; };
+layout (std430, binding = 4) buffer OccludedBuffer					{ uint occluded[]; };				// Rejected only by the depth pyramid
+
+uniform uint numCommands;
+uniform mat4 mModelViewProj;
+
+// Second phase: occluded commands of the first one are tested against the depth of the current frame, whereas the rest are not drawn again
+uniform bool retest;
+
+// Back-facing meshlets, only for perspective cameras
+uniform bool coneCulling;
+uniform mat4 mModelView;
+
+// Hierarchical depth of the previous frame (current frame while retesting): farthest view distance of each texel
+uniform bool occlusionCulling;
+uniform sampler2D texHiZ;
+uniform ivec2 hiZSize;
+uniform int hiZLevels;
+uniform mat4 mHiZModelView;
+uniform mat4 mHiZModelViewProj;
+
+
+// ********* FUNCTIONS ************
+
+// Returns the corners of the bounding box in a space given by a matrix
+void transformCorners(const mat4 matrix, const vec3 minPoint, const vec3 maxPoint, out vec4 corner[8])
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		corner[i] = matrix * vec4(mix(minPoint, maxPoint, bvec3(i & 1, i & 2, i & 4)), 1.0f);
+	}
+}
+
+// Checks whether every corner lies beyond the same clipping plane
+bool isOutsideFrustum(const vec4 corner[8])
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		bool outsideMin = true, outsideMax = true;
+
+		for (int i = 0; i < 8; ++i)
+		{
+			outsideMin = outsideMin && corner[i][axis] < -corner[i].w;
+			outsideMax = outsideMax && corner[i][axis] > corner[i].w;
+		}
+
+		if (outsideMin || outsideMax) return true;
+	}
+
+	return false;
+}
+
+// Checks whether every triangle of a meshlet faces away from the camera, bounding it with a sphere. Transforms are assumed to keep angles
+bool isBackFacing(const vec3 minPoint, const vec3 maxPoint, const vec4 cone, const mat4 transform)
+{
+	if (cone.w > 1.0f) return false;
+
+	const mat4 modelView = mModelView * transform;
+	const float scale = max(max(length(modelView[0].xyz), length(modelView[1].xyz)), length(modelView[2].xyz));
+	const vec3 center = (modelView * vec4((minPoint + maxPoint) * .5f, 1.0f)).xyz;
+	const vec3 axis = normalize(mat3(modelView) * cone.xyz);
+	const float radius = length(maxPoint - minPoint) * .5f * scale;
+
+	return dot(center, axis) >= cone.w * length(center) + radius;
+}
+
+// Checks whether the bounding box lies behind the depth of the previous frame, sampling the pyramid level where its footprint covers 2 x 2 texels
+bool isOccluded(const vec3 minPoint, const vec3 maxPoint, const mat4 transform)
+{
+	vec4 clipCorner[8], viewCorner[8];
+	transformCorners(mHiZModelViewProj * transform, minPoint, maxPoint, clipCorner);
+	transformCorners(mHiZModelView * transform, minPoint, maxPoint, viewCorner);
+
+	vec2 minUV = vec2(1.0f), maxUV = vec2(.0f);
+	float nearestDepth = 1e30f;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		if (clipCorner[i].w <= EPSILON) return false;					// Crosses the near plane
+
+		const vec2 uv = clipCorner[i].xy / clipCorner[i].w * .5f + .5f;
+		minUV = min(minUV, uv);
+		maxUV = max(maxUV, uv);
+		nearestDepth = min(nearestDepth, -viewCorner[i].z);
+	}
+
+	minUV = clamp(minUV, .0f, 1.0f);
+	maxUV = clamp(maxUV, .0f, 1.0f);
+
+	const vec2 extent = (maxUV - minUV) * vec2(hiZSize);
+	const int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0f)))), 0, hiZLevels - 1);
+	const ivec2 levelSize = max(hiZSize >> level, ivec2(1));
+	const ivec2 minTexel = min(ivec2(minUV * vec2(levelSize)), levelSize - 1), maxTexel = min(ivec2(maxUV * vec2(levelSize)), levelSize - 1);
+
+	const float farthestDepth = max(max(texelFetch(texHiZ, minTexel, level).r, texelFetch(texHiZ, ivec2(maxTexel.x, minTexel.y), level).r),
+									max(texelFetch(texHiZ, ivec2(minTexel.x, maxTexel.y), level).r, texelFetch(texHiZ, maxTexel, level).r));
+
+	return nearestDepth > farthestDepth;
+}
+
+
+void main()
+{
+	const uint index = gl_GlobalInvocationID.x;
+	if (index >= numCommands) return;
+
+	DrawCommand drawCommand = command[index];
+	const DrawBounds drawBounds = bounds[index];
+
+	if (retest)
+	{
+		const bool disoccluded = occluded[index] != 0 && !isOccluded(drawBounds.minPoint.xyz, drawBounds.maxPoint.xyz, drawData[drawCommand.baseInstance].transform);
+
+		drawCommand.instanceCount = disoccluded ? 1 : 0;
+		culledCommand[index] = drawCommand;
+
+		return;
+	}
+
+	bool isOccludedCommand = false;
+
+	if (drawBounds.minPoint.w > .0f)
+	{
+		const mat4 transform = drawData[drawCommand.baseInstance].transform;
+		vec4 corner[8];
+		transformCorners(mModelViewProj * transform, drawBounds.minPoint.xyz, drawBounds.maxPoint.xyz, corner);
+
+		bool visible = !isOutsideFrustum(corner);
+		if (visible && coneCulling) visible = !isBackFacing(drawBounds.minPoint.xyz, drawBounds.maxPoint.xyz, drawBounds.cone, transform);
+		if (visible && occlusionCulling) isOccludedCommand = isOccluded(drawBounds.minPoint.xyz, drawBounds.maxPoint.xyz, transform);
+
+		drawCommand.instanceCount = visible && !isOccludedCommand ? 1 : 0;			// Culled commands are kept, so that batches keep their ranges
+	}
+
+	culledCommand[index] = drawCommand;
+	occluded[index] = isOccludedCommand ? 1 : 0;
+}
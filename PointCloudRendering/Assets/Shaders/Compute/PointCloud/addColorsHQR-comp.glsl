@@ -6,18 +6,15 @@
 #extension GL_NV_gpu_shader5 : enable
 
 #include <Assets/Shaders/Compute/Templates/modelStructs.glsl>
+#include <Assets/Shaders/Compute/Templates/workGroupSize.glsl>
+#include <Assets/Shaders/Compute/Templates/frameParameters.glsl>
 
-layout (local_size_variable) in;
-
-layout (std430, binding = 0) buffer DepthBuffer		{ uint			depthBuffer[]; };
+layout (std430, binding = 0) readonly buffer DepthBuffer		{ uint			depthBuffer[]; };
 layout (std430, binding = 1) buffer Color01Buffer	{ uint64_t		colorBuffer01[]; };
 layout (std430, binding = 2) buffer Color02Buffer	{ uint64_t		colorBuffer02[]; };
-layout (std430, binding = 3) buffer PointBuffer		{ PointModel	points[]; };
+layout (std430, binding = 3) readonly buffer PointBuffer		{ PointModel	points[]; };
 
-uniform mat4	cameraMatrix;
-uniform float	distanceThreshold;
 uniform uint	numPoints;
-uniform uvec2	windowSize;
 
 void main()
 {
@@ -6,15 +6,13 @@
 #extension GL_NV_shader_subgroup_partitioned: require
 
 #include <Assets/Shaders/Compute/Templates/modelStructs.glsl>
-
-layout (local_size_variable) in;
+#include <Assets/Shaders/Compute/Templates/workGroupSize.glsl>
+#include <Assets/Shaders/Compute/Templates/frameParameters.glsl>
 
 layout (std430, binding = 0) buffer DepthBuffer { uint64_t		depthBuffer[]; };
-layout (std430, binding = 1) buffer PointBuffer { PointModel	points[]; };
+layout (std430, binding = 1) readonly buffer PointBuffer { PointModel	points[]; };
 
-uniform mat4	cameraMatrix;
 uniform uint	numPoints;
-uniform uvec2	windowSize;
 
 
 void main()
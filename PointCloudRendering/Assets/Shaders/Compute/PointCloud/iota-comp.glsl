@@ -4,7 +4,7 @@
 
 layout (local_size_variable) in;
 
-layout(std430, binding = 0) buffer IndexBuffer { uint indexPoint[]; };
+layout(std430, binding = 0) writeonly buffer IndexBuffer { uint indexPoint[]; };
 
 uniform uint arraySize;
 
@@ -3,18 +3,27 @@
 #extension GL_ARB_compute_variable_group_size: enable
 #extension GL_ARB_gpu_shader_int64: require
 
-layout (local_size_variable) in;
+#include <Assets/Shaders/Compute/Templates/workGroupSize.glsl>
+#include <Assets/Shaders/Compute/Templates/frameParameters.glsl>
 
+#ifdef HQR
+layout (std430, binding = 0) buffer DepthBuffer		{ uint			depthBuffer[]; };
+layout (std430, binding = 1) buffer Color01Buffer	{ uint64_t		colorBuffer01[]; };
+layout (std430, binding = 2) buffer Color02Buffer	{ uint64_t		colorBuffer02[]; };
+#else
 layout (std430, binding = 0) buffer DepthBuffer { uint64_t depthBuffer[]; };
-
-uniform uvec2 windowSize;
+#endif
 
 void main()
 {
 	uint index = gl_GlobalInvocationID.x;
 	if (index >= windowSize.x * windowSize.y) return;
 
-	// Maximum value of 64 bits
+	// Maximum value of 32 (HQR) or 64 bits
 	depthBuffer[index] = 0;
 	depthBuffer[index] = ~depthBuffer[index];
+
+#ifdef HQR
+	colorBuffer01[index] = colorBuffer02[index] = 0;
+#endif
 }
\ No newline at end of file
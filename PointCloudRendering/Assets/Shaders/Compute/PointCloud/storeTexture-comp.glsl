@@ -4,15 +4,17 @@
 #extension GL_ARB_gpu_shader_int64: require
 
 #include <Assets/Shaders/Compute/Templates/modelStructs.glsl>
-
-layout (local_size_variable) in;
-
-layout (std430, binding = 0) buffer DepthBuffer { uint64_t		depthBuffer[]; };
+#include <Assets/Shaders/Compute/Templates/workGroupSize.glsl>
+#include <Assets/Shaders/Compute/Templates/frameParameters.glsl>
+
+#ifdef HQR
+layout (std430, binding = 0) readonly buffer Color01Buffer { uint64_t		colorBuffer01[]; };
+layout (std430, binding = 1) readonly buffer Color02Buffer { uint64_t		colorBuffer02[]; };
+#else
+layout (std430, binding = 0) readonly buffer DepthBuffer { uint64_t		depthBuffer[]; };
+#endif
 uniform layout (rgba8) writeonly image2D texImage;
 
-uniform vec3	backgroundColor;
-uniform uvec2	windowSize;
-
 void main()
 {
 	const uint index = gl_GlobalInvocationID.x;
@@ -20,13 +22,31 @@ void main()
 
 	const uint py		= uint(floor(index / windowSize.x));
 	const uint px		= index % windowSize.x;
+
+	vec3 rgbColor = backgroundColor.rgb;
+
+#ifdef HQR
+	// Colors accumulated by the points of the nearest surface, which are averaged
+	const uint64_t rg = colorBuffer01[index];
+	const uint64_t ba = colorBuffer02[index];
+
+	const uint a = uint(ba);
+	const uint r = uint((rg >> 32) / a);
+	const uint g = uint(rg) / a;
+	const uint b = uint((ba >> 32) / a);
+
+	if (a > 0)
+	{
+		rgbColor = vec3(r, g, b) / 255.0f;
+	}
+#else
 	const uint colorInd	= uint(depthBuffer[index] & 0x00000000ffffffff);
 
-	vec3 rgbColor = backgroundColor;
 	if (colorInd != 0xffffffff)
 	{
 		rgbColor = unpackUnorm4x8(colorInd).rgb;
 	}
+#endif
 
 	imageStore(texImage, ivec2(px, py), vec4(rgbColor, 1.0f));
 }
\ No newline at end of file
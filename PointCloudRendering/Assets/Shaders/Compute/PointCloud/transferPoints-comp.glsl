@@ -6,9 +6,9 @@ layout (local_size_variable) in;
 
 #include <Assets/Shaders/Compute/Templates/modelStructs.glsl>
 
-layout(std430, binding = 0) buffer InputBuffer	{ PointModel	inputPoint[]; };
-layout(std430, binding = 1) buffer OutputBuffer { PointModel	outcomePoint[]; };
-layout(std430, binding = 2) buffer IndexBuffer	{ uint			indexPoint[]; };
+layout(std430, binding = 0) readonly buffer InputBuffer	{ PointModel	inputPoint[]; };
+layout(std430, binding = 1) writeonly buffer OutputBuffer { PointModel	outcomePoint[]; };
+layout(std430, binding = 2) readonly buffer IndexBuffer	{ uint			indexPoint[]; };
 
 uniform uint arraySize;
 
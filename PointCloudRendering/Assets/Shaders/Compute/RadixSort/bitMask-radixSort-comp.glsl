@@ -5,8 +5,8 @@ layout (local_size_variable) in;
 
 #include <Assets/Shaders/Compute/Templates/modelStructs.glsl>
 
-layout (std430, binding = 0) buffer MortonCodesBuffer { uint mortonCodes[]; };
-layout (std430, binding = 1) buffer IndicesBuffer { uint indices[]; };
+layout (std430, binding = 0) readonly buffer MortonCodesBuffer { uint mortonCodes[]; };
+layout (std430, binding = 1) readonly buffer IndicesBuffer { uint indices[]; };
 layout (std430, binding = 2) buffer OneBuffer { uint pBits[]; };
 layout (std430, binding = 3) buffer ZeroBuffer { uint nBits[]; };
 
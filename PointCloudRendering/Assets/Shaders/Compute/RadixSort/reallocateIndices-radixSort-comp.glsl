@@ -3,10 +3,10 @@
 #extension GL_ARB_compute_variable_group_size: enable
 layout (local_size_variable) in;
 
-layout(std430, binding = 0) buffer OneBuffer { uint pBits[]; };
-layout(std430, binding = 1) buffer ZeroBuffer { uint nBits[]; };
-layout (std430, binding = 2) buffer InputBufferB { uint inIndices[]; };
-layout (std430, binding = 3) buffer OutputBuffer { uint outIndices[]; };
+layout(std430, binding = 0) readonly buffer OneBuffer { uint pBits[]; };
+layout(std430, binding = 1) readonly buffer ZeroBuffer { uint nBits[]; };
+layout (std430, binding = 2) readonly buffer InputBufferB { uint inIndices[]; };
+layout (std430, binding = 3) writeonly buffer OutputBuffer { uint outIndices[]; };
 
 
 uniform uint arraySize;
@@ -0,0 +1,18 @@
+// Parameters shared by every point cloud kernel. They are uploaded once per frame into a std140 uniform buffer, whose layout
+// must match PointCloudAggregator::FrameParameters.
+
+layout (std140, binding = 0) uniform FrameParameters
+{
+	mat4	cameraMatrix;
+	vec4	backgroundColor;
+	uvec2	frameWindowSize;
+	float	distanceThreshold;
+};
+
+// Window size is a constant if the program defines WINDOW_WIDTH and WINDOW_HEIGHT, so that the compiler can fold divisions and bounds.
+
+#if defined(WINDOW_WIDTH) && defined(WINDOW_HEIGHT)
+const uvec2 windowSize = uvec2(WINDOW_WIDTH, WINDOW_HEIGHT);
+#else
+#define windowSize frameWindowSize
+#endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+// Morton codes of points normalized within the scene AABB, with 10 bits per axis as codes are 32-bit integers.
+
+uniform vec3 sceneMaxBoundary, sceneMinBoundary;			// Scene AABB to normalize positions
+
+// Expands a 10-bit integer into 30 bits by inserting 2 zeros after each bit.
+uint expandBits(in uint v)
+{
+	v = (v * 0x00010001u) & 0xFF0000FFu;
+	v = (v * 0x00000101u) & 0x0F00F00Fu;
+	v = (v * 0x00000011u) & 0xC30C30C3u;
+	v = (v * 0x00000005u) & 0x49249249u;
+
+	return v;
+}
+
+// We computes Morton codes for points located within the unit cube [0, 1].
+vec3 normalizeScenePoint(const vec3 position)
+{
+	return (position - sceneMinBoundary) / (sceneMaxBoundary - sceneMinBoundary);
+}
+
+// Calculates a 30-bit Morton code for the given 3D point located within the unit cube [0,1].
+uint morton3D(const vec3 position)
+{
+	const vec3 normVertex = normalizeScenePoint(position) * 1024.0f;
+
+	uint xx = expandBits(uint(normVertex.x));
+	uint yy = expandBits(uint(normVertex.y));
+	uint zz = expandBits(uint(normVertex.z));
+
+	return xx * 4 + yy * 2 + zz;
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+// Work groups have a fixed size if the program defines LOCAL_SIZE_X. Otherwise, it is given at dispatch time (ARB_compute_variable_group_size).
+
+#ifdef LOCAL_SIZE_X
+layout (local_size_x = LOCAL_SIZE_X) in;
+#else
+layout (local_size_variable) in;
+#endif
\ No newline at end of file
@@ -0,0 +1,7 @@
+#version 450
+
+// Shadow maps only need depth, which is written by the fixed pipeline
+
+void main()
+{
+}
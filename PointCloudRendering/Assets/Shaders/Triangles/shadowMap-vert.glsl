@@ -0,0 +1,36 @@
+#version 450
+
+#ifdef MULTI_DRAW
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
+// ********** PARAMETERS & VARIABLES ***********
+
+layout(location = 0) in vec3 vPosition;
+
+uniform mat4 mModelViewProj;
+
+#ifdef MULTI_DRAW
+// Data of each indirect command, indexed by its base instance. Only the transformation is needed for depth
+struct DrawData
+{
+	mat4 transform;
+	vec4 kad;
+	vec4 ks;
+	float shininess;
+	uint useTextures;
+	vec2 padding;
+};
+
+layout (std430, binding = 0) readonly buffer DrawBuffer { DrawData drawData[]; };
+#endif
+
+
+void main()
+{
+#ifdef MULTI_DRAW
+	gl_Position = mModelViewProj * drawData[gl_BaseInstanceARB].transform * vec4(vPosition, 1.0f);
+#else
+	gl_Position = mModelViewProj * vec4(vPosition, 1.0f);
+#endif
+}
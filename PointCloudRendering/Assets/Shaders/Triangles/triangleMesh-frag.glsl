@@ -19,6 +19,14 @@ in vec3 lightDir;
 in vec3 vertexToLightDir;
 in vec3 viewDir;
 
+#ifdef MULTI_DRAW
+// ------------ Draw data -----------
+flat in vec4 drawKad;
+flat in vec4 drawKs;
+flat in float drawShininess;
+flat in uint drawUseTextures;						// Single color materials are not given as textures
+#endif
+
 
 // ----------- Materials ------------
 uniform sampler2D texKadSampler;
@@ -77,6 +85,8 @@ uniform sampler2DShadow texShadowMapSampler;
 
 
 layout (location = 0) out vec4 fColor;
+layout (location = 1) out vec4 fPosition;			// G-buffer for ambient occlusion, ignored when drawing into the default framebuffer
+layout (location = 2) out vec4 fNormal;
 
 
 // ********* FUNCTIONS ************
@@ -109,6 +119,16 @@ float pixarAttenuation(const float distance)
 
 // ----------- Lighting ----------
 
+// Phong exponent of the material
+float getShininess()
+{
+#ifdef MULTI_DRAW
+	if (drawUseTextures == 0) return drawShininess;
+#endif
+
+	return shininess;
+}
+
 // Computes the diffuse term with lighting wrapping, if active
 vec3 getDiffuse(const vec3 fragKad, const float dotLN) 
 {
@@ -118,7 +138,7 @@ vec3 getDiffuse(const vec3 fragKad, const float dotLN)
 // Computes the specular term with halfway vector
 vec3 getSpecular(const vec3 fragKs, const float dotHN)
 {
-	return Is * fragKs * pow(max(dotHN, 0.0f), shininess);
+	return Is * fragKs * pow(max(dotHN, 0.0f), getShininess());
 }
 
 // Computes the color related to any light source. Receives the attenuation variables from shadows
@@ -218,12 +238,20 @@ vec3 rimLight(const vec3 fragKad, const vec3 fragKs, const vec3 fragNormal, cons
 // Obtains color from diffuse texture
 vec4 getKad()
 {
+#ifdef MULTI_DRAW
+	if (drawUseTextures == 0) return drawKad;
+#endif
+
 	return texture(texKadSampler, textCoord);
 }
 
 // Obtains color from specular texture
 vec4 getKs()
 {
+#ifdef MULTI_DRAW
+	if (drawUseTextures == 0) return drawKs;
+#endif
+
 	return texture(texKsSampler, textCoord);
 }
 
@@ -360,4 +388,6 @@ void main()
 	const vec3 reflectionColor = lightUniform(fragKad.rgb, fragKs.rgb, fragNormal, shadowDiffuseFactor, shadowSpecFactor);
 
 	fColor = vec4(reflectionColor, fragKad.w);
+	fPosition = vec4(position, 1.0f);
+	fNormal = vec4(normalize(normal), .0f);
 }
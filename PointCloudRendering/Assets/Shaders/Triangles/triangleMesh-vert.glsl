@@ -1,5 +1,9 @@
 #version 450
 
+#ifdef MULTI_DRAW
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
 // ********** PARAMETERS & VARIABLES ***********
 
 layout(location = 0) in vec3 vPosition;
@@ -25,6 +29,28 @@ uniform mat4 mModelView;
 uniform mat4 mModelViewProj;
 uniform mat4 mShadow;
 
+#ifdef MULTI_DRAW
+// Data of each indirect command, indexed by its base instance
+struct DrawData
+{
+	mat4 transform;
+	vec4 kad;
+	vec4 ks;
+	float shininess;
+	uint useTextures;
+	vec2 padding;
+};
+
+layout (std430, binding = 0) buffer DrawBuffer { DrawData drawData[]; };
+
+flat out vec4 drawKad;
+flat out vec4 drawKs;
+flat out float drawShininess;
+flat out uint drawUseTextures;
+#endif
+
+mat4 modelView;					// Matrices of the current draw
+
 
 // Vertex related
 out vec3 position;
@@ -45,7 +71,7 @@ out vec3 viewDir;
 // is considered as already computed
 mat3 getTBN()
 {
-	const vec3 tangent = vec3(mModelView * vec4(vTangent, 0.0f));
+	const vec3 tangent = vec3(modelView * vec4(vTangent, 0.0f));
 	const vec3 binormal = normalize(cross(normal, tangent));
 
 	return transpose(mat3(tangent, binormal, normal));
@@ -118,10 +144,25 @@ mat3 noDisplacement()
 
 void main()
 {
-	position = vec3(mModelView *  vec4(vPosition, 1.0f));
-	gl_Position = mModelViewProj * vec4(vPosition, 1.0f);
-	normal = vec3(mModelView * vec4(vNormal, 0.0f));			// Needed for TBN matrix
-	shadowCoord = mShadow * vec4(vPosition, 1.0f);
+#ifdef MULTI_DRAW
+	const DrawData draw = drawData[gl_BaseInstanceARB];
+	const vec4 modelPosition = draw.transform * vec4(vPosition, 1.0f);
+
+	modelView = mModelView * draw.transform;
+	drawKad = draw.kad;
+	drawKs = draw.ks;
+	drawShininess = draw.shininess;
+	drawUseTextures = draw.useTextures;
+#else
+	const vec4 modelPosition = vec4(vPosition, 1.0f);
+
+	modelView = mModelView;
+#endif
+
+	position = vec3(mModelView * modelPosition);
+	gl_Position = mModelViewProj * modelPosition;
+	normal = vec3(modelView * vec4(vNormal, 0.0f));			// Needed for TBN matrix
+	shadowCoord = mShadow * modelPosition;
 	textCoord = vTextCoord;
 
 	const mat3 TBN = displacementUniform();
@@ -25,6 +25,26 @@ AABB& AABB::operator=(const AABB& aabb)
 	return *this;
 }
 
+bool AABB::intersectsFrustum(const mat4& viewProjection) const
+{
+	unsigned outside[6] = { 0, 0, 0, 0, 0, 0 };
+
+	// Clip-space test: the box is culled only if its eight corners lie outside the same plane
+	for (unsigned corner = 0; corner < 8; ++corner)
+	{
+		const vec4 point = viewProjection * vec4(corner & 1 ? _max.x : _min.x, corner & 2 ? _max.y : _min.y, corner & 4 ? _max.z : _min.z, 1.0f);
+
+		outside[0] += point.x < -point.w;
+		outside[1] += point.x > point.w;
+		outside[2] += point.y < -point.w;
+		outside[3] += point.y > point.w;
+		outside[4] += point.z < -point.w;
+		outside[5] += point.z > point.w;
+	}
+
+	return std::none_of(outside, outside + 6, [](const unsigned count) { return count == 8; });
+}
+
 std::vector<AABB> AABB::split(const unsigned edgeDivisions) const
 {
 	std::vector<AABB> aabb;
@@ -47,6 +67,21 @@ std::vector<AABB> AABB::split(const unsigned edgeDivisions) const
 	return aabb;
 }
 
+AABB AABB::transform(const mat4& matrix) const
+{
+	AABB aabb;
+
+	if (!this->empty())
+	{
+		for (unsigned corner = 0; corner < 8; ++corner)
+		{
+			aabb.update(vec3(matrix * vec4(corner & 1 ? _max.x : _min.x, corner & 2 ? _max.y : _min.y, corner & 4 ? _max.z : _min.z, 1.0f)));
+		}
+	}
+
+	return aabb;
+}
+
 void AABB::update(const AABB& aabb)
 {
 	this->update(aabb.max());
@@ -45,6 +45,16 @@ public:
 	*/
 	vec3 extent() const { return _max - center(); }
 
+	/**
+	*	@return True if the box has not been updated with any point.
+	*/
+	bool empty() const { return glm::any(glm::greaterThan(_min, _max)); }
+
+	/**
+	*	@return True if the box is not completely outside the view frustum described by the given view-projection matrix.
+	*/
+	bool intersectsFrustum(const mat4& viewProjection) const;
+
 	/**
 	*	@return Maximum point.
 	*/
@@ -65,6 +75,11 @@ public:
 	*/
 	std::vector<AABB> split(const unsigned edgeDivisions) const;
 
+	/**
+	*	@return Axis-aligned box which wraps this one once transformed by the given matrix.
+	*/
+	AABB transform(const mat4& matrix) const;
+
 	/**
 	*	@brief Updates the boundaries with a new axis aligned bounding box.
 	*/
@@ -27,6 +27,14 @@ struct CGAppEnum
 		CAD_SCENE
 	};
 
+	// Ambient occlusion presets, from the fastest to the most accurate
+	enum SSAOQuality : uint8_t
+	{
+		SSAO_LOW,
+		SSAO_MEDIUM,
+		SSAO_HIGH
+	};
+
 	/**
 	*	@return Number of different visualization modes.
 	*/
@@ -37,6 +45,11 @@ struct CGAppEnum
 	*/
 	const static GLsizei numAvailableScenes() { return CAD_SCENE + 1; }
 
+	/**
+	*	@return Number of ambient occlusion presets.
+	*/
+	const static GLsizei numSSAOQualities() { return SSAO_HIGH + 1; }
+
 
 	// Application prebuilt materials
 	enum MaterialNames : uint16_t
@@ -12,9 +12,16 @@
 struct PointCloudParameters
 {
 public:
+	inline static GLuint	_cacheQuantizationBits = 21;		//!< Bits of each coordinate within compressed caches
+	inline static bool		_compressBinaryCache = false;		//!< Point clouds are cached as compressed chunks instead of raw binary files. Lossy (quantized) and reordered, so it is opt-in
+	inline static bool		_constantWindowSize = false;			//!< Per-frame kernels are compiled for the current window size, so they are rebuilt once the window stops being resized
+	inline static GLuint	_datasetPointBudget = 128;			//!< Millions of dataset points kept in GPU; tiles outside the view are evicted, farthest first, beyond it
 	inline static float		_distanceThreshold = 1.01f;			//!<
 	inline static bool		_enableHQR = true;					//!<
+	inline static bool		_gpuResident = false;				//!< Host points are released once uploaded, and read again from the cache when needed
 	inline static bool		_sortPointCloud = true;				//!<
 	inline static bool		_reducePointCloud = false;			//!<
 	inline static GLuint	_reduceIterations = 1;				//!<
+	inline static float		_uploadBudget = 8.0f;				//!< Time per frame spent uploading points while a point cloud is being loaded (ms)
+	inline static GLuint	_uploadChunkSize = 1 << 20;			//!< Maximum number of points uploaded at once while loading, so that each upload fits in a segment of the upload ring
 };
\ No newline at end of file
@@ -8,14 +8,16 @@
 #include "Graphics/Core/CADModel.h"
 #include "Graphics/Core/Light.h"
 #include "Graphics/Core/OpenGLUtilities.h"
+#include "Graphics/Application/PointCloudParameters.h"
 
 /// Initialization of static attributes
 const std::string PointCloudScene::SCENE_CAMERA_FILE = "Camera.txt";
 const std::string PointCloudScene::POINT_CLOUD_FILE = "Assets/Models/PointCloudSubsample01";
+const size_t PointCloudScene::MAX_QUEUED_CHUNKS = 64;
 
 // [Public methods]
 
-PointCloudScene::PointCloudScene() : _pointCloud(nullptr), _pointCloudAggregator(nullptr)
+PointCloudScene::PointCloudScene() : _pointCloud(nullptr), _pointCloudAggregator(nullptr), _pointCloudDataset(nullptr), _pendingChunk{ nullptr, 0, 0 }, _uploadedPoints(0), _totalPoints(0)
 {
 	ShaderList* shaderList = ShaderList::getInstance();
 
@@ -26,22 +28,79 @@ PointCloudScene::PointCloudScene() : _pointCloud(nullptr), _pointCloudAggregator
 
 PointCloudScene::~PointCloudScene()
 {
+	this->cancelPointCloudLoading();
+
 	delete _pointCloud;
+	delete _pointCloudDataset;
 	delete _pointCloudAggregator;
 }
 
+void PointCloudScene::cancelPointCloudLoading()
+{
+	if (_pointCloudDataset) _pointCloudDataset->cancelLoading();
+	if (!_loadingTask) return;
+
+	// Points of the cancelled cloud may still be in the middle of their upload
+	_pointCloudAggregator->flushUploads();
+
+	// Closing the queue unblocks the reader, which stops as its chunks are rejected
+	_chunkQueue->close();
+	_loadingTask->cancel();
+	_loadingTask.reset();
+	_chunkQueue.reset();
+
+	_pendingChunk = PointChunk{ nullptr, 0, 0 };
+}
+
+float PointCloudScene::getLoadingProgress() const
+{
+	if (_pointCloudDataset) return _pointCloudDataset->getLoadingProgress();
+
+	return _totalPoints ? float(_uploadedPoints) / _totalPoints : .0f;
+}
+
+bool PointCloudScene::isLoadingPointCloud() const
+{
+	return _loadingTask != nullptr || (_pointCloudDataset && _pointCloudDataset->isLoading());
+}
+
 bool PointCloudScene::loadPointCloud(const std::string& path)
 {
-	bool nullPointCloud = _pointCloud == nullptr;
+	this->cancelPointCloudLoading();
 	
 	delete _pointCloud;
+	delete _pointCloudDataset;
+	_pointCloud = nullptr;
+	_pointCloudDataset = nullptr;
+
+	if (PointCloudDataset::isDataset(path))
+	{
+		return this->loadPointCloudDataset(path);
+	}
+
 	_pointCloud = new PointCloud(path, true);
-	if (!_pointCloud->load()) return false;
-	_pointCloudAggregator->setPointCloud(_pointCloud);
+	_pointCloudAggregator->beginProgressiveUpload(_pointCloud);
 
-	if (Renderer::getInstance()->getRenderingParameters()->_updateCamera) this->loadDefaultCamera(_cameraManager->getActiveCamera());
+	_chunkQueue.reset(new BoundedQueue<PointChunk>(MAX_QUEUED_CHUNKS));
+	_uploadedPoints = _totalPoints = 0;
+
+	PointCloud* pointCloud = _pointCloud;
+	BoundedQueue<PointChunk>* chunkQueue = _chunkQueue.get();
 
-	std::cout << _pointCloud->getNumberOfPoints() << std::endl;
+	_loadingTask.reset(new BackgroundTask("Loading " + path, [pointCloud, chunkQueue](BackgroundTask& task) -> bool
+		{
+			size_t readPoints = 0;
+
+			pointCloud->setChunkCallback([&task, &readPoints, chunkQueue](const Point* points, size_t numPoints, size_t totalPoints) -> bool
+				{
+					readPoints += numPoints;
+					task.setProgress(float(readPoints) / std::max(totalPoints, size_t(1)));
+
+					return !task.isCancelled() && chunkQueue->push(PointChunk{ points, numPoints, totalPoints });
+				});
+
+			return pointCloud->load();
+		}));
 
 	return true;
 }
@@ -55,6 +114,8 @@ void PointCloudScene::modifySize(const uint16_t width, const uint16_t height)
 
 void PointCloudScene::render(const mat4& mModel, RenderingParameters* rendParams)
 {
+	this->updatePointCloudLoading();
+
 	this->bindDefaultFramebuffer(rendParams);	
 	this->renderPointCloud(mModel, rendParams);
 }
@@ -66,6 +127,9 @@ void PointCloudScene::drawAsPoints(const mat4& mModel, RenderingParameters* rend
 	Camera* activeCamera		= _cameraManager->getActiveCamera();
 	const mat4 projectionMatrix = activeCamera->getViewProjMatrix() * mModel;
 
+	// Tiles which become visible are requested before rendering those already uploaded
+	if (_pointCloudDataset) _pointCloudDataset->update(projectionMatrix);
+
 	_pointCloudAggregator->render(projectionMatrix);
 
 	_quadRenderer->use();
@@ -82,6 +146,11 @@ void PointCloudScene::loadDefaultCamera(Camera* camera)
 		camera->setPosition(_pointCloud->getAABB().center() + _pointCloud->getAABB().extent() * 1.5f);
 		camera->setLookAt(_pointCloud->getAABB().center());
 	}
+	else if (_pointCloudDataset && _pointCloudDataset->getAABB().min().x <= _pointCloudDataset->getAABB().max().x)
+	{
+		camera->setPosition(_pointCloudDataset->getAABB().center() + _pointCloudDataset->getAABB().extent() * 1.5f);
+		camera->setLookAt(_pointCloudDataset->getAABB().center());
+	}
 	else
 	{
 		camera->setPosition(vec3(3.0f, 3.338f, 2.94f));
@@ -108,12 +177,76 @@ void PointCloudScene::loadModels()
 {
 	{
 		_sceneGroup = new Group3D;
-		_pointCloudAggregator = new PointCloudAggregator();
 	}
 	
 	SSAOScene::loadModels();
 }
 
+bool PointCloudScene::loadPointCloudDataset(const std::string& path)
+{
+	_pointCloudAggregator->beginProgressiveUpload(nullptr);
+	_pointCloudDataset = new PointCloudDataset(_pointCloudAggregator);
+
+	if (!_pointCloudDataset->open(path)) return false;
+
+	// Only headers have been read, so the camera can be placed at once
+	if (Renderer::getInstance()->getRenderingParameters()->_updateCamera) this->loadDefaultCamera(_cameraManager->getActiveCamera());
+
+	return true;
+}
+
+void PointCloudScene::updatePointCloudLoading()
+{
+	if (!_loadingTask) return;
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	auto elapsedTime = [&startTime]() { return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count(); };
+
+	// At least one upload is performed per frame, so that loading progresses whatever the budget is
+	do
+	{
+		if (_pendingChunk._numPoints == 0 && !_chunkQueue->tryPop(_pendingChunk)) break;
+
+		const size_t numPoints = std::min(_pendingChunk._numPoints, size_t(PointCloudParameters::_uploadChunkSize));
+		_pointCloudAggregator->uploadChunk(_pendingChunk._points, unsigned(numPoints), _pendingChunk._totalPoints);
+
+		_pendingChunk._points += numPoints;
+		_pendingChunk._numPoints -= numPoints;
+		_uploadedPoints += numPoints;
+		_totalPoints = _pendingChunk._totalPoints;
+	} 
+	while (elapsedTime() < PointCloudParameters::_uploadBudget);
+
+	// Every chunk has been pushed once the task is finished
+	if (_loadingTask->isFinished() && _pendingChunk._numPoints == 0 && _chunkQueue->empty())
+	{
+		const bool success = _loadingTask->wait();
+
+		_pointCloud->setChunkCallback(nullptr);			// It refers to the task and queue
+		_loadingTask.reset();
+		_chunkQueue.reset();
+
+		if (!success)
+		{
+			std::cerr << "Point cloud could not be loaded." << std::endl;
+			return;
+		}
+
+		// Bounds of the whole cloud are known now, so chunks are reduced and sorted within the same grid
+		_pointCloudAggregator->finishProgressiveUpload(_pointCloud->getAABB());
+
+		// Every point is already in GPU, so the host copy is only retrieved if requested (e.g. for writing it)
+		if (PointCloudParameters::_gpuResident)
+		{
+			_pointCloud->releasePoints(std::bind(&PointCloudAggregator::readPoints, _pointCloudAggregator, std::placeholders::_1));
+		}
+
+		if (Renderer::getInstance()->getRenderingParameters()->_updateCamera) this->loadDefaultCamera(_cameraManager->getActiveCamera());
+
+		std::cout << _pointCloud->getNumberOfPoints() << std::endl;
+	}
+}
+
 void PointCloudScene::bindTexture(GLuint textureID, ShaderProgram* shader, const std::string& uniformName, unsigned offset)
 {
 	shader->setUniform(uniformName, offset);
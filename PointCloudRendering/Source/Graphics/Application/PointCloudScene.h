@@ -3,6 +3,9 @@
 #include "Graphics/Application/SSAOScene.h"
 #include "Graphics/Core/PointCloud.h"
 #include "Graphics/Core/PointCloudAggregator.h"
+#include "Graphics/Core/PointCloudDataset.h"
+#include "Utilities/BackgroundTask.h"
+#include "Utilities/BoundedQueue.h"
 
 #define CAMERA_POS_HEADER "Position"
 #define CAMERA_LOOKAT_HEADER "LookAt"
@@ -22,10 +25,27 @@ protected:
 	// Settings constraints
 	const static std::string SCENE_CAMERA_FILE;				//!<
 	const static std::string POINT_CLOUD_FILE;				//!<
+	const static size_t		 MAX_QUEUED_CHUNKS;				//!< Capacity of the queue of loaded chunks
+
+protected:
+	struct PointChunk
+	{
+		const Point*	_points;							//!< First point of the chunk
+		size_t			_numPoints;							//!< Number of points that are not uploaded yet
+		size_t			_totalPoints;						//!< Number of points of the whole cloud
+	};
 
 protected:
 	PointCloud*				_pointCloud;
 	PointCloudAggregator*	_pointCloudAggregator;
+	PointCloudDataset*		_pointCloudDataset;					//!< Tiled point cloud, if a directory or manifest was opened
+
+	// Asynchronous loading
+	std::unique_ptr<BackgroundTask>				_loadingTask;		//!< Job which loads the point cloud
+	std::unique_ptr<BoundedQueue<PointChunk>>	_chunkQueue;		//!< Chunks loaded but not uploaded yet
+	PointChunk									_pendingChunk;		//!< Chunk which is being uploaded across several frames
+	size_t										_uploadedPoints;	//!< Number of points already uploaded
+	size_t										_totalPoints;		//!< Number of points of the cloud being loaded, if known
 
 	// Rendering
 	RenderingShader*		_quadRenderer;
@@ -52,6 +72,16 @@ protected:
 	*/
 	virtual void loadModels();
 
+	/**
+	*	@brief Indexes the tiles of a dataset, which are loaded as they become visible.
+	*/
+	bool loadPointCloudDataset(const std::string& path);
+
+	/**
+	*	@brief Uploads loaded chunks within the time budget of a frame, and finishes the loading once every chunk is uploaded.
+	*/
+	void updatePointCloudLoading();
+
 protected:
 	// Rendering related
 	/**
@@ -78,7 +108,24 @@ public:
 	virtual ~PointCloudScene();
 
 	/**
-	*	@return True if the point cloud was successfully loaded.
+	*	@brief Stops the current loading, keeping the points that were already uploaded.
+	*/
+	void cancelPointCloudLoading();
+
+	/**
+	*	@return Fraction of points (or dataset tiles) already uploaded.
+	*/
+	float getLoadingProgress() const;
+
+	/**
+	*	@return True while a point cloud is being loaded.
+	*/
+	bool isLoadingPointCloud() const;
+
+	/**
+	*	@brief Launches the loading of a point cloud in background. Points are rendered as they arrive.
+	*	@param path Point cloud file, or directory / manifest of tiles.
+	*	@return True if the loading was launched.
 	*/
 	bool loadPointCloud(const std::string& path);
 
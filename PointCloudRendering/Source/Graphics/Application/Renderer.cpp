@@ -3,6 +3,7 @@
 
 #include "Graphics/Application/PointCloudScene.h"
 #include "Graphics/Core/PointCloudAggregator.h"
+#include "Graphics/Core/ShaderList.h"
 #include "Interface/Window.h"
 #include "Utilities/FileManagement.h"
 
@@ -73,6 +74,7 @@ void Renderer::prepareOpenGL(const uint16_t width, const uint16_t height)
 	glPrimitiveRestartIndex(Model3D::RESTART_PRIMITIVE_INDEX);
 
 	ComputeShader::initializeMaxGroupSize();			// Once the context is ready we can query for maximum work group size
+	if (_state->_shaderWarmUp) ShaderList::getInstance()->warmUp();
 	Model3D::buildShadowOffsetTexture();				// Alternative shadow technique
 	Model3D::buildSSAONoiseKernels();					// Ambient occlusion samples
 
@@ -30,6 +30,9 @@ public:
 	// Rendering type
 	int								_visualizationMode;						//!< Only triangle mesh is defined here
 	
+	// Shaders
+	bool							_shaderWarmUp;							//!< Every shader is built at startup instead of when it is first needed
+
 	// Point cloud
 	float							_scenePointSize;						//!<
 	vec3							_scenePointCloudColor;					//!< Color of point cloud which shows all the vertices
@@ -40,6 +43,12 @@ public:
 
 	// Triangle mesh
 	bool							_ambientOcclusion;						//!< Boolean value to enable/disable occlusion
+	int								_ssaoQuality;							//!< Resolution and number of samples of ambient occlusion (CGAppEnum::SSAOQuality)
+	int								_shadowTilesPerFrame;					//!< Maximum number of dirty shadow map tiles rendered per light and frame, zero to render all of them
+	bool							_multiDrawIndirect;						//!< Renders the scene components with an indirect call per material batch
+	bool							_gpuCulling;							//!< Components out of the frustum are culled in a compute shader before indirect draws
+	bool							_occlusionCulling;						//!< Components behind the depth of the previous frame are also culled
+	bool							_meshletConeCulling;					//!< Back faces are culled in the camera pass, and so are meshlets whose normal cone faces away from the camera
 	bool							_renderSemanticConcept;					//!< Boolean value to indicate if rendering semantic concepts is needed
 	int								_semanticRenderingConcept;				//!< ASPRS / Custom semantic concepts (selector)
 
@@ -67,6 +76,8 @@ public:
 
 		_visualizationMode(CGAppEnum::VIS_TRIANGLES),
 
+		_shaderWarmUp(true),
+
 		_scenePointSize(2.0f),
 		_scenePointCloudColor(1.0f, .0f, .0f),
 
@@ -74,6 +85,12 @@ public:
 		_wireframeColor(0.0f),
 
 		_ambientOcclusion(true),
+		_ssaoQuality(CGAppEnum::SSAO_HIGH),
+		_shadowTilesPerFrame(0),
+		_multiDrawIndirect(true),
+		_gpuCulling(true),
+		_occlusionCulling(true),
+		_meshletConeCulling(false),
 		_renderSemanticConcept(false),
 
 		_bvhNodesPercentage(1.0f),
@@ -33,25 +33,22 @@ void SSAOScene::render(const mat4& mModel, RenderingParameters* rendParams)
 
 	if (rendParams->_ambientOcclusion && this->needToApplyAmbientOcclusion(rendParams))
 	{
-		_ssaoFBO->bindMultisamplingFBO();
+		_ssaoFBO->bindGBufferFBO();
 		this->renderScene(mModel, rendParams);
-		_ssaoFBO->writeGBuffer(0);
-
-		_ssaoFBO->bindGBufferFBO(1);
-		if (rendParams->_showTriangleMesh) this->drawAsTriangles4Position(mModel, rendParams);
-
-		_ssaoFBO->bindGBufferFBO(2);
-		if (rendParams->_showTriangleMesh) this->drawAsTriangles4Normal(mModel, rendParams);
+		this->buildHiZBuffer();
 
+		_ssaoFBO->beginSSAOTimer();
 		_ssaoFBO->bindSSAOFBO();
 		this->drawSSAOScene();
 
 		this->bindDefaultFramebuffer(rendParams);
 		this->composeScene();
+		_ssaoFBO->endSSAOTimer();
 	}
 	else
 	{
 		this->bindDefaultFramebuffer(rendParams);
+		_hiZBuffer->invalidate();
 
 		this->renderScene(mModel, rendParams);
 	}
@@ -95,12 +92,15 @@ void SSAOScene::renderScene(const mat4& mModel, RenderingParameters* rendParams)
 		break;
 	case CGAppEnum::VIS_ALL_TOGETHER:
 		this->renderTriangleMesh(mModel, rendParams);
+		_ssaoFBO->writeGeometryAttachments(false);						// Only the triangle mesh takes part in ambient occlusion
 		this->renderWireframe(mModel, rendParams);
 		this->renderPointCloud(mModel, rendParams);
 		break;
 	}
 
+	_ssaoFBO->writeGeometryAttachments(false);
 	this->renderOtherStructures(mModel, rendParams);
+	_ssaoFBO->writeGeometryAttachments(true);
 }
 
 void SSAOScene::renderPointCloud(const mat4& mModel, RenderingParameters* rendParams)
@@ -148,13 +148,3 @@ void SSAOScene::drawSceneAsTriangles(RenderingShader* shader, RendEnum::RendShad
 {
 	Scene::drawSceneAsTriangles(shader, shaderType, matrix, rendParams);
 }
-
-void SSAOScene::drawSceneAsTriangles4Normal(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams)
-{
-	Scene::drawSceneAsTriangles4Normal(shader, shaderType, matrix, rendParams);
-}
-
-void SSAOScene::drawSceneAsTriangles4Position(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams)
-{
-	Scene::drawSceneAsTriangles4Position(shader, shaderType, matrix, rendParams);
-}
@@ -83,24 +83,6 @@ protected:
 	*/
 	virtual void drawSceneAsTriangles(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams);
 
-	/**
-	*	@brief Decides which objects are going to be rendered as a triangle mesh. Only the normal is calculated for each fragment.
-	*	@param shader Rendering shader which is drawing the scene.
-	*	@param shaderType Unique ID of "shader".
-	*	@param matrix Vector of matrices, including view, projection, etc.
-	*	@param rendParams Parameters which indicates how the scene is rendered.
-	*/
-	virtual void drawSceneAsTriangles4Normal(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams);
-
-	/**
-	*	@brief Decides which objects are going to be rendered as a triangle mesh. Only the position is calculated for each fragment.
-	*	@param shader Rendering shader which is drawing the scene.
-	*	@param shaderType Unique ID of "shader".
-	*	@param matrix Vector of matrices, including view, projection, etc.
-	*	@param rendParams Parameters which indicates how the scene is rendered.
-	*/
-	virtual void drawSceneAsTriangles4Position(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams);
-
 public:
 	/**
 	*	@brief Default constructor.
@@ -8,7 +8,7 @@
 
 Scene::Scene():
 	_cameraManager(std::unique_ptr<CameraManager>(new CameraManager())), _sceneGroup(nullptr),
-	_nextFramebufferID(0), _ssaoFBO(new SSAOFBO())
+	_nextFramebufferID(0), _ssaoFBO(new SSAOFBO()), _hiZBuffer(new HiZBuffer())
 {
 	_window = Window::getInstance();
 }
@@ -17,6 +17,7 @@ Scene::~Scene()
 {
 	delete _sceneGroup;
 	delete _ssaoFBO;
+	delete _hiZBuffer;
 }
 
 void Scene::load()
@@ -45,25 +46,22 @@ void Scene::render(const mat4& mModel, RenderingParameters* rendParams)
 
 	if (rendParams->_ambientOcclusion)
 	{
-		_ssaoFBO->bindMultisamplingFBO();
+		_ssaoFBO->bindGBufferFBO();
 		this->drawAsTriangles(mModel, rendParams);
-		_ssaoFBO->writeGBuffer(0);
-
-		_ssaoFBO->bindGBufferFBO(1);
-		if (rendParams->_showTriangleMesh) this->drawAsTriangles4Position(mModel, rendParams);
-
-		_ssaoFBO->bindGBufferFBO(2);
-		if (rendParams->_showTriangleMesh) this->drawAsTriangles4Normal(mModel, rendParams);
+		this->buildHiZBuffer();
 
+		_ssaoFBO->beginSSAOTimer();
 		_ssaoFBO->bindSSAOFBO();
 		this->drawSSAOScene();
 
 		this->bindDefaultFramebuffer(rendParams);
 		this->composeScene();
+		_ssaoFBO->endSSAOTimer();
 	}
 	else
 	{
 		this->bindDefaultFramebuffer(rendParams);
+		_hiZBuffer->invalidate();
 
 		this->drawAsTriangles(mModel, rendParams);
 	}
@@ -109,22 +107,50 @@ void Scene::drawAsTriangles(const mat4& mModel, RenderingParameters* rendParams)
 
 void Scene::drawAsTriangles(Camera* camera, const mat4& mModel, RenderingParameters* rendParams)
 {
-	RenderingShader* shader = ShaderList::getInstance()->getRenderingShader(RendEnum::TRIANGLE_MESH_SHADER);
+	const RendEnum::RendShaderTypes shaderType = rendParams->_multiDrawIndirect ? RendEnum::TRIANGLE_MESH_GROUP_SHADER : RendEnum::TRIANGLE_MESH_SHADER;
+	RenderingShader* shader = ShaderList::getInstance()->getRenderingShader(shaderType);
 	std::vector<mat4> matrix(RendEnum::numMatricesTypes());
 	const mat4 bias = glm::translate(mat4(1.0f), vec3(0.5f)) * glm::scale(mat4(1.0f), vec3(0.5f));						// Proj: [-1, 1] => with bias: [0, 1]
+	bool occlusionCulled = false;
+
+	// Meshlets are only culled by their normal cone if back faces would be discarded anyway, since models may be double-sided
+	const bool backFaceCulling = rendParams->_meshletConeCulling;
+	const bool coneCulling = backFaceCulling && camera->getCameraType() == Camera::PERSPECTIVE_PROJ;
 
 	{
 		matrix[RendEnum::MODEL_MATRIX] = mModel;
 		matrix[RendEnum::VIEW_MATRIX] = camera->getViewMatrix();
 		matrix[RendEnum::VIEW_PROJ_MATRIX] = camera->getViewProjMatrix();
 
+		// Depth of the last frame only tells which components are occluded from the same viewpoint
+		if (rendParams->_multiDrawIndirect)
+		{
+			occlusionCulled = _sceneGroup->cullMultiDraw(matrix, camera == _cameraManager->getActiveCamera() ? _hiZBuffer : nullptr, coneCulling);
+		}
+
+		if (backFaceCulling)
+		{
+			glEnable(GL_CULL_FACE);
+			glCullFace(GL_BACK);
+		}
+
 		glDepthFunc(GL_LEQUAL);
 
 		shader->use();
 		shader->setUniform("materialScattering", rendParams->_materialScattering);										// Ambient lighting
 	}
 
+	// Components hidden by the last frame but disoccluded in this one are tested against the depth which has just been drawn, instead of popping in a frame later.
+	// Occlusion culling is only enabled while the G-buffer is drawn, so its positions can be reduced again
+	for (unsigned phase = 0; phase < (occlusionCulled ? 2u : 1u); ++phase)
 	{
+		if (phase == 1)
+		{
+			this->buildHiZBuffer();
+			_sceneGroup->cullOccludedMultiDraw(matrix, _hiZBuffer);
+			shader->use();
+		}
+
 		for (unsigned int i = 0; i < _lights.size(); ++i)																// Multipass rendering
 		{
 			if (i == 0)
@@ -145,52 +171,25 @@ void Scene::drawAsTriangles(Camera* camera, const mat4& mModel, RenderingParamet
 			_lights[i]->applyShadowMapTexture(shader);
 			shader->applyActiveSubroutines();
 
-			this->drawSceneAsTriangles(shader, RendEnum::TRIANGLE_MESH_SHADER, &matrix, rendParams);
+			this->drawSceneAsTriangles(shader, shaderType, &matrix, rendParams);
 		}
 	}
 
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);					// Back to initial state
 	glDepthFunc(GL_LESS);
-}
-
-void Scene::drawAsTriangles4Position(const mat4& mModel, RenderingParameters* rendParams)
-{
-	Camera* activeCamera = _cameraManager->getActiveCamera(); if (!activeCamera) return;
-	RenderingShader* shader = ShaderList::getInstance()->getRenderingShader(RendEnum::TRIANGLE_MESH_POSITION_SHADER);
-	std::vector<mat4> matrix(RendEnum::numMatricesTypes());
-
-	{
-		matrix[RendEnum::MODEL_MATRIX] = mModel;
-		matrix[RendEnum::VIEW_MATRIX] = activeCamera->getViewMatrix();
-		matrix[RendEnum::VIEW_PROJ_MATRIX] = activeCamera->getViewProjMatrix();
-
-		shader->use();
-
-		this->drawSceneAsTriangles4Position(shader, RendEnum::TRIANGLE_MESH_POSITION_SHADER, &matrix, rendParams);
-	}
-}
-
-void Scene::drawAsTriangles4Normal(const mat4& mModel, RenderingParameters* rendParams)
-{
-	Camera* activeCamera = _cameraManager->getActiveCamera(); if (!activeCamera) return;
-	RenderingShader* shader = ShaderList::getInstance()->getRenderingShader(RendEnum::TRIANGLE_MESH_NORMAL_SHADER);
-	std::vector<mat4> matrix(RendEnum::numMatricesTypes());
 
+	if (backFaceCulling)
 	{
-		matrix[RendEnum::MODEL_MATRIX] = mModel;
-		matrix[RendEnum::VIEW_MATRIX] = activeCamera->getViewMatrix();
-		matrix[RendEnum::VIEW_PROJ_MATRIX] = activeCamera->getViewProjMatrix();
-
-		shader->use();
-
-		this->drawSceneAsTriangles4Normal(shader, RendEnum::TRIANGLE_MESH_POSITION_SHADER, &matrix, rendParams);
+		glCullFace(GL_FRONT);											// Expected by shadow mapping
+		glDisable(GL_CULL_FACE);
 	}
 }
 
 void Scene::drawAsTriangles4Shadows(const mat4& mModel, RenderingParameters* rendParams)
 {
 	Camera* activeCamera = _cameraManager->getActiveCamera(); if (!activeCamera) return;
-	RenderingShader* shader = ShaderList::getInstance()->getRenderingShader(RendEnum::SHADOWS_SHADER);
+	const RendEnum::RendShaderTypes shaderType = rendParams->_multiDrawIndirect ? RendEnum::SHADOWS_GROUP_SHADER : RendEnum::SHADOWS_SHADER;
+	RenderingShader* shader = ShaderList::getInstance()->getRenderingShader(shaderType);
 	const ivec2 canvasSize = rendParams->_viewportSize;
 	std::vector<mat4> matrix(RendEnum::numMatricesTypes());
 
@@ -202,28 +201,65 @@ void Scene::drawAsTriangles4Shadows(const mat4& mModel, RenderingParameters* ren
 		shader->use();
 	}
 
+	std::vector<AABB> changedRegions;
+	_sceneGroup->collectChangedRegions(changedRegions);
+	_shadowMapVersion.resize(_lights.size(), UINT_MAX);
+
 	for (unsigned int i = 0; i < _lights.size(); ++i)
 	{
 		Light* light = _lights[i].get();
+		if (!light->shouldCastShadows()) continue;
+
+		ShadowMap* shadowMap = light->getShadowMap();
+		const mat4 viewProjection = light->getCamera()->getViewProjMatrix();
+
+		// Dependencies: the whole map depends on the light, whereas each tile depends on the models within it
+		if (_shadowMapVersion[i] != light->getShadowVersion())
+		{
+			shadowMap->invalidate();
+			_shadowMapVersion[i] = light->getShadowVersion();
+		}
+		else
+		{
+			for (const AABB& region : changedRegions) shadowMap->invalidate(region, viewProjection * mModel);
+		}
 
-		if (light->shouldCastShadows() && _computeShadowMap[i])
+		if (!shadowMap->isDirty()) continue;
+
+		{
+			shadowMap->bindFBO();
+			glEnable(GL_SCISSOR_TEST);
+			shader->applyActiveSubroutines();
+		}
+
+		unsigned numRenderedTiles = 0;
+
+		for (unsigned tile = 0; tile < shadowMap->getNumTiles(); ++tile)
 		{
-			ShadowMap* shadowMap = light->getShadowMap();
-			const ivec2 size = shadowMap->getSize();
+			if (!shadowMap->isTileDirty(tile)) continue;
+			if (rendParams->_shadowTilesPerFrame > 0 && numRenderedTiles == unsigned(rendParams->_shadowTilesPerFrame)) break;			// Remaining tiles are spread over the next frames
+
+			const ivec4 viewport = shadowMap->getTileViewport(tile);
+			glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+			glScissor(viewport.x, viewport.y, viewport.z, viewport.w);
+			glClear(GL_DEPTH_BUFFER_BIT);
+
+			// Each tile is rendered with its own frustum, so that only the casters within it are drawn
+			matrix[RendEnum::VIEW_PROJ_MATRIX] = shadowMap->getTileCropMatrix(tile) * viewProjection;
 
+			if (rendParams->_multiDrawIndirect)
 			{
-				shadowMap->bindFBO();
-				glClear(GL_DEPTH_BUFFER_BIT);
-				glViewport(0, 0, size.x, size.y);
-				shader->applyActiveSubroutines();
+				_sceneGroup->cullMultiDraw(matrix, nullptr, false);
+				shader->use();
 			}
 
-			matrix[RendEnum::VIEW_PROJ_MATRIX] = light->getCamera()->getViewProjMatrix();
+			_sceneGroup->drawAsTriangles4Shadows(shader, shaderType, matrix);
 
-			_sceneGroup->drawAsTriangles4Shadows(shader, RendEnum::SHADOWS_SHADER, matrix);
-
-			_computeShadowMap[i] = false;
+			shadowMap->setTileUpdated(tile);
+			++numRenderedTiles;
 		}
+
+		glDisable(GL_SCISSOR_TEST);
 	}
 
 	glViewport(0, 0, canvasSize.x, canvasSize.y);
@@ -246,16 +282,6 @@ void Scene::drawSceneAsTriangles(RenderingShader* shader, RendEnum::RendShaderTy
 	_sceneGroup->drawAsTriangles(shader, shaderType, *matrix);
 }
 
-void Scene::drawSceneAsTriangles4Normal(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams)
-{
-	_sceneGroup->drawAsTriangles4Shadows(shader, shaderType, *matrix);
-}
-
-void Scene::drawSceneAsTriangles4Position(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams)
-{
-	_sceneGroup->drawAsTriangles4Shadows(shader, shaderType, *matrix);
-}
-
 void Scene::bindDefaultFramebuffer(RenderingParameters* rendParams)
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, _nextFramebufferID);
@@ -265,7 +291,8 @@ void Scene::bindDefaultFramebuffer(RenderingParameters* rendParams)
 
 void Scene::composeScene()
 {
-	RenderingShader* shader = ShaderList::getInstance()->getRenderingShader(RendEnum::BLUR_SSAO_SHADER);
+	// Occlusion computed at a lower resolution is upsampled guided by the G-buffer, so that it does not bleed across edges
+	RenderingShader* shader = ShaderList::getInstance()->getRenderingShader(_ssaoFBO->isSSAOUpsampled() ? RendEnum::BILATERAL_UPSAMPLE_SSAO_SHADER : RendEnum::BLUR_SSAO_SHADER);
 	shader->use();
 
 	_ssaoFBO->bindSSAOTexture(shader);
@@ -282,11 +309,22 @@ void Scene::drawSSAOScene()
 
 	_ssaoFBO->bindGBufferTextures(shader);
 	Model3D::bindSSAOTextures(shader);
-	shader->setUniform("windowSize", vec2(_window->getSize()));
+	shader->setUniform("windowSize", vec2(_ssaoFBO->getSSAOSize()));
+	shader->setUniform("kernelSize", _ssaoFBO->getSSAOPreset()._kernelSize);
 	shader->setUniform("mProjMatrix", activeCamera->getProjectionMatrix());
 
 	VAO* quadVAO = Primitives::getQuadVAO();
 	quadVAO->drawObject(RendEnum::IBO_TRIANGLE_MESH, GL_TRIANGLES, 2 * 4);		
+
+	const ivec2 windowSize = _window->getSize();
+	glViewport(0, 0, windowSize.x, windowSize.y);
+}
+
+void Scene::buildHiZBuffer()
+{
+	Camera* activeCamera = _cameraManager->getActiveCamera(); if (!activeCamera) return;
+
+	_hiZBuffer->build(_ssaoFBO->getPositionTexture(), _ssaoFBO->getSize(), activeCamera->getViewMatrix(), activeCamera->getViewProjMatrix());
 }
 
 void Scene::loadCameras()
@@ -299,9 +337,5 @@ void Scene::loadCameras()
 
 void Scene::loadLights()
 {
-	_computeShadowMap = std::vector<bool>(_lights.size());
-	for (unsigned int i = 0; i < _computeShadowMap.size(); ++i)
-	{
-		_computeShadowMap[i] = true;
-	}
+	_shadowMapVersion = std::vector<unsigned>(_lights.size(), UINT_MAX);			// Every shadow map is rendered at first
 }
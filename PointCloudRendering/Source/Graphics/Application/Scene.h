@@ -5,6 +5,7 @@
 #include "Graphics/Application/RenderingParameters.h"
 #include "Graphics/Core/Camera.h"
 #include "Graphics/Core/Group3D.h"
+#include "Graphics/Core/HiZBuffer.h"
 #include "Graphics/Core/Light.h"
 #include "Graphics/Core/Model3D.h"
 #include "Graphics/Core/PlanarSurface.h"
@@ -30,11 +31,12 @@ protected:
 	Group3D*							_sceneGroup;					//!< Model wrapper
 
 	// [FBO]
-	std::vector<bool>					_computeShadowMap;				//!< Boolean value which determines if the shadow map must be computed again for a light
+	std::vector<unsigned>				_shadowMapVersion;				//!< Light version of each shadow map, which is invalidated as a whole if the light changes
 	GLuint								_nextFramebufferID;				//!< Framebuffer where we will render the next scene
 
 	// [SSAO]
 	SSAOFBO*							_ssaoFBO;						//!< FBO for ambient occlusion	
+	HiZBuffer*							_hiZBuffer;						//!< Depth pyramid of the last G-buffer, for occlusion culling
 	Window*								_window;						//!< Source of queries for window size, etc
 
 protected:
@@ -67,21 +69,7 @@ protected:
 	virtual void drawAsTriangles(Camera* camera, const mat4& mModel, RenderingParameters* rendParams);
 
 	/**
-	*	@brief Renders the scene so that every fragment take the color of its position.
-	*	@param mModel Additional model matrix to be applied over the initial model matrix.
-	*	@param rendParams Rendering parameters to be taken into account.
-	*/
-	virtual void drawAsTriangles4Position(const mat4& mModel, RenderingParameters* rendParams);
-
-	/**
-	*	@brief Renders the scene so that every fragment take the color of its normal.
-	*	@param mModel Additional model matrix to be applied over the initial model matrix.
-	*	@param rendParams Rendering parameters to be taken into account.
-	*/
-	virtual void drawAsTriangles4Normal(const mat4& mModel, RenderingParameters* rendParams);
-
-	/**
-	*	@brief Renders the scene as a set of triangles with no textures.
+	*	@brief Renders the dirty tiles of shadow maps, i.e. those whose light changed or which cover a transformed model.
 	*	@param mModel Additional model matrix to be applied over the initial model matrix.
 	*	@param rendParams Rendering parameters to be taken into account.
 	*/
@@ -116,24 +104,6 @@ protected:
 	*/
 	virtual void drawSceneAsTriangles(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams);
 
-	/**
-	*	@brief Decides which objects are going to be rendered as a triangle mesh. Only the normal is calculated for each fragment.
-	*	@param shader Rendering shader which is drawing the scene.
-	*	@param shaderType Unique ID of "shader".
-	*	@param matrix Vector of matrices, including view, projection, etc.
-	*	@param rendParams Parameters which indicates how the scene is rendered.
-	*/
-	virtual void drawSceneAsTriangles4Normal(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams);
-
-	/**
-	*	@brief Decides which objects are going to be rendered as a triangle mesh. Only the position is calculated for each fragment.
-	*	@param shader Rendering shader which is drawing the scene.
-	*	@param shaderType Unique ID of "shader".
-	*	@param matrix Vector of matrices, including view, projection, etc.
-	*	@param rendParams Parameters which indicates how the scene is rendered.
-	*/
-	virtual void drawSceneAsTriangles4Position(RenderingShader* shader, RendEnum::RendShaderTypes shaderType, std::vector<mat4>* matrix, RenderingParameters* rendParams);
-
 	// --------------- SSAO -----------------
 	
 	/**
@@ -151,6 +121,12 @@ protected:
 	*/
 	void drawSSAOScene();
 
+	/**
+	*	@brief Builds the depth pyramid from the G-buffer which has just been rendered, so that the next frame can cull occluded components.
+	*	It is also built in the middle of the G-buffer pass, to test again the components culled with the depth of the previous frame.
+	*/
+	void buildHiZBuffer();
+
 	// --------------- Load ----------------
 
 	/**
@@ -0,0 +1,329 @@
+#include "stdafx.h"
+#include "ASCIIPointReader.h"
+
+#include <charconv>
+#include <filesystem>
+#include "Graphics/Core/PLYReader.h"
+#include "Utilities/MemoryMappedFile.h"
+
+// [Static members initialization]
+
+const unsigned ASCIIPointReader::BLOCKS_PER_THREAD = 8;
+const unsigned ASCIIPointReader::MAX_COLUMNS = 16;
+const std::vector<std::vector<std::string>> ASCIIPointReader::COLUMN_NAMES = { { "x" }, { "y" }, { "z" }, { "r", "red" }, { "g", "green" }, { "b", "blue" } };
+
+/// [Public methods]
+
+ASCIIPointReader::ASCIIPointReader() : _throughput(.0)
+{
+}
+
+double ASCIIPointReader::benchmark(const std::string& filename, const unsigned numRepetitions)
+{
+	ASCIIPointReader reader;
+	std::vector<PointModel> points;
+	AABB aabb;
+	double throughput = .0;
+
+	for (unsigned repetition = 0; repetition < numRepetitions; ++repetition)
+	{
+		if (!reader.read(filename, points, aabb)) return .0;
+
+		throughput += reader.getThroughput();
+	}
+
+	throughput /= std::max(numRepetitions, 1u);
+	std::cout << "ASCII parsing benchmark (" << filename << "): " << throughput << " MB/s" << std::endl;
+
+	return throughput;
+}
+
+bool ASCIIPointReader::read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	MemoryMappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+
+	const char* begin = reinterpret_cast<const char*>(file.data()), * end = begin + file.size();
+	size_t maxPoints = SIZE_MAX;
+	Layout layout;
+
+	std::string extension = std::filesystem::path(filename).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	if (extension == PLY_EXTENSION)
+	{
+		PLYReader::Header header;
+		std::istringstream headerStream(std::string(begin, std::min(file.size(), size_t(1 << 20))));
+
+		if (!PLYReader::readHeader(headerStream, header) || !header._ascii)
+		{
+			return false;
+		}
+
+		layout._numColumns = header._numColumns;
+		layout._hasColor = header._property[PLYReader::RED]._found && header._property[PLYReader::GREEN]._found && header._property[PLYReader::BLUE]._found;
+		for (unsigned propertyIdx = 0; propertyIdx < PLYReader::NUM_VERTEX_PROPERTIES; ++propertyIdx)
+		{
+			layout._column[propertyIdx] = header._property[propertyIdx]._column;
+		}
+
+		begin += header._dataOffset;
+		for (size_t lineIdx = 0; lineIdx < header._numPrecedingLines && begin < end; ++lineIdx)
+		{
+			begin = std::find(begin, end, '\n') + 1;
+		}
+		begin = std::min(begin, end);
+
+		maxPoints = header._numVertices;								// Elements after vertices (e.g. faces) are discarded
+	}
+	else if (!this->deduceLayout(begin, end, layout))
+	{
+		return false;
+	}
+
+	if (layout._numColumns > MAX_COLUMNS)
+	{
+		std::cerr << "Too many columns in ASCII point cloud: " << filename << std::endl;
+		return false;
+	}
+
+	// 1. Count lines of each block, which bound the number of points, so that the point vector is only resized once
+	std::vector<Block> blocks = this->splitBlocks(begin, end);
+
+	std::for_each(std::execution::par, blocks.begin(), blocks.end(), [](Block& block)
+		{
+			block._numLines = std::count(block._begin, block._end, '\n');
+			if (block._begin != block._end && *(block._end - 1) != '\n') ++block._numLines;
+		});
+
+	size_t numLines = 0;
+	for (const Block& block : blocks) numLines += block._numLines;
+
+	points.resize(std::min(numLines, maxPoints));
+
+	// Blocks are parsed in batches, so that read points can be consumed before the whole file is parsed
+	const size_t blocksPerBatch = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<AABB> blockAABB(blocks.size());
+	size_t numPoints = 0;
+
+	for (size_t firstBlock = 0; firstBlock < blocks.size() && numPoints < points.size(); firstBlock += blocksPerBatch)
+	{
+		const size_t lastBlock = std::min(firstBlock + blocksPerBatch, blocks.size()), firstPoint = numPoints;
+
+		// 2. Parse blocks into their own buffer, as comments and empty lines do not produce any point
+		std::for_each(std::execution::par, blocks.begin() + firstBlock, blocks.begin() + lastBlock, [&](Block& block)
+			{
+				const char* lineBegin = block._begin;
+				PointModel point;
+
+				block._points.reserve(block._numLines);
+
+				while (lineBegin < block._end)
+				{
+					const char* lineEnd = std::find(lineBegin, block._end, '\n');
+					if (this->parseLine(lineBegin, lineEnd, layout, point)) block._points.push_back(point);
+
+					lineBegin = lineEnd + 1;
+				}
+			});
+
+		// 3. Locate the points of each block. Parsed vertices are counted, since elements after them (e.g. faces) must be discarded
+		for (size_t blockIdx = firstBlock; blockIdx < lastBlock; ++blockIdx)
+		{
+			blocks[blockIdx]._firstPoint = numPoints;
+			blocks[blockIdx]._numPoints = std::min(blocks[blockIdx]._points.size(), points.size() - numPoints);
+			numPoints += blocks[blockIdx]._numPoints;
+		}
+
+		// 4. Move points to their final position, computing the bounding box of each block
+		std::for_each(std::execution::par, blocks.begin() + firstBlock, blocks.begin() + lastBlock, [&](Block& block)
+			{
+				std::copy(block._points.begin(), block._points.begin() + block._numPoints, points.begin() + block._firstPoint);
+				blockAABB[&block - blocks.data()] = this->computeBoundaries(points.data() + block._firstPoint, block._numPoints);
+
+				std::vector<PointModel>().swap(block._points);
+			});
+
+		if (!this->notifyChunk(firstPoint, numPoints - firstPoint, points.size()))
+		{
+			points.clear();
+			return false;
+		}
+	}
+
+	points.resize(numPoints);
+	aabb = this->mergeBoundaries(blockAABB);
+
+	const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+	_throughput = file.size() / (1024.0 * 1024.0) / std::max(seconds, 1e-9);
+
+	std::cout << "ASCII point cloud parsed at " << _throughput << " MB/s" << std::endl;
+
+	return numPoints > 0;
+}
+
+/// [Protected methods]
+
+bool ASCIIPointReader::deduceLayout(const char* begin, const char* end, Layout& layout)
+{
+	std::vector<std::string> columnNames;
+
+	auto isSeparator = [](const char character) { return character == ' ' || character == '\t' || character == ',' || character == ';' || character == '\r'; };
+
+	while (begin < end)
+	{
+		const char* lineEnd = std::find(begin, end, '\n');
+		unsigned numColumns = 0;
+		double value[MAX_COLUMNS];
+		bool numeric = true;
+
+		// Count numeric columns; PTS files start with a line containing only the number of points
+		for (const char* character = begin; character < lineEnd; )
+		{
+			while (character < lineEnd && isSeparator(*character)) ++character;
+			if (character >= lineEnd) break;
+
+			double columnValue;
+			const std::from_chars_result result = std::from_chars(character, lineEnd, columnValue);
+			if (result.ec != std::errc()) { numeric = false; break; }
+
+			if (numColumns < MAX_COLUMNS) value[numColumns] = columnValue;
+			character = result.ptr;
+			++numColumns;
+		}
+
+		if (!numeric)
+		{
+			// Header lines may name the columns, prefixed by comment characters
+			columnNames.clear();
+
+			for (const char* character = begin; character < lineEnd; )
+			{
+				while (character < lineEnd && (isSeparator(*character) || *character == '/' || *character == '#')) ++character;
+
+				const char* nameEnd = character;
+				while (nameEnd < lineEnd && !isSeparator(*nameEnd)) ++nameEnd;
+
+				if (nameEnd > character)
+				{
+					std::string name(character, nameEnd);
+					std::transform(name.begin(), name.end(), name.begin(), [](const char character) { return char(std::tolower(static_cast<unsigned char>(character))); });
+					columnNames.push_back(name);
+				}
+
+				character = nameEnd;
+			}
+		}
+		else if (numColumns >= 3)
+		{
+			layout._numColumns = numColumns;
+
+			if (columnNames.size() == numColumns && findColumns(columnNames, layout))
+			{
+				return true;
+			}
+
+			// x y z [intensity] [r g b]
+			layout._hasColor = numColumns >= 6 && numColumns <= MAX_COLUMNS;
+			for (unsigned coordIdx = 0; coordIdx < 3; ++coordIdx)
+			{
+				layout._column[coordIdx] = coordIdx;
+				layout._column[coordIdx + 3] = numColumns - 3 + coordIdx;
+
+				if (layout._hasColor)
+				{
+					const double color = value[numColumns - 3 + coordIdx];
+					layout._hasColor = color >= .0 && color <= 255.0 && color == std::floor(color);
+				}
+			}
+
+			return true;
+		}
+
+		begin = lineEnd + 1;
+	}
+
+	return false;
+}
+
+bool ASCIIPointReader::findColumns(const std::vector<std::string>& columnNames, Layout& layout)
+{
+	bool found[6] = { false, false, false, false, false, false };
+
+	for (unsigned propertyIdx = 0; propertyIdx < COLUMN_NAMES.size(); ++propertyIdx)
+	{
+		for (unsigned columnIdx = 0; columnIdx < columnNames.size() && !found[propertyIdx]; ++columnIdx)
+		{
+			const std::vector<std::string>& names = COLUMN_NAMES[propertyIdx];
+
+			if (std::find(names.begin(), names.end(), columnNames[columnIdx]) != names.end())
+			{
+				layout._column[propertyIdx] = columnIdx;
+				found[propertyIdx] = true;
+			}
+		}
+	}
+
+	layout._hasColor = found[3] && found[4] && found[5];
+	if (!layout._hasColor)
+	{
+		layout._column[3] = layout._column[4] = layout._column[5] = 0;
+	}
+
+	return found[0] && found[1] && found[2];
+}
+
+bool ASCIIPointReader::parseLine(const char* begin, const char* end, const Layout& layout, PointModel& point)
+{
+	double value[MAX_COLUMNS];
+	unsigned column = 0;
+
+	while (begin < end && column < layout._numColumns)
+	{
+		while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == ',' || *begin == ';' || *begin == '\r')) ++begin;
+		if (begin >= end || *begin == '#' || *begin == '/') break;
+		if (*begin == '+') ++begin;										// Not accepted by std::from_chars
+
+		const std::from_chars_result result = std::from_chars(begin, end, value[column]);
+		if (result.ec != std::errc()) return false;
+
+		begin = result.ptr;
+		++column;
+	}
+
+	if (column <= std::max({ layout._column[0], layout._column[1], layout._column[2] }) || (layout._hasColor && column < layout._numColumns))
+	{
+		return false;
+	}
+
+	point._point = vec3(value[layout._column[0]], value[layout._column[1]], value[layout._column[2]]);
+	point._rgb = layout._hasColor ? PointModel::getRGBColor(glm::clamp(vec3(value[layout._column[3]], value[layout._column[4]], value[layout._column[5]]), .0f, 255.0f)) : 
+									PointModel::getRGBColor(vec3(255.0f));
+
+	return true;
+}
+
+std::vector<ASCIIPointReader::Block> ASCIIPointReader::splitBlocks(const char* begin, const char* end)
+{
+	const size_t numBlocks = std::max(1u, std::thread::hardware_concurrency()) * BLOCKS_PER_THREAD;
+	const size_t blockSize = std::max(size_t(end - begin) / numBlocks, size_t(1));
+	std::vector<Block> blocks;
+	
+	while (begin < end)
+	{
+		// Blocks end right after a line break
+		const char* blockEnd = begin + std::min(blockSize, size_t(end - begin));
+		blockEnd = std::find(blockEnd, end, '\n');
+		if (blockEnd != end) ++blockEnd;
+
+		blocks.push_back(Block{ begin, blockEnd, 0, 0, 0 });
+		begin = blockEnd;
+	}
+
+	return blocks;
+}
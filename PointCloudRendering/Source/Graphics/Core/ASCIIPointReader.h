@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Graphics/Core/PointCloudReader.h"
+
+/**
+*	@file ASCIIPointReader.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Parallel reader of ASCII point clouds (XYZ, PTS and ASCII PLY). The mapped file is split into line-aligned blocks
+*	which are parsed with std::from_chars by different threads, and notified in batches.
+*/
+class ASCIIPointReader : public PointCloudReader
+{
+protected:
+	const static unsigned	BLOCKS_PER_THREAD;				//!< Number of blocks assigned to each thread, so that the workload is balanced
+	const static unsigned	MAX_COLUMNS;					//!< Maximum number of columns that are parsed from each line
+	const static std::vector<std::vector<std::string>> COLUMN_NAMES;	//!< Accepted names for x, y, z, red, green and blue in XYZ headers
+
+	struct Layout
+	{
+		unsigned	_numColumns;							//!< Number of columns of the data lines
+		unsigned	_column[6];								//!< Column of x, y, z, red, green and blue
+		bool		_hasColor;								//!< False if colors are not included in the file
+	};
+
+	struct Block
+	{
+		const char* _begin, * _end;							//!< Range of characters, starting and ending at line boundaries
+		size_t		_firstPoint;							//!< Index of the first point of the block within the read points
+		size_t		_numLines;								//!< Number of line breaks within the block
+		size_t		_numPoints;								//!< Number of valid points parsed from the block
+		std::vector<PointModel> _points;					//!< Points parsed from the block, before being moved to their final position
+	};
+
+protected:
+	double			_throughput;							//!< Throughput of the last read (MB/s)
+
+protected:
+	/**
+	*	@brief Deduces the layout of XYZ and PTS files from their first data line. Columns are located by name if the preceding 
+	*	line declares them (e.g. //X Y Z R G B Nx Ny Nz); otherwise, trailing columns are only taken as colors if they are 
+	*	integers within [0, 255], so that normals are not read as colors.
+	*	@return False if no valid line is found.
+	*/
+	static bool deduceLayout(const char* begin, const char* end, Layout& layout);
+
+	/**
+	*	@brief Locates x, y, z and color columns from a list of column names.
+	*	@return False if any coordinate is missing.
+	*/
+	static bool findColumns(const std::vector<std::string>& columnNames, Layout& layout);
+
+	/**
+	*	@brief Splits the data section in line-aligned blocks.
+	*/
+	static std::vector<Block> splitBlocks(const char* begin, const char* end);
+
+	/**
+	*	@brief Parses a single line into a point.
+	*	@return False if the line is empty, a comment or does not contain the expected columns.
+	*/
+	static bool parseLine(const char* begin, const char* end, const Layout& layout, PointModel& point);
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	ASCIIPointReader();
+
+	/**
+	*	@brief Reads the file several times, reporting the average throughput.
+	*	@return Throughput in MB/s, or zero if the file could not be read.
+	*/
+	static double benchmark(const std::string& filename, const unsigned numRepetitions = 5);
+
+	/**
+	*	@return Throughput of the last read (MB/s).
+	*/
+	double getThroughput() const { return _throughput; }
+
+	/**
+	*	@brief Reads an ASCII point cloud. Format is deduced from the extension: PLY files are expected to be ASCII, 
+	*	while XYZ, PTS and TXT files contain one point per line (x y z [intensity] [r g b]).
+	*/
+	virtual bool read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb);
+};
+
@@ -9,6 +9,9 @@
 #include "Utilities/ChronoUtilities.h"
 
 // Initialization of static attributes
+const char CADModel::BINARY_MAGIC[8] = { 'C', 'A', 'D', 'B', 'I', 'N', '\0', '\0' };
+const uint32_t CADModel::BINARY_VERSION = 2;
+
 std::unordered_map<std::string, std::unique_ptr<Material>> CADModel::_cadMaterials;
 std::unordered_map<std::string, std::unique_ptr<Texture>> CADModel::_cadTextures;
 
@@ -30,11 +33,11 @@ bool CADModel::load(const mat4& modelMatrix)
 {
 	if (!_loaded)
 	{
-		bool success = false, binaryExists = false;
+		bool success = false, binaryExists = false, binaryLoaded = false;
 
 		if (_useBinary && (binaryExists = std::filesystem::exists(_filename + BINARY_EXTENSION)))
 		{
-			success = this->loadModelFromBinaryFile();
+			success = binaryLoaded = this->loadModelFromBinaryFile();
 		}
 			
 		if (!success)
@@ -42,7 +45,7 @@ bool CADModel::load(const mat4& modelMatrix)
 			success = this->loadModelFromOBJ(modelMatrix);
 		}
 
-		if (!binaryExists && success)
+		if ((!binaryExists || (_useBinary && !binaryLoaded)) && success)				// Outdated binary files are replaced
 		{
 			this->writeToBinary();
 		}
@@ -72,10 +75,8 @@ void CADModel::computeMeshData(ModelComponent* modelComp)
 	shader->setUniform("restartPrimitiveIndex", Model3D::RESTART_PRIMITIVE_INDEX);
 	shader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
-	FaceGPUData* faceData = shader->readData(meshBufferID, FaceGPUData());
-	GLuint* rawMeshData = shader->readData(outBufferID, GLuint());
-	modelComp->_topology = std::move(std::vector<FaceGPUData>(faceData, faceData + arraySize));
-	modelComp->_triangleMesh = std::move(std::vector<GLuint>(rawMeshData, rawMeshData + arraySize * 4));
+	modelComp->_topology = ComputeShader::readData(meshBufferID, FaceGPUData(), arraySize);
+	modelComp->_triangleMesh = ComputeShader::readData(outBufferID, GLuint(), arraySize * 4);
 
 	glDeleteBuffers(1, &modelBufferID);
 	glDeleteBuffers(1, &meshBufferID);
@@ -180,11 +181,11 @@ void CADModel::generateGeometryTopology(Model3D::ModelComponent* modelComp, cons
 	if (modelComp->_material) modelComp->_material->applyMaterial4ComputeShader(shader);
 	shader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
-	VertexGPUData* data = shader->readData(modelBufferID, VertexGPUData());
-	modelComp->_geometry = std::move(std::vector<VertexGPUData>(data, data + arraySize));
+	modelComp->_geometry = ComputeShader::readData(modelBufferID, VertexGPUData(), arraySize);
 
 	this->computeTangents(modelComp);
 	this->computeMeshData(modelComp);
+	modelComp->buildMeshlets();
 
 	glDeleteBuffers(1, &modelBufferID);
 
@@ -293,7 +294,18 @@ bool CADModel::readBinary(const std::string& filename, const std::vector<Model3D
 		return false;
 	}
 
-	size_t numModelComps, numVertices, numTriangles, numIndices;
+	char magic[8];
+	uint32_t version = 0;
+	size_t numModelComps, numVertices, numTriangles, numIndices, numMeshlets;
+
+	fin.read(magic, sizeof(magic));
+	fin.read((char*)&version, sizeof(uint32_t));
+
+	if (!fin || std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) != 0 || version != BINARY_VERSION)
+	{
+		std::cout << "Outdated binary file: " << filename << std::endl;
+		return false;
+	}
 
 	fin.read((char*)&numModelComps, sizeof(size_t));
 	while (_modelComp.size() < numModelComps)
@@ -323,6 +335,10 @@ bool CADModel::readBinary(const std::string& filename, const std::vector<Model3D
 		model->_wireframe.resize(numIndices);
 		fin.read((char*)&model->_wireframe[0], numIndices * sizeof(GLuint));
 
+		fin.read((char*)&numMeshlets, sizeof(size_t));
+		model->_meshlet.resize(numMeshlets);
+		fin.read((char*)model->_meshlet.data(), numMeshlets * sizeof(Model3D::Meshlet));
+
 		fin.read((char*)&model->_modelDescription, sizeof(Model3D::ModelComponentDescription));
 	}
 
@@ -411,6 +427,7 @@ void CADModel::setVAOData(ModelComponent* modelComp)
 	modelComp->_topologyIndicesLength[RendEnum::IBO_POINT_CLOUD] = modelComp->_pointCloud.size();
 	modelComp->_topologyIndicesLength[RendEnum::IBO_WIREFRAME] = modelComp->_wireframe.size();
 	modelComp->_topologyIndicesLength[RendEnum::IBO_TRIANGLE_MESH] = modelComp->_triangleMesh.size();
+	modelComp->computeAABB();
 
 	vao->setVBOData(modelComp->_geometry);
 	vao->setIBOData(RendEnum::IBO_POINT_CLOUD, modelComp->_pointCloud);
@@ -430,6 +447,8 @@ bool CADModel::writeToBinary()
 
 	size_t numIndices;
 	const size_t numModelComps = _modelComp.size();
+	fout.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	fout.write((char*)&BINARY_VERSION, sizeof(uint32_t));
 	fout.write((char*)&numModelComps, sizeof(size_t));
 
 	for (Model3D::ModelComponent* model : _modelComp)
@@ -454,6 +473,10 @@ bool CADModel::writeToBinary()
 		fout.write((char*)&numIndices, sizeof(size_t));
 		fout.write((char*)&model->_wireframe[0], numIndices * sizeof(GLuint));
 
+		const size_t numMeshlets = model->_meshlet.size();
+		fout.write((char*)&numMeshlets, sizeof(size_t));
+		fout.write((char*)model->_meshlet.data(), numMeshlets * sizeof(Model3D::Meshlet));
+
 		fout.write((char*)&model->_modelDescription, sizeof(Model3D::ModelComponentDescription));
 	}
 
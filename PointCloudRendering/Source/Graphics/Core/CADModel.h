@@ -16,6 +16,10 @@
 */
 class CADModel: public Model3D
 {
+protected:
+	const static char		BINARY_MAGIC[8];				//!< Identifier of binary files
+	const static uint32_t	BINARY_VERSION;					//!< Current version of binary files, which are written again if outdated
+
 protected:
 	static std::unordered_map<std::string, std::unique_ptr<Material>> _cadMaterials;
 	static std::unordered_map<std::string, std::unique_ptr<Texture>> _cadTextures;
@@ -63,6 +67,7 @@ protected:
 
 	/**
 	*	@brief Loads the CAD model from a binary file, if possible.
+	*	@return False if the file cannot be read or its version is outdated.
 	*/
 	bool readBinary(const std::string& filename, const std::vector<Model3D::ModelComponent*>& modelComp);
 
@@ -153,6 +153,11 @@ public:
 	*/
 	float getFovY() const { return _fovY; }
 
+	/**
+	*	@return Type of projection.
+	*/
+	CameraTypes getCameraType() const { return _cameraType; }
+
 	/**
 	*	@return Height of screen (persp) or height of canonical view volume (ortho).
 	*/
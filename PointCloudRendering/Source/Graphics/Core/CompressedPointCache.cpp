@@ -0,0 +1,468 @@
+#include "stdafx.h"
+#include "CompressedPointCache.h"
+
+#include <atomic>
+#include "Utilities/MemoryMappedFile.h"
+
+// [Static members initialization]
+
+const char CompressedPointCache::CACHE_MAGIC[8] = { 'P', 'C', 'R', 'P', 'C', 'C', '\0', '\0' };
+const uint32_t CompressedPointCache::CACHE_VERSION = 1;
+const unsigned CompressedPointCache::NUM_PLANES = 11;
+const uint32_t CompressedPointCache::POINTS_PER_CHUNK = 1 << 16;
+const unsigned CompressedPointCache::RANS_PROBABILITY_BITS = 12;
+const uint32_t CompressedPointCache::RANS_LOWER_BOUND = 1 << 23;
+
+/// [Public methods]
+
+CompressedPointCache::CompressedPointCache() : _localOrigin(.0), _throughput(.0f)
+{
+}
+
+bool CompressedPointCache::read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	MemoryMappedFile mappedFile;
+
+	if (!mappedFile.open(filename, false))
+	{
+		return false;
+	}
+
+	Header header;
+	const uint8_t* data = mappedFile.data();
+
+	if (mappedFile.size() < sizeof(Header)) return false;
+	std::memcpy(&header, data, sizeof(Header));
+
+	if (std::memcmp(header._magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header._version != CACHE_VERSION || header._quantizationBits > 21 || !header._pointsPerChunk ||
+		header._numChunks != (header._numPoints + header._pointsPerChunk - 1) / header._pointsPerChunk || sizeof(Header) + header._numChunks * sizeof(Chunk) > mappedFile.size())
+	{
+		std::cerr << "Outdated compressed cache: " << filename << std::endl;
+		return false;
+	}
+
+	std::vector<Chunk> chunks(header._numChunks);
+	std::memcpy(chunks.data(), data + sizeof(Header), chunks.size() * sizeof(Chunk));
+
+	for (size_t chunkIdx = 0; chunkIdx < chunks.size(); ++chunkIdx)
+	{
+		const Chunk& chunk = chunks[chunkIdx];
+		const uint64_t expectedPoints = std::min(uint64_t(header._pointsPerChunk), header._numPoints - chunkIdx * header._pointsPerChunk);
+
+		if (chunk._offset + chunk._size > mappedFile.size() || chunk._numPoints != expectedPoints)
+		{
+			std::cerr << "Corrupted compressed cache: " << filename << std::endl;
+			return false;
+		}
+	}
+
+	points.resize(header._numPoints);
+
+	// Chunks are decompressed in batches, so that the loaded points can be consumed while the rest are decoded
+	const size_t chunksPerBatch = std::max(1u, std::thread::hardware_concurrency()) * 2;
+	std::atomic<bool> success(true);
+
+	for (size_t firstChunk = 0; firstChunk < chunks.size() && success; firstChunk += chunksPerBatch)
+	{
+		const size_t lastChunk = std::min(firstChunk + chunksPerBatch, chunks.size());
+		const size_t firstPoint = firstChunk * header._pointsPerChunk;
+		size_t lastPoint = firstPoint;
+
+		std::for_each(std::execution::par, chunks.begin() + firstChunk, chunks.begin() + lastChunk, [&](const Chunk& chunk)
+			{
+				const size_t chunkIdx = &chunk - chunks.data();
+
+				if (!decodeChunk(data + chunk._offset, chunk, header, points.data() + chunkIdx * header._pointsPerChunk)) success = false;
+			});
+
+		for (size_t chunkIdx = firstChunk; chunkIdx < lastChunk; ++chunkIdx) lastPoint += chunks[chunkIdx]._numPoints;
+
+		if (success && !this->notifyChunk(firstPoint, lastPoint - firstPoint, header._numPoints))
+		{
+			points.clear();
+			return false;
+		}
+	}
+
+	if (!success)
+	{
+		std::cerr << "Corrupted compressed cache: " << filename << std::endl;
+		points.clear();
+		return false;
+	}
+
+	aabb = AABB(header._minPoint, header._maxPoint);
+	_localOrigin = glm::dvec3(header._localOrigin[0], header._localOrigin[1], header._localOrigin[2]);
+
+	const float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - startTime).count();
+	_throughput = points.size() * sizeof(PointModel) / (1024.0f * 1024.0f) / std::max(seconds, 1e-6f);
+
+	std::cout << "Compressed cache decoded at " << _throughput << " MB/s (" << float(mappedFile.size()) / std::max(size_t(1), points.size()) << " bytes per point)" << std::endl;
+
+	return true;
+}
+
+bool CompressedPointCache::readHeader(const std::string& filename, Header& header)
+{
+	std::ifstream fin(filename, std::ios::in | std::ios::binary);
+
+	if (!fin.is_open() || !fin.read(reinterpret_cast<char*>(&header), sizeof(Header)))
+	{
+		return false;
+	}
+
+	return std::memcmp(header._magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header._version == CACHE_VERSION;
+}
+
+bool CompressedPointCache::write(const std::string& filename, const PointModel* points, const size_t numPoints, const AABB& aabb, const glm::dvec3& localOrigin, const unsigned quantizationBits)
+{
+	std::ofstream fout(filename, std::ios::out | std::ios::binary);
+	if (!fout.is_open())
+	{
+		return false;
+	}
+
+	Header header;
+	std::memset(&header, 0, sizeof(Header));
+	std::memcpy(header._magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header._version				= CACHE_VERSION;
+	header._quantizationBits	= std::min(std::max(quantizationBits, 1u), 21u);
+	header._numPoints			= numPoints;
+	header._numChunks			= (numPoints + POINTS_PER_CHUNK - 1) / POINTS_PER_CHUNK;
+	header._pointsPerChunk		= POINTS_PER_CHUNK;
+	header._minPoint			= numPoints ? aabb.min() : vec3(.0f);
+	header._maxPoint			= numPoints ? aabb.max() : vec3(.0f);
+	for (int axis = 0; axis < 3; ++axis) header._localOrigin[axis] = localOrigin[axis];
+
+	const float maxCell = float((1u << header._quantizationBits) - 1);
+	const vec3 size = header._maxPoint - header._minPoint;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		header._quantizationStep[axis] = size[axis] > .0f ? size[axis] / maxCell : 1.0f;
+	}
+
+	// Points are quantized and sorted along the Morton curve, so that consecutive codes (and colors) are similar
+	std::vector<uint64_t> codes(numPoints);
+	std::vector<size_t> order(numPoints);
+	std::iota(order.begin(), order.end(), size_t(0));
+
+	std::for_each(std::execution::par_unseq, order.begin(), order.end(), [&](const size_t pointIdx)
+		{
+			const vec3 cell = (points[pointIdx]._point - header._minPoint) / header._quantizationStep;
+			const uvec3 position(std::min(std::max(std::round(cell.x), .0f), maxCell), std::min(std::max(std::round(cell.y), .0f), maxCell), std::min(std::max(std::round(cell.z), .0f), maxCell));
+
+			codes[pointIdx] = encodeMorton(position);
+		});
+
+	std::sort(std::execution::par_unseq, order.begin(), order.end(), [&codes](const size_t a, const size_t b) { return codes[a] < codes[b]; });
+
+	std::vector<Chunk> chunks(header._numChunks);
+	std::vector<std::vector<uint8_t>> chunkData(header._numChunks);
+
+	std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](Chunk& chunk)
+		{
+			const size_t chunkIdx = &chunk - chunks.data(), firstPoint = chunkIdx * POINTS_PER_CHUNK;
+
+			chunk._numPoints = uint32_t(std::min(size_t(POINTS_PER_CHUNK), numPoints - firstPoint));
+			chunk._firstCode = codes[order[firstPoint]];
+			encodeChunk(points, codes.data(), order.data() + firstPoint, chunk._numPoints, chunkData[chunkIdx]);
+			chunk._size = uint32_t(chunkData[chunkIdx].size());
+		});
+
+	uint64_t offset = sizeof(Header) + chunks.size() * sizeof(Chunk);
+	for (Chunk& chunk : chunks)
+	{
+		chunk._offset = offset;
+		offset += chunk._size;
+	}
+
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	fout.write(reinterpret_cast<const char*>(chunks.data()), chunks.size() * sizeof(Chunk));
+	for (const std::vector<uint8_t>& data : chunkData) fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+	const bool success = bool(fout);
+	fout.close();
+
+	std::cout << "Compressed cache written with " << float(offset) / std::max(size_t(1), numPoints) << " bytes per point" << std::endl;
+
+	return success;
+}
+
+/// [Protected methods]
+
+const uint8_t* CompressedPointCache::decodePlane(const uint8_t* data, const uint8_t* end, const size_t numValues, uint8_t* plane)
+{
+	if (data >= end) return nullptr;
+
+	const PlaneMode mode = PlaneMode(*data++);
+
+	if (mode == CONSTANT_PLANE)
+	{
+		if (data >= end) return nullptr;
+		std::memset(plane, *data, numValues);
+
+		return data + 1;
+	}
+
+	if (mode == RAW_PLANE)
+	{
+		if (data + numValues > end) return nullptr;
+		std::memcpy(plane, data, numValues);
+
+		return data + numValues;
+	}
+
+	if (mode != RANS_PLANE || data + sizeof(uint16_t) > end) return nullptr;
+
+	// Frequency table: number of symbols, and then (symbol, frequency) pairs
+	const uint32_t probabilityScale = 1 << RANS_PROBABILITY_BITS;
+	uint32_t frequency[256] = { 0 }, start[256] = { 0 };
+	uint8_t symbolOfSlot[1 << RANS_PROBABILITY_BITS];
+	uint16_t numSymbols;
+	uint32_t encodedSize, accumFrequency = 0;
+
+	std::memcpy(&numSymbols, data, sizeof(uint16_t));
+	data += sizeof(uint16_t);
+	if (numSymbols > 256 || data + numSymbols * 3 + sizeof(uint32_t) > end) return nullptr;
+
+	for (uint16_t symbolIdx = 0; symbolIdx < numSymbols; ++symbolIdx, data += 3)
+	{
+		const uint8_t symbol = data[0];
+		uint16_t symbolFrequency;
+		std::memcpy(&symbolFrequency, data + 1, sizeof(uint16_t));
+
+		if (accumFrequency + symbolFrequency > probabilityScale) return nullptr;
+
+		frequency[symbol] = symbolFrequency;
+		start[symbol] = accumFrequency;
+		std::memset(symbolOfSlot + accumFrequency, symbol, symbolFrequency);
+		accumFrequency += symbolFrequency;
+	}
+
+	std::memcpy(&encodedSize, data, sizeof(uint32_t));
+	data += sizeof(uint32_t);
+	if (accumFrequency != probabilityScale || encodedSize < 4 || data + encodedSize > end) return nullptr;
+
+	const uint8_t* cursor = data, *encodedEnd = data + encodedSize;
+	uint32_t state = uint32_t(cursor[0]) | uint32_t(cursor[1]) << 8 | uint32_t(cursor[2]) << 16 | uint32_t(cursor[3]) << 24;
+	cursor += 4;
+
+	for (size_t valueIdx = 0; valueIdx < numValues; ++valueIdx)
+	{
+		const uint32_t slot = state & (probabilityScale - 1);
+		const uint8_t symbol = symbolOfSlot[slot];
+
+		plane[valueIdx] = symbol;
+		state = frequency[symbol] * (state >> RANS_PROBABILITY_BITS) + slot - start[symbol];
+
+		while (state < RANS_LOWER_BOUND && cursor < encodedEnd) state = (state << 8) | *cursor++;
+	}
+
+	return encodedEnd;
+}
+
+bool CompressedPointCache::decodeChunk(const uint8_t* data, const Chunk& chunk, const Header& header, PointModel* points)
+{
+	const size_t numPoints = chunk._numPoints;
+	const uint8_t* end = data + chunk._size;
+	std::vector<uint8_t> planes(NUM_PLANES * numPoints);
+
+	for (unsigned planeIdx = 0; planeIdx < NUM_PLANES && data; ++planeIdx)
+	{
+		data = decodePlane(data, end, numPoints, planes.data() + planeIdx * numPoints);
+	}
+
+	if (!data) return false;
+
+	const uint8_t* colorPlane = planes.data() + 8 * numPoints;
+	uint64_t code = chunk._firstCode;
+	uint8_t rgb[3] = { 0, 0, 0 };
+
+	for (size_t pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+	{
+		uint64_t delta = 0;
+		for (unsigned byte = 0; byte < 8; ++byte) delta |= uint64_t(planes[byte * numPoints + pointIdx]) << (byte * 8);
+		code += delta;
+
+		// Color deltas are stored in zigzag order, so that small negative values become small bytes
+		for (unsigned channel = 0; channel < 3; ++channel)
+		{
+			const uint8_t zigzag = colorPlane[channel * numPoints + pointIdx];
+			rgb[channel] += uint8_t((zigzag >> 1) ^ -(zigzag & 1));
+		}
+
+		const uvec3 position = decodeMorton(code);
+		points[pointIdx]._point = header._minPoint + vec3(position) * header._quantizationStep;
+		points[pointIdx]._rgb = uint32_t(rgb[0]) | uint32_t(rgb[1]) << 8 | uint32_t(rgb[2]) << 16;
+	}
+
+	return true;
+}
+
+void CompressedPointCache::encodePlane(const uint8_t* plane, const size_t numValues, std::vector<uint8_t>& data)
+{
+	std::vector<uint32_t> histogram(256, 0), frequency;
+	for (size_t valueIdx = 0; valueIdx < numValues; ++valueIdx) ++histogram[plane[valueIdx]];
+
+	const uint16_t numSymbols = uint16_t(std::count_if(histogram.begin(), histogram.end(), [](const uint32_t count) { return count > 0; }));
+
+	if (numSymbols == 1)
+	{
+		data.push_back(CONSTANT_PLANE);
+		data.push_back(plane[0]);
+		return;
+	}
+
+	normalizeFrequencies(histogram, numValues, frequency);
+
+	uint32_t start[256], accumFrequency = 0;
+	for (unsigned symbol = 0; symbol < 256; ++symbol)
+	{
+		start[symbol] = accumFrequency;
+		accumFrequency += frequency[symbol];
+	}
+
+	// rANS emits bytes backwards, so the buffer is filled from its end
+	std::vector<uint8_t> encoded(numValues + numValues / 2 + 16);
+	uint8_t* cursor = encoded.data() + encoded.size(), *begin = encoded.data() + 4;
+	uint32_t state = RANS_LOWER_BOUND;
+	bool overflow = false;
+
+	for (size_t valueIdx = numValues; valueIdx-- > 0 && !overflow; )
+	{
+		const uint8_t symbol = plane[valueIdx];
+		const uint32_t maxState = ((RANS_LOWER_BOUND >> RANS_PROBABILITY_BITS) << 8) * frequency[symbol];
+
+		while (state >= maxState)
+		{
+			if (cursor == begin) { overflow = true; break; }
+
+			*--cursor = uint8_t(state & 0xFF);
+			state >>= 8;
+		}
+
+		state = ((state / frequency[symbol]) << RANS_PROBABILITY_BITS) + (state % frequency[symbol]) + start[symbol];
+	}
+
+	cursor -= 4;
+	for (int byte = 0; byte < 4; ++byte) cursor[byte] = uint8_t(state >> (byte * 8));
+
+	const uint32_t encodedSize = uint32_t(encoded.data() + encoded.size() - cursor);
+	const size_t ransSize = sizeof(uint16_t) + numSymbols * 3 + sizeof(uint32_t) + encodedSize;
+
+	if (overflow || ransSize >= numValues)
+	{
+		data.push_back(RAW_PLANE);
+		data.insert(data.end(), plane, plane + numValues);
+		return;
+	}
+
+	data.push_back(RANS_PLANE);
+	data.insert(data.end(), reinterpret_cast<const uint8_t*>(&numSymbols), reinterpret_cast<const uint8_t*>(&numSymbols) + sizeof(uint16_t));
+
+	for (unsigned symbol = 0; symbol < 256; ++symbol)
+	{
+		if (!frequency[symbol]) continue;
+
+		const uint16_t symbolFrequency = uint16_t(frequency[symbol]);
+		data.push_back(uint8_t(symbol));
+		data.insert(data.end(), reinterpret_cast<const uint8_t*>(&symbolFrequency), reinterpret_cast<const uint8_t*>(&symbolFrequency) + sizeof(uint16_t));
+	}
+
+	data.insert(data.end(), reinterpret_cast<const uint8_t*>(&encodedSize), reinterpret_cast<const uint8_t*>(&encodedSize) + sizeof(uint32_t));
+	data.insert(data.end(), cursor, cursor + encodedSize);
+}
+
+void CompressedPointCache::encodeChunk(const PointModel* points, const uint64_t* codes, const size_t* order, const size_t numPoints, std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> planes(NUM_PLANES * numPoints);
+	uint8_t* colorPlane = planes.data() + 8 * numPoints;
+	uint64_t previousCode = codes[order[0]];
+	uint32_t previousRGB = 0;
+
+	for (size_t pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+	{
+		const uint64_t code = codes[order[pointIdx]], delta = code - previousCode;
+		const uint32_t rgb = points[order[pointIdx]]._rgb;
+
+		for (unsigned byte = 0; byte < 8; ++byte) planes[byte * numPoints + pointIdx] = uint8_t(delta >> (byte * 8));
+
+		for (unsigned channel = 0; channel < 3; ++channel)
+		{
+			const int8_t colorDelta = int8_t(uint8_t(rgb >> (channel * 8)) - uint8_t(previousRGB >> (channel * 8)));
+			colorPlane[channel * numPoints + pointIdx] = uint8_t((uint8_t(colorDelta) << 1) ^ uint8_t(colorDelta >> 7));
+		}
+
+		previousCode = code;
+		previousRGB = rgb;
+	}
+
+	for (unsigned planeIdx = 0; planeIdx < NUM_PLANES; ++planeIdx)
+	{
+		encodePlane(planes.data() + planeIdx * numPoints, numPoints, data);
+	}
+}
+
+void CompressedPointCache::normalizeFrequencies(const std::vector<uint32_t>& histogram, const size_t numValues, std::vector<uint32_t>& frequency)
+{
+	const int64_t probabilityScale = 1 << RANS_PROBABILITY_BITS;
+	int64_t sum = 0;
+
+	frequency.assign(256, 0);
+
+	for (unsigned symbol = 0; symbol < 256; ++symbol)
+	{
+		if (!histogram[symbol]) continue;
+
+		frequency[symbol] = std::max(uint32_t(1), uint32_t(uint64_t(histogram[symbol]) * probabilityScale / numValues));
+		sum += frequency[symbol];
+	}
+
+	// Rounding errors are compensated by the most frequent symbols, which never drop below one
+	while (sum != probabilityScale)
+	{
+		const unsigned symbol = unsigned(std::max_element(frequency.begin(), frequency.end()) - frequency.begin());
+		const int64_t change = sum < probabilityScale ? probabilityScale - sum : -std::min(int64_t(frequency[symbol]) - 1, sum - probabilityScale);
+
+		if (change == 0) break;
+
+		frequency[symbol] = uint32_t(frequency[symbol] + change);
+		sum += change;
+	}
+}
+
+uint64_t CompressedPointCache::encodeMorton(const uvec3& position)
+{
+	auto expandBits = [](uint64_t value) -> uint64_t
+	{
+		value &= 0x1FFFFF;
+		value = (value | value << 32) & 0x1F00000000FFFFull;
+		value = (value | value << 16) & 0x1F0000FF0000FFull;
+		value = (value | value << 8) & 0x100F00F00F00F00Full;
+		value = (value | value << 4) & 0x10C30C30C30C30C3ull;
+		value = (value | value << 2) & 0x1249249249249249ull;
+
+		return value;
+	};
+
+	return expandBits(position.x) | expandBits(position.y) << 1 | expandBits(position.z) << 2;
+}
+
+uvec3 CompressedPointCache::decodeMorton(const uint64_t code)
+{
+	auto compactBits = [](uint64_t value) -> unsigned
+	{
+		value &= 0x1249249249249249ull;
+		value = (value ^ (value >> 2)) & 0x10C30C30C30C30C3ull;
+		value = (value ^ (value >> 4)) & 0x100F00F00F00F00Full;
+		value = (value ^ (value >> 8)) & 0x1F0000FF0000FFull;
+		value = (value ^ (value >> 16)) & 0x1F00000000FFFFull;
+		value = (value ^ (value >> 32)) & 0x1FFFFF;
+
+		return unsigned(value);
+	};
+
+	return uvec3(compactBits(code), compactBits(code >> 1), compactBits(code >> 2));
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Graphics/Core/PointCloudReader.h"
+
+/**
+*	@file CompressedPointCache.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Compressed alternative to raw binary point clouds. Positions are quantized on a global grid and sorted by their Morton code;
+*	points are then split into chunks which store the deltas between consecutive codes and colors as byte planes, each of them coded
+*	with rANS. Chunks are independent, so they are decompressed in parallel straight into the destination array.
+*/
+class CompressedPointCache : public PointCloudReader
+{
+public:
+	struct Header
+	{
+		char		_magic[8];						//!< CACHE_MAGIC
+		uint32_t	_version;						//!< CACHE_VERSION
+		uint32_t	_quantizationBits;				//!< Bits of each quantized coordinate
+		uint64_t	_numPoints;						//!< Number of stored points
+		uint64_t	_numChunks;						//!< Number of chunks, whose table follows the header
+		vec3		_minPoint;						//!< Minimum corner of the point cloud AABB, i.e. origin of the quantization grid
+		uint32_t	_pointsPerChunk;				//!< Number of points of each chunk but the last one
+		vec3		_maxPoint;						//!< Maximum corner of the point cloud AABB
+		uint32_t	_reserved;						//!< Padding
+		vec3		_quantizationStep;				//!< Size of a grid cell
+		uint32_t	_reserved2;						//!< Padding
+		double		_localOrigin[3];				//!< Origin of the point coordinates
+	};
+
+	struct Chunk
+	{
+		uint64_t	_offset;						//!< Offset of the compressed chunk from the beginning of the file
+		uint64_t	_firstCode;						//!< Morton code of the first point
+		uint32_t	_size;							//!< Size of the compressed chunk (bytes)
+		uint32_t	_numPoints;						//!< Number of points of the chunk
+	};
+
+protected:
+	enum PlaneMode : uint8_t
+	{
+		CONSTANT_PLANE, RAW_PLANE, RANS_PLANE
+	};
+
+	const static char		CACHE_MAGIC[8];					//!< Identifier of compressed caches
+	const static uint32_t	CACHE_VERSION;					//!< Current version of the format
+	const static unsigned	NUM_PLANES;						//!< Byte planes of each chunk: 8 for code deltas and 3 for color deltas
+	const static uint32_t	POINTS_PER_CHUNK;				//!< Default number of points of each chunk
+	const static unsigned	RANS_PROBABILITY_BITS;			//!< Precision of symbol frequencies
+	const static uint32_t	RANS_LOWER_BOUND;				//!< Lower bound of the rANS state
+
+protected:
+	glm::dvec3				_localOrigin;					//!< Origin of the last read points
+	float					_throughput;					//!< Decompression speed of the last read (MB/s of raw points)
+
+protected:
+	/**
+	*	@brief Decodes a byte plane.
+	*	@return Pointer to the next plane, or nullptr if the chunk is corrupted.
+	*/
+	static const uint8_t* decodePlane(const uint8_t* data, const uint8_t* end, const size_t numValues, uint8_t* plane);
+
+	/**
+	*	@brief Decompresses a chunk into the point array.
+	*/
+	static bool decodeChunk(const uint8_t* data, const Chunk& chunk, const Header& header, PointModel* points);
+
+	/**
+	*	@brief Appends a byte plane to a compressed chunk, choosing the smallest of the available codings.
+	*/
+	static void encodePlane(const uint8_t* plane, const size_t numValues, std::vector<uint8_t>& data);
+
+	/**
+	*	@brief Compresses a range of points sorted by their Morton code.
+	*/
+	static void encodeChunk(const PointModel* points, const uint64_t* codes, const size_t* order, const size_t numPoints, std::vector<uint8_t>& data);
+
+	/**
+	*	@brief Scales the histogram of a plane so that frequencies sum 1 << RANS_PROBABILITY_BITS.
+	*/
+	static void normalizeFrequencies(const std::vector<uint32_t>& histogram, const size_t numValues, std::vector<uint32_t>& frequency);
+
+	/**
+	*	@return Morton code of a quantized position, interleaving 21 bits per axis.
+	*/
+	static uint64_t encodeMorton(const uvec3& position);
+
+	/**
+	*	@return Quantized position from a Morton code.
+	*/
+	static uvec3 decodeMorton(const uint64_t code);
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	CompressedPointCache();
+
+	/**
+	*	@return Origin that must be added to the points to obtain their original coordinates.
+	*/
+	glm::dvec3 getLocalOrigin() const { return _localOrigin; }
+
+	/**
+	*	@return Decompression speed of the last read (MB/s of raw points).
+	*/
+	float getThroughput() const { return _throughput; }
+
+	/**
+	*	@brief Reads a compressed cache. Points are given in Morton order.
+	*/
+	virtual bool read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb);
+
+	/**
+	*	@brief Reads the header of a compressed cache.
+	*	@return False if the file cannot be read or its version is outdated.
+	*/
+	static bool readHeader(const std::string& filename, Header& header);
+
+	/**
+	*	@brief Writes a compressed cache.
+	*	@param quantizationBits Bits of each quantized coordinate, up to 21.
+	*	@return Success of the writing process.
+	*/
+	static bool write(const std::string& filename, const PointModel* points, const size_t numPoints, const AABB& aabb, const glm::dvec3& localOrigin, const unsigned quantizationBits);
+};
+
@@ -0,0 +1,70 @@
+#include "stdafx.h"
+#include "ComputeCommandList.h"
+
+/// [Public methods]
+
+ComputeCommandList::ComputeCommandList()
+{
+}
+
+ComputeCommandList::~ComputeCommandList()
+{
+}
+
+void ComputeCommandList::clear()
+{
+	_commands.clear();
+}
+
+void ComputeCommandList::dispatch(ComputeShader* shader, const std::vector<GLuint>& buffers, const uvec3& numGroups, const uvec3& workGroupSize, const int section)
+{
+	Command command;
+	command._shader			= shader;
+	command._buffers		= buffers;
+	command._numGroups		= numGroups;
+	command._workGroupSize	= workGroupSize;
+	command._section		= section;
+
+	_commands.push_back(std::move(command));
+}
+
+void ComputeCommandList::execute(const std::vector<bool>& enabledSections) const
+{
+	ComputeShader* activeShader = nullptr;
+
+	for (const Command& command : _commands)
+	{
+		if (command._section >= 0 && size_t(command._section) < enabledSections.size() && !enabledSections[command._section])
+		{
+			continue;
+		}
+
+		if (command._shader != activeShader)
+		{
+			command._shader->use();
+			activeShader = command._shader;
+		}
+
+		command._shader->bindBuffers(command._buffers);
+		for (const auto& uniform : command._uniforms) glUniform1ui(uniform.first, uniform.second);
+
+		command._shader->execute(command._numGroups.x, command._numGroups.y, command._numGroups.z, command._workGroupSize.x, command._workGroupSize.y, command._workGroupSize.z);
+	}
+}
+
+bool ComputeCommandList::setUniform(const std::string& name, const GLuint value)
+{
+	if (_commands.empty()) return false;
+
+	const GLint location = _commands.back()._shader->getUniformLocation(name);
+
+	if (location < 0)
+	{
+		std::cout << "Cannot find localization for: " << name << std::endl;
+		return false;
+	}
+
+	_commands.back()._uniforms.emplace_back(location, value);
+
+	return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Graphics/Core/ComputeShader.h"
+
+/**
+*	@file ComputeCommandList.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Sequence of compute dispatches which is recorded once and replayed every frame. Shaders, bound buffers, uniform locations
+*	and group counts are resolved when recording, so that a replay only switches programs when needed, binds buffers, sets
+*	unsigned uniforms and dispatches. Commands may belong to a section (e.g. a chunk of points) which can be skipped on each replay.
+*/
+class ComputeCommandList
+{
+protected:
+	struct Command
+	{
+		ComputeShader*							_shader;				//!< Program of the dispatch
+		std::vector<GLuint>						_buffers;				//!< Storage buffers bound to consecutive binding points
+		std::vector<std::pair<GLint, GLuint>>	_uniforms;				//!< Location and value of unsigned uniforms
+		uvec3									_numGroups;				//!< Number of work groups
+		uvec3									_workGroupSize;			//!< Size of each work group
+		int										_section;				//!< Section of the command, or -1 if it is always executed
+	};
+
+protected:
+	std::vector<Command>	_commands;								//!< Recorded dispatches, in order
+
+public:
+	/**
+	*	@brief Constructor of an empty list.
+	*/
+	ComputeCommandList();
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~ComputeCommandList();
+
+	/**
+	*	@brief Removes every command, e.g. once the recorded buffers or shaders are no longer valid.
+	*/
+	void clear();
+
+	/**
+	*	@brief Records a dispatch. Buffers are bound to binding points 0, 1, ... as in ComputeShader::bindBuffers.
+	*	@param section Section which the command belongs to, or -1 if it must always be executed.
+	*/
+	void dispatch(ComputeShader* shader, const std::vector<GLuint>& buffers, const uvec3& numGroups, const uvec3& workGroupSize, const int section = -1);
+
+	/**
+	*	@brief Replays every command in order.
+	*	@param enabledSections Flag of each section. Sections beyond the size of the vector are executed.
+	*/
+	void execute(const std::vector<bool>& enabledSections = std::vector<bool>()) const;
+
+	/**
+	*	@brief Records the value of an unsigned uniform for the last recorded dispatch.
+	*	@return False if there is no dispatch or its shader does not use the uniform.
+	*/
+	bool setUniform(const std::string& name, const GLuint value);
+
+	/**
+	*	@return Number of recorded dispatches.
+	*/
+	size_t getNumCommands() const { return _commands.size(); }
+
+	/**
+	*	@return True if no command has been recorded.
+	*/
+	bool isEmpty() const { return _commands.empty(); }
+};
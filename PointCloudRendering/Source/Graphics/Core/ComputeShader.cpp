@@ -1,14 +1,22 @@
 #include "stdafx.h"
 #include "ComputeShader.h"
 
+#include <regex>
+
 /// [Static members initialization]
 
 std::vector<GLint> ComputeShader::MAX_WORK_GROUP_SIZE = { 1024, 1024, 64 };					//!< That value can't be queried before OpenGL is ready
 
+std::vector<GLuint> ComputeShader::_boundBuffers;
+std::unordered_set<GLuint> ComputeShader::_pendingWrites;
+std::unordered_set<GLuint> ComputeShader::_pendingReads;
+bool ComputeShader::_hazardTracking = true;
+ComputeShader::BarrierStatistics ComputeShader::_barrierStatistics = { 0, 0, 0, 0 };
+
 
 /// [Public methods]
 
-ComputeShader::ComputeShader(): ShaderProgram()
+ComputeShader::ComputeShader(): ShaderProgram(), _knownAccess(false), _writesImages(true), _localSize(0)
 {
 }
 
@@ -23,61 +31,85 @@ void ComputeShader::applyActiveSubroutines()
 
 void ComputeShader::bindBuffers(const std::vector<GLuint>& bufferID)
 {
+	if (_boundBuffers.size() < bufferID.size()) _boundBuffers.resize(bufferID.size(), 0);
+
 	for (unsigned i = 0; i < bufferID.size(); ++i)
 	{
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, bufferID[i]);
+		_boundBuffers[i] = bufferID[i];
 	}
 }
 
 GLuint ComputeShader::createShaderProgram(const char* filename)
 {
-	if (_handler <= 0) 
-	{										// Shader identifier
-		_handler = glCreateProgram();
-
-		if (_handler == 0) 
-		{
-			fprintf(stderr, "Cannot create shader program: %s!\n", filename);
-			return 0;
-		}
+	if (!this->submitShaderProgram(filename))
+	{
+		return 0;
 	}
 
-	char fileNameComplete[256];
-	strcpy_s(fileNameComplete, filename);
-	strcat_s(fileNameComplete, "-comp.glsl");
-	const GLuint vertexShaderObject = compileShader(fileNameComplete, GL_COMPUTE_SHADER);
-	if (vertexShaderObject == 0) 
+	return this->finishShaderProgram(filename);
+}
+
+void ComputeShader::execute(GLuint numGroups_x, GLuint numGroups_y, GLuint numGroups_z, GLuint workGroup_x, GLuint workGroup_y, GLuint workGroup_z)
+{
+	++_barrierStatistics._numDispatches;
+
+	if (!_hazardTracking)
 	{
-		return 0;
+		this->dispatch(numGroups_x, numGroups_y, numGroups_z, workGroup_x, workGroup_y, workGroup_z);
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		++_barrierStatistics._numBarriers;
+
+		return;
 	}
 
-	glAttachShader(_handler, vertexShaderObject);				// Link shader program and compute shader
-	glLinkProgram(_handler);									// Link shader program to check errors
-	GLint linkSuccess = 0;
-	glGetProgramiv(_handler, GL_LINK_STATUS, &linkSuccess);
+	// Read-after-write and write-after-write hazards: previous shader writes must be visible before this dispatch accesses the same buffer.
+	// Write-after-read hazards: previous dispatches must have read a buffer before this one overwrites it
+	bool hazard = false;
 
-	if (linkSuccess == GL_FALSE)
+	for (unsigned binding = 0; binding < _boundBuffers.size() && !hazard; ++binding)
 	{
-		GLint logLen = 0;
-		glGetProgramiv(_handler, GL_INFO_LOG_LENGTH, &logLen);
+		const GLuint buffer = _boundBuffers[binding];
+		const uint8_t access = this->getBufferAccess(binding);
 
-		if (logLen > 0) 
-		{
-			char* cLogString = new char[logLen];
-			GLint written = 0;
-			
-			glGetProgramInfoLog(_handler, logLen, &written, cLogString);
-			_logString.assign(cLogString);
-			delete[] cLogString;
-
-			std::cout << "Cannot link shader " << filename << ":" << std::endl << _logString << std::endl;
-		}
+		hazard = buffer && ((access && _pendingWrites.count(buffer)) || ((access & BUFFER_WRITE) && _pendingReads.count(buffer)));
+	}
 
-		return 0;
+	if (hazard)
+	{
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		_pendingWrites.clear();
+		_pendingReads.clear();
+		++_barrierStatistics._numBarriers;
 	}
 	else
 	{
-		_linked = true;
+		++_barrierStatistics._numSkippedBarriers;
+	}
+
+	this->dispatch(numGroups_x, numGroups_y, numGroups_z, workGroup_x, workGroup_y, workGroup_z);
+
+	for (unsigned binding = 0; binding < _boundBuffers.size(); ++binding)
+	{
+		if (!_boundBuffers[binding]) continue;
+
+		if (this->getBufferAccess(binding) & BUFFER_WRITE) _pendingWrites.insert(_boundBuffers[binding]);
+		if (this->getBufferAccess(binding) & BUFFER_READ) _pendingReads.insert(_boundBuffers[binding]);
+	}
+
+	// Images are consumed by draw calls and texture transfers, which are not tracked
+	if (_writesImages)
+	{
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+		++_barrierStatistics._numBarriers;
+	}
+}
+
+GLuint ComputeShader::finishShaderProgram(const char* filename)
+{
+	if (!this->finishLink(filename))
+	{
+		return 0;
 	}
 
 	// Reserve space for subroutines
@@ -87,13 +119,16 @@ GLuint ComputeShader::createShaderProgram(const char* filename)
 	_activeSubroutineUniform[COMPUTE_SHADER].resize(numSubroutines);
 	std::fill(_activeSubroutineUniform[COMPUTE_SHADER].begin(), _activeSubroutineUniform[COMPUTE_SHADER].end(), -1);		// Non valid id
 
-	return _handler;
-}
+	// Work group size can only be queried if it is fixed
+	if (_defines.find("LOCAL_SIZE_X") != _defines.end())
+	{
+		GLint localSize[3];
 
-void ComputeShader::execute(GLuint numGroups_x, GLuint numGroups_y, GLuint numGroups_z, GLuint workGroup_x, GLuint workGroup_y, GLuint workGroup_z)
-{
-	glDispatchComputeGroupSizeARB(numGroups_x, numGroups_y, numGroups_z, workGroup_x, workGroup_y, workGroup_z);											
-	glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		glGetProgramiv(_handler, GL_COMPUTE_WORK_GROUP_SIZE, localSize);
+		_localSize = uvec3(localSize[0], localSize[1], localSize[2]);
+	}
+
+	return _handler;
 }
 
 std::vector<GLint> ComputeShader::getMaxLocalSize()
@@ -122,8 +157,295 @@ void ComputeShader::initializeMaxGroupSize()
 	ComputeShader::MAX_WORK_GROUP_SIZE = getMaxLocalSize();
 }
 
+void ComputeShader::resetBarrierStatistics()
+{
+	_barrierStatistics = { 0, 0, 0, 0 };
+}
+
+void ComputeShader::setHazardTracking(const bool enable)
+{
+	if (_hazardTracking && !enable && !_pendingWrites.empty())
+	{
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+	}
+
+	_hazardTracking = enable;
+	_pendingWrites.clear();
+	_pendingReads.clear();
+}
+
+void ComputeShader::synchronizeBuffer(const GLuint bufferID, const GLbitfield barrierBits)
+{
+	if (_hazardTracking && !_pendingWrites.count(bufferID)) return;
+
+	// The buffer is kept as pending, since these bits do not make its content visible to later shaders
+	glMemoryBarrier(barrierBits);
+	++_barrierStatistics._numBarriers;
+}
+
+void ComputeShader::synchronizeDraw()
+{
+	// Without hazard tracking, every dispatch is already followed by a full barrier
+	if (!_hazardTracking || _pendingWrites.empty()) return;
+
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	_pendingWrites.clear();
+	_pendingReads.clear();
+	++_barrierStatistics._numBarriers;
+	++_barrierStatistics._numDrawBarriers;
+}
+
 void ComputeShader::setImageUniform(const GLint id, const std::string& shaderVariable)
 {
-	int location = glGetUniformLocation(_handler, shaderVariable.c_str());
+	const GLint location = this->getUniformLocation(shaderVariable);
 	glProgramUniform1i(_handler, location, id);
-}
\ No newline at end of file
+}
+
+bool ComputeShader::submitShaderProgram(const char* filename)
+{
+	if (_handler <= 0) 
+	{										// Shader identifier
+		_handler = glCreateProgram();
+
+		if (_handler == 0) 
+		{
+			fprintf(stderr, "Cannot create shader program: %s!\n", filename);
+			return false;
+		}
+	}
+
+	char fileNameComplete[256];
+	strcpy_s(fileNameComplete, filename);
+	strcat_s(fileNameComplete, "-comp.glsl");
+
+	std::string source;
+	if (!this->readShaderSource(fileNameComplete, GL_COMPUTE_SHADER, source))
+	{
+		return false;
+	}
+
+	this->parseResourceAccess(source);
+
+	return this->submitLink({ { GL_COMPUTE_SHADER, source } });
+}
+
+/// [Protected methods]
+
+void ComputeShader::dispatch(GLuint numGroups_x, GLuint numGroups_y, GLuint numGroups_z, GLuint workGroup_x, GLuint workGroup_y, GLuint workGroup_z)
+{
+	if (_localSize.x == 0)
+	{
+		glDispatchComputeGroupSizeARB(numGroups_x, numGroups_y, numGroups_z, workGroup_x, workGroup_y, workGroup_z);
+		return;
+	}
+
+	glDispatchCompute((numGroups_x * workGroup_x + _localSize.x - 1) / _localSize.x, (numGroups_y * workGroup_y + _localSize.y - 1) / _localSize.y, 
+					  (numGroups_z * workGroup_z + _localSize.z - 1) / _localSize.z);
+}
+
+std::string ComputeShader::evaluateConditionals(const std::string& source)
+{
+	struct Conditional
+	{
+		bool	_parentActive;					//!< Enclosing code is compiled
+		bool	_active;						//!< Current branch is compiled
+		bool	_taken;							//!< A previous branch was compiled, so the remaining ones are not
+	};
+
+	enum Value : uint8_t { FALSE_VALUE, TRUE_VALUE, UNKNOWN_VALUE };
+
+	std::unordered_map<std::string, std::string> macros;
+	std::vector<Conditional> conditionals;
+	std::stringstream input(source);
+	std::string line, result;
+	const std::regex directive("^\\s*#\\s*(\\w+)\\s*(.*)$"), token("\\s*(\\w+|&&|\\|\\||[!()])");
+
+	// Recursive descent over ||, &&, !, parentheses, defined and integer operands; any other construct makes the condition unknown
+	auto evaluate = [&macros, &token](const std::string& expression) -> Value
+	{
+		std::vector<std::string> tokens;
+		std::smatch match;
+		std::string remaining = expression;
+
+		while (std::regex_search(remaining, match, token, std::regex_constants::match_continuous))
+		{
+			tokens.push_back(match[1].str());
+			remaining = match.suffix().str();
+		}
+
+		if (remaining.find_first_not_of(" \t\r") != std::string::npos) return UNKNOWN_VALUE;
+
+		size_t position = 0;
+		std::function<Value()> parseOr, parseAnd, parseUnary;
+
+		auto combine = [](const Value a, const Value b, const bool conjunction) -> Value
+		{
+			if (conjunction) return (a == FALSE_VALUE || b == FALSE_VALUE) ? FALSE_VALUE : (a == TRUE_VALUE && b == TRUE_VALUE ? TRUE_VALUE : UNKNOWN_VALUE);
+			return (a == TRUE_VALUE || b == TRUE_VALUE) ? TRUE_VALUE : (a == FALSE_VALUE && b == FALSE_VALUE ? FALSE_VALUE : UNKNOWN_VALUE);
+		};
+
+		parseUnary = [&]() -> Value
+		{
+			if (position >= tokens.size()) return UNKNOWN_VALUE;
+
+			const std::string current = tokens[position++];
+
+			if (current == "!")
+			{
+				const Value value = parseUnary();
+				return value == UNKNOWN_VALUE ? value : Value(value == FALSE_VALUE);
+			}
+
+			if (current == "(")
+			{
+				const Value value = parseOr();
+				return (position < tokens.size() && tokens[position++] == ")") ? value : UNKNOWN_VALUE;
+			}
+
+			if (current == "defined")
+			{
+				const bool parenthesis = position < tokens.size() && tokens[position] == "(";
+				if (parenthesis) ++position;
+				if (position >= tokens.size()) return UNKNOWN_VALUE;
+
+				const Value value = Value(macros.count(tokens[position++]) > 0);
+				if (parenthesis && (position >= tokens.size() || tokens[position++] != ")")) return UNKNOWN_VALUE;
+
+				return value;
+			}
+
+			// Undefined identifiers evaluate to zero, as in the C preprocessor
+			std::string operand = current;
+			if (!std::isdigit(uint8_t(operand[0])))
+			{
+				const auto macro = macros.find(operand);
+				if (macro == macros.end()) return FALSE_VALUE;
+
+				operand = macro->second;
+			}
+
+			if (operand.empty() || operand.find_first_not_of("0123456789") != std::string::npos) return UNKNOWN_VALUE;
+
+			return Value(operand.find_first_not_of('0') != std::string::npos);
+		};
+
+		parseAnd = [&]() -> Value
+		{
+			Value value = parseUnary();
+			while (position < tokens.size() && tokens[position] == "&&") { ++position; value = combine(value, parseUnary(), true); }
+
+			return value;
+		};
+
+		parseOr = [&]() -> Value
+		{
+			Value value = parseAnd();
+			while (position < tokens.size() && tokens[position] == "||") { ++position; value = combine(value, parseAnd(), false); }
+
+			return value;
+		};
+
+		const Value value = parseOr();
+
+		return position == tokens.size() ? value : UNKNOWN_VALUE;
+	};
+
+	auto isActive = [&conditionals]() { return conditionals.empty() || conditionals.back()._active; };
+
+	while (std::getline(input, line))
+	{
+		std::smatch match;
+
+		if (!std::regex_match(line, match, directive))
+		{
+			if (isActive()) result += line + "\n";
+			continue;
+		}
+
+		const std::string name = match[1].str();
+		std::string argument = match[2].str();
+		argument = std::regex_replace(argument, std::regex("//.*$"), "");
+
+		if (name == "if" || name == "ifdef" || name == "ifndef")
+		{
+			const std::string identifier = argument.substr(0, argument.find_first_of(" \t\r"));
+			const Value value = name == "if" ? evaluate(argument) : Value((macros.count(identifier) > 0) == (name == "ifdef"));
+			const bool parentActive = isActive();
+
+			conditionals.push_back(Conditional{ parentActive, parentActive && value != FALSE_VALUE, value == TRUE_VALUE });
+		}
+		else if ((name == "elif" || name == "else") && !conditionals.empty())
+		{
+			Conditional& conditional = conditionals.back();
+			const Value value = name == "else" ? TRUE_VALUE : evaluate(argument);
+
+			conditional._active = conditional._parentActive && !conditional._taken && value != FALSE_VALUE;
+			conditional._taken = conditional._taken || value == TRUE_VALUE;
+		}
+		else if (name == "endif" && !conditionals.empty())
+		{
+			conditionals.pop_back();
+		}
+		else if (isActive())
+		{
+			std::smatch definition;
+			const std::string trimmed = argument.substr(0, argument.find_last_not_of(" \t\r") + 1);
+
+			if (name == "define" && std::regex_match(trimmed, definition, std::regex("(\\w+)(?:\\s+(.*))?")))
+			{
+				macros[definition[1].str()] = definition[2].str();
+			}
+			else if (name == "undef")
+			{
+				macros.erase(trimmed);
+			}
+
+			result += line + "\n";
+		}
+	}
+
+	return result;
+}
+
+uint8_t ComputeShader::getBufferAccess(const unsigned binding) const
+{
+	if (!_knownAccess) return BUFFER_READ_WRITE;
+
+	return binding < _bufferAccess.size() ? _bufferAccess[binding] : 0;
+}
+
+void ComputeShader::parseResourceAccess(const std::string& source)
+{
+	_bufferAccess.clear();
+
+	// Comments could contain declarations, and only the branches of conditional directives which are compiled must be parsed
+	const std::string content = evaluateConditionals(std::regex_replace(source, std::regex("//[^\\n]*|/\\*[\\s\\S]*?\\*/"), " "));
+
+	const std::regex bufferDeclaration("((?:\\w+\\s+)*)layout\\s*\\(([^)]*)\\)\\s*((?:\\w+\\s+)*)buffer\\b");
+	const std::regex bindingQualifier("binding\\s*=\\s*(\\d+)");
+	const std::regex imageDeclaration("\\buniform\\s+((?:layout\\s*\\([^)]*\\)\\s*|\\w+\\s+)*)[iu]?image\\w+\\s+\\w+");
+	std::smatch binding;
+
+	for (auto it = std::sregex_iterator(content.begin(), content.end(), bufferDeclaration); it != std::sregex_iterator(); ++it)
+	{
+		const std::string layout = (*it)[2].str(), qualifiers = (*it)[1].str() + " " + (*it)[3].str();
+		if (!std::regex_search(layout, binding, bindingQualifier)) continue;
+
+		const unsigned bindingPoint = std::stoi(binding[1].str());
+		uint8_t access = BUFFER_READ_WRITE;
+
+		if (qualifiers.find("readonly") != std::string::npos) access = BUFFER_READ;
+		else if (qualifiers.find("writeonly") != std::string::npos) access = BUFFER_WRITE;
+
+		if (_bufferAccess.size() <= bindingPoint) _bufferAccess.resize(bindingPoint + 1, 0);
+		_bufferAccess[bindingPoint] |= access;
+	}
+
+	_knownAccess = true;
+	_writesImages = false;
+
+	for (auto it = std::sregex_iterator(content.begin(), content.end(), imageDeclaration); it != std::sregex_iterator() && !_writesImages; ++it)
+	{
+		_writesImages = (*it)[1].str().find("readonly") == std::string::npos;
+	}
+}
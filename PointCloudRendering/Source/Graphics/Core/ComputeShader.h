@@ -1,5 +1,8 @@
 #pragma once
 
+#include "Graphics/Core/GPUBufferPool.h"
+#include "Graphics/Core/GPUReadback.h"
+#include "Graphics/Core/GPUUploadRing.h"
 #include "Graphics/Core/ShaderProgram.h"
 
 /**
@@ -16,9 +19,54 @@ class ComputeShader: public ShaderProgram
 public:
 	enum WorkGroupAxis { X_AXIS, Y_AXIS, Z_AXIS };
 
+	struct BarrierStatistics
+	{
+		size_t		_numDispatches;					//!< Executed compute shaders
+		size_t		_numBarriers;					//!< Memory barriers issued, either before a dispatch or before reading a buffer back
+		size_t		_numSkippedBarriers;			//!< Dispatches which did not need any barrier
+		size_t		_numDrawBarriers;				//!< Barriers issued before draw calls which consume buffers written by compute shaders
+	};
+
 protected:
+	enum BufferAccess : uint8_t { BUFFER_READ = 1, BUFFER_WRITE = 2, BUFFER_READ_WRITE = BUFFER_READ | BUFFER_WRITE };
+
 	static std::vector<GLint> MAX_WORK_GROUP_SIZE;					//!< This value can be useful since the number of groups is not as limited as group size
 
+	static std::vector<GLuint>			_boundBuffers;				//!< Storage buffers bound to each binding point, shared by every compute shader as in OpenGL
+	static std::unordered_set<GLuint>	_pendingWrites;				//!< Buffers written by shaders which have not been made visible yet
+	static std::unordered_set<GLuint>	_pendingReads;				//!< Buffers read by shaders since the last barrier, which must not be overwritten by later dispatches without one
+	static bool							_hazardTracking;			//!< Barriers are only issued when a dispatch depends on a pending write. Otherwise, every dispatch is followed by a full barrier
+	static BarrierStatistics			_barrierStatistics;			//!< Counters of issued and skipped barriers
+
+protected:
+	std::vector<uint8_t>	_bufferAccess;							//!< Access of the shader to each binding point, as declared by readonly / writeonly qualifiers
+	bool					_knownAccess;							//!< False if the source could not be parsed, so that every binding point is considered to be read and written
+	bool					_writesImages;							//!< True if any image is not declared as readonly
+	uvec3					_localSize;								//!< Fixed work group size if the program defines LOCAL_SIZE_X, zero if it is given at dispatch time
+
+protected:
+	/**
+	*	@brief Launches the work groups. Programs with a fixed work group size are dispatched with as many groups as needed to cover the same
+	*	number of invocations, so that callers do not need to know which permutation they are using.
+	*/
+	void dispatch(GLuint numGroups_x, GLuint numGroups_y, GLuint numGroups_z, GLuint workGroup_x, GLuint workGroup_y, GLuint workGroup_z);
+
+	/**
+	*	@return Access of the shader to a binding point.
+	*/
+	uint8_t getBufferAccess(const unsigned binding) const;
+
+	/**
+	*	@brief Removes the code excluded by conditional directives, given the macros defined along the source. Conditions which cannot be 
+	*	evaluated keep every branch, so that no declaration is missed.
+	*/
+	static std::string evaluateConditionals(const std::string& source);
+
+	/**
+	*	@brief Retrieves from the preprocessed source which storage buffers are read and written by the shader, and whether it writes any image.
+	*/
+	void parseResourceAccess(const std::string& source);
+
 public:	
 	/**
 	*	@brief Default constructor.
@@ -30,6 +78,18 @@ public:
 	*/
 	virtual ~ComputeShader();
 
+	/**
+	*	@brief Borrows a buffer from the pool and fills it with the given data. It is given back once the handle is destroyed.
+	*/
+	template<typename T>
+	static GPUBuffer acquireReadBuffer(const T* data, const unsigned arraySize);
+
+	/**
+	*	@brief Borrows a buffer from the pool which is only written in GPU. It is given back once the handle is destroyed.
+	*/
+	template<typename T>
+	static GPUBuffer acquireWriteBuffer(const T& dataType, const unsigned arraySize);
+
 	/**
 	*	@brief Applies all the active subroutines.
 	*/
@@ -40,6 +100,38 @@ public:
 	*/
 	void bindBuffers(const std::vector<GLuint>& bufferID);
 
+	/**
+	*	@return Counters of issued and skipped barriers.
+	*/
+	static BarrierStatistics getBarrierStatistics() { return _barrierStatistics; }
+
+	/**
+	*	@return True if barriers are only issued for buffers with pending writes.
+	*/
+	static bool isHazardTrackingEnabled() { return _hazardTracking; }
+
+	/**
+	*	@brief Resets the counters of issued and skipped barriers.
+	*/
+	static void resetBarrierStatistics();
+
+	/**
+	*	@brief Switches between hazard-tracked barriers and a full barrier after every dispatch.
+	*/
+	static void setHazardTracking(const bool enable);
+
+	/**
+	*	@brief Makes pending shader writes visible before a buffer is accessed by other than a compute shader.
+	*	@param barrierBits Barrier required by the following access, e.g. GL_BUFFER_UPDATE_BARRIER_BIT for copies and readbacks.
+	*/
+	static void synchronizeBuffer(const GLuint bufferID, const GLbitfield barrierBits);
+
+	/**
+	*	@brief Makes pending shader writes visible to the next draw call, which may consume them as vertices, indices, indirect commands, 
+	*	uniforms or storage buffers. Draw calls do not declare their buffers, so a single barrier covers every pending write.
+	*/
+	static void synchronizeDraw();
+
 	/**
 	*	@brief Reads and compiles the compute shader located at filename, which is followed by string -comp.glsl.
 	*	@filename filename Shader program name. Example: pointCloud => parallel-comp.glsl.
@@ -51,6 +143,11 @@ public:
 	*/
 	void execute(GLuint numGroups_x, GLuint numGroups_y, GLuint numGroups_z, GLuint workGroup_x, GLuint workGroup_y, GLuint workGroup_z);
 
+	/**
+	*	@brief Checks the linking of the program and reserves space for its subroutines.
+	*/
+	virtual GLuint finishShaderProgram(const char* filename);
+
 	/**
 	*	@return Maximum size a work group can get.
 	*/
@@ -77,12 +174,21 @@ public:
 	static void initializeMaxGroupSize();
 
 	/**
-	*	@brief Retrieves data from GPU.
+	*	@brief Retrieves data from GPU, waiting for the shaders which write it.
 	*	@param bufferID Identifier of buffer in GPU.
-	*	@param Type of data to be retrieved. Any value can be used here.
+	*	@param dataType Type of data to be retrieved. Any value can be used here.
+	*	@param arraySize Number of elements to be retrieved.
 	*/
 	template<typename T>
-	static T* readData(GLuint bufferID, const T& dataType);
+	static std::vector<T> readData(GLuint bufferID, const T& dataType, const unsigned arraySize);
+
+	/**
+	*	@brief Copies data from GPU into a staging buffer without waiting for it.
+	*	@param offset First element to be retrieved.
+	*	@return Handle which gives access to the data once the copy is finished.
+	*/
+	template<typename T>
+	static GPUReadback<T> readDataAsync(GLuint bufferID, const T& dataType, const unsigned arraySize, const unsigned offset = 0);
 
 	/**
 	*	@brief Sets a new uniform which correspondons to an input image.
@@ -118,7 +224,18 @@ public:
 	static GLuint setWriteBuffer(const T& dataType, const GLuint arraySize, const GLuint changeFrequency = GL_DYNAMIC_DRAW);
 
 	/**
-	*	@brief Defines a new buffer at OpenGL context.
+	*	@brief Reads the compute shader and requests its compilation, unless it is found in the binary cache.
+	*/
+	virtual bool submitShaderProgram(const char* filename);
+
+	/**
+	*	@brief Overwrites the first elements of a buffer through the upload ring, without reallocating it, as required by pooled buffers.
+	*/
+	template<typename T>
+	static void updateBufferSubData(const GLuint id, const T* data, const unsigned arraySize);
+
+	/**
+	*	@brief Overwrites the content of a buffer through the upload ring. Its storage is only reallocated if it is not large enough.
 	*/
 	template<typename T>
 	static void updateReadBuffer(const GLuint id, const T* data, const unsigned arraySize, const GLuint changeFrequency = GL_DYNAMIC_DRAW);
@@ -131,15 +248,42 @@ public:
 };
 
 template<typename T>
-inline T* ComputeShader::readData(GLuint bufferID, const T& dataType)
+inline GPUBuffer ComputeShader::acquireReadBuffer(const T* data, const unsigned arraySize)
 {
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferID);																	
-	T* data = (T*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY);
-	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER); 
+	return GPUBufferPool::getInstance()->acquire(sizeof(T) * arraySize, data);
+}
+
+template<typename T>
+inline GPUBuffer ComputeShader::acquireWriteBuffer(const T& dataType, const unsigned arraySize)
+{
+	return GPUBufferPool::getInstance()->acquire(sizeof(dataType) * arraySize);
+}
+
+template<typename T>
+inline std::vector<T> ComputeShader::readData(GLuint bufferID, const T& dataType, const unsigned arraySize)
+{
+	std::vector<T> data(arraySize);
+
+	synchronizeBuffer(bufferID, GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferID);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(T) * arraySize, data.data());
 
 	return data;
 }
 
+template<typename T>
+inline GPUReadback<T> ComputeShader::readDataAsync(GLuint bufferID, const T& dataType, const unsigned arraySize, const unsigned offset)
+{
+	GPUBuffer stagingBuffer = GPUBufferPool::getInstance()->acquireStaging(sizeof(T) * arraySize);
+
+	synchronizeBuffer(bufferID, GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, stagingBuffer.getID());
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(sizeof(T)) * offset, 0, sizeof(T) * arraySize);
+
+	return GPUReadback<T>(std::move(stagingBuffer), arraySize);
+}
+
 template<typename T>
 inline GLuint ComputeShader::setReadBuffer(const std::vector<T>& data, const GLuint changeFrequency)
 {
@@ -184,11 +328,26 @@ inline GLuint ComputeShader::setWriteBuffer(const T& dataType, const GLuint arra
 	return id;
 }
 
+template<typename T>
+inline void ComputeShader::updateBufferSubData(const GLuint id, const T* data, const unsigned arraySize)
+{
+	GPUUploadRing::getInstance()->upload(id, 0, data, GLsizeiptr(sizeof(T)) * arraySize);
+}
+
 template<typename T>
 inline void ComputeShader::updateReadBuffer(const GLuint id, const T* data, const unsigned arraySize, const GLuint changeFrequency)
 {
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(T) * arraySize, data, changeFrequency);
+	// Storage is queried rather than cached, since buffer names are recycled once deleted
+	GLint64 bufferSize = 0;
+	glGetNamedBufferParameteri64v(id, GL_BUFFER_SIZE, &bufferSize);
+
+	if (bufferSize < GLint64(sizeof(T) * arraySize))
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(T) * arraySize, nullptr, changeFrequency);
+	}
+
+	GPUUploadRing::getInstance()->upload(id, 0, data, GLsizeiptr(sizeof(T)) * arraySize);
 }
 
 template<typename T>
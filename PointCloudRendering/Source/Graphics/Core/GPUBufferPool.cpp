@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "GPUBufferPool.h"
+
+#include "Graphics/Core/GPUUploadRing.h"
+
+// [Static members initialization]
+
+const size_t GPUBufferPool::MAX_IDLE_BYTES = size_t(1) << 30;
+const GLsizeiptr GPUBufferPool::MIN_BUFFER_SIZE = 256;
+const unsigned GPUBufferPool::SIZE_CLASS_STEPS_LOG2 = 2;
+
+/// [Public methods]
+
+GPUBufferPool::~GPUBufferPool()
+{
+	this->trim();
+}
+
+GPUBuffer GPUBufferPool::acquire(const GLsizeiptr size, const void* data)
+{
+	const GLsizeiptr sizeClass = getSizeClass(size);
+	GLuint id = this->reuse(_idleBuffers, sizeClass)._id;
+
+	if (!id)
+	{
+		glGenBuffers(1, &id);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeClass, nullptr, GL_DYNAMIC_DRAW);
+
+		++_statistics._numAllocations;
+	}
+
+	if (data) GPUUploadRing::getInstance()->upload(id, 0, data, size);
+
+	_statistics._liveBytes += sizeClass;
+	_statistics._peakLiveBytes = std::max(_statistics._peakLiveBytes, _statistics._liveBytes);
+	++_statistics._numLiveBuffers;
+
+	return GPUBuffer(id, sizeClass);
+}
+
+GPUBuffer GPUBufferPool::acquireStaging(const GLsizeiptr size)
+{
+	const GLsizeiptr sizeClass = getSizeClass(size);
+	IdleBuffer buffer = this->reuse(_idleStagingBuffers, sizeClass);
+
+	if (!buffer._id)
+	{
+		const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		// Immutable storage is required to keep the buffer mapped while the GPU copies into it
+		glGenBuffers(1, &buffer._id);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer._id);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, sizeClass, nullptr, flags);
+		buffer._mappedData = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, sizeClass, flags);
+
+		++_statistics._numAllocations;
+	}
+
+	_statistics._liveBytes += sizeClass;
+	_statistics._peakLiveBytes = std::max(_statistics._peakLiveBytes, _statistics._liveBytes);
+	++_statistics._numLiveBuffers;
+
+	return GPUBuffer(buffer._id, sizeClass, buffer._mappedData);
+}
+
+void GPUBufferPool::trim()
+{
+	for (auto* idleBufferMap : { &_idleBuffers, &_idleStagingBuffers })
+	{
+		for (auto& idleBuffers : *idleBufferMap)
+		{
+			for (const IdleBuffer& buffer : idleBuffers.second) glDeleteBuffers(1, &buffer._id);
+		}
+
+		idleBufferMap->clear();
+	}
+
+	_statistics._idleBytes = 0;
+	_statistics._numIdleBuffers = 0;
+}
+
+/// [Protected methods]
+
+GPUBufferPool::GPUBufferPool() : _statistics{ 0, 0, 0, 0, 0, 0, 0 }
+{
+}
+
+GLsizeiptr GPUBufferPool::getSizeClass(const GLsizeiptr size)
+{
+	if (size <= MIN_BUFFER_SIZE) return MIN_BUFFER_SIZE;
+
+	// Classes between two powers of two are evenly spaced, so that at most 1 / 2^SIZE_CLASS_STEPS_LOG2 of the buffer is wasted
+	GLsizeiptr powerOfTwo = MIN_BUFFER_SIZE;
+	while (powerOfTwo * 2 < size) powerOfTwo *= 2;
+
+	const GLsizeiptr step = powerOfTwo >> SIZE_CLASS_STEPS_LOG2;
+
+	return powerOfTwo + (size - powerOfTwo + step - 1) / step * step;
+}
+
+void GPUBufferPool::release(const GLuint id, const GLsizeiptr size, void* mappedData)
+{
+	_statistics._liveBytes -= size;
+	--_statistics._numLiveBuffers;
+
+	if (_statistics._idleBytes + size > MAX_IDLE_BYTES)
+	{
+		glDeleteBuffers(1, &id);
+		return;
+	}
+
+	(mappedData ? _idleStagingBuffers : _idleBuffers)[size].push_back(IdleBuffer{ id, mappedData });
+	_statistics._idleBytes += size;
+	++_statistics._numIdleBuffers;
+}
+
+GPUBufferPool::IdleBuffer GPUBufferPool::reuse(std::unordered_map<GLsizeiptr, std::vector<IdleBuffer>>& idleBuffers, const GLsizeiptr sizeClass)
+{
+	std::vector<IdleBuffer>& classBuffers = idleBuffers[sizeClass];
+
+	if (classBuffers.empty()) return IdleBuffer{ 0, nullptr };
+
+	const IdleBuffer buffer = classBuffers.back();
+	classBuffers.pop_back();
+
+	_statistics._idleBytes -= sizeClass;
+	--_statistics._numIdleBuffers;
+	++_statistics._numReuses;
+
+	return buffer;
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "Utilities/Singleton.h"
+
+/**
+*	@file GPUBufferPool.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Shader storage buffer borrowed from GPUBufferPool, which gets it back once the handle is destroyed.
+*/
+class GPUBuffer
+{
+	friend class GPUBufferPool;
+
+protected:
+	GLuint			_id;							//!< OpenGL identifier, 0 if the handle is empty
+	GLsizeiptr		_size;							//!< Allocated size (bytes), which may be larger than the requested one
+	void*			_mappedData;					//!< Persistent mapping of staging buffers, nullptr otherwise
+
+protected:
+	/**
+	*	@brief Constructor of a handle which owns the given buffer.
+	*/
+	GPUBuffer(const GLuint id, const GLsizeiptr size, void* mappedData = nullptr) : _id(id), _size(size), _mappedData(mappedData) {}
+
+public:
+	/**
+	*	@brief Constructor of an empty handle.
+	*/
+	GPUBuffer() : _id(0), _size(0), _mappedData(nullptr) {}
+
+	/**
+	*	@brief Move constructor. The moved handle becomes empty.
+	*/
+	GPUBuffer(GPUBuffer&& buffer) noexcept : _id(buffer._id), _size(buffer._size), _mappedData(buffer._mappedData) { buffer._id = 0; buffer._size = 0; buffer._mappedData = nullptr; }
+
+	/**
+	*	@brief Destructor. Gives the buffer back to the pool.
+	*/
+	virtual ~GPUBuffer() { this->reset(); }
+
+	/**
+	*	@brief Invalidated copy constructor, since buffers have a single owner.
+	*/
+	GPUBuffer(const GPUBuffer&) = delete;
+
+	/**
+	*	@brief Invalidated assignment operator, since buffers have a single owner.
+	*/
+	GPUBuffer& operator=(const GPUBuffer&) = delete;
+
+	/**
+	*	@brief Move assignment operator. The previous buffer is given back to the pool.
+	*/
+	GPUBuffer& operator=(GPUBuffer&& buffer) noexcept;
+
+	/**
+	*	@return OpenGL identifier of the buffer.
+	*/
+	GLuint getID() const { return _id; }
+
+	/**
+	*	@return Client address of a staging buffer, which remains mapped while it is alive.
+	*/
+	void* getMappedData() const { return _mappedData; }
+
+	/**
+	*	@return Allocated size (bytes).
+	*/
+	GLsizeiptr getSize() const { return _size; }
+
+	/**
+	*	@brief Gives the buffer back to the pool, leaving the handle empty.
+	*/
+	void reset();
+};
+
+/**
+*	@brief Pool of shader storage buffers for temporary data (e.g. Morton codes, radix sort or prefix scan arrays). Requests are rounded up to
+*	size classes, i.e. powers of two divided into four steps, and released buffers are kept to serve later requests of the same class, thus
+*	avoiding the allocation of new driver storage on every call. It also provides persistently mapped staging buffers to read data back, and
+*	keeps track of the memory that is being used. It must only be used from the thread which owns the OpenGL context.
+*/
+class GPUBufferPool: public Singleton<GPUBufferPool>
+{
+	friend class GPUBuffer;
+	friend class Singleton<GPUBufferPool>;
+
+public:
+	struct Statistics
+	{
+		size_t		_liveBytes;						//!< Size of the buffers which are currently borrowed
+		size_t		_peakLiveBytes;					//!< Maximum value of _liveBytes
+		size_t		_idleBytes;						//!< Size of the buffers which are waiting to be reused
+		unsigned	_numLiveBuffers;				//!< Number of borrowed buffers
+		unsigned	_numIdleBuffers;				//!< Number of buffers waiting to be reused
+		unsigned	_numAllocations;				//!< Number of requests which needed a new buffer
+		unsigned	_numReuses;						//!< Number of requests served with an idle buffer
+	};
+
+protected:
+	const static size_t		MAX_IDLE_BYTES;					//!< Released buffers are deleted rather than kept beyond this size
+	const static GLsizeiptr	MIN_BUFFER_SIZE;				//!< Size of the smallest class (bytes)
+	const static unsigned	SIZE_CLASS_STEPS_LOG2;			//!< Each power of two is split into 2^SIZE_CLASS_STEPS_LOG2 classes
+
+protected:
+	struct IdleBuffer
+	{
+		GLuint		_id;							//!< OpenGL identifier
+		void*		_mappedData;					//!< Persistent mapping, only for staging buffers
+	};
+
+protected:
+	std::unordered_map<GLsizeiptr, std::vector<IdleBuffer>>	_idleBuffers;			//!< Released storage buffers indexed by their size class
+	std::unordered_map<GLsizeiptr, std::vector<IdleBuffer>>	_idleStagingBuffers;	//!< Released staging buffers indexed by their size class
+	Statistics												_statistics;			//!< Memory usage
+
+protected:
+	/**
+	*	@brief Default constructor.
+	*/
+	GPUBufferPool();
+
+	/**
+	*	@return Smallest size class which can hold the given size.
+	*/
+	static GLsizeiptr getSizeClass(const GLsizeiptr size);
+
+	/**
+	*	@brief Keeps a buffer to be reused, or deletes it if there are too many idle bytes.
+	*/
+	void release(const GLuint id, const GLsizeiptr size, void* mappedData);
+
+	/**
+	*	@return Idle buffer of the given class, whose identifier is 0 if there is none.
+	*/
+	IdleBuffer reuse(std::unordered_map<GLsizeiptr, std::vector<IdleBuffer>>& idleBuffers, const GLsizeiptr sizeClass);
+
+public:
+	/**
+	*	@brief Destructor. Deletes the idle buffers.
+	*/
+	virtual ~GPUBufferPool();
+
+	/**
+	*	@brief Borrows a buffer of at least the given size.
+	*	@param data Initial content of the first size bytes, or nullptr if the buffer is written in GPU.
+	*/
+	GPUBuffer acquire(const GLsizeiptr size, const void* data = nullptr);
+
+	/**
+	*	@brief Borrows a buffer of at least the given size whose storage is persistently mapped for reading, so that the CPU can access the
+	*	data copied into it without mapping it again. Reads must wait for a fence signaled after the copy.
+	*/
+	GPUBuffer acquireStaging(const GLsizeiptr size);
+
+	/**
+	*	@return Memory usage of the pool.
+	*/
+	const Statistics& getStatistics() const { return _statistics; }
+
+	/**
+	*	@brief Restarts the peak of live bytes from the current value.
+	*/
+	void resetPeak() { _statistics._peakLiveBytes = _statistics._liveBytes; }
+
+	/**
+	*	@brief Deletes every idle buffer.
+	*/
+	void trim();
+};
+
+inline GPUBuffer& GPUBuffer::operator=(GPUBuffer&& buffer) noexcept
+{
+	if (this != &buffer)
+	{
+		this->reset();
+		std::swap(_id, buffer._id);
+		std::swap(_size, buffer._size);
+		std::swap(_mappedData, buffer._mappedData);
+	}
+
+	return *this;
+}
+
+inline void GPUBuffer::reset()
+{
+	if (_id)
+	{
+		GPUBufferPool::getInstance()->release(_id, _size, _mappedData);
+		_id = 0;
+		_size = 0;
+		_mappedData = nullptr;
+	}
+}
+
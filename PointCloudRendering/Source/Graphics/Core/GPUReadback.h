@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Graphics/Core/GPUBufferPool.h"
+
+/**
+*	@file GPUReadback.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Pending copy of GPU data into a persistently mapped staging buffer, similar to a future. The copy is followed by a fence, so the
+*	CPU only waits when it actually needs the data, and can meanwhile record more GPU work or process previous results.
+*/
+template<typename T>
+class GPUReadback
+{
+protected:
+	GPUBuffer		_stagingBuffer;					//!< Destination of the copy, mapped for reading
+	GLsync			_fence;							//!< Signaled once the copy is finished, nullptr after it is waited for
+	unsigned		_arraySize;						//!< Number of copied elements
+
+public:
+	/**
+	*	@brief Constructor of an empty readback.
+	*/
+	GPUReadback() : _fence(nullptr), _arraySize(0) {}
+
+	/**
+	*	@brief Constructor. Signals a fence after the copy which has just been issued into the staging buffer.
+	*/
+	GPUReadback(GPUBuffer&& stagingBuffer, const unsigned arraySize);
+
+	/**
+	*	@brief Move constructor.
+	*/
+	GPUReadback(GPUReadback&& readback) noexcept;
+
+	/**
+	*	@brief Destructor. The staging buffer is given back to the pool.
+	*/
+	virtual ~GPUReadback();
+
+	/**
+	*	@brief Invalidated copy constructor.
+	*/
+	GPUReadback(const GPUReadback&) = delete;
+
+	/**
+	*	@brief Invalidated assignment operator.
+	*/
+	GPUReadback& operator=(const GPUReadback&) = delete;
+
+	/**
+	*	@brief Move assignment operator.
+	*/
+	GPUReadback& operator=(GPUReadback&& readback) noexcept;
+
+	/**
+	*	@brief Waits for the copy if it is not finished yet.
+	*	@return Pointer to the copied elements, which is valid while the readback is alive.
+	*/
+	const T* get();
+
+	/**
+	*	@return Number of copied elements.
+	*/
+	unsigned getArraySize() const { return _arraySize; }
+
+	/**
+	*	@return True if the copy is finished, so that get() does not block.
+	*/
+	bool isReady();
+
+	/**
+	*	@return True if the readback refers to a copy.
+	*/
+	bool isValid() const { return _stagingBuffer.getID() != 0; }
+};
+
+template<typename T>
+inline GPUReadback<T>::GPUReadback(GPUBuffer&& stagingBuffer, const unsigned arraySize) : 
+	_stagingBuffer(std::move(stagingBuffer)), _fence(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)), _arraySize(arraySize)
+{
+}
+
+template<typename T>
+inline GPUReadback<T>::GPUReadback(GPUReadback&& readback) noexcept : 
+	_stagingBuffer(std::move(readback._stagingBuffer)), _fence(readback._fence), _arraySize(readback._arraySize)
+{
+	readback._fence = nullptr;
+	readback._arraySize = 0;
+}
+
+template<typename T>
+inline GPUReadback<T>::~GPUReadback()
+{
+	if (_fence) glDeleteSync(_fence);
+}
+
+template<typename T>
+inline GPUReadback<T>& GPUReadback<T>::operator=(GPUReadback&& readback) noexcept
+{
+	if (this != &readback)
+	{
+		if (_fence) glDeleteSync(_fence);
+
+		_stagingBuffer = std::move(readback._stagingBuffer);
+		_fence = readback._fence;
+		_arraySize = readback._arraySize;
+
+		readback._fence = nullptr;
+		readback._arraySize = 0;
+	}
+
+	return *this;
+}
+
+template<typename T>
+inline const T* GPUReadback<T>::get()
+{
+	if (_fence)
+	{
+		// The first wait flushes the command queue, otherwise the fence might never reach the GPU
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+		while (glClientWaitSync(_fence, flags, 1000000) == GL_TIMEOUT_EXPIRED) flags = 0;
+
+		glDeleteSync(_fence);
+		_fence = nullptr;
+	}
+
+	return static_cast<const T*>(_stagingBuffer.getMappedData());
+}
+
+template<typename T>
+inline bool GPUReadback<T>::isReady()
+{
+	if (_fence && glClientWaitSync(_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) return false;
+
+	return true;
+}
+
@@ -0,0 +1,297 @@
+#include "stdafx.h"
+#include "GPUUploadRing.h"
+
+#include "Graphics/Core/ComputeShader.h"
+
+// [Static members initialization]
+
+const GLsizeiptr GPUUploadRing::ALIGNMENT = 256;
+const unsigned GPUUploadRing::NUM_SEGMENTS = 3;
+const GLsizeiptr GPUUploadRing::SEGMENT_SIZE = 16 << 20;
+
+/// [Public methods]
+
+GPUUploadRing::~GPUUploadRing()
+{
+	// The worker may still be writing into the mapped buffer, so its remaining jobs are finished first
+	if (_stagingThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(_stagingMutex);
+			_stopStaging = true;
+		}
+
+		_stagingQueued.notify_one();
+		_stagingThread.join();
+	}
+
+	for (GLsync fence : _segmentFence)
+	{
+		if (fence) glDeleteSync(fence);
+	}
+
+	if (_stagingBuffer) glDeleteBuffers(1, &_stagingBuffer);
+}
+
+uint64_t GPUUploadRing::submitPendingCopies(const bool wait)
+{
+	this->stageDeferredUploads(wait);
+
+	return this->issueStagedCopies(wait);
+}
+
+void GPUUploadRing::upload(const GLuint bufferID, const GLintptr offset, const void* data, const GLsizeiptr size)
+{
+	if (!_stagingBuffer) this->initialize();
+
+	// Copies into the same buffer must keep their order
+	if (std::any_of(_pendingCopies.begin(), _pendingCopies.end(), [bufferID](const PendingCopy& copy) { return copy._bufferID == bufferID; }) ||
+		std::any_of(_deferredUploads.begin(), _deferredUploads.end(), [bufferID](const DeferredUpload& upload) { return upload._bufferID == bufferID; }))
+	{
+		this->submitPendingCopies(true);
+	}
+
+	ComputeShader::synchronizeBuffer(bufferID, GL_BUFFER_UPDATE_BARRIER_BIT);				// Shader writes must land before being overwritten
+
+	if (size > SEGMENT_SIZE)
+	{
+		this->uploadTransient(bufferID, offset, data, size);
+		return;
+	}
+
+	const uint8_t* source = static_cast<const uint8_t*>(data);
+	GLsizeiptr uploadedBytes = 0;
+
+	while (uploadedBytes < size)
+	{
+		GLsizeiptr pieceSize = size - uploadedBytes;
+		const GLintptr stagingOffset = this->reserve(pieceSize, pieceSize, true);
+
+		// Coherent mapping: the copy command sees the written bytes without any explicit flush
+		std::memcpy(_mappedData + stagingOffset, source + uploadedBytes, pieceSize);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, _stagingBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, stagingOffset, offset + uploadedBytes, pieceSize);
+
+		uploadedBytes += pieceSize;
+	}
+
+	_statistics._uploadedBytes += size;
+}
+
+uint64_t GPUUploadRing::uploadAsync(const GLuint bufferID, const GLintptr offset, const void* data, const GLsizeiptr size)
+{
+	if (!_stagingBuffer) this->initialize();
+
+	const uint64_t ticket = ++_lastTicket;
+
+	// Every upload goes through the deferred queue, so that it is staged after the previous ones even if they are waiting for room
+	_deferredUploads.push_back(DeferredUpload{ bufferID, offset, static_cast<const uint8_t*>(data), size, ticket });
+	this->stageDeferredUploads(false);
+
+	_statistics._uploadedBytes += size;
+
+	return ticket;
+}
+
+/// [Protected methods]
+
+GPUUploadRing::GPUUploadRing() : 
+	_stagingBuffer(0), _mappedData(nullptr), _segmentFence(NUM_SEGMENTS, nullptr), _segmentCopies(NUM_SEGMENTS, 0), _currentSegment(0), _head(0), _lastTicket(0), _submittedTicket(0), 
+	_statistics{ 0, 0, 0, 0, 0 }, _numQueuedJobs(0), _numStagedJobs(0), _stopStaging(false)
+{
+}
+
+void GPUUploadRing::initialize()
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &_stagingBuffer);
+	glBindBuffer(GL_COPY_READ_BUFFER, _stagingBuffer);
+	glBufferStorage(GL_COPY_READ_BUFFER, NUM_SEGMENTS * SEGMENT_SIZE, nullptr, flags);
+	_mappedData = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, NUM_SEGMENTS * SEGMENT_SIZE, flags));
+
+	_stagingThread = std::thread(&GPUUploadRing::stageData, this);
+}
+
+uint64_t GPUUploadRing::issueStagedCopies(const bool wait)
+{
+	while (!_pendingCopies.empty())
+	{
+		PendingCopy& copy = _pendingCopies.front();
+
+		{
+			std::unique_lock<std::mutex> lock(_stagingMutex);
+
+			if (_numStagedJobs < copy._stagingJob)
+			{
+				if (!wait) break;
+				_stagingFinished.wait(lock, [this, &copy]() { return _numStagedJobs >= copy._stagingJob; });
+			}
+		}
+
+		// Coherent mapping: the copy command sees the written bytes without any explicit flush
+		ComputeShader::synchronizeBuffer(copy._bufferID, GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_COPY_READ_BUFFER, _stagingBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, copy._bufferID);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, copy._stagingOffset, copy._offset, copy._size);
+
+		// A segment left behind is fenced once no copy reads from it anymore
+		const unsigned segment = unsigned(copy._stagingOffset / SEGMENT_SIZE);
+
+		if (--_segmentCopies[segment] == 0 && segment != _currentSegment)
+		{
+			_segmentFence[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		// Uploads may be split into several copies, so the ticket is only submitted with its last one
+		const uint64_t ticket = copy._ticket;
+		_pendingCopies.pop_front();
+
+		if ((_pendingCopies.empty() || _pendingCopies.front()._ticket != ticket) && (_deferredUploads.empty() || _deferredUploads.front()._ticket != ticket))
+		{
+			_submittedTicket = ticket;
+		}
+	}
+
+	// Uploads without data have no copies, so they are submitted as soon as the previous ones
+	while (!_deferredUploads.empty() && _pendingCopies.empty() && !_deferredUploads.front()._size)
+	{
+		_submittedTicket = _deferredUploads.front()._ticket;
+		_deferredUploads.pop_front();
+	}
+
+	return _submittedTicket;
+}
+
+bool GPUUploadRing::nextSegment(const bool wait)
+{
+	const unsigned segment = (_currentSegment + 1) % NUM_SEGMENTS;
+
+	// Copies from the next segment may not even be issued yet, e.g. if its data is still being staged
+	if (_segmentCopies[segment])
+	{
+		if (!wait) return false;
+		this->issueStagedCopies(true);
+	}
+
+	GLsync& fence = _segmentFence[segment];
+
+	if (fence)
+	{
+		// Copies from this segment are usually finished by now, since two more segments were filled afterwards
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		GLenum status = glClientWaitSync(fence, flags, 0);
+
+		if (status == GL_TIMEOUT_EXPIRED)
+		{
+			if (!wait) return false;
+
+			++_statistics._numStalls;
+			flags = 0;
+
+			while ((status = glClientWaitSync(fence, flags, 1000000)) == GL_TIMEOUT_EXPIRED);
+		}
+
+		++_statistics._numWraps;
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	// Otherwise, the segment which is left is fenced once its pending copies are issued
+	if (!_segmentCopies[_currentSegment])
+	{
+		_segmentFence[_currentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	_currentSegment = segment;
+	_head = 0;
+
+	return true;
+}
+
+GLintptr GPUUploadRing::reserve(const GLsizeiptr size, GLsizeiptr& reservedSize, const bool wait)
+{
+	if (_head >= SEGMENT_SIZE && !this->nextSegment(wait)) return -1;
+
+	const GLintptr stagingOffset = _currentSegment * SEGMENT_SIZE + _head;
+	reservedSize = std::min(size, SEGMENT_SIZE - _head);
+	_head += (reservedSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+	return stagingOffset;
+}
+
+void GPUUploadRing::stageDeferredUploads(const bool wait)
+{
+	while (!_deferredUploads.empty() && _deferredUploads.front()._size)
+	{
+		DeferredUpload& upload = _deferredUploads.front();
+		GLsizeiptr pieceSize = upload._size;
+		const GLintptr stagingOffset = this->reserve(pieceSize, pieceSize, wait);
+
+		if (stagingOffset < 0)
+		{
+			++_statistics._numDeferrals;
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_stagingMutex);
+			_stagingJobs.push_back(StagingJob{ _mappedData + stagingOffset, upload._data, pieceSize });
+			++_numQueuedJobs;
+		}
+
+		_stagingQueued.notify_one();
+		_pendingCopies.push_back(PendingCopy{ _numQueuedJobs, upload._bufferID, stagingOffset, upload._offset, pieceSize, upload._ticket });
+		++_segmentCopies[_currentSegment];
+
+		upload._offset += pieceSize;
+		upload._data += pieceSize;
+		upload._size -= pieceSize;
+
+		if (!upload._size) _deferredUploads.pop_front();
+	}
+}
+
+void GPUUploadRing::stageData()
+{
+	while (true)
+	{
+		StagingJob job;
+
+		{
+			std::unique_lock<std::mutex> lock(_stagingMutex);
+			_stagingQueued.wait(lock, [this]() { return _stopStaging || !_stagingJobs.empty(); });
+
+			if (_stagingJobs.empty()) return;
+
+			job = _stagingJobs.front();
+			_stagingJobs.pop_front();
+		}
+
+		std::memcpy(job._destination, job._source, job._size);
+
+		{
+			std::lock_guard<std::mutex> lock(_stagingMutex);
+			++_numStagedJobs;
+		}
+
+		_stagingFinished.notify_all();
+	}
+}
+
+void GPUUploadRing::uploadTransient(const GLuint bufferID, const GLintptr offset, const void* data, const GLsizeiptr size)
+{
+	GLuint stagingBuffer;
+
+	glGenBuffers(1, &stagingBuffer);
+	glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+	glBufferStorage(GL_COPY_READ_BUFFER, size, data, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, offset, size);
+	glDeleteBuffers(1, &stagingBuffer);
+
+	++_statistics._numTransientUploads;
+	_statistics._uploadedBytes += size;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "Utilities/Singleton.h"
+
+/**
+*	@file GPUUploadRing.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Streaming path for CPU to GPU transfers. Data is written into a persistently mapped staging buffer, split into three segments that
+*	are used as a ring, and then copied by the GPU into the destination buffer. Each segment is fenced once it is left behind, so it is only
+*	overwritten after the GPU has consumed it; meanwhile, the other segments are being filled. Hence, uploads neither reallocate storage nor
+*	wait for the driver to copy the data synchronously. It must only be used from the thread which owns the OpenGL context, although
+*	asynchronous uploads copy their data into the staging buffer from a persistent worker thread. Asynchronous uploads never wait for 
+*	the GPU: if the next segment is still in use, they are deferred until a later submitPendingCopies(). Synchronous uploads larger 
+*	than a segment would wrap around the ring and wait for their own copies, so they go through a transient staging buffer instead.
+*/
+class GPUUploadRing: public Singleton<GPUUploadRing>
+{
+	friend class Singleton<GPUUploadRing>;
+
+public:
+	struct Statistics
+	{
+		size_t		_uploadedBytes;					//!< Bytes copied through the ring
+		unsigned	_numWraps;						//!< Number of times a segment was reused
+		unsigned	_numStalls;						//!< Number of reused segments which were still being consumed by the GPU, and so were waited for
+		unsigned	_numDeferrals;					//!< Number of times asynchronous uploads were deferred, as the next segment was still in use
+		unsigned	_numTransientUploads;			//!< Number of uploads larger than a segment, copied through their own staging buffer
+	};
+
+protected:
+	struct PendingCopy
+	{
+		uint64_t			_stagingJob;			//!< Job of the worker which writes the data into the staging buffer
+		GLuint				_bufferID;				//!< Destination buffer
+		GLintptr			_stagingOffset;			//!< Offset of the data within the staging buffer
+		GLintptr			_offset;				//!< Offset within the destination buffer
+		GLsizeiptr			_size;					//!< Size of the copy (bytes)
+		uint64_t			_ticket;				//!< Identifier of the upload which the copy belongs to
+	};
+
+	struct DeferredUpload
+	{
+		GLuint				_bufferID;				//!< Destination buffer
+		GLintptr			_offset;				//!< Offset within the destination buffer of the remaining data
+		const uint8_t*		_data;					//!< Remaining data, which has no room in the ring yet
+		GLsizeiptr			_size;					//!< Remaining size (bytes)
+		uint64_t			_ticket;				//!< Identifier of the upload
+	};
+
+	struct StagingJob
+	{
+		uint8_t*			_destination;			//!< Range of the mapped staging buffer
+		const uint8_t*		_source;				//!< Data given to uploadAsync()
+		GLsizeiptr			_size;					//!< Size of the range (bytes)
+	};
+
+protected:
+	const static GLsizeiptr	ALIGNMENT;						//!< Alignment of each upload within a segment
+	const static unsigned	NUM_SEGMENTS;					//!< Triple buffering
+	const static GLsizeiptr	SEGMENT_SIZE;					//!< Size of each segment (bytes)
+
+protected:
+	GLuint					_stagingBuffer;					//!< Buffer with immutable storage, mapped for writing while it is alive
+	uint8_t*				_mappedData;					//!< Client address of the staging buffer
+	std::vector<GLsync>		_segmentFence;					//!< Signaled once the GPU has consumed the copies of each segment
+	std::vector<unsigned>	_segmentCopies;					//!< Pending copies which read from each segment. A segment is only fenced once they are issued
+	unsigned				_currentSegment;				//!< Segment being filled
+	GLsizeiptr				_head;							//!< First free byte of the current segment
+	std::deque<PendingCopy>	_pendingCopies;					//!< Asynchronous uploads whose GPU copy has not been issued yet, in order
+	std::deque<DeferredUpload> _deferredUploads;			//!< Asynchronous uploads which did not fit in the free segments, in order
+	uint64_t				_lastTicket;					//!< Ticket of the last asynchronous upload
+	uint64_t				_submittedTicket;				//!< Every asynchronous upload up to this ticket has its GPU copy issued
+	Statistics				_statistics;					//!< Usage of the ring
+
+	// [Staging worker]
+	std::thread				_stagingThread;					//!< Writes the data of asynchronous uploads into the staging buffer
+	std::deque<StagingJob>	_stagingJobs;					//!< Jobs not taken by the worker yet
+	uint64_t				_numQueuedJobs;					//!< Jobs given to the worker since it was launched
+	uint64_t				_numStagedJobs;					//!< Jobs finished by the worker, which are done in submission order
+	bool					_stopStaging;					//!< The worker finishes once there is no queued job
+	std::mutex				_stagingMutex;					//!< Protects the jobs and counters of the worker
+	std::condition_variable	_stagingQueued;					//!< Wakes up the worker once a job is queued or the ring is destroyed
+	std::condition_variable	_stagingFinished;				//!< Wakes up the OpenGL thread once a job is finished
+
+protected:
+	/**
+	*	@brief Default constructor.
+	*/
+	GPUUploadRing();
+
+	/**
+	*	@brief Creates and maps the staging buffer.
+	*/
+	void initialize();
+
+	/**
+	*	@brief Issues the GPU copies whose data is already in the staging buffer, in submission order. Segments left behind are fenced
+	*	once every copy from them is issued.
+	*	@param wait Waits for the worker rather than stopping at the first copy which is still being staged.
+	*/
+	uint64_t issueStagedCopies(const bool wait);
+
+	/**
+	*	@brief Moves to the next segment, fencing the current one if its copies are already issued.
+	*	@param wait Waits for the copies and the GPU to release the next segment. Otherwise, a segment still in use is not acquired.
+	*	@return False if the next segment is still in use and waiting was not requested.
+	*/
+	bool nextSegment(const bool wait);
+
+	/**
+	*	@brief Reserves a range of the current segment, moving to the next one if it is full.
+	*	@param wait Waits for the next segment if it is still in use.
+	*	@return Offset of the range within the staging buffer, or -1 if there is no free range and waiting was not requested.
+	*/
+	GLintptr reserve(const GLsizeiptr size, GLsizeiptr& reservedSize, const bool wait);
+
+	/**
+	*	@brief Reserves staging ranges for deferred uploads and queues their data for the worker, in submission order.
+	*	@param wait Waits for segments still in use, so that every deferred upload is staged.
+	*/
+	void stageDeferredUploads(const bool wait);
+
+	/**
+	*	@brief Main loop of the staging worker.
+	*/
+	void stageData();
+
+	/**
+	*	@brief Copies data larger than a segment through a staging buffer which is deleted right away. The driver keeps it until the copy is done.
+	*/
+	void uploadTransient(const GLuint bufferID, const GLintptr offset, const void* data, const GLsizeiptr size);
+
+public:
+	/**
+	*	@brief Destructor. Joins the staging worker and deletes the staging buffer and pending fences.
+	*/
+	virtual ~GPUUploadRing();
+
+	/**
+	*	@return Usage of the ring.
+	*/
+	const Statistics& getStatistics() const { return _statistics; }
+
+	/**
+	*	@brief Stages deferred uploads if segments were released, and issues the GPU copies of asynchronous uploads whose data is already 
+	*	in the staging buffer, in submission order.
+	*	@param wait Waits for every pending upload rather than stopping at the first one which is still being copied or has no room.
+	*	@return Ticket of the last upload whose copies were issued.
+	*/
+	uint64_t submitPendingCopies(const bool wait);
+
+	/**
+	*	@brief Copies data into a range of a buffer which already has enough storage.
+	*/
+	void upload(const GLuint bufferID, const GLintptr offset, const void* data, const GLsizeiptr size);
+
+	/**
+	*	@brief Copies data into a range of a buffer like upload(), but the data is written into the staging buffer by a worker thread, and the
+	*	GPU copy is issued by a later submitPendingCopies(). If the ring is full, the upload is deferred rather than waiting for the GPU. 
+	*	Meanwhile, data must stay valid and the range must not be used.
+	*	@return Ticket of the upload, which is complete once submitPendingCopies() returns the same ticket or a later one.
+	*/
+	uint64_t uploadAsync(const GLuint bufferID, const GLintptr offset, const void* data, const GLsizeiptr size);
+};
+
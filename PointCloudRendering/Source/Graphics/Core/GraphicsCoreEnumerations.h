@@ -51,11 +51,11 @@ struct RendEnum
 		REFLECTIVE_TRIANGLE_MESH_SHADER,
 		TRIANGLE_MESH_SHADER,
 		TRIANGLE_MESH_GROUP_SHADER,
-		TRIANGLE_MESH_NORMAL_SHADER,
-		TRIANGLE_MESH_POSITION_SHADER,
 		SHADOWS_SHADER,
+		SHADOWS_GROUP_SHADER,
 
 		// SSAO
+		BILATERAL_UPSAMPLE_SSAO_SHADER,
 		BLUR_SSAO_SHADER,
 		SSAO_SHADER,
 
@@ -83,6 +83,10 @@ struct RendEnum
 		REALLOCATE_RADIX_SORT,
 		RESET_BUFFER_INDEX,
 
+		// Culling
+		BUILD_HI_Z,
+		CULL_DRAW_COMMANDS,
+
 		// Model
 		COMPUTE_TANGENTS_1,
 		COMPUTE_TANGENTS_2,
@@ -97,11 +101,9 @@ struct RendEnum
 		IOTA_SHADER,
 		REDUCE_POINT_BUFFER_SHADER,
 		RESET_DEPTH_BUFFER_SHADER,
-		RESET_DEPTH_BUFFER_HQR_SHADER,
 		PROJECTION_SHADER,
 		PROJECTION_HQR_SHADER,
 		STORE_TEXTURE_SHADER,
-		STORE_TEXTURE_HQR_SHADER,
 		TRANSFER_POINTS_SHADER
 	};
 
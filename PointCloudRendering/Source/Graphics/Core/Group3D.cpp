@@ -7,18 +7,20 @@
 #include "Graphics/Application/Renderer.h"
 #include "Graphics/Application/RenderingParameters.h"
 #include "Graphics/Core/OpenGLUtilities.h"
+#include "Graphics/Core/SAHBVHBuilder.h"
 #include "Graphics/Core/ShaderList.h"
 #include "Graphics/Core/VAO.h"
 #include "Utilities/ChronoUtilities.h"
 
 /// [Initialization of static attributes]
 const GLuint	Group3D::BVH_BUILDING_RADIUS = 100;
+const GLuint	Group3D::MULTI_DRAW_BINDING = 0;
 
 /// [Public methods]
 
 Group3D::Group3D(const mat4& modelMatrix):
 	Model3D(modelMatrix, 1),									// Just in case we need to save some component properties
-	_numClusters(0), _bvhVAO(nullptr), _staticGPUData(nullptr)
+	_numClusters(0), _bvhVAO(nullptr), _multiDrawData(nullptr), _staticGPUData(nullptr)
 {
 }
 
@@ -30,153 +32,137 @@ Group3D::~Group3D()
 	}
 
 	delete _bvhVAO;
+	delete _multiDrawData;
 	delete _staticGPUData;
 }
 
 void Group3D::addComponent(Model3D* object)
 {
 	_objects.push_back(object);
+
+	// Components are registered along with the scene if it has not been done yet
+	if (!_globalModelComp.empty()) object->registerModelComponentGroup(this);
+	if (_multiDrawData) this->buildMultiDrawData();
 }
 
-Group3D::StaticGPUData* Group3D::generateBVH(bool buildVisualization)
+Group3D::StaticGPUData* Group3D::generateBVH(bool buildVisualization, const BVHBuilder builder, BVHBenchmark* benchmark)
 {
 	VolatileGPUData* volatileGPUData;
+	std::vector<BVHCluster> sahCluster;
+	std::vector<FaceGPUData> sahFace;
+	long long clusterMergingTime = 0, sahTime = 0;
+	size_t numFaces = 0;
 
-	this->aggregateSSBOData(volatileGPUData, _staticGPUData);
-
-	// BVH generation
-	const unsigned radius = BVH_BUILDING_RADIUS;
-	
-	ComputeShader* findNeighborShader		= ShaderList::getInstance()->getComputeShader(RendEnum::FIND_BEST_NEIGHBOR);
-	ComputeShader* clusterMergingShader		= ShaderList::getInstance()->getComputeShader(RendEnum::CLUSTER_MERGING);
-	ComputeShader* reallocClustersShader	= ShaderList::getInstance()->getComputeShader(RendEnum::REALLOCATE_CLUSTERS);
-	ComputeShader* endLoopCompShader		= ShaderList::getInstance()->getComputeShader(RendEnum::END_LOOP_COMPUTATIONS);
-
-	// Prefix scan
-	ComputeShader* reduceShader				= ShaderList::getInstance()->getComputeShader(RendEnum::REDUCE_PREFIX_SCAN);
-	ComputeShader* downSweepShader			= ShaderList::getInstance()->getComputeShader(RendEnum::DOWN_SWEEP_PREFIX_SCAN);
-	ComputeShader* resetPositionShader		= ShaderList::getInstance()->getComputeShader(RendEnum::RESET_LAST_POSITION_PREFIX_SCAN);
+	if (_globalModelComp.empty())
+	{
+		this->registerScene();
+	}
 
-	// Compute shader execution data: groups and iteration control
-	unsigned arraySize = _staticGPUData->_numTriangles, startIndex = arraySize, finishBit = 0, iteration, numExec, numThreads, startThreads;
-	int numGroups, numGroups2Log;
-	const int maxGroupSize = ComputeShader::getMaxGroupSize();
+	for (ModelComponent* modelComp : _globalModelComp)
+	{
+		numFaces += modelComp->_topology.size();
+	}
 
-	// Prepare buffers for GPU
-	BVHCluster* outCluster = new BVHCluster[arraySize];					// We declare an input buffer instead of asking for a GPU one cause we've proved it's faster
+	// Meshes would be released without building anything
+	if (!numFaces)
+	{
+		std::cerr << "BVH could not be built: the group has no faces." << std::endl;
+		return nullptr;
+	}
 
-	// Compact cluster buffer support
-	GLuint* currentPosBuffer = new GLuint[arraySize], *currentPosBufferOut = new GLuint[arraySize];
-	std::iota(currentPosBufferOut, currentPosBufferOut + arraySize, 0);
+	// The CPU builder only needs the component meshes, so it runs through the same path as builds without OpenGL context
+	if (builder == CPU_BINNED_SAH || benchmark)
+	{
+		ChronoUtilities::initChrono();
+		this->generateBVHOnCPU(sahCluster, sahFace);
+		sahTime = ChronoUtilities::getDuration();
+	}
 
-	GLuint coutBuffer				= volatileGPUData->_tempClusterSSBO;													// Swapped during loop => not const
-	GLuint cinBuffer				= ComputeShader::setReadBuffer(outCluster, arraySize);
-	GLuint inCurrentPosition		= ComputeShader::setReadBuffer(currentPosBuffer, arraySize);		// Position of compact buffer where a cluster is saved
-	GLuint outCurrentPosition		= ComputeShader::setReadBuffer(currentPosBufferOut, arraySize);
-	const GLuint neighborIndex		= ComputeShader::setWriteBuffer(GLuint(), arraySize);				// Nearest neighbor search	
-	const GLuint prefixScan			= ComputeShader::setWriteBuffer(GLuint(), arraySize);				// Final position of each valid cluster for the next loop iteration
-	const GLuint validCluster		= ComputeShader::setWriteBuffer(GLuint(), arraySize);				// Clusters which takes part of next loop iteration
-	const GLuint mergedCluster		= ComputeShader::setWriteBuffer(GLuint(), arraySize);				// A merged cluster is always valid, but the opposite situation is not fitting
-	const GLuint numNodesCount		= ComputeShader::setReadData(arraySize);							// Number of currently added nodes, which increases as the clusters are merged
-	const GLuint arraySizeCount		= ComputeShader::setWriteBuffer(GLuint(), 1);
+	this->aggregateSSBOData(volatileGPUData, _staticGPUData);
 
-	while (arraySize > 1)
+	// Both builders run over the same faces when benchmarked, though only the selected tree is kept
+	if (builder == GPU_CLUSTER_MERGING || benchmark)
 	{
-		// Binary tree and whole array group sizes and iteration boundaries
-		numGroups		= ComputeShader::getNumGroups(arraySize);
-		startThreads	= std::ceil(arraySize / 2.0f);
-		numExec			= std::ceil(std::log2(arraySize));
-		numGroups2Log	= ComputeShader::getNumGroups(startThreads);
-
-		std::vector<GLuint> threadCount{ startThreads };				// Thread sizes are repeated on reduce and sweep down phases
-		threadCount.reserve(numExec);
+		glFinish();
+		ChronoUtilities::initChrono();
+		this->buildClusterMergingBVH(volatileGPUData);
+		clusterMergingTime = ChronoUtilities::getDuration();								// Nodes are read back, so the GPU already finished
+	}
 
-		std::swap(coutBuffer, cinBuffer);
-		std::swap(inCurrentPosition, outCurrentPosition);
+	if (benchmark)
+	{
+		*benchmark = BVHBenchmark{ _staticGPUData->_numTriangles, clusterMergingTime, SAHBVHBuilder::computeSAHCost(volatileGPUData->_cluster), sahTime, SAHBVHBuilder::computeSAHCost(sahCluster) };
 
-		findNeighborShader->bindBuffers(std::vector<GLuint>{ cinBuffer, neighborIndex });
-		findNeighborShader->use();
-		findNeighborShader->setUniform("arraySize", arraySize);
-		findNeighborShader->setUniform("radius", radius);
-		findNeighborShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
+		std::cout << "BVH of " << benchmark->_numFaces << " faces. Cluster merging (GPU): " << benchmark->_clusterMergingTime << " ms, SAH cost " << benchmark->_clusterMergingCost
+				  << ". Binned SAH (CPU): " << benchmark->_sahTime << " ms, SAH cost " << benchmark->_sahCost << std::endl;
+	}
 
-		clusterMergingShader->bindBuffers(std::vector<GLuint>{ cinBuffer, _staticGPUData->_clusterSSBO, neighborIndex, validCluster, mergedCluster, 
-															   prefixScan, inCurrentPosition, numNodesCount });
-		clusterMergingShader->use();
-		clusterMergingShader->setUniform("arraySize", arraySize);
-		clusterMergingShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
+	if (builder == CPU_BINNED_SAH)
+	{
+		if (benchmark) glDeleteBuffers(1, &_staticGPUData->_clusterSSBO);
 
-		// FIRST STEP: build a binary tree with a summatory of the array
-		reduceShader->bindBuffers(std::vector<GLuint> { prefixScan });
-		reduceShader->use();
-		reduceShader->setUniform("arraySize", arraySize);
+		_staticGPUData->_clusterSSBO = ComputeShader::setReadBuffer(sahCluster, GL_STATIC_DRAW);
+		volatileGPUData->_cluster.swap(sahCluster);
+	}
 
-		iteration = 0;
-		while (iteration < numExec)
-		{
-			numThreads = threadCount[threadCount.size() - 1];
+	// CG Visualization
+	if (buildVisualization)
+	{
+		this->buildBVHVAO(volatileGPUData);
+	}
 
-			reduceShader->setUniform("iteration", iteration++);
-			reduceShader->setUniform("numThreads", numThreads);
-			reduceShader->execute(numGroups2Log, 1, 1, maxGroupSize, 1, 1);
+	delete volatileGPUData;
 
-			threadCount.push_back(std::ceil(numThreads / 2.0f));
-		}
+	return _staticGPUData;
+}
 
-		// SECOND STEP: set last position to zero, its faster to do it in GPU than retrieve the array in CPU, modify and write it again to GPU
-		resetPositionShader->bindBuffers(std::vector<GLuint> { prefixScan });
-		resetPositionShader->use();
-		resetPositionShader->setUniform("arraySize", arraySize);
-		resetPositionShader->execute(1, 1, 1, 1, 1, 1);
+bool Group3D::generateBVHOnCPU(std::vector<BVHCluster>& cluster, std::vector<FaceGPUData>& face)
+{
+	if (_globalModelComp.empty())
+	{
+		this->registerScene();
+	}
 
-		// THIRD STEP: build tree back to first level and compute final summatory
-		downSweepShader->bindBuffers(std::vector<GLuint> { prefixScan });
-		downSweepShader->use();
-		downSweepShader->setUniform("arraySize", arraySize);
+	size_t numFaces = 0;
 
-		iteration = threadCount.size() - 2;
-		while (iteration >= 0 && iteration < numExec)
-		{
-			downSweepShader->setUniform("iteration", iteration);
-			downSweepShader->setUniform("numThreads", threadCount[iteration--]);
-			downSweepShader->execute(numGroups2Log, 1, 1, maxGroupSize, 1, 1);
-		}
-
-		reallocClustersShader->bindBuffers(std::vector<GLuint>{ cinBuffer, coutBuffer, validCluster, prefixScan, inCurrentPosition, outCurrentPosition });
-		reallocClustersShader->use();
-		reallocClustersShader->setUniform("arraySize", arraySize);
-		reallocClustersShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
+	for (ModelComponent* modelComp : _globalModelComp)
+	{
+		if (modelComp->_geometry.empty() && !modelComp->_topology.empty()) return false;
+		numFaces += modelComp->_topology.size();
+	}
 
-		// Updates cluster size
-		endLoopCompShader->bindBuffers(std::vector<GLuint>{ arraySizeCount, prefixScan, validCluster });
-		endLoopCompShader->use();
-		endLoopCompShader->setUniform("arraySize", arraySize);
-		endLoopCompShader->execute(1, 1, 1, 1, 1, 1); 
+	face.clear();
+	face.reserve(numFaces);
 
-		arraySize = endLoopCompShader->readData(arraySizeCount, GLuint())[0];
+	// Face bounds are computed again, instead of relying on those read back from the mesh generation shader
+	for (ModelComponent* modelComp : _globalModelComp)
+	{
+		modelComp->computeFaceAABBs();
+		face.insert(face.end(), modelComp->_topology.begin(), modelComp->_topology.end());
 	}
 
-	// Wait for the end of compute shaders
-	BVHCluster* clusterData = ComputeShader::readData(_staticGPUData->_clusterSSBO, BVHCluster());
-	volatileGPUData->_cluster = std::move(std::vector<BVHCluster>(clusterData, clusterData + _staticGPUData->_numTriangles * 2 - 1));				
+	SAHBVHBuilder sahBuilder;
+	if (!sahBuilder.build(face, cluster)) return false;
 
-	// Free buffers from GPU
-	GLuint toDeleteBuffers[] = { coutBuffer, cinBuffer, inCurrentPosition, outCurrentPosition, neighborIndex,
-							     prefixScan, validCluster, mergedCluster, numNodesCount, arraySizeCount };
-	glDeleteBuffers(sizeof(toDeleteBuffers) / sizeof(GLuint), toDeleteBuffers);
+	_aabb = AABB(cluster.back()._minPoint, cluster.back()._maxPoint);
 
-	// CG Visualization
-	if (buildVisualization)
+	return true;
+}
+
+void Group3D::applyTransform(const mat4& transform)
+{
+	for (Model3D* model : _objects)
 	{
-		this->buildBVHVAO(volatileGPUData);
+		model->applyTransform(transform);
 	}
+}
 
-	// Free dynamic memory
-	delete[]	outCluster;
-	delete[]	currentPosBuffer;
-	delete[]	currentPosBufferOut;
-
-	return _staticGPUData;
+void Group3D::collectChangedRegions(std::vector<AABB>& regions)
+{
+	for (Model3D* model : _objects)
+	{
+		model->collectChangedRegions(regions);
+	}
 }
 
 Model3D::ModelComponent* Group3D::getModelComponent(unsigned id)
@@ -194,7 +180,20 @@ bool Group3D::load(const mat4& modelMatrix)
 		success &= model->load(mMatrix);
 	}
 
-	return success;
+	return (_loaded = success);
+}
+
+AABB Group3D::getTransformedAABB()
+{
+	AABB aabb;
+
+	for (Model3D* model : _objects)
+	{
+		const AABB modelAABB = model->getTransformedAABB();
+		if (!modelAABB.empty()) aabb.update(modelAABB);
+	}
+
+	return aabb;
 }
 
 void Group3D::registerModelComponent(ModelComponent* modelComp)
@@ -246,6 +245,12 @@ void Group3D::drawAsPoints(RenderingShader* shader, const RendEnum::RendShaderTy
 
 void Group3D::drawAsTriangles(RenderingShader* shader, const RendEnum::RendShaderTypes shaderType, std::vector<mat4>& matrix)
 {
+	if (shaderType == RendEnum::TRIANGLE_MESH_GROUP_SHADER)
+	{
+		this->drawMultiIndirect(shader, shaderType, matrix);
+		return;
+	}
+
 	Material* material = _modelComp[0]->_material;
 	this->setShaderUniforms(shader, shaderType, matrix);
 
@@ -273,6 +278,12 @@ void Group3D::drawAsReflectiveTriangles(RenderingShader* shader, const RendEnum:
 
 void Group3D::drawAsTriangles4Shadows(RenderingShader* shader, const RendEnum::RendShaderTypes shaderType, std::vector<mat4>& matrix)
 {
+	if (shaderType == RendEnum::SHADOWS_GROUP_SHADER)
+	{
+		this->drawMultiIndirect(shader, shaderType, matrix);
+		return;
+	}
+
 	this->setShaderUniforms(shader, shaderType, matrix);
 
 	for (Model3D* object : _objects)
@@ -294,6 +305,110 @@ void Group3D::drawBVH(RenderingShader* shader, const RendEnum::RendShaderTypes s
 	}
 }
 
+bool Group3D::cullMultiDraw(std::vector<mat4>& matrix, HiZBuffer* hiZBuffer, const bool coneCulling)
+{
+	RenderingParameters* rendParams = Renderer::getInstance()->getRenderingParameters();
+
+	if (!_multiDrawData)
+	{
+		this->buildMultiDrawData();
+	}
+
+	const GLuint numCommands = _multiDrawData->_numCommands;
+	if (!numCommands) return false;
+
+	this->updateMultiDrawTransforms();
+
+	if (!rendParams->_gpuCulling)
+	{
+		// The indirect buffer may have been written by the culling shader of a previous pass
+		ComputeShader::synchronizeBuffer(_multiDrawData->_indirectBuffer, GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, _multiDrawData->_commandSSBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _multiDrawData->_indirectBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, numCommands * sizeof(VAO::IndirectCommand));
+
+		return false;
+	}
+
+	ComputeShader* cullShader = ShaderList::getInstance()->getComputeShader(RendEnum::CULL_DRAW_COMMANDS);
+	const mat4 modelMatrix = matrix[RendEnum::MODEL_MATRIX] * _transformMatrix;
+	const bool occlusionCulling = rendParams->_occlusionCulling && hiZBuffer && hiZBuffer->isValid();
+
+	cullShader->bindBuffers(std::vector<GLuint>{ _multiDrawData->_commandSSBO, _multiDrawData->_drawSSBO, _multiDrawData->_boundsSSBO, _multiDrawData->_indirectBuffer, _multiDrawData->_occludedSSBO });
+	cullShader->use();
+	cullShader->setUniform("retest", GLint(false));
+	cullShader->setUniform("numCommands", numCommands);
+	cullShader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * modelMatrix);
+	cullShader->setUniform("mModelView", matrix[RendEnum::VIEW_MATRIX] * modelMatrix);
+	cullShader->setUniform("coneCulling", GLint(coneCulling));
+	cullShader->setUniform("occlusionCulling", GLint(occlusionCulling));
+	if (occlusionCulling) hiZBuffer->bindTexture(cullShader, 0, modelMatrix);
+	cullShader->execute(ComputeShader::getNumGroups(numCommands), 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+
+	// Commands are consumed by the next draws rather than by another shader
+	ComputeShader::synchronizeBuffer(_multiDrawData->_indirectBuffer, GL_COMMAND_BARRIER_BIT);
+
+	return occlusionCulling;
+}
+
+void Group3D::cullOccludedMultiDraw(std::vector<mat4>& matrix, HiZBuffer* hiZBuffer)
+{
+	if (!_multiDrawData || !_multiDrawData->_numCommands || !hiZBuffer->isValid()) return;
+
+	ComputeShader* cullShader = ShaderList::getInstance()->getComputeShader(RendEnum::CULL_DRAW_COMMANDS);
+	const mat4 modelMatrix = matrix[RendEnum::MODEL_MATRIX] * _transformMatrix;
+	const GLuint numCommands = _multiDrawData->_numCommands;
+
+	// Frustum and cone tests are not repeated, since every command which passed them was either drawn or flagged as occluded
+	cullShader->bindBuffers(std::vector<GLuint>{ _multiDrawData->_commandSSBO, _multiDrawData->_drawSSBO, _multiDrawData->_boundsSSBO, _multiDrawData->_indirectBuffer, _multiDrawData->_occludedSSBO });
+	cullShader->use();
+	cullShader->setUniform("retest", GLint(true));
+	cullShader->setUniform("numCommands", numCommands);
+	cullShader->setUniform("occlusionCulling", GLint(true));
+	hiZBuffer->bindTexture(cullShader, 0, modelMatrix);
+	cullShader->execute(ComputeShader::getNumGroups(numCommands), 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+
+	ComputeShader::synchronizeBuffer(_multiDrawData->_indirectBuffer, GL_COMMAND_BARRIER_BIT);
+}
+
+void Group3D::drawMultiIndirect(RenderingShader* shader, const RendEnum::RendShaderTypes shaderType, std::vector<mat4>& matrix)
+{
+	if (!_multiDrawData)
+	{
+		this->buildMultiDrawData();
+	}
+
+	if (_multiDrawData->_batch.empty()) return;
+
+	this->updateMultiDrawTransforms();
+	this->setShaderUniforms(shader, shaderType, matrix);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _multiDrawData->_indirectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MULTI_DRAW_BINDING, _multiDrawData->_drawSSBO);
+
+	// Depth does not depend on materials, so every command is drawn at once
+	if (shaderType == RendEnum::SHADOWS_GROUP_SHADER)
+	{
+		_multiDrawData->_vao->drawObjectIndirect(RendEnum::IBO_TRIANGLE_MESH, GL_TRIANGLES, 0, _multiDrawData->_numCommands);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		return;
+	}
+
+	for (const MultiDrawData::Batch& batch : _multiDrawData->_batch)
+	{
+		if (batch._material)
+		{
+			batch._material->applyMaterial(shader);
+		}
+
+		_multiDrawData->_vao->drawObjectIndirect(RendEnum::IBO_TRIANGLE_MESH, GL_TRIANGLES, batch._firstCommand, batch._numCommands);
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
 /// [Protected methods]
 
 void Group3D::aggregateSSBOData(VolatileGPUData*& volatileGPUData, StaticGPUData*& staticGPUData)
@@ -333,7 +448,16 @@ void Group3D::aggregateSSBOData(VolatileGPUData*& volatileGPUData, StaticGPUData
 
 		currentGeometry += numVertices;
 		currentTopology += modelComp->_topology.size();
+	}
 
+	// Indirect rendering needs the component meshes, which are not available anymore once released
+	if (!_multiDrawData)
+	{
+		this->buildMultiDrawData();
+	}
+
+	for (ModelComponent* modelComp : _globalModelComp)
+	{
 		modelComp->releaseMemory();
 	}
 
@@ -344,10 +468,6 @@ void Group3D::aggregateSSBOData(VolatileGPUData*& volatileGPUData, StaticGPUData
 	staticGPUData->_groupGeometrySSBO	= ComputeShader::setReadBuffer(groupData->_geometry, GL_STATIC_DRAW);
 	staticGPUData->_groupMeshSSBO		= ComputeShader::setReadBuffer(groupData->_meshData, GL_STATIC_DRAW);
 	staticGPUData->_groupTopologySSBO	= ComputeShader::setReadBuffer(groupData->_triangleMesh, GL_STATIC_DRAW);
-	const GLuint mortonCodes			= this->computeMortonCodes();
-	const GLuint sortedIndices			= this->sortFacesByMortonCode(mortonCodes);
-	
-	this->buildClusterBuffer(volatileGPUData, sortedIndices);
 
 	delete groupData;
 }
@@ -377,26 +497,158 @@ void Group3D::buildClusterBuffer(VolatileGPUData* gpuData, const GLuint sortedFa
 	buildClusterShader->setUniform("arraySize", arraySize);
 	buildClusterShader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
-	glDeleteBuffers(1, &sortedFaces);
-
 	delete[] clusterData;
 	delete[] tempClusterData;
 }
 
+void Group3D::buildClusterMergingBVH(VolatileGPUData* volatileGPUData)
+{
+	const GPUBuffer mortonCodes		= this->computeMortonCodes();
+	const GPUBuffer sortedIndices	= this->sortFacesByMortonCode(mortonCodes.getID());
+
+	this->buildClusterBuffer(volatileGPUData, sortedIndices.getID());
+
+	// BVH generation
+	const unsigned radius = BVH_BUILDING_RADIUS;
+	
+	ComputeShader* findNeighborShader		= ShaderList::getInstance()->getComputeShader(RendEnum::FIND_BEST_NEIGHBOR);
+	ComputeShader* clusterMergingShader		= ShaderList::getInstance()->getComputeShader(RendEnum::CLUSTER_MERGING);
+	ComputeShader* reallocClustersShader	= ShaderList::getInstance()->getComputeShader(RendEnum::REALLOCATE_CLUSTERS);
+	ComputeShader* endLoopCompShader		= ShaderList::getInstance()->getComputeShader(RendEnum::END_LOOP_COMPUTATIONS);
+
+	// Prefix scan
+	ComputeShader* reduceShader				= ShaderList::getInstance()->getComputeShader(RendEnum::REDUCE_PREFIX_SCAN);
+	ComputeShader* downSweepShader			= ShaderList::getInstance()->getComputeShader(RendEnum::DOWN_SWEEP_PREFIX_SCAN);
+	ComputeShader* resetPositionShader		= ShaderList::getInstance()->getComputeShader(RendEnum::RESET_LAST_POSITION_PREFIX_SCAN);
+
+	// Compute shader execution data: groups and iteration control
+	unsigned arraySize = _staticGPUData->_numTriangles, startIndex = arraySize, finishBit = 0, iteration, numExec, numThreads, startThreads;
+	int numGroups, numGroups2Log;
+	const int maxGroupSize = ComputeShader::getMaxGroupSize();
+
+	// Compact cluster buffer support
+	GLuint* currentPosBufferOut = new GLuint[arraySize];
+	std::iota(currentPosBufferOut, currentPosBufferOut + arraySize, 0);
+
+	// Buffers are borrowed from the pool and given back once this method returns
+	const GPUBuffer clusterBuffer	= ComputeShader::acquireWriteBuffer(BVHCluster(), arraySize);
+	GLuint coutBuffer				= volatileGPUData->_tempClusterSSBO;													// Swapped during loop => not const
+	GLuint cinBuffer				= clusterBuffer.getID();
+	GPUBuffer inCurrentPosition		= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);			// Position of compact buffer where a cluster is saved
+	GPUBuffer outCurrentPosition	= ComputeShader::acquireReadBuffer(currentPosBufferOut, arraySize);
+	const GPUBuffer neighborIndex	= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);			// Nearest neighbor search	
+	const GPUBuffer prefixScan		= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);			// Final position of each valid cluster for the next loop iteration
+	const GPUBuffer validCluster	= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);			// Clusters which takes part of next loop iteration
+	const GPUBuffer mergedCluster	= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);			// A merged cluster is always valid, but the opposite situation is not fitting
+	const GPUBuffer numNodesCount	= ComputeShader::acquireReadBuffer(&arraySize, 1);					// Number of currently added nodes, which increases as the clusters are merged
+	const GPUBuffer arraySizeCount	= ComputeShader::acquireReadBuffer(&arraySize, 1);					// Number of clusters, which is read by kernels instead of the CPU one
+
+	// The number of clusters is computed and read in GPU, so that an iteration is dispatched before the result of the previous one is read back. 
+	// Dispatches are sized with the last number known in CPU, which is an upper bound since clusters are only merged
+	GPUReadback<GLuint> arraySizeReadback, previousArraySizeReadback;
+
+	while (arraySize > 1)
+	{
+		// Binary tree and whole array group sizes and iteration boundaries
+		numGroups		= ComputeShader::getNumGroups(arraySize);
+		startThreads	= std::ceil(arraySize / 2.0f);
+		numExec			= std::ceil(std::log2(arraySize));
+		numGroups2Log	= ComputeShader::getNumGroups(startThreads);
+
+		std::vector<GLuint> threadCount{ startThreads };				// Thread sizes are repeated on reduce and sweep down phases
+		threadCount.reserve(numExec);
+
+		std::swap(coutBuffer, cinBuffer);
+		std::swap(inCurrentPosition, outCurrentPosition);
+
+		findNeighborShader->bindBuffers(std::vector<GLuint>{ cinBuffer, neighborIndex.getID(), arraySizeCount.getID() });
+		findNeighborShader->use();
+		findNeighborShader->setUniform("radius", radius);
+		findNeighborShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
+
+		clusterMergingShader->bindBuffers(std::vector<GLuint>{ cinBuffer, _staticGPUData->_clusterSSBO, neighborIndex.getID(), validCluster.getID(), mergedCluster.getID(), 
+															   prefixScan.getID(), inCurrentPosition.getID(), numNodesCount.getID(), arraySizeCount.getID() });
+		clusterMergingShader->use();
+		clusterMergingShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
+
+		// FIRST STEP: build a binary tree with a summatory of the array. Clusters beyond the GPU number do not modify the sums of the previous ones
+		reduceShader->bindBuffers(std::vector<GLuint> { prefixScan.getID() });
+		reduceShader->use();
+		reduceShader->setUniform("arraySize", arraySize);
+
+		iteration = 0;
+		while (iteration < numExec)
+		{
+			numThreads = threadCount[threadCount.size() - 1];
+
+			reduceShader->setUniform("iteration", iteration++);
+			reduceShader->setUniform("numThreads", numThreads);
+			reduceShader->execute(numGroups2Log, 1, 1, maxGroupSize, 1, 1);
+
+			threadCount.push_back(std::ceil(numThreads / 2.0f));
+		}
+
+		// SECOND STEP: set last position to zero, its faster to do it in GPU than retrieve the array in CPU, modify and write it again to GPU
+		resetPositionShader->bindBuffers(std::vector<GLuint> { prefixScan.getID() });
+		resetPositionShader->use();
+		resetPositionShader->setUniform("arraySize", arraySize);
+		resetPositionShader->execute(1, 1, 1, 1, 1, 1);
+
+		// THIRD STEP: build tree back to first level and compute final summatory
+		downSweepShader->bindBuffers(std::vector<GLuint> { prefixScan.getID() });
+		downSweepShader->use();
+		downSweepShader->setUniform("arraySize", arraySize);
+
+		iteration = threadCount.size() - 2;
+		while (iteration >= 0 && iteration < numExec)
+		{
+			downSweepShader->setUniform("iteration", iteration);
+			downSweepShader->setUniform("numThreads", threadCount[iteration--]);
+			downSweepShader->execute(numGroups2Log, 1, 1, maxGroupSize, 1, 1);
+		}
+
+		reallocClustersShader->bindBuffers(std::vector<GLuint>{ cinBuffer, coutBuffer, validCluster.getID(), prefixScan.getID(), inCurrentPosition.getID(), outCurrentPosition.getID(), 
+																arraySizeCount.getID() });
+		reallocClustersShader->use();
+		reallocClustersShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
+
+		// Updates cluster size
+		endLoopCompShader->bindBuffers(std::vector<GLuint>{ arraySizeCount.getID(), prefixScan.getID(), validCluster.getID() });
+		endLoopCompShader->use();
+		endLoopCompShader->execute(1, 1, 1, 1, 1, 1); 
+
+		// Waits for the previous iteration while the current one is running. Once it reaches a single cluster, the current iteration does nothing
+		previousArraySizeReadback = std::move(arraySizeReadback);
+		arraySizeReadback = ComputeShader::readDataAsync(arraySizeCount.getID(), GLuint(), 1);
+
+		if (previousArraySizeReadback.isValid()) arraySize = *previousArraySizeReadback.get();
+	}
+
+	// Wait for the end of compute shaders
+	volatileGPUData->_cluster = ComputeShader::readData(_staticGPUData->_clusterSSBO, BVHCluster(), _staticGPUData->_numTriangles * 2 - 1);				
+
+	// Free the temporary cluster buffer from GPU, whereas pooled buffers are given back on return
+	glDeleteBuffers(1, &volatileGPUData->_tempClusterSSBO);
+	volatileGPUData->_tempClusterSSBO = -1;
+
+	// Free dynamic memory
+	delete[]	currentPosBufferOut;
+}
+
 AABB Group3D::computeAABB(VolatileGroupData* groupData)
 {
 	ComputeShader* computeAABBShader	= ShaderList::getInstance()->getComputeShader(RendEnum::COMPUTE_GROUP_AABB);
 
-	const GLuint triangleBufferID		= ComputeShader::setReadBuffer(groupData->_triangleMesh, GL_DYNAMIC_DRAW);
-	const GLuint maxPointBufferID		= ComputeShader::setWriteBuffer(vec4(), 1, GL_DYNAMIC_DRAW);
-	const GLuint minPointBufferID		= ComputeShader::setWriteBuffer(vec4(), 1, GL_DYNAMIC_DRAW);
+	const GPUBuffer triangleBuffer		= ComputeShader::acquireReadBuffer(groupData->_triangleMesh.data(), unsigned(groupData->_triangleMesh.size()));
+	const GPUBuffer maxPointBuffer		= ComputeShader::acquireWriteBuffer(vec4(), 1);
+	const GPUBuffer minPointBuffer		= ComputeShader::acquireWriteBuffer(vec4(), 1);
 
 	unsigned arraySize		= _staticGPUData->_numTriangles;
 	const int numExec		= std::ceil(std::log2(arraySize));
 	unsigned numThreads		= std::ceil(arraySize / 2.0f);
 	int numGroups			= ComputeShader::getNumGroups(numThreads);
 
-	computeAABBShader->bindBuffers(std::vector<GLuint> { triangleBufferID, maxPointBufferID, minPointBufferID });
+	computeAABBShader->bindBuffers(std::vector<GLuint> { triangleBuffer.getID(), maxPointBuffer.getID(), minPointBuffer.getID() });
 	computeAABBShader->use();
 	computeAABBShader->setUniform("arraySize", arraySize);
 
@@ -410,25 +662,187 @@ AABB Group3D::computeAABB(VolatileGroupData* groupData)
 		numGroups = ComputeShader::getNumGroups(numThreads);
 	}
 
-	vec4* pMaxPoint = computeAABBShader->readData(maxPointBufferID, vec4()), *pMinPoint = computeAABBShader->readData(minPointBufferID, vec4());
-	vec3 maxPoint = *pMaxPoint, minPoint = *pMinPoint;
-
-	glDeleteBuffers(1, &triangleBufferID);
-	glDeleteBuffers(1, &maxPointBufferID);
-	glDeleteBuffers(1, &minPointBufferID);
+	// Both corners are copied before waiting, so that there is a single stall
+	GPUReadback<vec4> maxPointReadback = ComputeShader::readDataAsync(maxPointBuffer.getID(), vec4(), 1);
+	GPUReadback<vec4> minPointReadback = ComputeShader::readDataAsync(minPointBuffer.getID(), vec4(), 1);
+	vec3 maxPoint = *maxPointReadback.get(), minPoint = *minPointReadback.get();
 
 	return AABB(minPoint, maxPoint);
 }
 
-GLuint Group3D::computeMortonCodes()
+void Group3D::buildMultiDrawData()
+{
+	if (_globalModelComp.empty())
+	{
+		this->registerScene();
+	}
+
+	MultiDrawData* previousData = _multiDrawData;
+	std::unordered_map<ModelComponent*, size_t> previousIndex;
+	_multiDrawData = new MultiDrawData;
+
+	if (previousData)
+	{
+		for (size_t drawIdx = 0; drawIdx < previousData->_component.size(); ++drawIdx) previousIndex[previousData->_component[drawIdx]] = drawIdx;
+	}
+
+	// Single color materials are given by the draw data, so they can share a call. Textured ones need their textures to be bound
+	auto getBatchMaterial = [](ModelComponent* modelComp) -> Material*
+	{
+		return (modelComp->_material && !modelComp->_material->isUniformColor()) ? modelComp->_material : nullptr;
+	};
+
+	std::vector<ModelComponent*>& component = _multiDrawData->_component;
+	for (ModelComponent* modelComp : _globalModelComp)
+	{
+		if (!modelComp->_triangleMesh.empty() || previousIndex.count(modelComp)) component.push_back(modelComp);
+	}
+
+	std::stable_sort(component.begin(), component.end(), [&](ModelComponent* a, ModelComponent* b)
+	{
+		return std::less<Material*>()(getBatchMaterial(a), getBatchMaterial(b));
+	});
+
+	std::vector<VAO::IndirectCommand>& command = _multiDrawData->_command;
+	std::vector<MultiDrawData::DrawBounds>& bounds = _multiDrawData->_bounds;
+	std::vector<MultiDrawData::Batch>& batch = _multiDrawData->_batch;
+	Material* lastBatchMaterial = nullptr;
+	GLuint numVertices = 0, numIndices = 0;
+
+	for (GLuint drawIdx = 0; drawIdx < component.size(); ++drawIdx)
+	{
+		ModelComponent* modelComp = component[drawIdx];
+		Material* material = modelComp->_material, *batchMaterial = getBatchMaterial(modelComp);
+		const GLuint firstCommand = GLuint(command.size());
+		const AABB& aabb = modelComp->_aabb;
+		MultiDrawData::ComponentRange range{ numVertices, GLuint(modelComp->_geometry.size()), numIndices, GLuint(modelComp->_triangleMesh.size()), firstCommand, 0 };
+
+		if (modelComp->_triangleMesh.empty())
+		{
+			// Released mesh: commands and bounds are those of the previous data, moved to the new ranges
+			const MultiDrawData::ComponentRange& previousRange = previousData->_range[previousIndex[modelComp]];
+
+			range._numVertices = previousRange._numVertices;
+			range._numIndices = previousRange._numIndices;
+
+			for (GLuint commandIdx = previousRange._firstCommand; commandIdx < previousRange._firstCommand + previousRange._numCommands; ++commandIdx)
+			{
+				VAO::IndirectCommand previousCommand = previousData->_command[commandIdx];
+				previousCommand._firstIndex = previousCommand._firstIndex - previousRange._firstIndex + range._firstIndex;
+				previousCommand._baseVertex = GLint(range._firstVertex);
+				previousCommand._baseInstance = drawIdx;
+
+				command.push_back(previousCommand);
+				bounds.push_back(previousData->_bounds[commandIdx]);
+			}
+		}
+		// Indices stay local to the component, as the base vertex is added after checking the restart index. Meshlets of a component share its draw data
+		else if (modelComp->_meshlet.empty())
+		{
+			command.push_back(VAO::IndirectCommand{ GLuint(modelComp->_triangleMesh.size()), 1, range._firstIndex, GLint(range._firstVertex), drawIdx });
+			bounds.push_back(MultiDrawData::DrawBounds{ vec4(aabb.min(), aabb.empty() ? .0f : 1.0f), vec4(aabb.max(), .0f), vec4(.0f, 1.0f, .0f, 2.0f) });
+		}
+		else
+		{
+			for (const Model3D::Meshlet& meshlet : modelComp->_meshlet)
+			{
+				command.push_back(VAO::IndirectCommand{ meshlet._numIndices, 1, range._firstIndex + meshlet._firstIndex, GLint(range._firstVertex), drawIdx });
+				bounds.push_back(MultiDrawData::DrawBounds{ vec4(meshlet._minPoint, 1.0f), vec4(meshlet._maxPoint, .0f), vec4(meshlet._coneAxis, meshlet._coneCutoff) });
+			}
+		}
+
+		range._numCommands = GLuint(command.size()) - firstCommand;
+		_multiDrawData->_range.push_back(range);
+		numVertices += range._numVertices;
+		numIndices += range._numIndices;
+
+		MultiDrawData::DrawGPUData drawData;
+		drawData._transform		= modelComp->_root->getTransformMatrix();
+		drawData._kad			= material ? material->getColor(Texture::KAD_TEXTURE) : vec4(.0f);
+		drawData._ks			= material ? material->getColor(Texture::KS_TEXTURE) : vec4(.0f);
+		drawData._shininess		= material ? material->getShininess() : .0f;
+		drawData._useTextures	= batchMaterial != nullptr;
+		_multiDrawData->_drawData.push_back(drawData);
+
+		// A new batch starts whenever the textured material changes. The single color batch applies any of its materials so that 
+		// subroutines are set as they are with the classic path
+		if (batch.empty() || lastBatchMaterial != batchMaterial)
+		{
+			batch.push_back(MultiDrawData::Batch{ material, firstCommand, 0 });
+			lastBatchMaterial = batchMaterial;
+		}
+		else if (!batch.back()._material)
+		{
+			batch.back()._material = material;
+		}
+
+		batch.back()._numCommands += range._numCommands;
+	}
+
+	_multiDrawData->_numCommands = GLuint(command.size());
+
+	if (!command.empty())
+	{
+		_multiDrawData->_vao = new VAO(true);
+
+		const GLuint vbo = _multiDrawData->_vao->getVBO(RendEnum::VBO_POSITION), ibo = _multiDrawData->_vao->getIBO(RendEnum::IBO_TRIANGLE_MESH);
+		const GLuint previousVBO = previousData && previousData->_vao ? previousData->_vao->getVBO(RendEnum::VBO_POSITION) : 0;
+		const GLuint previousIBO = previousData && previousData->_vao ? previousData->_vao->getIBO(RendEnum::IBO_TRIANGLE_MESH) : 0;
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+		glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(numVertices) * sizeof(Model3D::VertexGPUData), nullptr, GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+		glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(numIndices) * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+
+		// Meshes in memory are uploaded, whereas released ones are only available in the previous buffers
+		for (size_t drawIdx = 0; drawIdx < component.size(); ++drawIdx)
+		{
+			ModelComponent* modelComp = component[drawIdx];
+			const MultiDrawData::ComponentRange& range = _multiDrawData->_range[drawIdx];
+
+			if (!modelComp->_triangleMesh.empty())
+			{
+				glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(range._firstVertex) * sizeof(Model3D::VertexGPUData), GLsizeiptr(range._numVertices) * sizeof(Model3D::VertexGPUData), modelComp->_geometry.data());
+				glBindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(range._firstIndex) * sizeof(GLuint), GLsizeiptr(range._numIndices) * sizeof(GLuint), modelComp->_triangleMesh.data());
+			}
+			else
+			{
+				const MultiDrawData::ComponentRange& previousRange = previousData->_range[previousIndex[modelComp]];
+
+				glBindBuffer(GL_COPY_READ_BUFFER, previousVBO);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(previousRange._firstVertex) * sizeof(Model3D::VertexGPUData), GLintptr(range._firstVertex) * sizeof(Model3D::VertexGPUData),
+									GLsizeiptr(range._numVertices) * sizeof(Model3D::VertexGPUData));
+				glBindBuffer(GL_COPY_READ_BUFFER, previousIBO);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(previousRange._firstIndex) * sizeof(GLuint), GLintptr(range._firstIndex) * sizeof(GLuint), GLsizeiptr(range._numIndices) * sizeof(GLuint));
+			}
+
+			// The classic path draws the same ranges, so the component does not keep its own copy of geometry and triangles
+			if (modelComp->_vao) modelComp->_vao->shareGeometry(_multiDrawData->_vao, GLint(range._firstVertex), RendEnum::IBO_TRIANGLE_MESH, range._firstIndex);
+		}
+
+		_multiDrawData->_commandSSBO = ComputeShader::setReadBuffer(command, GL_STATIC_DRAW);
+		_multiDrawData->_indirectBuffer = ComputeShader::setReadBuffer(command, GL_DYNAMIC_DRAW);				// Every component is drawn until culled
+		_multiDrawData->_drawSSBO = ComputeShader::setReadBuffer(_multiDrawData->_drawData, GL_DYNAMIC_DRAW);
+		_multiDrawData->_boundsSSBO = ComputeShader::setReadBuffer(bounds, GL_STATIC_DRAW);
+		_multiDrawData->_occludedSSBO = ComputeShader::setReadBuffer(std::vector<GLuint>(command.size(), 0), GL_DYNAMIC_DRAW);
+	}
+
+	delete previousData;
+}
+
+GPUBuffer Group3D::computeMortonCodes()
 {
 	ComputeShader* computeMortonShader = ShaderList::getInstance()->getComputeShader(RendEnum::COMPUTE_MORTON_CODES);
 
 	const unsigned arraySize = _staticGPUData->_numTriangles;
 	const int numGroups = ComputeShader::getNumGroups(arraySize);
-	const GLuint mortonCodeBuffer = ComputeShader::setWriteBuffer(unsigned(), arraySize);
+	GPUBuffer mortonCodeBuffer = ComputeShader::acquireWriteBuffer(unsigned(), arraySize);
 
-	computeMortonShader->bindBuffers(std::vector<GLuint> { _staticGPUData->_groupTopologySSBO, mortonCodeBuffer });
+	computeMortonShader->bindBuffers(std::vector<GLuint> { _staticGPUData->_groupTopologySSBO, mortonCodeBuffer.getID() });
 	computeMortonShader->use();
 	computeMortonShader->setUniform("arraySize", arraySize);
 	computeMortonShader->setUniform("sceneMaxBoundary", _aabb.max());
@@ -438,7 +852,7 @@ GLuint Group3D::computeMortonCodes()
 	return mortonCodeBuffer;
 }
 
-GLuint Group3D::sortFacesByMortonCode(const GLuint mortonCodes)
+GPUBuffer Group3D::sortFacesByMortonCode(const GLuint mortonCodes)
 {
 	ComputeShader* bitMaskShader			= ShaderList::getInstance()->getComputeShader(RendEnum::BIT_MASK_RADIX_SORT);
 	ComputeShader* reduceShader				= ShaderList::getInstance()->getComputeShader(RendEnum::REDUCE_PREFIX_SCAN);
@@ -461,24 +875,23 @@ GLuint Group3D::sortFacesByMortonCode(const GLuint mortonCodes)
 	// Fill indices array from zero to arraySize - 1
 	for (int i = 0; i < arraySize; ++i) { indices[i] = i; }
 
-	GLuint indicesBufferID_1, indicesBufferID_2, pBitsBufferID, nBitsBufferID, positionBufferID;
-	indicesBufferID_1	= ComputeShader::setWriteBuffer(GLuint(), arraySize);
-	indicesBufferID_2	= ComputeShader::setReadBuffer(indices, arraySize);					// Substitutes indicesBufferID_1 for the next iteration
-	pBitsBufferID		= ComputeShader::setWriteBuffer(GLuint(), arraySize);
-	nBitsBufferID		= ComputeShader::setWriteBuffer(GLuint(), arraySize);
-	positionBufferID	= ComputeShader::setWriteBuffer(GLuint(), arraySize);
+	GPUBuffer indicesBuffer_1		= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);
+	GPUBuffer indicesBuffer_2		= ComputeShader::acquireReadBuffer(indices, arraySize);			// Substitutes indicesBuffer_1 for the next iteration
+	const GPUBuffer pBitsBuffer		= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);
+	const GPUBuffer nBitsBuffer		= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);
+	const GLuint pBitsBufferID		= pBitsBuffer.getID(), nBitsBufferID = nBitsBuffer.getID();
 
 	while (currentBits < numBits)
 	{
 		std::vector<GLuint> threadCount{ startThreads };
 		threadCount.reserve(numExec);
 
-		std::swap(indicesBufferID_1, indicesBufferID_2);							// indicesBufferID_2 is initialized with indices cause it's swapped here
+		std::swap(indicesBuffer_1, indicesBuffer_2);								// indicesBuffer_2 is initialized with indices cause it's swapped here
 
 		// FIRST STEP: BIT MASK, check if a morton code gives zero or one for a certain mask (iteration)
 		unsigned bitMask = 1 << currentBits++;
 
-		bitMaskShader->bindBuffers(std::vector<GLuint> { mortonCodes, indicesBufferID_1, pBitsBufferID, nBitsBufferID });
+		bitMaskShader->bindBuffers(std::vector<GLuint> { mortonCodes, indicesBuffer_1.getID(), pBitsBufferID, nBitsBufferID });
 		bitMaskShader->use();
 		bitMaskShader->setUniform("arraySize", arraySize);
 		bitMaskShader->setUniform("bitMask", bitMask);
@@ -520,20 +933,37 @@ GLuint Group3D::sortFacesByMortonCode(const GLuint mortonCodes)
 			downSweepShader->execute(numGroups2Log, 1, 1, maxGroupSize, 1, 1);
 		}
 
-		reallocatePositionShader->bindBuffers(std::vector<GLuint> { pBitsBufferID, nBitsBufferID, indicesBufferID_1, indicesBufferID_2 });
+		reallocatePositionShader->bindBuffers(std::vector<GLuint> { pBitsBufferID, nBitsBufferID, indicesBuffer_1.getID(), indicesBuffer_2.getID() });
 		reallocatePositionShader->use();
 		reallocatePositionShader->setUniform("arraySize", arraySize);
 		reallocatePositionShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
 	}
 
-	glDeleteBuffers(1, &indicesBufferID_1);
-	glDeleteBuffers(1, &pBitsBufferID);
-	glDeleteBuffers(1, &nBitsBufferID);
-	glDeleteBuffers(1, &positionBufferID);
-
 	delete[] indices;
 
-	return indicesBufferID_2;
+	return indicesBuffer_2;
+}
+
+void Group3D::updateMultiDrawTransforms()
+{
+	bool changed = false;
+
+	for (size_t drawIdx = 0; drawIdx < _multiDrawData->_component.size(); ++drawIdx)
+	{
+		const mat4 transform = _multiDrawData->_component[drawIdx]->_root->getTransformMatrix();
+
+		if (transform != _multiDrawData->_drawData[drawIdx]._transform)
+		{
+			_multiDrawData->_drawData[drawIdx]._transform = transform;
+			changed = true;
+		}
+	}
+
+	if (changed)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _multiDrawData->_drawSSBO);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _multiDrawData->_drawData.size() * sizeof(MultiDrawData::DrawGPUData), _multiDrawData->_drawData.data());
+	}
 }
 
 void Group3D::writeModelComponentsPly()
@@ -573,6 +1003,20 @@ void Group3D::writeModelComponentsPly()
 	}
 }
 
+/// MultiDrawData
+
+Group3D::MultiDrawData::MultiDrawData() : _vao(nullptr), _commandSSBO(-1), _indirectBuffer(-1), _drawSSBO(-1), _boundsSSBO(-1), _occludedSSBO(-1), _numCommands(0)
+{
+}
+
+Group3D::MultiDrawData::~MultiDrawData()
+{
+	delete _vao;
+
+	GLuint toDeleteBuffers[] = { _commandSSBO, _indirectBuffer, _drawSSBO, _boundsSSBO, _occludedSSBO };
+	glDeleteBuffers(sizeof(toDeleteBuffers) / sizeof(GLuint), toDeleteBuffers);
+}
+
 /// VolatileGPUData
 
 Group3D::VolatileGPUData::VolatileGPUData() : _tempClusterSSBO(-1), _mortonCodesSSBO(-1)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Graphics/Core/GPUBufferPool.h"
+#include "Graphics/Core/HiZBuffer.h"
 #include "Graphics/Core/Model3D.h"
 #include "tinyply/tinyply.h"
 
@@ -17,12 +19,28 @@
 class Group3D: public Model3D
 {
 public:
+	struct MultiDrawData;
 	struct VolatileGPUData;
 	struct VolatileGroupData;
 	struct StaticGPUData;
 
+	enum BVHBuilder
+	{
+		GPU_CLUSTER_MERGING, CPU_BINNED_SAH
+	};
+
+	struct BVHBenchmark
+	{
+		unsigned						_numFaces;						//!< Leaves of both trees
+		long long						_clusterMergingTime;			//!< GPU cluster merging (ms), including the readback of the nodes
+		float							_clusterMergingCost;			//!< SAH cost of the cluster merging tree
+		long long						_sahTime;						//!< CPU binned SAH (ms), including the computation of face bounds
+		float							_sahCost;						//!< SAH cost of the binned SAH tree
+	};
+
 protected:
 	const static GLuint					BVH_BUILDING_RADIUS;			//!< Radius to search nearest neighbors in BVH building process
+	const static GLuint					MULTI_DRAW_BINDING;				//!< Binding of the per-draw data buffer in the multi-draw shader
 		
 protected:
 	AABB								_aabb;							//!< Boundaries of all those objects defined behind this group
@@ -35,6 +53,7 @@ protected:
 
 	// [Rendering status]
 	VAO*								_bvhVAO;						//!< VAO which allows us to render current tree level
+	MultiDrawData*						_multiDrawData;					//!< Geometry of every component packed for indirect rendering, built on first use
 
 protected:
 	/**
@@ -53,22 +72,41 @@ protected:
 	*/
 	void buildClusterBuffer(VolatileGPUData* gpuData, const GLuint sortedFaces);
 
+	/**
+	*	@brief Builds the BVH in GPU by merging nearest clusters of faces sorted by their morton codes.
+	*/
+	void buildClusterMergingBVH(VolatileGPUData* volatileGPUData);
+
 	/**
 	*	@brief Computes the AABB which wraps all the triangles contained in this group.
 	*	@param triangleBufferID To compute the AABB we need to define the triangle buffer in GPU, so that is saved to be reused.
 	*/
 	virtual AABB computeAABB(VolatileGroupData* groupData);
 
+	/**
+	*	@brief Packs the geometry and topology of every component into shared buffers, along with an indirect command and material
+	*	colors for each of them. Commands are sorted so that components with single color materials are drawn with one call. If the data
+	*	was already built (e.g. a component was added), components whose meshes were released are copied from the previous buffers. The
+	*	VAO of each component is then pointed to its range of the shared buffers, so that its geometry is not stored twice.
+	*/
+	void buildMultiDrawData();
+
 	/**
 	*	@brief Computes the morton codes for each triangle boundind box.
+	*	@return Pooled buffer with a code per triangle.
 	*/
-	GLuint computeMortonCodes();
+	GPUBuffer computeMortonCodes();
 
 	/**
 	*	@brief Rearranges the face array to sort it by morton codes.
 	*	@param mortonCodes Computed morton codes from faces buffer.
 	*/
-	GLuint sortFacesByMortonCode(const GLuint mortonCodes);
+	GPUBuffer sortFacesByMortonCode(const GLuint mortonCodes);
+
+	/**
+	*	@brief Uploads the transformations of those models which changed since the last frame.
+	*/
+	void updateMultiDrawTransforms();
 
 	/**
 	*	@brief Saves group objects in a PLY file. 
@@ -93,9 +131,30 @@ public:
 	void addComponent(Model3D* object);
 
 	/**
-	*	@brief Builds the BVH from scratch once the group is loaded.
+	*	@brief Transforms every object of the group at rendering time.
 	*/
-	StaticGPUData* generateBVH(bool buildVisualization = false);
+	virtual void applyTransform(const mat4& transform);
+
+	/**
+	*	@brief Builds the BVH from scratch once the group is loaded. Component meshes are released afterwards.
+	*	@param builder GPU cluster merging or CPU binned SAH. Both of them produce the same node layout.
+	*	@param benchmark If given, both builders are run and their build time and SAH cost are written, whereas only the tree of the selected builder is kept.
+	*/
+	StaticGPUData* generateBVH(bool buildVisualization = false, const BVHBuilder builder = GPU_CLUSTER_MERGING, BVHBenchmark* benchmark = nullptr);
+
+	/**
+	*	@brief Builds the BVH with the binned SAH builder without any OpenGL call, e.g. from a thread without context. Face bounds are
+	*	computed from the component meshes, which must not be released yet, and nothing is uploaded.
+	*	@param cluster Nodes of the tree, whose leaves refer to the given faces.
+	*	@param face Faces of every component, in the order of the group buffers.
+	*	@return False if there are no faces or component meshes were already released.
+	*/
+	bool generateBVHOnCPU(std::vector<BVHCluster>& cluster, std::vector<FaceGPUData>& face);
+
+	/**
+	*	@brief Appends the regions changed by any object of the group since the last call.
+	*/
+	virtual void collectChangedRegions(std::vector<AABB>& regions);
 
 	/**
 	*	@brief Loads all those components who belong to this group, applying the model matrix linked to such group.
@@ -124,6 +183,21 @@ public:
 	*/
 	AABB getAABB() { return _aabb; }
 
+	/**
+	*	@return True if the BVH was already generated, and so component meshes are not available anymore.
+	*/
+	bool hasBVH() const { return _staticGPUData != nullptr; }
+
+	/**
+	*	@return Number of BVH nodes, once its visualization is built.
+	*/
+	unsigned getNumClusters() const { return _numClusters; }
+
+	/**
+	*	@return Boundaries of the group objects once transformed.
+	*/
+	virtual AABB getTransformedAABB();
+
 	/**
 	*	@return Model component which is identifier by id param.
 	*/
@@ -184,7 +258,96 @@ public:
 	*/
 	virtual void drawBVH(RenderingShader* shader, const RendEnum::RendShaderTypes shaderType, std::vector<mat4>& matrix);
 
+	/**
+	*	@brief Culls the components, or their meshlets, for the next indirect draws in a compute shader. Components are drawn as long as no culling was requested.
+	*	@param matrix Model, view and view-projection matrices of the pass.
+	*	@param hiZBuffer Depth of the previous frame to test occlusion against, or nullptr if only frustum culling is applied.
+	*	@param coneCulling Meshlets facing away from the viewpoint are culled. Only valid for perspective cameras whose pass culls back faces.
+	*	@return True if components were tested for occlusion, and so those disoccluded in this frame need cullOccludedMultiDraw().
+	*/
+	bool cullMultiDraw(std::vector<mat4>& matrix, HiZBuffer* hiZBuffer, const bool coneCulling);
+
+	/**
+	*	@brief Second phase of occlusion culling: components rejected by the last cullMultiDraw() only because of the previous depth are tested
+	*	again against the depth of the components already drawn in this frame. The next indirect draws only render those which turned out visible.
+	*	@param hiZBuffer Pyramid built from the current frame.
+	*/
+	void cullOccludedMultiDraw(std::vector<mat4>& matrix, HiZBuffer* hiZBuffer);
+
+	/**
+	*	@brief Renders every component with an indirect call per batch of materials, instead of a call per component.
+	*	@param shader Multi-draw shader, which reads transformation and colors of each command from a buffer.
+	*	@param shaderType Index of shader at the list, so we can identify what type of uniform variables must be declared.
+	*	@param matrix Vector of matrices which can be applied in the rendering process.
+	*/
+	void drawMultiIndirect(RenderingShader* shader, const RendEnum::RendShaderTypes shaderType, std::vector<mat4>& matrix);
+
 public:
+	/**
+	*	@brief Shared buffers for multi-draw indirect rendering.
+	*/
+	struct MultiDrawData
+	{
+		struct DrawGPUData
+		{
+			mat4						_transform;						//!< Rendering transformation of the model
+			vec4						_kad;							//!< Diffuse color
+			vec4						_ks;							//!< Specular color
+			float						_shininess;						//!< Phong exponent
+			GLuint						_useTextures;					//!< Colors are sampled from the bound material instead
+			vec2						_padding;
+		};
+
+		struct DrawBounds
+		{
+			vec4						_minPoint;						//!< W is zero if the component has no bounds, so that it is never culled
+			vec4						_maxPoint;
+			vec4						_cone;							//!< Axis and cutoff of the normal cone, whose cutoff is greater than one if it cannot be back-facing
+		};
+
+		struct ComponentRange
+		{
+			GLuint						_firstVertex, _numVertices;		//!< Vertices of the component within the shared VBO
+			GLuint						_firstIndex, _numIndices;		//!< Triangle indices of the component within the shared IBO
+			GLuint						_firstCommand, _numCommands;	//!< Commands of the component
+		};
+
+		struct Batch
+		{
+			Material*					_material;						//!< Material applied before drawing the batch
+			GLuint						_firstCommand;					//!< First command of the batch
+			GLuint						_numCommands;					//!< Number of consecutive commands
+		};
+
+		// [GPU buffers]
+		VAO*							_vao;							//!< Geometry and topology of every component
+		GLuint							_commandSSBO;					//!< One command per component, as they were built
+		GLuint							_indirectBuffer;				//!< Commands of the last culling, whose instance count is zero for culled components
+		GLuint							_drawSSBO;						//!< Data of each command, indexed by its base instance
+		GLuint							_boundsSSBO;					//!< Local bounding box of each command
+		GLuint							_occludedSSBO;					//!< Commands rejected by the last culling only because of the depth pyramid
+
+		// [Metadata]
+		std::vector<Batch>				_batch;							//!< Single color materials share the first batch, whereas textured ones need a batch each
+		GLuint							_numCommands;					//!< One per meshlet, or per component if it has no meshlets
+		std::vector<ModelComponent*>	_component;						//!< Component of each draw data
+		std::vector<ComponentRange>		_range;							//!< Buffer ranges of each component, so that they can be copied when the data is rebuilt
+		std::vector<VAO::IndirectCommand> _command;						//!< CPU copy of the commands, whose meshes may have been released
+		std::vector<DrawBounds>			_bounds;						//!< CPU copy of the bounds of each command
+		std::vector<DrawGPUData>		_drawData;						//!< CPU copy of the draw data, so that transformations are only uploaded when they change
+
+		/**
+		*	@brief Default constructor.
+		*/
+		MultiDrawData();
+
+		/**
+		*	@brief Destructor.
+		*/
+		~MultiDrawData();
+	};
+
+
 	/**
 	*	@brief
 	*/
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "HiZBuffer.h"
+
+#include "Graphics/Core/ShaderList.h"
+
+/// [Public methods]
+
+HiZBuffer::HiZBuffer() : _textureID(0), _size(0), _numLevels(0), _viewMatrix(1.0f), _viewProjMatrix(1.0f), _valid(false)
+{
+}
+
+HiZBuffer::~HiZBuffer()
+{
+	glDeleteTextures(1, &_textureID);
+}
+
+void HiZBuffer::bindTexture(ComputeShader* shader, const GLuint unit, const mat4& modelMatrix)
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, _textureID);
+
+	shader->setUniform("texHiZ", GLint(unit));
+	shader->setUniform("hiZSize", _size);
+	shader->setUniform("hiZLevels", _numLevels);
+	shader->setUniform("mHiZModelView", _viewMatrix * modelMatrix);
+	shader->setUniform("mHiZModelViewProj", _viewProjMatrix * modelMatrix);
+}
+
+void HiZBuffer::build(const GLuint positionTexture, const ivec2& size, const mat4& viewMatrix, const mat4& viewProjMatrix)
+{
+	ComputeShader* buildShader = ShaderList::getInstance()->getComputeShader(RendEnum::BUILD_HI_Z);
+
+	if (size != _size)
+	{
+		this->allocate(size);
+	}
+
+	buildShader->use();
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, positionTexture);
+	buildShader->setUniform("texPosition", 0);
+	buildShader->setImageUniform(0, "previousLevel");
+	buildShader->setImageUniform(1, "currentLevel");
+
+	ivec2 previousSize = _size;
+
+	for (GLint level = 0; level < _numLevels; ++level)
+	{
+		const ivec2 currentSize = glm::max(_size >> level, ivec2(1));
+		const unsigned numTexels = currentSize.x * currentSize.y;
+
+		// Each level is reduced from the previous one, which must be completely written at this point
+		if (level > 0) glBindImageTexture(0, _textureID, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, _textureID, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		buildShader->setUniform("level", level);
+		buildShader->setUniform("previousSize", previousSize);
+		buildShader->setUniform("currentSize", currentSize);
+		buildShader->execute(ComputeShader::getNumGroups(numTexels), 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+
+		previousSize = currentSize;
+	}
+
+	_viewMatrix = viewMatrix;
+	_viewProjMatrix = viewProjMatrix;
+	_valid = true;
+}
+
+/// [Protected methods]
+
+void HiZBuffer::allocate(const ivec2& size)
+{
+	glDeleteTextures(1, &_textureID);
+
+	_size = size;
+	_numLevels = GLint(std::floor(std::log2(std::max(size.x, size.y)))) + 1;
+
+	glGenTextures(1, &_textureID);
+	glBindTexture(GL_TEXTURE_2D, _textureID);
+	glTexStorage2D(GL_TEXTURE_2D, _numLevels, GL_R32F, _size.x, _size.y);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Graphics/Core/ComputeShader.h"
+
+/**
+*	@file HiZBuffer.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Hierarchical depth of the last rendered frame. Each texel keeps the farthest view distance of the G-buffer pixels below it,
+*	so that a bounding box can be tested for occlusion with a few texel fetches. The camera of that frame is kept along with the pyramid.
+*/
+class HiZBuffer
+{
+protected:
+	GLuint		_textureID;						//!< R32F texture whose mip levels compose the pyramid
+	ivec2		_size;							//!< Size of the first level
+	GLint		_numLevels;						//!< Number of mip levels
+	mat4		_viewMatrix;					//!< View matrix of the frame the pyramid was built from
+	mat4		_viewProjMatrix;				//!< View-projection matrix of the frame the pyramid was built from
+	bool		_valid;							//!< The pyramid describes the last frame
+
+protected:
+	/**
+	*	@brief Allocates the pyramid for a new size.
+	*/
+	void allocate(const ivec2& size);
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	HiZBuffer();
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~HiZBuffer();
+
+	/**
+	*	@brief Sets the pyramid and the matrices of its frame as uniforms of a culling shader.
+	*	@param unit Texture unit where the pyramid is bound.
+	*/
+	void bindTexture(ComputeShader* shader, const GLuint unit, const mat4& modelMatrix);
+
+	/**
+	*	@brief Builds the pyramid from the view-space positions of a G-buffer.
+	*	@param positionTexture G-buffer texture with positions, whose alpha is zero where no triangle was drawn.
+	*	@param size Size of the position texture.
+	*	@param viewMatrix View matrix of the camera which rendered the G-buffer.
+	*	@param viewProjMatrix View-projection matrix of the camera which rendered the G-buffer.
+	*/
+	void build(const GLuint positionTexture, const ivec2& size, const mat4& viewMatrix, const mat4& viewProjMatrix);
+
+	/**
+	*	@brief Discards the pyramid, e.g. when the last frame did not fill the G-buffer.
+	*/
+	void invalidate() { _valid = false; }
+
+	/**
+	*	@return True if the pyramid describes the last frame.
+	*/
+	bool isValid() const { return _valid; }
+};
+
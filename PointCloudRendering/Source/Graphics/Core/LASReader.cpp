@@ -0,0 +1,189 @@
+#include "stdafx.h"
+#include "LASReader.h"
+
+#include "Utilities/MemoryMappedFile.h"
+
+// [Static members initialization]
+
+const unsigned LASReader::MIN_RECORD_LENGTH[11] = { 20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67 };
+const size_t LASReader::POINTS_PER_TASK = 1 << 18;
+const size_t LASReader::SAMPLED_RECORDS = 1 << 16;
+
+/// [Public methods]
+
+LASReader::LASReader() : _localOrigin(.0)
+{
+}
+
+bool LASReader::read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb)
+{
+	MemoryMappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+
+	Header header;
+	if (!this->readHeader(file.data(), file.size(), header))
+	{
+		std::cerr << "Unsupported LAS file: " << filename << std::endl;
+		return false;
+	}
+
+	// Truncated files are read up to their last complete record
+	const size_t availablePoints = (file.size() - header._dataOffset) / header._recordLength;
+	const size_t numPoints = std::min(size_t(header._numPoints), availablePoints);
+	const size_t numTasks = (numPoints + POINTS_PER_TASK - 1) / POINTS_PER_TASK;
+
+	this->detectValueRanges(file.data() + header._dataOffset, numPoints, header);
+
+	// Points are relative to the minimum corner, whose magnitude would otherwise exhaust the float precision
+	_localOrigin = header._minPoint;
+
+	points.resize(numPoints);
+	_classification.resize(numPoints);
+	_intensity.resize(numPoints);
+
+	std::vector<AABB> taskAABB(numTasks);
+	std::vector<size_t> tasks(numTasks);
+	std::iota(tasks.begin(), tasks.end(), 0);
+
+	// Tasks are launched in batches, so that decoded points can be consumed before the whole file is read
+	const size_t tasksPerBatch = std::max(1u, std::thread::hardware_concurrency()) * 2;
+
+	for (size_t firstTask = 0; firstTask < numTasks; firstTask += tasksPerBatch)
+	{
+		const size_t lastTask = std::min(firstTask + tasksPerBatch, numTasks);
+
+		std::for_each(std::execution::par, tasks.begin() + firstTask, tasks.begin() + lastTask, [&](const size_t task)
+			{
+				const size_t firstPoint = task * POINTS_PER_TASK, lastPoint = std::min(firstPoint + POINTS_PER_TASK, numPoints);
+
+				this->decodeRecords(file.data() + header._dataOffset, header, firstPoint, lastPoint, points.data());
+				taskAABB[task] = this->computeBoundaries(points.data() + firstPoint, lastPoint - firstPoint);
+			});
+
+		const size_t firstPoint = firstTask * POINTS_PER_TASK, lastPoint = std::min(lastTask * POINTS_PER_TASK, numPoints);
+		if (!this->notifyChunk(firstPoint, lastPoint - firstPoint, numPoints))
+		{
+			points.clear();
+			return false;
+		}
+	}
+
+	aabb = this->mergeBoundaries(taskAABB);
+
+	std::cout << "LAS " << unsigned(header._versionMajor) << "." << unsigned(header._versionMinor) << ", point format " << unsigned(header._pointFormat) << std::endl;
+
+	return numPoints > 0;
+}
+
+/// [Protected methods]
+
+void LASReader::decodeRecords(const uint8_t* records, const Header& header, const size_t firstPoint, const size_t lastPoint, PointModel* points)
+{
+	const bool extendedFormat = header._pointFormat >= 6;
+	const bool hasRGB = header._pointFormat == 2 || header._pointFormat == 3 || header._pointFormat == 7 || header._pointFormat == 8;
+	const unsigned classificationOffset = extendedFormat ? 16 : 15;
+	const unsigned rgbOffset = header._pointFormat == 2 ? 20 : (header._pointFormat == 3 ? 28 : 30);
+
+	auto readUInt16 = [](const uint8_t* data) -> uint16_t { uint16_t value; std::memcpy(&value, data, sizeof(uint16_t)); return value; };
+	auto readInt32 = [](const uint8_t* data) -> int32_t { int32_t value; std::memcpy(&value, data, sizeof(int32_t)); return value; };
+
+	for (size_t pointIdx = firstPoint; pointIdx < lastPoint; ++pointIdx)
+	{
+		const uint8_t* record = records + pointIdx * header._recordLength;
+		const glm::dvec3 position = glm::dvec3(readInt32(record), readInt32(record + 4), readInt32(record + 8)) * header._scale + header._offset;
+		const uint16_t intensity = readUInt16(record + 12);
+
+		points[pointIdx]._point = vec3(position - _localOrigin);
+		_intensity[pointIdx] = intensity;
+		_classification[pointIdx] = extendedFormat ? record[classificationOffset] : (record[classificationOffset] & 0x1F);
+
+		if (hasRGB)
+		{
+			const uint16_t red = readUInt16(record + rgbOffset), green = readUInt16(record + rgbOffset + 2), blue = readUInt16(record + rgbOffset + 4);
+
+			points[pointIdx]._rgb = PointModel::getRGBColor(vec3(red >> header._colorShift, green >> header._colorShift, blue >> header._colorShift));
+		}
+		else
+		{
+			points[pointIdx]._rgb = PointModel::getRGBColor(vec3(std::min(intensity >> header._intensityShift, 255)));
+		}
+	}
+}
+
+void LASReader::detectValueRanges(const uint8_t* records, const size_t numPoints, Header& header)
+{
+	const bool hasRGB = header._pointFormat == 2 || header._pointFormat == 3 || header._pointFormat == 7 || header._pointFormat == 8;
+	const unsigned rgbOffset = header._pointFormat == 2 ? 20 : (header._pointFormat == 3 ? 28 : 30);
+	const size_t step = std::max(numPoints / SAMPLED_RECORDS, size_t(1));
+	uint16_t maxColor = 0, maxIntensity = 0, value;
+
+	for (size_t pointIdx = 0; pointIdx < numPoints; pointIdx += step)
+	{
+		const uint8_t* record = records + pointIdx * header._recordLength;
+
+		std::memcpy(&value, record + 12, sizeof(uint16_t));
+		maxIntensity = std::max(maxIntensity, value);
+
+		for (unsigned channel = 0; hasRGB && channel < 3; ++channel)
+		{
+			std::memcpy(&value, record + rgbOffset + channel * sizeof(uint16_t), sizeof(uint16_t));
+			maxColor = std::max(maxColor, value);
+		}
+	}
+
+	// Colors are meant to be 16-bit values, but some writers only fill the lower byte
+	header._colorShift = maxColor > 255 ? 8 : 0;
+	header._intensityShift = 0;
+	while ((maxIntensity >> header._intensityShift) > 255) ++header._intensityShift;
+}
+
+bool LASReader::readHeader(const uint8_t* data, const size_t size, Header& header)
+{
+	const size_t minHeaderSize = 227;
+
+	if (size < minHeaderSize || std::memcmp(data, "LASF", 4) != 0)
+	{
+		return false;
+	}
+
+	auto read = [data](const size_t offset, auto& value) { std::memcpy(&value, data + offset, sizeof(value)); };
+	uint16_t headerSize;
+	uint32_t legacyNumPoints;
+	double bounds[6];
+
+	header._versionMajor = data[24];
+	header._versionMinor = data[25];
+	read(94, headerSize);
+	read(96, header._dataOffset);
+	read(104, header._pointFormat);
+	read(105, header._recordLength);
+	read(107, legacyNumPoints);
+	read(131, header._scale);
+	read(155, header._offset);
+	read(179, bounds);
+
+	header._numPoints = legacyNumPoints;
+	header._maxPoint = glm::dvec3(bounds[0], bounds[2], bounds[4]);
+	header._minPoint = glm::dvec3(bounds[1], bounds[3], bounds[5]);
+
+	// LAS 1.4 stores 64-bit counters; the legacy one is zero for formats 6-10 or large files
+	if (header._versionMajor == 1 && header._versionMinor >= 4 && headerSize >= 375 && size >= 375)
+	{
+		read(247, header._numPoints);
+	}
+
+	// Bits 6 and 7 of the format flag compressed (LAZ) records
+	if (header._pointFormat & 0xC0)
+	{
+		return false;
+	}
+
+	const uint8_t format = header._pointFormat;
+	const bool supportedFormat = format <= 3 || (format >= 6 && format <= 8);
+
+	return header._versionMajor == 1 && header._versionMinor >= 2 && header._versionMinor <= 4 && supportedFormat &&
+		   header._recordLength >= MIN_RECORD_LENGTH[format] && header._dataOffset < size;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Graphics/Core/PointCloudReader.h"
+
+/**
+*	@file LASReader.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Reader of LAS 1.2-1.4 files with point formats 0-3 and 6-8. Records are decoded in parallel from the mapped file. 
+*	Coordinates are computed in double precision and stored relative to a local origin, so that they keep their precision as floats.
+*/
+class LASReader : public PointCloudReader
+{
+public:
+	struct Header
+	{
+		uint8_t		_versionMajor, _versionMinor;				//!< LAS version
+		uint32_t	_dataOffset;								//!< Offset of the first point record
+		uint8_t		_pointFormat;								//!< Point data record format
+		uint16_t	_recordLength;								//!< Size of each point record, including extra bytes
+		uint64_t	_numPoints;									//!< Number of point records
+		glm::dvec3	_scale, _offset;							//!< Transformation from integer to real coordinates
+		glm::dvec3	_minPoint, _maxPoint;						//!< Bounding box stored in the header
+		unsigned	_colorShift, _intensityShift;				//!< Shifts that map colors and intensities into [0, 255]
+	};
+
+protected:
+	const static unsigned	MIN_RECORD_LENGTH[11];				//!< Minimum record length of each point format (bytes)
+	const static size_t		POINTS_PER_TASK;					//!< Number of points decoded by each parallel task
+	const static size_t		SAMPLED_RECORDS;					//!< Number of records inspected to detect the range of colors and intensities
+
+protected:
+	glm::dvec3				_localOrigin;						//!< Origin subtracted from every point
+	std::vector<uint8_t>	_classification;					//!< Classification of the last read points
+	std::vector<uint16_t>	_intensity;							//!< Intensity of the last read points
+
+protected:
+	/**
+	*	@brief Decodes a range of point records.
+	*/
+	void decodeRecords(const uint8_t* records, const Header& header, const size_t firstPoint, const size_t lastPoint, PointModel* points);
+
+	/**
+	*	@brief Inspects a sample of records to find out how colors and intensities must be scaled into 8 bits.
+	*/
+	static void detectValueRanges(const uint8_t* records, const size_t numPoints, Header& header);
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	LASReader();
+
+	/**
+	*	@return Classification of each point read in the last call.
+	*/
+	std::vector<uint8_t>& getClassification() { return _classification; }
+
+	/**
+	*	@return Intensity of each point read in the last call.
+	*/
+	std::vector<uint16_t>& getIntensity() { return _intensity; }
+
+	/**
+	*	@return Origin that must be added to the points to obtain their original coordinates.
+	*/
+	glm::dvec3 getLocalOrigin() const { return _localOrigin; }
+
+	/**
+	*	@brief Reads a LAS file. Formats without RGB are colored by their intensity.
+	*/
+	virtual bool read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb);
+
+	/**
+	*	@brief Parses the public header block.
+	*	@return False if the file is not a supported LAS file.
+	*/
+	static bool readHeader(const uint8_t* data, const size_t size, Header& header);
+};
+
@@ -88,6 +88,7 @@ Light::Light()
 	_shadowIntensity = vec2(0.0f, 1.0f);
 	_shadowRadius = .005;
 	_blurFilterSize = BLUR_FILTER_SIZE;
+	_shadowVersion = 0;
 }
 
 Light::~Light()
@@ -157,18 +158,21 @@ void Light::setLightType(const LightModels lightType)
 {
 	_lightType = lightType;
 	_shadowMapCamera->setCameraType((ORTHOGRAPHIC_CAMERA.find(_lightType) == ORTHOGRAPHIC_CAMERA.end()) ? Camera::PERSPECTIVE_PROJ : Camera::ORTHO_PROJ);
+	++_shadowVersion;
 }
 
 void Light::setPosition(const vec3& position)
 {
 	_position = position;
 	_shadowMapCamera->setPosition(position);
+	++_shadowVersion;
 }
 
 void Light::setDirection(const vec3& direction)
 {
 	_direction = glm::normalize(direction);
 	_shadowMapCamera->setLookAt(_position + direction);
+	++_shadowVersion;
 }
 
 void Light::setExponentS(const float exponent)
@@ -181,6 +185,7 @@ void Light::setUmbraPenumbraRange(const float innerAngle, const float outterAngl
 	_cosPenumbraAngle = std::cos(innerAngle * glm::pi<float>() / 180.0f);
 	_cosUmbraAngle = std::cos(outterAngle * glm::pi<float>() / 180.0f);
 	_shadowMapCamera->setFovX(std::cos(this->getUmbraDegrees()));
+	++_shadowVersion;
 }
 
 void Light::setAttenuationCoefficients(const float c1, const float c2, const float c3)
@@ -88,6 +88,7 @@ protected:
 	Camera*		_shadowMapCamera;					//!< Camera with its eye at the light position
 	ShadowMap*	_shadowMap;							//!< Shadow map rendered from the shadow map camera
 	float		_shadowRadius;						//!< Shadow radius from where offsets are considered
+	unsigned	_shadowVersion;						//!< Increased whenever the shadow map camera changes, so that the shadow map is rendered again
 
 protected:
 	/**
@@ -145,7 +146,7 @@ public:
 	/**
 	*	@brief Enables or disables the shadow projection from this light source.
 	*/
-	void castShadows(const bool enabled) { _castShadows = enabled; }
+	void castShadows(const bool enabled) { _castShadows = enabled; ++_shadowVersion; }
 
 	/**
 	*	@brief Light isn't enabled and must not be taken into account when rendering the scene.
@@ -274,6 +275,11 @@ public:
 	*/
 	ShadowMap* getShadowMap() const { return _shadowMap; }
 
+	/**
+	*	@return Version of the shadow map camera, which changes along with position, direction, type and aperture of the light.
+	*/
+	unsigned getShadowVersion() const { return _shadowVersion; }
+
 	/// [Setters]
 
 	/**
@@ -174,6 +174,26 @@ void Material::applyTexture(ShaderProgram* shader, const Texture::TextureTypes t
 	}
 }
 
+vec4 Material::getColor(const Texture::TextureTypes textureType) const
+{
+	return _texture[textureType] ? _texture[textureType]->getColor() : vec4(.0f);
+}
+
+bool Material::isUniformColor() const
+{
+	for (int textureType = 0; textureType < Texture::NUM_TEXTURE_TYPES; ++textureType)
+	{
+		if (!_texture[textureType]) continue;
+
+		if ((textureType != Texture::KAD_TEXTURE && textureType != Texture::KS_TEXTURE) || !_texture[textureType]->isUniformColor())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void Material::setDisplacementFactor(const float dispFactor)
 {
 	_displacementFactor = dispFactor;
@@ -86,6 +86,22 @@ public:
 	*/
 	void applyTexture(ShaderProgram* shader, const Texture::TextureTypes textureType);
 
+	/**
+	*	@return Color of a single color texture, or black if the texture is missing.
+	*/
+	vec4 getColor(const Texture::TextureTypes textureType) const;
+
+	/**
+	*	@return Phong exponent.
+	*/
+	float getShininess() const { return _shininess; }
+
+	/**
+	*	@return True if the material is only defined by single color diffuse and specular textures, so that it can be replaced by
+	*	its colors, e.g. when drawing many components with a single call.
+	*/
+	bool isUniformColor() const;
+
 	/**
 	*	@brief Modifies the displacement along the points tangents.
 	*	@param dispFactor Displacement length.
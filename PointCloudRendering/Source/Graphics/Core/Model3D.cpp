@@ -15,6 +15,8 @@
 // [Static variables initialization]
 
 const GLuint Model3D::RESTART_PRIMITIVE_INDEX	= 0xFFFFFFFF;
+const GLuint Model3D::MESHLET_MAX_TRIANGLES		= 128;
+const GLuint Model3D::MESHLET_MIN_TRIANGLES		= 32;
 
 std::unordered_map<std::string, unsigned> Model3D::_groupId;
 std::unordered_map<unsigned, std::string> Model3D::_groupName;
@@ -143,7 +145,7 @@ void Model3D::buildShadowOffsetTexture()
 /// [Public methods]
 
 Model3D::Model3D(const glm::mat4& modelMatrix, unsigned numComponents) :
-	_loaded(false), _modelMatrix(modelMatrix),  _modelComp(numComponents)
+	_loaded(false), _modelMatrix(modelMatrix), _transformMatrix(1.0f), _modelComp(numComponents)
 {
 	for (int i = 0; i < numComponents; ++i)
 	{
@@ -182,9 +184,46 @@ void Model3D::drawAsReflectiveTriangles(RenderingShader* shader, const RendEnum:
 {
 }
 
+void Model3D::applyTransform(const mat4& transform)
+{
+	_changedRegion.update(this->getTransformedAABB());
+	_transformMatrix = transform * _transformMatrix;
+	_changedRegion.update(this->getTransformedAABB());
+}
+
+void Model3D::collectChangedRegions(std::vector<AABB>& regions)
+{
+	if (!_changedRegion.empty())
+	{
+		regions.push_back(_changedRegion);
+		_changedRegion = AABB();
+	}
+}
+
 void Model3D::drawAsTriangles4Shadows(RenderingShader* shader, const RendEnum::RendShaderTypes shaderType, std::vector<mat4>& matrix)
 {
-	for (ModelComponent* modelComp : _modelComp) this->renderTriangles4Shadows(shader, shaderType, matrix, modelComp, GL_TRIANGLES);
+	const mat4 viewProjModel = matrix[RendEnum::VIEW_PROJ_MATRIX] * matrix[RendEnum::MODEL_MATRIX] * _transformMatrix;
+
+	// Only casters within the light frustum (or tile of it) are rendered
+	for (ModelComponent* modelComp : _modelComp)
+	{
+		if (modelComp->_aabb.empty() || modelComp->_aabb.intersectsFrustum(viewProjModel))
+		{
+			this->renderTriangles4Shadows(shader, shaderType, matrix, modelComp, GL_TRIANGLES);
+		}
+	}
+}
+
+AABB Model3D::getTransformedAABB()
+{
+	AABB aabb;
+
+	for (ModelComponent* modelComp : _modelComp)
+	{
+		if (!modelComp->_aabb.empty()) aabb.update(modelComp->_aabb.transform(_transformMatrix));
+	}
+
+	return aabb;
 }
 
 void Model3D::registerModelComponentGroup(Group3D* group)
@@ -195,6 +234,16 @@ void Model3D::registerModelComponentGroup(Group3D* group)
 	}
 }
 
+void Model3D::setModelMatrix(const mat4& modelMatrix)
+{
+	if (_loaded)
+	{
+		this->applyTransform(modelMatrix * glm::inverse(_modelMatrix));
+	}
+
+	_modelMatrix = modelMatrix;
+}
+
 void Model3D::setName(const std::string& name, const unsigned int compIndex)
 {
 	if (compIndex >= _modelComp.size())
@@ -290,8 +339,7 @@ void Model3D::computeTangents(ModelComponent* modelComp)
 	shader->setUniform("numVertices", numVertices);
 	shader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
-	VertexGPUData* data		= ComputeShader::readData(geometryBufferID, VertexGPUData());
-	modelComp->_geometry	= std::move(std::vector<VertexGPUData>(data, data + numVertices));
+	modelComp->_geometry	= ComputeShader::readData(geometryBufferID, VertexGPUData(), numVertices);
 
 	glDeleteBuffers(1, &geometryBufferID);
 	glDeleteBuffers(1, &meshBufferID);
@@ -355,15 +403,16 @@ void Model3D::generateWireframe()
 void Model3D::setShaderUniforms(ShaderProgram* shader, const RendEnum::RendShaderTypes shaderType, const std::vector<mat4>& matrix)
 {
 	RenderingParameters* rendParams = Renderer::getInstance()->getRenderingParameters();
+	const mat4 modelMatrix = matrix[RendEnum::MODEL_MATRIX] * _transformMatrix;
 
 	switch (shaderType)
 	{
 	case RendEnum::TRIANGLE_MESH_SHADER:
 	case RendEnum::TRIANGLE_MESH_GROUP_SHADER:
 	case RendEnum::REFLECTIVE_TRIANGLE_MESH_SHADER:
-		shader->setUniform("mModelView", matrix[RendEnum::VIEW_MATRIX] * matrix[RendEnum::MODEL_MATRIX]);
-		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * matrix[RendEnum::MODEL_MATRIX]);
-		shader->setUniform("mShadow", matrix[RendEnum::BIAS_VIEW_PROJ_MATRIX] * matrix[RendEnum::MODEL_MATRIX]);
+		shader->setUniform("mModelView", matrix[RendEnum::VIEW_MATRIX] * modelMatrix);
+		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * modelMatrix);
+		shader->setUniform("mShadow", matrix[RendEnum::BIAS_VIEW_PROJ_MATRIX] * modelMatrix);
 		
 		// ---- Alternative shadow technique
 		shader->setUniform("texOffset", 10);
@@ -373,27 +422,21 @@ void Model3D::setShaderUniforms(ShaderProgram* shader, const RendEnum::RendShade
 		break;
 
 	case RendEnum::POINT_CLOUD_SHADER:
-		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * matrix[RendEnum::MODEL_MATRIX]);
+		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * modelMatrix);
 		shader->setUniform("pointSize", rendParams->_scenePointSize);
 		shader->setUniform("vColor", rendParams->_scenePointCloudColor);
 
 		break;
 
 	case RendEnum::WIREFRAME_SHADER:
-		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * matrix[RendEnum::MODEL_MATRIX]);
+		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * modelMatrix);
 		shader->setUniform("vColor", rendParams->_wireframeColor);
 
 		break;
 
-	case RendEnum::TRIANGLE_MESH_NORMAL_SHADER:
-	case RendEnum::TRIANGLE_MESH_POSITION_SHADER:
-		shader->setUniform("mModelView", matrix[RendEnum::VIEW_MATRIX] * matrix[RendEnum::MODEL_MATRIX]);
-		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * matrix[RendEnum::MODEL_MATRIX]);
-
-		break;
-		
 	case RendEnum::SHADOWS_SHADER:
-		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * matrix[RendEnum::MODEL_MATRIX]);
+	case RendEnum::SHADOWS_GROUP_SHADER:
+		shader->setUniform("mModelViewProj", matrix[RendEnum::VIEW_PROJ_MATRIX] * modelMatrix);
 
 		break;
 	}
@@ -409,6 +452,7 @@ void Model3D::setVAOData()
 		modelComp->_topologyIndicesLength[RendEnum::IBO_POINT_CLOUD] = modelComp->_pointCloud.size();
 		modelComp->_topologyIndicesLength[RendEnum::IBO_WIREFRAME] = modelComp->_wireframe.size();
 		modelComp->_topologyIndicesLength[RendEnum::IBO_TRIANGLE_MESH] = modelComp->_triangleMesh.size();
+		modelComp->computeAABB();
 
 		vao->setVBOData(modelComp->_geometry);
 		vao->setIBOData(RendEnum::IBO_POINT_CLOUD, modelComp->_pointCloud);
@@ -504,6 +548,164 @@ void Model3D::ModelComponent::buildPointCloudTopology()
 	std::iota(_pointCloud.begin(), _pointCloud.end(), 0);
 }
 
+void Model3D::ModelComponent::computeAABB()
+{
+	_aabb = AABB();
+
+	for (const VertexGPUData& vertex : _geometry)
+	{
+		_aabb.update(vertex._position);
+	}
+}
+
+void Model3D::ModelComponent::computeFaceAABBs()
+{
+	for (FaceGPUData& face : _topology)
+	{
+		const vec3 a = _geometry[face._vertices.x]._position, b = _geometry[face._vertices.y]._position, c = _geometry[face._vertices.z]._position;
+
+		face._minPoint = glm::min(a, glm::min(b, c));
+		face._maxPoint = glm::max(a, glm::max(b, c));
+	}
+}
+
+void Model3D::ModelComponent::buildMeshlets()
+{
+	const size_t numTriangles = _triangleMesh.size() / 4;
+	std::vector<vec3> normal(numTriangles), centroid(numTriangles);
+	std::vector<std::pair<uint64_t, GLuint>> sortKey(numTriangles);
+	AABB centroidAABB;
+
+	_meshlet.clear();
+	if (!numTriangles) return;
+
+	auto expandBits = [](uint64_t value) -> uint64_t
+	{
+		value = (value | (value << 16)) & 0x030000FF;
+		value = (value | (value << 8)) & 0x0300F00F;
+		value = (value | (value << 4)) & 0x030C30C3;
+		value = (value | (value << 2)) & 0x09249249;
+
+		return value;
+	};
+
+	for (size_t triangle = 0; triangle < numTriangles; ++triangle)
+	{
+		const vec3 a = _geometry[_triangleMesh[triangle * 4 + 0]]._position;
+		const vec3 b = _geometry[_triangleMesh[triangle * 4 + 1]]._position;
+		const vec3 c = _geometry[_triangleMesh[triangle * 4 + 2]]._position;
+		const vec3 n = glm::cross(b - a, c - a);
+		const float length = glm::length(n);
+
+		normal[triangle] = length > glm::epsilon<float>() ? n / length : vec3(.0f);
+		centroid[triangle] = (a + b + c) / 3.0f;
+		centroidAABB.update(centroid[triangle]);
+	}
+
+	// Triangles are grouped by the dominant axis of their normal and sorted along a Morton curve within each group, so that meshlets are compact and their cones narrow
+	const vec3 centroidSize = glm::max(centroidAABB.max() - centroidAABB.min(), vec3(glm::epsilon<float>()));
+
+	for (size_t triangle = 0; triangle < numTriangles; ++triangle)
+	{
+		const vec3 absNormal = glm::abs(normal[triangle]);
+		const int axis = absNormal.x >= absNormal.y && absNormal.x >= absNormal.z ? 0 : (absNormal.y >= absNormal.z ? 1 : 2);
+		const uint64_t direction = axis * 2 + (normal[triangle][axis] < .0f);
+		const uvec3 cell = uvec3(glm::clamp((centroid[triangle] - centroidAABB.min()) / centroidSize, .0f, 1.0f) * 1023.0f);
+
+		sortKey[triangle] = std::make_pair((direction << 32) | (expandBits(cell.x) << 2) | (expandBits(cell.y) << 1) | expandBits(cell.z), GLuint(triangle));
+	}
+
+	std::sort(sortKey.begin(), sortKey.end());
+
+	// Each direction group is split into meshlets of balanced size, instead of full meshlets followed by a tiny one
+	std::vector<size_t> rangeBegin, meshletBegin;
+	size_t groupBegin = 0;
+
+	while (groupBegin < numTriangles)
+	{
+		size_t groupEnd = groupBegin + 1;
+		while (groupEnd < numTriangles && (sortKey[groupEnd].first >> 32) == (sortKey[groupBegin].first >> 32)) ++groupEnd;
+
+		const size_t groupSize = groupEnd - groupBegin, numRanges = (groupSize + MESHLET_MAX_TRIANGLES - 1) / MESHLET_MAX_TRIANGLES;
+		for (size_t range = 0; range < numRanges; ++range) rangeBegin.push_back(groupBegin + groupSize * range / numRanges);
+
+		groupBegin = groupEnd;
+	}
+
+	rangeBegin.push_back(numTriangles);
+
+	// Small groups are merged with the previous meshlet if both fit, since a wider cone is cheaper than a command for a few triangles
+	for (size_t range = 0; range + 1 < rangeBegin.size(); ++range)
+	{
+		const size_t begin = rangeBegin[range], end = rangeBegin[range + 1];
+		const bool merge = !meshletBegin.empty() && end - meshletBegin.back() <= MESHLET_MAX_TRIANGLES && (end - begin < MESHLET_MIN_TRIANGLES || begin - meshletBegin.back() < MESHLET_MIN_TRIANGLES);
+
+		if (!merge) meshletBegin.push_back(begin);
+	}
+
+	meshletBegin.push_back(numTriangles);
+
+	std::vector<GLuint> triangleMesh;
+	std::vector<FaceGPUData> topology;
+	const bool sortTopology = _topology.size() == numTriangles;					// Faces are kept in the same order as triangles
+
+	triangleMesh.reserve(_triangleMesh.size());
+	if (sortTopology) topology.reserve(numTriangles);
+
+	for (size_t meshletIdx = 0; meshletIdx + 1 < meshletBegin.size(); ++meshletIdx)
+	{
+		const size_t firstTriangle = meshletBegin[meshletIdx], lastTriangle = meshletBegin[meshletIdx + 1];
+
+		Meshlet meshlet;
+		AABB aabb;
+		vec3 normalSum(.0f);
+
+		meshlet._firstIndex = GLuint(triangleMesh.size());
+		meshlet._numIndices = GLuint(lastTriangle - firstTriangle) * 4;
+
+		for (size_t index = firstTriangle; index < lastTriangle; ++index)
+		{
+			const GLuint triangle = sortKey[index].second;
+
+			for (unsigned vertex = 0; vertex < 4; ++vertex)
+			{
+				triangleMesh.push_back(_triangleMesh[triangle * 4 + vertex]);
+				if (vertex < 3) aabb.update(_geometry[_triangleMesh[triangle * 4 + vertex]]._position);
+			}
+
+			if (sortTopology) topology.push_back(_topology[triangle]);
+			normalSum += normal[triangle];
+		}
+
+		const float normalLength = glm::length(normalSum);
+		float minDot = -1.0f;
+
+		if (normalLength > glm::epsilon<float>())
+		{
+			meshlet._coneAxis = normalSum / normalLength;
+			minDot = 1.0f;
+
+			for (size_t index = firstTriangle; index < lastTriangle; ++index)
+			{
+				const vec3& n = normal[sortKey[index].second];
+				if (n != vec3(.0f)) minDot = std::min(minDot, glm::dot(meshlet._coneAxis, n));				// Degenerate triangles are never visible
+			}
+		}
+		else
+		{
+			meshlet._coneAxis = vec3(.0f, 1.0f, .0f);
+		}
+
+		meshlet._coneCutoff = minDot > .0f ? std::sqrt(1.0f - minDot * minDot) : 2.0f;
+		meshlet._minPoint = aabb.min();
+		meshlet._maxPoint = aabb.max();
+		_meshlet.push_back(meshlet);
+	}
+
+	_triangleMesh.swap(triangleMesh);
+	if (sortTopology) _topology.swap(topology);
+}
+
 void Model3D::ModelComponent::buildWireframeTopology()
 {
 	std::unordered_map<int, std::unordered_set<int>> includedEdges;				// Already included edges
@@ -15,8 +15,13 @@ class TriangleMesh;
 class VAO;
 
 #define BINARY_EXTENSION ".bin"
+#define COMPRESSED_CACHE_EXTENSION ".pcc"
+#define LAS_EXTENSION ".las"
 #define OBJ_EXTENSION ".obj"
 #define PLY_EXTENSION ".ply"
+#define PTS_EXTENSION ".pts"
+#define TXT_EXTENSION ".txt"
+#define XYZ_EXTENSION ".xyz"
 
 /**
 *	@file Model3D.h
@@ -69,6 +74,22 @@ public:
 		float		_padding3;
 	};
 
+	/**
+	*	@brief Cluster of close triangles of a component with similar orientation, which is culled as a whole. Its triangles are 
+	*	consecutive in the triangle mesh of the component.
+	*/
+	struct Meshlet
+	{
+		vec3		_minPoint;								//!< Bounding box corner
+		GLuint		_firstIndex;							//!< First index in the triangle mesh
+
+		vec3		_maxPoint;
+		GLuint		_numIndices;							//!< Number of indices, including restart ones
+
+		vec3		_coneAxis;								//!< Average normal of the triangles
+		float		_coneCutoff;							//!< Sine of the cone aperture, greater than one if the meshlet can always face the camera
+	};
+
 	struct MeshGPUData
 	{
 		unsigned	_numVertices;
@@ -174,6 +195,8 @@ public:
 public:
 	// [Rendering]
 	const static GLuint		RESTART_PRIMITIVE_INDEX;		//!< Index which marks the end of a primitive
+	const static GLuint		MESHLET_MAX_TRIANGLES;			//!< Maximum number of triangles of a meshlet
+	const static GLuint		MESHLET_MIN_TRIANGLES;			//!< Meshlets below this size are merged with the previous one if possible
 
 protected:
 	static std::unordered_map<std::string, unsigned>	_groupId;
@@ -192,6 +215,10 @@ protected:
 
 	// [Matrices]
 	glm::mat4						_modelMatrix;			//!< World transformation
+	glm::mat4						_transformMatrix;		//!< Transformation applied while rendering, since geometry is baked with the model matrix at load time
+
+	// [Changes]
+	AABB							_changedRegion;			//!< Boundaries covered by the model before and after its last transformations, until they are collected
 
 protected:
 	/**
@@ -352,6 +379,16 @@ public:
 	*/
 	virtual void registerModelComponentGroup(Group3D* group);
 
+	/**
+	*	@brief Transforms the loaded geometry at rendering time and marks the covered boundaries as changed.
+	*/
+	virtual void applyTransform(const mat4& transform);
+
+	/**
+	*	@brief Appends the regions changed since the last call, e.g. to invalidate the shadow maps which depend on them.
+	*/
+	virtual void collectChangedRegions(std::vector<AABB>& regions);
+
 	// ------------- Getters ----------------
 
 	/**
@@ -364,6 +401,16 @@ public:
 	*/
 	mat4 getModelMatrix() { return _modelMatrix; }
 
+	/**
+	*	@return Transformation applied to the loaded geometry while rendering.
+	*/
+	mat4 getTransformMatrix() const { return _transformMatrix; }
+
+	/**
+	*	@return Boundaries of the loaded geometry once transformed.
+	*/
+	virtual AABB getTransformedAABB();
+
 	// -------------- Setters ------------------
 
 	/**
@@ -383,9 +430,9 @@ public:
 	void setMaterial(std::vector<Material*> material);
 
 	/**
-	*	@brief Assigns a new matrix for model transformation.
+	*	@brief Assigns a new matrix for model transformation. Loaded models are transformed while rendering.
 	*/
-	void setModelMatrix(const mat4& modelMatrix) { _modelMatrix = modelMatrix; }
+	void setModelMatrix(const mat4& modelMatrix);
 };
 
 class Model3D::ModelComponent
@@ -404,6 +451,8 @@ public:
 	// [GPU Data]
 	std::vector<VertexGPUData>	_geometry;									//!<
 	std::vector<FaceGPUData>	_topology;									//!<
+	AABB						_aabb;										//!< Boundaries of the geometry, which are kept once it is released
+	std::vector<Meshlet>		_meshlet;									//!< Clusters of the triangle mesh, empty if it is culled as a whole
 				
 	// [GPU storage]
 	VAO*						_vao;										//!<
@@ -440,6 +489,21 @@ public:
 	*/
 	virtual void buildPointCloudTopology();
 
+	/**
+	*	@brief Computes the boundaries of the loaded geometry.
+	*/
+	void computeAABB();
+
+	/**
+	*	@brief Computes the bounding box of each face on the CPU, as the face AABB shader does.
+	*/
+	void computeFaceAABBs();
+
+	/**
+	*	@brief Splits the triangle mesh into meshlets, reordering its triangles (and faces) so that each meshlet is a consecutive range.
+	*/
+	void buildMeshlets();
+
 	/**
 	*	@brief Builds an array with those indices which compose the wireframe topology.
 	*/
@@ -0,0 +1,278 @@
+#include "stdafx.h"
+#include "PLYReader.h"
+
+#include <future>
+
+// [Static members initialization]
+
+const size_t PLYReader::BLOCK_SIZE = 64 * 1024 * 1024;
+
+const std::unordered_map<std::string, PLYReader::PropertyType> PLYReader::PROPERTY_TYPE = 
+{
+	{ "char", INT8 }, { "int8", INT8 }, { "uchar", UINT8 }, { "uint8", UINT8 },
+	{ "short", INT16 }, { "int16", INT16 }, { "ushort", UINT16 }, { "uint16", UINT16 },
+	{ "int", INT32 }, { "int32", INT32 }, { "uint", UINT32 }, { "uint32", UINT32 },
+	{ "float", FLOAT32 }, { "float32", FLOAT32 }, { "double", FLOAT64 }, { "float64", FLOAT64 }
+};
+
+const unsigned PLYReader::PROPERTY_SIZE[NUM_PROPERTY_TYPES] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+
+const std::vector<std::vector<std::string>> PLYReader::VERTEX_PROPERTY_NAMES = 
+{
+	{ "x" }, { "y" }, { "z" }, { "red", "r", "diffuse_red" }, { "green", "g", "diffuse_green" }, { "blue", "b", "diffuse_blue" }
+};
+
+/// [Public methods]
+
+bool PLYReader::readHeader(std::istream& stream, Header& header)
+{
+	std::string line, keyword;
+	std::vector<unsigned> elementStride;											// Size of elements preceding vertices
+	std::vector<size_t> elementCount;
+	bool vertexElement = false, vertexFound = false, fixedPrecedingStride = true;
+
+	header = Header{ false, false, true, 0, 0, 0, 0, 0 };
+	for (Property& property : header._property) property._found = false;
+
+	if (!std::getline(stream, line) || line.compare(0, 3, "ply") != 0)
+	{
+		return false;
+	}
+
+	while (std::getline(stream, line))
+	{
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+
+		std::istringstream lineStream(line);
+		lineStream >> keyword;
+
+		if (keyword == "format")
+		{
+			std::string format;
+			lineStream >> format;
+
+			header._ascii = format == "ascii";
+			header._bigEndian = format == "binary_big_endian";
+		}
+		else if (keyword == "element")
+		{
+			std::string name;
+			size_t count;
+			lineStream >> name >> count;
+
+			// Files written by previous versions name the element pointCloud, with float colors in [0, 255]
+			vertexElement = (name == "vertex" || name == "pointCloud") && !vertexFound;
+			if (vertexElement)
+			{
+				vertexFound = true;
+				header._numVertices = count;
+			}
+			else if (!vertexFound)
+			{
+				elementStride.push_back(0);
+				elementCount.push_back(count);
+			}
+		}
+		else if (keyword == "property")
+		{
+			std::string type, name;
+			lineStream >> type;
+
+			if (type == "list")
+			{
+				if (vertexElement) header._fixedStride = false;
+				else if (!vertexFound) fixedPrecedingStride = false;
+
+				continue;
+			}
+
+			lineStream >> name;
+
+			auto typeIt = PROPERTY_TYPE.find(type);
+			if (typeIt == PROPERTY_TYPE.end())
+			{
+				std::cerr << "Unknown PLY property type: " << type << std::endl;
+				return false;
+			}
+
+			if (vertexElement)
+			{
+				for (unsigned propertyIdx = 0; propertyIdx < NUM_VERTEX_PROPERTIES; ++propertyIdx)
+				{
+					const std::vector<std::string>& names = VERTEX_PROPERTY_NAMES[propertyIdx];
+
+					if (!header._property[propertyIdx]._found && std::find(names.begin(), names.end(), name) != names.end())
+					{
+						header._property[propertyIdx] = Property{ typeIt->second, header._stride, header._numColumns, true };
+					}
+				}
+
+				header._stride += PROPERTY_SIZE[typeIt->second];
+				++header._numColumns;
+			}
+			else if (!vertexFound && !elementStride.empty())
+			{
+				elementStride.back() += PROPERTY_SIZE[typeIt->second];
+			}
+		}
+		else if (keyword == "end_header")
+		{
+			break;
+		}
+	}
+
+	if (!vertexFound || !header._property[X]._found || !header._property[Y]._found || !header._property[Z]._found)
+	{
+		return false;
+	}
+
+	header._dataOffset = size_t(stream.tellg());
+
+	// Elements written before the vertices must be skipped: each instance takes a line in ASCII files, even with list properties
+	for (const size_t count : elementCount)
+	{
+		header._numPrecedingLines += count;
+	}
+
+	if (!header._ascii)
+	{
+		if (!fixedPrecedingStride) header._fixedStride = false;
+
+		for (size_t elementIdx = 0; elementIdx < elementStride.size(); ++elementIdx)
+		{
+			header._dataOffset += elementStride[elementIdx] * elementCount[elementIdx];
+		}
+	}
+
+	return true;
+}
+
+bool PLYReader::read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb)
+{
+	std::ifstream fin(filename, std::ios::in | std::ios::binary);
+	if (!fin.is_open())
+	{
+		return false;
+	}
+
+	Header header;
+	if (!this->readHeader(fin, header) || header._ascii || !header._fixedStride)
+	{
+		return false;
+	}
+
+	fin.seekg(header._dataOffset, std::ios::beg);
+
+	const size_t recordsPerBlock = std::max(size_t(1), BLOCK_SIZE / header._stride);
+	std::vector<uint8_t> readBlock(recordsPerBlock * header._stride), convertedBlock(recordsPerBlock * header._stride);
+	size_t readRecords = 0, convertedRecords = 0;
+
+	points.resize(header._numVertices);
+	aabb = AABB();
+
+	auto readNextBlock = [&](std::vector<uint8_t>& block) -> size_t
+	{
+		const size_t numRecords = std::min(recordsPerBlock, header._numVertices - readRecords);
+		fin.read(reinterpret_cast<char*>(block.data()), numRecords * header._stride);
+		readRecords += numRecords;
+
+		return fin ? numRecords : 0;
+	};
+
+	// Double buffering: the next block is read from disk while the current one is converted
+	size_t numRecords = readNextBlock(readBlock);
+
+	while (numRecords > 0)
+	{
+		std::swap(readBlock, convertedBlock);
+		
+		std::future<size_t> nextBlock = std::async(std::launch::async, [&]() { return readRecords < header._numVertices ? readNextBlock(readBlock) : 0; });
+		aabb.update(this->convertBlock(convertedBlock.data(), numRecords, header, points.data() + convertedRecords));
+		const bool proceed = this->notifyChunk(convertedRecords, numRecords, header._numVertices);
+		convertedRecords += numRecords;
+
+		numRecords = nextBlock.get();
+
+		if (!proceed)
+		{
+			points.clear();
+			return false;
+		}
+	}
+
+	if (convertedRecords != header._numVertices)
+	{
+		std::cerr << "Truncated PLY file: " << filename << std::endl;
+		points.resize(convertedRecords);
+	}
+
+	return convertedRecords > 0;
+}
+
+/// [Protected methods]
+
+AABB PLYReader::convertBlock(const uint8_t* block, const size_t numRecords, const Header& header, PointModel* points)
+{
+	const size_t numTasks = std::max(1u, std::thread::hardware_concurrency());
+	const size_t recordsPerTask = (numRecords + numTasks - 1) / numTasks;
+	std::vector<AABB> taskAABB(numTasks);
+	std::vector<size_t> tasks(numTasks);
+	std::iota(tasks.begin(), tasks.end(), 0);
+
+	std::for_each(std::execution::par, tasks.begin(), tasks.end(), [&](const size_t task)
+		{
+			const size_t firstRecord = std::min(task * recordsPerTask, numRecords), lastRecord = std::min(firstRecord + recordsPerTask, numRecords);
+			const Property* property = header._property;
+
+			for (size_t recordIdx = firstRecord; recordIdx < lastRecord; ++recordIdx)
+			{
+				const uint8_t* record = block + recordIdx * header._stride;
+				PointModel& point = points[recordIdx];
+
+				point._point = vec3(readProperty(record, property[X], header._bigEndian), readProperty(record, property[Y], header._bigEndian), readProperty(record, property[Z], header._bigEndian));
+				point._rgb = glm::packUnorm4x8(vec4(readColor(record, property[RED], header._bigEndian), readColor(record, property[GREEN], header._bigEndian), 
+													readColor(record, property[BLUE], header._bigEndian), .0f) / 255.0f);
+			}
+
+			taskAABB[task] = this->computeBoundaries(points + firstRecord, lastRecord - firstRecord);
+		});
+
+	return this->mergeBoundaries(taskAABB);
+}
+
+double PLYReader::readProperty(const uint8_t* record, const Property& property, const bool bigEndian)
+{
+	uint8_t bytes[8];
+	const unsigned size = PROPERTY_SIZE[property._type];
+
+	if (bigEndian) std::reverse_copy(record + property._offset, record + property._offset + size, bytes);
+	else std::memcpy(bytes, record + property._offset, size);
+
+	switch (property._type)
+	{
+	case INT8:		{ int8_t value;		std::memcpy(&value, bytes, size); return value; }
+	case UINT8:		{ uint8_t value;	std::memcpy(&value, bytes, size); return value; }
+	case INT16:		{ int16_t value;	std::memcpy(&value, bytes, size); return value; }
+	case UINT16:	{ uint16_t value;	std::memcpy(&value, bytes, size); return value; }
+	case INT32:		{ int32_t value;	std::memcpy(&value, bytes, size); return value; }
+	case UINT32:	{ uint32_t value;	std::memcpy(&value, bytes, size); return value; }
+	case FLOAT32:	{ float value;		std::memcpy(&value, bytes, size); return value; }
+	case FLOAT64:	{ double value;		std::memcpy(&value, bytes, size); return value; }
+	default:		return .0;
+	}
+}
+
+uint8_t PLYReader::readColor(const uint8_t* record, const Property& property, const bool bigEndian)
+{
+	if (!property._found) return 255;
+
+	const double value = readProperty(record, property, bigEndian);
+
+	// Wider integer types are scaled down, while floating point colors are expected to be in [0, 255]
+	switch (property._type)
+	{
+	case UINT16:	return uint8_t(uint32_t(value) >> 8);
+	case UINT32:	return uint8_t(uint32_t(value) >> 24);
+	default:		return uint8_t(glm::clamp(value, .0, 255.0));
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Graphics/Core/PointCloudReader.h"
+
+/**
+*	@file PLYReader.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Streaming reader of binary PLY point clouds. Vertex records are read in large blocks which are converted 
+*	into PointModel by several threads while the next block is being read from disk.
+*/
+class PLYReader : public PointCloudReader
+{
+public:
+	enum PropertyType : uint8_t
+	{
+		INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, NUM_PROPERTY_TYPES
+	};
+
+	enum VertexProperty : uint8_t
+	{
+		X, Y, Z, RED, GREEN, BLUE, NUM_VERTEX_PROPERTIES
+	};
+
+	struct Property
+	{
+		PropertyType	_type;						//!< Type of the stored value
+		unsigned		_offset;					//!< Offset within a vertex record (bytes)
+		unsigned		_column;					//!< Index of the property within the vertex element
+		bool			_found;						//!< False if the vertex element does not contain this property
+	};
+
+	struct Header
+	{
+		bool			_ascii;						//!< Format is ASCII instead of binary
+		bool			_bigEndian;					//!< Binary values are stored as big endian
+		bool			_fixedStride;				//!< False if any list property precludes computing the record size
+		size_t			_dataOffset;				//!< Offset of the first vertex record from the beginning of the file (binary) or first line after header (ASCII)
+		size_t			_numVertices;				//!< Number of vertex records
+		size_t			_numPrecedingLines;			//!< Number of ASCII lines of the elements written before the vertices
+		unsigned		_numColumns;				//!< Number of properties of the vertex element
+		unsigned		_stride;					//!< Size of each vertex record (bytes)
+		Property		_property[NUM_VERTEX_PROPERTIES];	//!< Location of the properties we are interested in
+	};
+
+protected:
+	const static size_t											BLOCK_SIZE;				//!< Size of each block read from disk (bytes)
+	const static std::unordered_map<std::string, PropertyType>	PROPERTY_TYPE;			//!< Type of each PLY type name
+	const static unsigned										PROPERTY_SIZE[NUM_PROPERTY_TYPES];	//!< Size of each property type (bytes)
+	const static std::vector<std::vector<std::string>>			VERTEX_PROPERTY_NAMES;	//!< Accepted names for each vertex property
+
+protected:
+	/**
+	*	@brief Converts a block of vertex records into points, using several threads.
+	*	@return Bounding box of the converted points.
+	*/
+	AABB convertBlock(const uint8_t* block, const size_t numRecords, const Header& header, PointModel* points);
+
+	/**
+	*	@return Value of a property in a binary record, whatever its type and endianness is.
+	*/
+	static double readProperty(const uint8_t* record, const Property& property, const bool bigEndian);
+
+	/**
+	*	@return Value of a property as an unsigned byte.
+	*/
+	static uint8_t readColor(const uint8_t* record, const Property& property, const bool bigEndian);
+
+public:
+	/**
+	*	@brief Parses the header of a PLY file, locating the vertex properties regardless of their order and type.
+	*	@return False if the header is not valid or there is no vertex element.
+	*/
+	static bool readHeader(std::istream& stream, Header& header);
+
+	/**
+	*	@brief Reads a binary PLY file. ASCII files and vertex elements with list properties are rejected.
+	*/
+	virtual bool read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb);
+};
+
@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "PLYWriter.h"
+
+#include <charconv>
+#include <filesystem>
+#include <future>
+
+// [Static members initialization]
+
+const size_t PLYWriter::POINTS_PER_BLOCK = 1 << 22;
+const size_t PLYWriter::RECORD_SIZE = 3 * sizeof(float) + 3 * sizeof(uint8_t);
+
+/// [Public methods]
+
+bool PLYWriter::write(const std::string& filename, const PointModel* points, const size_t numPoints, const bool ascii, BackgroundTask* task)
+{
+	std::ofstream fout(filename, std::ios::out | std::ios::binary);
+
+	if (!fout.is_open())
+	{
+		std::cerr << "Failed to open " << filename << "." << std::endl;
+		return false;
+	}
+
+	const std::string header = getHeader(numPoints, ascii);
+	fout.write(header.data(), header.size());
+
+	std::vector<char> encodedBlock, writtenBlock;
+	std::future<bool> writing = std::async(std::launch::deferred, []() { return true; });
+	size_t encodedPoints = 0;
+	bool success = bool(fout);
+
+	// Double buffering: the next block is encoded while the previous one is written to disk
+	while (success && encodedPoints < numPoints)
+	{
+		if (task && task->isCancelled())
+		{
+			success = false;
+			break;
+		}
+
+		const size_t blockPoints = std::min(POINTS_PER_BLOCK, numPoints - encodedPoints);
+
+		if (ascii)	encodeASCIIBlock(points + encodedPoints, blockPoints, encodedBlock);
+		else		encodeBinaryBlock(points + encodedPoints, blockPoints, encodedBlock);
+
+		success = writing.get();
+		std::swap(encodedBlock, writtenBlock);
+		writing = std::async(std::launch::async, [&fout, &writtenBlock]() { return bool(fout.write(writtenBlock.data(), writtenBlock.size())); });
+
+		encodedPoints += blockPoints;
+		if (task) task->setProgress(float(encodedPoints) / numPoints);
+	}
+
+	success = writing.get() && success;
+	fout.close();
+
+	if (!success)
+	{
+		std::cerr << "Point cloud " << filename << " was not completely written." << std::endl;
+		std::filesystem::remove(filename);
+	}
+
+	return success;
+}
+
+/// [Protected methods]
+
+void PLYWriter::encodeASCIIBlock(const PointModel* points, const size_t numPoints, std::vector<char>& block)
+{
+	const size_t maxLineLength = 3 * 16 + 3 * 4 + 1;
+	const size_t numTasks = std::max(1u, std::thread::hardware_concurrency());
+	const size_t pointsPerTask = (numPoints + numTasks - 1) / numTasks;
+	std::vector<std::vector<char>> taskBlock(numTasks);
+	std::vector<size_t> tasks(numTasks);
+	std::iota(tasks.begin(), tasks.end(), 0);
+
+	std::for_each(std::execution::par, tasks.begin(), tasks.end(), [&](const size_t task)
+		{
+			const size_t firstPoint = std::min(task * pointsPerTask, numPoints), lastPoint = std::min(firstPoint + pointsPerTask, numPoints);
+			std::vector<char>& text = taskBlock[task];
+			text.resize((lastPoint - firstPoint) * maxLineLength);
+			char* cursor = text.data(), *end = text.data() + text.size();
+
+			for (size_t pointIdx = firstPoint; pointIdx < lastPoint; ++pointIdx)
+			{
+				const PointModel& point = points[pointIdx];
+
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					cursor = std::to_chars(cursor, end, point._point[axis]).ptr;
+					*cursor++ = ' ';
+				}
+
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					cursor = std::to_chars(cursor, end, (point._rgb >> (channel * 8)) & 0xFF).ptr;
+					*cursor++ = channel < 2 ? ' ' : '\n';
+				}
+			}
+
+			text.resize(cursor - text.data());
+		});
+
+	block.clear();
+	for (const std::vector<char>& text : taskBlock) block.insert(block.end(), text.begin(), text.end());
+}
+
+void PLYWriter::encodeBinaryBlock(const PointModel* points, const size_t numPoints, std::vector<char>& block)
+{
+	const size_t numTasks = std::max(1u, std::thread::hardware_concurrency());
+	const size_t pointsPerTask = (numPoints + numTasks - 1) / numTasks;
+	std::vector<size_t> tasks(numTasks);
+	std::iota(tasks.begin(), tasks.end(), 0);
+
+	block.resize(numPoints * RECORD_SIZE);
+
+	std::for_each(std::execution::par, tasks.begin(), tasks.end(), [&](const size_t task)
+		{
+			const size_t firstPoint = std::min(task * pointsPerTask, numPoints), lastPoint = std::min(firstPoint + pointsPerTask, numPoints);
+			char* record = block.data() + firstPoint * RECORD_SIZE;
+
+			for (size_t pointIdx = firstPoint; pointIdx < lastPoint; ++pointIdx, record += RECORD_SIZE)
+			{
+				// Colors are packed as RGBA bytes, so the first three bytes are copied as they are
+				std::memcpy(record, &points[pointIdx]._point, 3 * sizeof(float));
+				std::memcpy(record + 3 * sizeof(float), &points[pointIdx]._rgb, 3 * sizeof(uint8_t));
+			}
+		});
+}
+
+std::string PLYWriter::getHeader(const size_t numPoints, const bool ascii)
+{
+	std::stringstream header;
+
+	header << "ply\n" << "format " << (ascii ? "ascii" : "binary_little_endian") << " 1.0\n"
+		   << "element vertex " << numPoints << "\n"
+		   << "property float x\n" << "property float y\n" << "property float z\n"
+		   << "property uchar red\n" << "property uchar green\n" << "property uchar blue\n"
+		   << "end_header\n";
+
+	return header.str();
+}
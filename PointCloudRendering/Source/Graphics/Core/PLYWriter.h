@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Graphics/Core/PointCloud.h"
+#include "Utilities/BackgroundTask.h"
+
+/**
+*	@file PLYWriter.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Streaming writer of PLY files with fixed-stride vertex records (float x, y, z and uchar red, green, blue). Points are
+*	encoded in blocks by several threads while the previous block is written to disk, so that no copy of the whole cloud is needed.
+*	Points are written as the standard vertex element; files from previous versions (pointCloud element with float r, g, b) are still read.
+*/
+class PLYWriter
+{
+protected:
+	typedef PointCloud::PointModel PointModel;
+
+	const static size_t		POINTS_PER_BLOCK;					//!< Number of points encoded and written at once
+	const static size_t		RECORD_SIZE;						//!< Size of each binary vertex record (bytes)
+
+protected:
+	/**
+	*	@brief Encodes a block of points as ASCII lines, using several threads.
+	*/
+	static void encodeASCIIBlock(const PointModel* points, const size_t numPoints, std::vector<char>& block);
+
+	/**
+	*	@brief Encodes a block of points as little-endian binary records, using several threads.
+	*/
+	static void encodeBinaryBlock(const PointModel* points, const size_t numPoints, std::vector<char>& block);
+
+	/**
+	*	@return PLY header for the given number of points.
+	*/
+	static std::string getHeader(const size_t numPoints, const bool ascii);
+
+public:
+	/**
+	*	@brief Writes a point array into a PLY file.
+	*	@param task Task which runs the writing, if any. Its progress is updated after each block, and writing stops if it is cancelled.
+	*	@return True if the whole file was written. Partial files are removed.
+	*/
+	static bool write(const std::string& filename, const PointModel* points, const size_t numPoints, const bool ascii, BackgroundTask* task = nullptr);
+};
+
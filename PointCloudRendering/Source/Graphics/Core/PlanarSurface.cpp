@@ -95,14 +95,9 @@ void PlanarSurface::generateGeometryTopology(const mat4& modelMatrix)
 	shader->setUniform("numFaces", numTriangles);
 	shader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
-	VertexGPUData* modelData	= shader->readData(modelBufferID, VertexGPUData());
-	modelComp->_geometry		= std::move(std::vector<VertexGPUData>(modelData, modelData + numVertices));
-
-	FaceGPUData* faceData		= shader->readData(meshBufferID, FaceGPUData());					// Fully computed after second phase
-	modelComp->_topology		= std::move(std::vector<FaceGPUData>(faceData, faceData + numTriangles));
-
-	GLuint* meshData			= shader->readData(rawMeshBufferID, GLuint());
-	modelComp->_triangleMesh	= std::move(std::vector<GLuint>(meshData, meshData + numIndices));
+	modelComp->_geometry		= ComputeShader::readData(modelBufferID, VertexGPUData(), numVertices);
+	modelComp->_topology		= ComputeShader::readData(meshBufferID, FaceGPUData(), numTriangles);				// Fully computed after second phase
+	modelComp->_triangleMesh	= ComputeShader::readData(rawMeshBufferID, GLuint(), numIndices);
 
 	glDeleteBuffers(1, &modelBufferID);
 	glDeleteBuffers(1, &meshBufferID);
@@ -3,80 +3,380 @@
 
 #include <filesystem>
 #include "Graphics/Application/TextureList.h"
+#include "Graphics/Application/PointCloudParameters.h"
+#include "Graphics/Core/ASCIIPointReader.h"
+#include "Graphics/Core/CompressedPointCache.h"
+#include "Graphics/Core/LASReader.h"
+#include "Graphics/Core/PLYReader.h"
+#include "Graphics/Core/PLYWriter.h"
 #include "Graphics/Core/ShaderList.h"
 #include "Graphics/Core/VAO.h"
 #include "tinyply/tinyply.h"
 
 // Initialization of static attributes
+const uint32_t		PointCloud::BINARY_DATA_ALIGNMENT = 4096;
+const char			PointCloud::BINARY_MAGIC[8] = { 'P', 'C', 'R', 'B', 'I', 'N', '\0', '\0' };
+const uint32_t		PointCloud::BINARY_VERSION = 4;
+const size_t		PointCloud::CHECKSUM_SAMPLES = 64;
+const size_t		PointCloud::CHECKSUM_SAMPLE_SIZE = 4096;
 const std::string	PointCloud::WRITE_POINT_CLOUD_FOLDER = "PointClouds/";
 
+static_assert(sizeof(PointCloud::BinaryHeader) == 128, "Binary header layout must not depend on the compiler");
+static_assert(sizeof(PointCloud::PointModel) % sizeof(uint64_t) == 0, "Checksum is computed over 64-bit words");
+
 /// Public methods
 
 PointCloud::PointCloud(const std::string& filename, const bool useBinary, const mat4& modelMatrix) : 
-	Model3D(modelMatrix, 1), _filename(filename), _useBinary(useBinary)
+	Model3D(modelMatrix, 1), _filename(filename), _extension(PLY_EXTENSION), _useBinary(useBinary), _localOrigin(.0), _mappedPoints(nullptr), _numMappedPoints(0), 
+	_notifiedPoints(0), _loadCancelled(false), _pointsReleased(false), _numReleasedPoints(0)
 {
+	std::string path = filename, extension = std::filesystem::path(filename).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	// Cached files are opened directly; their source is named after them (cloud.las.bin), or it is a PLY file next to them
+	if (extension == BINARY_EXTENSION || extension == COMPRESSED_CACHE_EXTENSION)
+	{
+		path = filename.substr(0, filename.size() - extension.size());
+		extension = std::filesystem::path(path).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	}
+
+	// Filenames without a known extension are PLY files, as in previous versions
+	if (extension == LAS_EXTENSION || extension == PLY_EXTENSION || extension == PTS_EXTENSION || extension == TXT_EXTENSION || extension == XYZ_EXTENSION)
+	{
+		_filename = path.substr(0, path.size() - extension.size());
+		_extension = path.substr(path.size() - extension.size());
+	}
+	else
+	{
+		_filename = path;
+	}
 }
 
 PointCloud::~PointCloud()
 {
+	_writingTask.reset();						// Cancels every pending writing, as they refer to the points
 }
 
 bool PointCloud::load(const mat4& modelMatrix)
 {
 	if (!_loaded)
 	{
-		bool success = false, binaryExists = false;
+		bool success = false, binaryLoaded = false;
 
-		if (_useBinary && (binaryExists = std::filesystem::exists(_filename + BINARY_EXTENSION)))
+		_notifiedPoints = 0;
+		_loadCancelled = false;
+
+		if (_useBinary && (std::filesystem::exists(this->getCachePath(_filename + _extension, COMPRESSED_CACHE_EXTENSION)) || 
+						   std::filesystem::exists(this->getCachePath(_filename + _extension, BINARY_EXTENSION))))
 		{
-			success = this->loadModelFromBinaryFile();
+			success = binaryLoaded = this->loadModelFromBinaryFile();
 		}
 
-		if (!success)
+		if (!success && !_loadCancelled)
 		{
-			success = this->loadModelFromPLY(modelMatrix);
+			success = this->loadModelFromFile(modelMatrix);
 		}
 
-		std::cout << "Number of Points: " << _points.size() << std::endl;
+		// Points that were not communicated while reading (e.g. binary files) are notified at once
+		if (success && _notifiedPoints < this->getNumberOfPoints())
+		{
+			success = this->notifyChunk(_notifiedPoints, this->getNumberOfPoints() - _notifiedPoints, this->getNumberOfPoints());
+		}
+
+		std::cout << "Number of Points: " << this->getNumberOfPoints() << std::endl;
 
-		if (success && !binaryExists)
+		if (success && _useBinary && !binaryLoaded)
 		{
-			this->writeToBinary(_filename + BINARY_EXTENSION);
+			this->writeCache();
 		}
 
-		_loaded = true;
+		// Cancelled loads can be resumed afterwards
+		_loaded = !_loadCancelled;
 		
-		return true;
+		return success;
 	}
 
 	return false;
 }
 
-bool PointCloud::writePointCloud(const std::string& filename, const bool ascii)
+std::string PointCloud::getCachePath(const std::string& path, const std::string& cacheExtension)
 {
-	std::thread writePointCloudThread(&PointCloud::threadedWritePointCloud, this, filename, ascii);
-	writePointCloudThread.detach();
+	std::string source = path, extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
 
-	return true;
+	if (extension == BINARY_EXTENSION || extension == COMPRESSED_CACHE_EXTENSION)
+	{
+		source = path.substr(0, path.size() - extension.size());
+		extension = std::filesystem::path(source).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	}
+
+	if (extension == PLY_EXTENSION)
+	{
+		source = source.substr(0, source.size() - extension.size());
+	}
+
+	return source + cacheExtension;
+}
+
+bool PointCloud::readBinaryHeader(const std::string& filename, BinaryHeader& header)
+{
+	std::ifstream fin(filename, std::ios::in | std::ios::binary);
+
+	if (!fin.is_open() || !fin.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader)))
+	{
+		return false;
+	}
+
+	return std::memcmp(header._magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0 && header._version == BINARY_VERSION && header._pointSize == sizeof(PointModel);
+}
+
+void PointCloud::releasePoints(const PointSource& readBack)
+{
+	if (_pointsReleased) return;
+
+	// Points cannot be released while they are being written
+	if (_writingTask) _writingTask->wait();
+
+	_numReleasedPoints = this->getNumberOfPoints();
+	_releasedPointSource = readBack;
+	_pointsReleased = true;
+
+	std::vector<PointModel>().swap(_points);
+	this->releaseMappedFile();
+}
+
+bool PointCloud::restorePoints()
+{
+	if (!_pointsReleased) return true;
+
+	// Restoring must not be reported as a new load
+	const ChunkCallback chunkCallback = _chunkCallback;
+	_chunkCallback = nullptr;
+
+	bool success = this->loadOriginalPoints() && this->getNumberOfPoints() == _numReleasedPoints;
+
+	if (!success && _releasedPointSource)
+	{
+		this->releaseMappedFile();
+		success = _releasedPointSource(_points);
+	}
+
+	_chunkCallback = chunkCallback;
+	_pointsReleased = !success;
+	if (success) _releasedPointSource = nullptr;
+
+	if (!success)
+	{
+		std::cerr << "Points of " << _filename << " could not be restored." << std::endl;
+	}
+
+	return success;
+}
+
+void PointCloud::releaseMappedFile()
+{
+	// Pending writings may be reading the mapped points
+	if (_writingTask) _writingTask->wait();
+
+	_mappedFile.close();
+	_mappedPoints = nullptr;
+	_numMappedPoints = 0;
+}
+
+std::vector<PointCloud::PointModel>* PointCloud::unmapPoints()
+{
+	if (_writingTask) _writingTask->wait();
+	this->restorePoints();
+
+	if (_mappedPoints)
+	{
+		_points.assign(_mappedPoints, _mappedPoints + _numMappedPoints);
+		this->releaseMappedFile();
+	}
+
+	return &_points;
+}
+
+std::shared_future<bool> PointCloud::writePointCloud(const std::string& filename, const bool ascii)
+{
+	const std::string path = WRITE_POINT_CLOUD_FOLDER + filename;
+	const std::shared_ptr<BackgroundTask> previousTask = _writingTask;
+	std::shared_ptr<PointCloud> source;
+	bool available = true;
+
+	// Released points are read again from their source in background, without restoring them into this cloud. Otherwise, they 
+	// are read back from GPU, which must be done in this thread
+	if (_pointsReleased)
+	{
+		if (std::filesystem::exists(this->getCachePath(_filename + _extension, BINARY_EXTENSION)) || std::filesystem::exists(_filename + _extension))
+		{
+			source.reset(new PointCloud(_filename + _extension, _useBinary, _modelMatrix));
+		}
+		else
+		{
+			available = this->restorePoints();
+		}
+	}
+
+	const PointModel* points = this->getPointData();
+	const size_t numPoints = this->getNumberOfPoints();
+
+	// Points stay valid while any writing is pending, since releasing or unmapping them waits for the last task
+	_writingTask.reset(new BackgroundTask("Writing " + path, [path, points, numPoints, ascii, available, source, previousTask](BackgroundTask& task) -> bool
+		{
+			// Writings are serialized in background rather than blocking the caller; cancellation is propagated to previous ones
+			while (previousTask && previousTask->getFuture().wait_for(std::chrono::milliseconds(10)) != std::future_status::ready)
+			{
+				if (task.isCancelled()) previousTask->cancel();
+			}
+
+			if (!available || task.isCancelled()) return false;
+			if (!source) return PLYWriter::write(path, points, numPoints, ascii, &task);
+
+			return source->loadOriginalPoints() && PLYWriter::write(path, source->getPointData(), source->getNumberOfPoints(), ascii, &task);
+		}));
+
+	return _writingTask->getFuture();
 }
 
 /// [Protected methods]
 
+uint64_t PointCloud::computeChecksum(const PointModel* points, const size_t numPoints)
+{
+	const uint64_t* words = reinterpret_cast<const uint64_t*>(points);
+	const size_t numWords = numPoints * sizeof(PointModel) / sizeof(uint64_t);
+	const size_t wordsPerSample = std::min(numWords, CHECKSUM_SAMPLE_SIZE / sizeof(uint64_t));
+	const size_t numSamples = wordsPerSample ? std::min(CHECKSUM_SAMPLES, (numWords + wordsPerSample - 1) / wordsPerSample) : 0;
+	uint64_t checksum = numPoints;
+
+	// Samples include the first and last pages. Each word is mixed with its position, so that swapped points are also detected
+	for (size_t sample = 0; sample < numSamples; ++sample)
+	{
+		const size_t firstWord = numSamples > 1 ? (numWords - wordsPerSample) * sample / (numSamples - 1) : 0;
+
+		for (size_t wordIdx = firstWord; wordIdx < firstWord + wordsPerSample; ++wordIdx)
+		{
+			checksum += (words[wordIdx] ^ wordIdx) * 0x9E3779B97F4A7C15ull;
+		}
+	}
+
+	return checksum;
+}
+
+bool PointCloud::notifyChunk(const size_t firstPoint, const size_t numPoints, const size_t totalPoints)
+{
+	if (_chunkCallback && !_loadCancelled)
+	{
+		_loadCancelled = !_chunkCallback(this->getPointData() + firstPoint, numPoints, totalPoints);
+	}
+
+	_notifiedPoints = firstPoint + numPoints;
+
+	return !_loadCancelled;
+}
+
 void PointCloud::computeCloudData()
 {
 	ModelComponent* modelComp = _modelComp[0];
 
 	// Fill point cloud indices with iota
-	modelComp->_pointCloud.resize(_points.size());
+	modelComp->_pointCloud.resize(this->getNumberOfPoints());
 	std::iota(modelComp->_pointCloud.begin(), modelComp->_pointCloud.end(), 0);
 }
 
 bool PointCloud::loadModelFromBinaryFile()
 {
-	return this->readBinary(_filename + BINARY_EXTENSION, _modelComp);
+	const std::string compressedPath = this->getCachePath(_filename + _extension, COMPRESSED_CACHE_EXTENSION);
+
+	if (std::filesystem::exists(compressedPath))
+	{
+		CompressedPointCache cache;
+		cache.setChunkCallback(std::bind(&PointCloud::notifyChunk, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+
+		if (cache.read(compressedPath, _points, _aabb))
+		{
+			_localOrigin = cache.getLocalOrigin();
+			return true;
+		}
+
+		if (_loadCancelled) return false;
+	}
+
+	return this->readBinary(this->getCachePath(_filename + _extension, BINARY_EXTENSION), _modelComp);
+}
+
+bool PointCloud::loadModelFromFile(const mat4& modelMatrix)
+{
+	std::string extension = _extension;
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	if (extension == PLY_EXTENSION)
+	{
+		return this->loadModelFromPLY(modelMatrix);
+	}
+
+	if (extension == LAS_EXTENSION)
+	{
+		LASReader lasReader;
+		lasReader.setModelMatrix(modelMatrix);
+		lasReader.setChunkCallback(std::bind(&PointCloud::notifyChunk, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+
+		if (!lasReader.read(_filename + _extension, _points, _aabb)) return false;
+
+		_localOrigin = lasReader.getLocalOrigin();
+		_classification = std::move(lasReader.getClassification());
+		_intensity = std::move(lasReader.getIntensity());
+
+		return true;
+	}
+
+	ASCIIPointReader asciiReader;
+	asciiReader.setModelMatrix(modelMatrix);
+	asciiReader.setChunkCallback(std::bind(&PointCloud::notifyChunk, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+	
+	return asciiReader.read(_filename + _extension, _points, _aabb);
+}
+
+bool PointCloud::loadOriginalPoints()
+{
+	const std::string binaryPath = this->getCachePath(_filename + _extension, BINARY_EXTENSION);
+
+	if (_useBinary && std::filesystem::exists(binaryPath) && this->readBinary(binaryPath, _modelComp))
+	{
+		return true;
+	}
+
+	return this->loadModelFromFile(_modelMatrix);
 }
 
 bool PointCloud::loadModelFromPLY(const mat4& modelMatrix)
+{
+	PLYReader plyReader;
+	ASCIIPointReader asciiReader;
+	const std::string filename = _filename + _extension;
+
+	plyReader.setModelMatrix(modelMatrix);
+	asciiReader.setModelMatrix(modelMatrix);
+	plyReader.setChunkCallback(std::bind(&PointCloud::notifyChunk, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+	asciiReader.setChunkCallback(std::bind(&PointCloud::notifyChunk, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+
+	if (plyReader.read(filename, _points, _aabb) || (!_loadCancelled && asciiReader.read(filename, _points, _aabb)))
+	{
+		return true;
+	}
+
+	if (_loadCancelled)
+	{
+		return false;
+	}
+
+	// Layouts which cannot be parsed by our readers (e.g. list properties in vertices) are read through tinyply
+	return this->loadModelFromPLYLibrary(modelMatrix);
+}
+
+bool PointCloud::loadModelFromPLYLibrary(const mat4& modelMatrix)
 {
 	std::unique_ptr<std::istream> fileStream;
 	std::vector<uint8_t> byteBuffer;
@@ -88,7 +388,7 @@ bool PointCloud::loadModelFromPLY(const mat4& modelMatrix)
 
 	try
 	{
-		const std::string filename = _filename + PLY_EXTENSION;
+		const std::string filename = _filename + _extension;
 		fileStream.reset(new std::ifstream(filename, std::ios::binary));
 
 		if (!fileStream || fileStream->fail()) return false;
@@ -140,6 +440,7 @@ bool PointCloud::loadModelFromPLY(const mat4& modelMatrix)
 
 					_points[index] = PointModel{ vec3(pointsRawFloat[baseIndex], pointsRawFloat[baseIndex + 1], pointsRawFloat[baseIndex + 2]),
 												 PointModel::getRGBColor(vec3(colorsRaw[baseIndex], colorsRaw[baseIndex + 1], colorsRaw[baseIndex + 2])) };
+					_points[index]._point = vec3(modelMatrix * vec4(_points[index]._point, 1.0f));
 					_aabb.update(_points[index]._point);
 				}
 			}
@@ -151,6 +452,7 @@ bool PointCloud::loadModelFromPLY(const mat4& modelMatrix)
 
 					_points[index] = PointModel{ vec3(pointsRawDouble[baseIndex], pointsRawDouble[baseIndex + 1], pointsRawDouble[baseIndex + 2]),
 												 PointModel::getRGBColor(vec3(colorsRaw[baseIndex], colorsRaw[baseIndex + 1], colorsRaw[baseIndex + 2])) };
+					_points[index]._point = vec3(modelMatrix * vec4(_points[index]._point, 1.0f));
 					_aabb.update(_points[index]._point);
 				}
 			}
@@ -168,20 +470,63 @@ bool PointCloud::loadModelFromPLY(const mat4& modelMatrix)
 
 bool PointCloud::readBinary(const std::string& filename, const std::vector<Model3D::ModelComponent*>& modelComp)
 {
-	std::ifstream fin(filename, std::ios::in | std::ios::binary);
-	if (!fin.is_open())
+	if (!_mappedFile.open(filename))
 	{
 		return false;
 	}
 
-	size_t numPoints;
+	const BinaryHeader* header = reinterpret_cast<const BinaryHeader*>(_mappedFile.data());
+
+	if (_mappedFile.size() < sizeof(BinaryHeader) || std::memcmp(header->_magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 || header->_version != BINARY_VERSION)
+	{
+		std::cout << "Outdated binary file: " << filename << std::endl;
+		this->releaseMappedFile();
+
+		return false;
+	}
 
-	fin.read((char*)&numPoints, sizeof(size_t));
-	_points.resize(numPoints);
-	fin.read((char*)&_points[0], numPoints * sizeof(PointModel));
-	fin.read((char*)&_aabb, sizeof(AABB));
+	const size_t pointSize = sizeof(PointModel) + ((header->_attributes & CLASSIFICATION_ATTRIBUTE) ? sizeof(uint8_t) : 0) + ((header->_attributes & INTENSITY_ATTRIBUTE) ? sizeof(uint16_t) : 0);
 
-	fin.close();
+	// Number of points is compared by division, as it is read from the file and its product may overflow
+	if (header->_pointSize != sizeof(PointModel) || header->_dataOffset % alignof(PointModel) != 0 || header->_dataOffset > _mappedFile.size() ||
+		header->_numPoints > (_mappedFile.size() - header->_dataOffset) / pointSize)
+	{
+		std::cerr << "Corrupted binary file: " << filename << std::endl;
+		this->releaseMappedFile();
+
+		return false;
+	}
+
+	const PointModel* points = reinterpret_cast<const PointModel*>(_mappedFile.data() + header->_dataOffset);
+
+	if (this->computeChecksum(points, header->_numPoints) != header->_checksum)
+	{
+		std::cerr << "Checksum mismatch in binary file: " << filename << std::endl;
+		this->releaseMappedFile();
+
+		return false;
+	}
+
+	_points.clear();
+	_mappedPoints = points;
+	_numMappedPoints = header->_numPoints;
+	_aabb = AABB(header->_minPoint, header->_maxPoint);
+	_localOrigin = glm::dvec3(header->_localOrigin[0], header->_localOrigin[1], header->_localOrigin[2]);
+
+	// Side arrays are small enough to be copied, so that they can be released independently of the points
+	const uint8_t* attributes = reinterpret_cast<const uint8_t*>(points + _numMappedPoints);
+
+	if (header->_attributes & CLASSIFICATION_ATTRIBUTE)
+	{
+		_classification.assign(attributes, attributes + _numMappedPoints);
+		attributes += _numMappedPoints * sizeof(uint8_t);
+	}
+
+	if (header->_attributes & INTENSITY_ATTRIBUTE)
+	{
+		_intensity.resize(_numMappedPoints);
+		std::memcpy(_intensity.data(), attributes, _numMappedPoints * sizeof(uint16_t));
+	}
 
 	return true;
 }
@@ -192,34 +537,20 @@ void PointCloud::setVAOData()
 	ModelComponent* modelComp = _modelComp[0];
 	unsigned startIndex = 0, size = modelComp->_pointCloud.size(), currentSize;
 
-	vao->setVBOData(RendEnum::VBO_POSITION, _points, GL_STATIC_DRAW);
+	vao->setVBOData(RendEnum::VBO_POSITION, this->getPointData(), this->getNumberOfPoints(), GL_STATIC_DRAW);			// Mapped pages are uploaded without any copy
 	vao->setIBOData(RendEnum::IBO_POINT_CLOUD, modelComp->_pointCloud);
 	modelComp->_topologyIndicesLength[RendEnum::IBO_POINT_CLOUD] = unsigned(modelComp->_pointCloud.size());
 }
 
-void PointCloud::threadedWritePointCloud(const std::string& filename, const bool ascii)
+bool PointCloud::writeCache()
 {
-	std::filebuf fileBuffer;					
-	fileBuffer.open(WRITE_POINT_CLOUD_FOLDER + filename, ascii ? std::ios::out : std::ios::out | std::ios::binary);
-
-	std::ostream outstream(&fileBuffer);
-	if (outstream.fail()) throw std::runtime_error("Failed to open " + filename + ".");
-
-	tinyply::PlyFile pointCloud;
-
-	std::vector<vec3> position;
-	std::vector<vec3> rgb;
-
-	for (int pointIdx = 0; pointIdx < _points.size(); ++pointIdx)
+	// Side arrays are only kept by raw binary files
+	if (PointCloudParameters::_compressBinaryCache && _classification.empty() && _intensity.empty())
 	{
-		position.push_back(_points[pointIdx]._point);
-		rgb.push_back(_points[pointIdx].getRGBVec3());
+		return CompressedPointCache::write(this->getCachePath(_filename + _extension, COMPRESSED_CACHE_EXTENSION), this->getPointData(), this->getNumberOfPoints(), _aabb, _localOrigin, PointCloudParameters::_cacheQuantizationBits);
 	}
 
-	const std::string componentName = "pointCloud";
-	pointCloud.add_properties_to_element(componentName, { "x", "y", "z" }, tinyply::Type::FLOAT32, position.size(), reinterpret_cast<uint8_t*>(position.data()), tinyply::Type::INVALID, 0);
-	pointCloud.add_properties_to_element(componentName, { "r", "g", "b" }, tinyply::Type::FLOAT32, rgb.size(), reinterpret_cast<uint8_t*>(rgb.data()), tinyply::Type::INVALID, 0);
-	pointCloud.write(outstream, !ascii);
+	return this->writeToBinary(this->getCachePath(_filename + _extension, BINARY_EXTENSION));
 }
 
 bool PointCloud::writeToBinary(const std::string& filename)
@@ -230,10 +561,30 @@ bool PointCloud::writeToBinary(const std::string& filename)
 		return false;
 	}
 
-	const size_t numPoints = _points.size();
-	fout.write((char*)&numPoints, sizeof(size_t));
-	fout.write((char*)&_points[0], numPoints * sizeof(PointModel));
-	fout.write((char*)&_aabb, sizeof(AABB));
+	const PointModel* points = this->getPointData();
+	const size_t numPoints = this->getNumberOfPoints();
+
+	BinaryHeader header;
+	std::memset(&header, 0, sizeof(BinaryHeader));
+	std::memcpy(header._magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	header._version		= BINARY_VERSION;
+	header._dataOffset	= BINARY_DATA_ALIGNMENT;
+	header._numPoints	= numPoints;
+	header._minPoint	= _aabb.min();
+	header._pointSize	= sizeof(PointModel);
+	header._maxPoint	= _aabb.max();
+	header._checksum	= this->computeChecksum(points, numPoints);
+	header._attributes	= (_classification.size() == numPoints && numPoints ? CLASSIFICATION_ATTRIBUTE : 0) | (_intensity.size() == numPoints && numPoints ? INTENSITY_ATTRIBUTE : 0);
+	for (int axis = 0; axis < 3; ++axis) header._localOrigin[axis] = _localOrigin[axis];
+
+	// Header is padded up to the data offset, so that points start at a page boundary
+	std::vector<char> headerBlock(header._dataOffset, 0);
+	std::memcpy(headerBlock.data(), &header, sizeof(BinaryHeader));
+
+	fout.write(headerBlock.data(), headerBlock.size());
+	fout.write((const char*)points, numPoints * sizeof(PointModel));
+	if (header._attributes & CLASSIFICATION_ATTRIBUTE) fout.write((const char*)_classification.data(), numPoints * sizeof(uint8_t));
+	if (header._attributes & INTENSITY_ATTRIBUTE) fout.write((const char*)_intensity.data(), numPoints * sizeof(uint16_t));
 
 	fout.close();
 
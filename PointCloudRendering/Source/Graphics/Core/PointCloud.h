@@ -3,6 +3,8 @@
 #include "Geometry/3D/AABB.h"
 #include "Graphics/Application/RenderingParameters.h"
 #include "Graphics/Core/Model3D.h"
+#include "Utilities/BackgroundTask.h"
+#include "Utilities/MemoryMappedFile.h"
 
 /**
 *	@file Pix4DPointCloud.h
@@ -16,6 +18,18 @@
 class PointCloud : public Model3D
 {
 public:
+	struct PointModel;
+
+	/**
+	*	@brief Receives consecutive ranges of points as soon as they are loaded. Returns false if loading must be stopped.
+	*/
+	typedef std::function<bool(const PointModel* points, size_t numPoints, size_t totalPoints)> ChunkCallback;
+
+	/**
+	*	@brief Retrieves released points from another storage (e.g. GPU buffers). Returns false if they could not be retrieved.
+	*/
+	typedef std::function<bool(std::vector<PointModel>& points)> PointSource;
+
 	struct PointModel
 	{
 		vec3		_point;
@@ -37,47 +51,130 @@ public:
 		void saveRGB(const vec3& rgb) { _rgb = this->getRGBColor(rgb); }
 	};
 
+	/**
+	*	@brief Header of binary point cloud files. Points are stored right after the header as a raw array of PointModel, 
+	*	starting at an offset aligned to BINARY_DATA_ALIGNMENT so that they can be mapped and uploaded without any copy. 
+	*	Optional side arrays (classification, intensity) follow the points.
+	*/
+	struct BinaryHeader
+	{
+		char		_magic[8];						//!< BINARY_MAGIC
+		uint32_t	_version;						//!< BINARY_VERSION
+		uint32_t	_dataOffset;					//!< Offset of the first point from the beginning of the file
+		uint64_t	_numPoints;						//!< Number of stored points
+		vec3		_minPoint;						//!< Minimum corner of the point cloud AABB
+		uint32_t	_pointSize;						//!< Size of each point, so that layout changes are detected
+		vec3		_maxPoint;						//!< Maximum corner of the point cloud AABB
+		uint32_t	_attributes;					//!< Side arrays stored after the points (BinaryAttribute)
+		uint64_t	_checksum;						//!< Checksum of sampled pages of the point array
+		double		_localOrigin[3];				//!< Origin of the point coordinates
+		uint8_t		_reserved[40];					//!< Room for future fields without changing the header size
+	};
+
+	enum BinaryAttribute : uint32_t
+	{
+		CLASSIFICATION_ATTRIBUTE = 1, INTENSITY_ATTRIBUTE = 2
+	};
+
 protected:
+	const static uint32_t		BINARY_DATA_ALIGNMENT;				//!< Alignment of the point array within binary files
+	const static char			BINARY_MAGIC[8];					//!< Identifier of our binary point cloud files
+	const static size_t			CHECKSUM_SAMPLES;					//!< Number of pages of the point array covered by the checksum
+	const static size_t			CHECKSUM_SAMPLE_SIZE;				//!< Size of each sampled page (bytes)
+	const static uint32_t		BINARY_VERSION;						//!< Current version of binary files
 	const static std::string	WRITE_POINT_CLOUD_FOLDER;			//!<
 
 protected:
-	std::string					_filename;									//!<
+	std::string					_filename;									//!< Path of the point cloud without extension
+	std::string					_extension;									//!< Extension of the source file, which determines its format
 	bool						_useBinary;									//!<
 
 	// Spatial information
 	AABB						_aabb;										//!<
 	std::vector<PointModel>		_points;									//!<			
 
+	// Optional attributes (e.g. from LAS files)
+	glm::dvec3					_localOrigin;								//!< Points are stored relative to this origin to keep their precision as floats
+	std::vector<uint8_t>		_classification;							//!< Classification of each point, empty if not available
+	std::vector<uint16_t>		_intensity;									//!< Intensity of each point, empty if not available
+
+	// Memory-mapped binary file
+	MemoryMappedFile			_mappedFile;								//!< Binary file whose pages are used as point storage
+	const PointModel*			_mappedPoints;								//!< Points within the mapped file, nullptr if they are stored in _points
+	size_t						_numMappedPoints;							//!< Number of points within the mapped file
+
+	// Progressive loading
+	ChunkCallback				_chunkCallback;								//!< Receives points while they are being loaded
+	size_t						_notifiedPoints;							//!< Number of points already communicated through the callback
+	bool						_loadCancelled;								//!< The callback asked to stop loading
+
+	// GPU-resident mode
+	bool						_pointsReleased;							//!< Host points were released once uploaded
+	size_t						_numReleasedPoints;							//!< Number of points before releasing them
+	PointSource					_releasedPointSource;						//!< Fallback to retrieve released points if there is no cache
+
+	// Writing
+	std::shared_ptr<BackgroundTask>	_writingTask;							//!< Last task which wrote the points into a PLY file. It keeps the previous one, which it waits for
+
 protected:
+	/**
+	*	@return Checksum of a point array, computed over 64-bit words of a few evenly spaced pages so that validating a mapped file does not 
+	*	page in the whole array.
+	*/
+	static uint64_t computeChecksum(const PointModel* points, const size_t numPoints);
+
 	/**
 	*	@brief Computes a triangle mesh buffer composed only by indices.
 	*/
 	void computeCloudData();
 
 	/**
-	*	@brief Fills the content of model component with binary file data.
+	*	@brief Fills the content of model component with the compressed cache or the binary file.
 	*/
 	bool loadModelFromBinaryFile();
 
 	/**
-	*	@brief Generates geometry via GPU.
+	*	@brief Reads the source file with the reader of its format.
+	*/
+	bool loadModelFromFile(const mat4& modelMatrix);
+
+	/**
+	*	@brief Reads the points exactly as they were loaded, i.e. from the raw binary cache or from the source file, but never from 
+	*	the compressed cache, which is quantized and reordered.
+	*/
+	bool loadOriginalPoints();
+
+	/**
+	*	@brief Reads the PLY file through the binary or ASCII readers, or through tinyply if its layout is not supported.
 	*/
 	bool loadModelFromPLY(const mat4& modelMatrix);
 
 	/**
-	*	@brief Loads the PLY point cloud from a binary file, if possible.
+	*	@brief Reads the PLY file through tinyply.
+	*/
+	bool loadModelFromPLYLibrary(const mat4& modelMatrix);
+
+	/**
+	*	@brief Maps the binary point cloud file, if possible. Points are not copied but referenced from the mapped pages.
 	*/
 	virtual bool readBinary(const std::string& filename, const std::vector<Model3D::ModelComponent*>& modelComp);
 
+	/**
+	*	@brief Communicates a range of loaded points through the chunk callback.
+	*	@return False if loading must be stopped.
+	*/
+	bool notifyChunk(const size_t firstPoint, const size_t numPoints, const size_t totalPoints);
+
 	/**
 	*	@brief Communicates the model structure to GPU for rendering purposes.
 	*/
 	virtual void setVAOData();
 
 	/**
-	*	@brief
+	*	@brief Writes the points into a compressed cache, or into a raw binary file if compression is disabled or side arrays must be kept.
+	*	@return Success of writing process.
 	*/
-	void threadedWritePointCloud(const std::string& filename, const bool ascii);
+	bool writeCache();
 
 	/**
 	*	@brief Writes the model to a binary file in order to fasten the following executions.
@@ -87,7 +184,8 @@ protected:
 
 public:
 	/**
-	*	@brief 
+	*	@brief Constructor. 
+	*	@param filename Path of the point cloud. Its extension (.bin, .las, .pcc, .ply, .pts, .txt, .xyz) selects the reader; PLY is assumed if it is missing.
 	*/
 	PointCloud(const std::string& filename, const bool useBinary, const mat4& modelMatrix = mat4(1.0f));
 
@@ -97,21 +195,57 @@ public:
 	virtual ~PointCloud();
 
 	/**
-	*	@brief Loads the point cloud, either from a binary or a PLY file.
+	*	@brief Loads the point cloud, either from a binary or a source file.
 	*	@param modelMatrix Model transformation matrix.
 	*	@return True if the point cloud could be properly loaded.
 	*/
 	virtual bool load(const mat4& modelMatrix = mat4(1.0f));
 
+	/**
+	*	@brief Reads the header of a binary point cloud file without mapping its points.
+	*	@return False if the file cannot be read or its version is outdated.
+	*/
+	static bool readBinaryHeader(const std::string& filename, BinaryHeader& header);
+
+	/**
+	*	@brief Path of the cache of a point cloud, given its source or any of its caches. PLY caches keep the name of previous 
+	*	versions (e.g. cloud.bin), whereas other formats include the source extension (e.g. cloud.las.bin) so that they do not collide.
+	*/
+	static std::string getCachePath(const std::string& path, const std::string& cacheExtension);
+
 	/**
 	*	@brief Updates the current Axis-Aligned Bounding-Box.
 	*/
 	void updateBoundaries(const vec3& xyz) { _aabb.update(xyz); }
 
 	/**
-	*	@brief Writes point cloud as a PLY file.
+	*	@brief Releases the memory-mapped binary file, if any.
 	*/
-	bool writePointCloud(const std::string& filename, const bool ascii);
+	void releaseMappedFile();
+
+	/**
+	*	@brief Frees the host copy of the points, e.g. once they are uploaded to GPU. The AABB and the number of points are kept.
+	*	@param readBack Function which retrieves the points if the binary cache cannot be read.
+	*/
+	void releasePoints(const PointSource& readBack = nullptr);
+
+	/**
+	*	@brief Retrieves released points from the raw binary cache or the source file, or otherwise through the function given to releasePoints().
+	*	@return True if points are available in the host.
+	*/
+	bool restorePoints();
+
+	/**
+	*	@brief Sets the function which receives points while load() is running, so that they can be consumed from another thread.
+	*/
+	void setChunkCallback(const ChunkCallback& chunkCallback) { _chunkCallback = chunkCallback; }
+
+	/**
+	*	@brief Writes the point cloud as a PLY file in background. Writes are chained, so that a new one does not block the caller, and 
+	*	releasing or unmapping the points waits for every pending write, as tasks read them directly.
+	*	@return Future which becomes true once the file is completely written.
+	*/
+	std::shared_future<bool> writePointCloud(const std::string& filename, const bool ascii);
 
 	// Getters
 
@@ -120,6 +254,21 @@ public:
 	*/
 	AABB getAABB() { return _aabb; }
 
+	/**
+	*	@return Classification of each point, empty if the source format does not include it.
+	*/
+	const std::vector<uint8_t>& getClassification() { return _classification; }
+
+	/**
+	*	@return Intensity of each point, empty if the source format does not include it.
+	*/
+	const std::vector<uint16_t>& getIntensity() { return _intensity; }
+
+	/**
+	*	@return Origin that must be added to the points to retrieve their original coordinates.
+	*/
+	glm::dvec3 getLocalOrigin() { return _localOrigin; }
+
 	/**
 	*	@return Path where the point cloud is saved.
 	*/
@@ -128,11 +277,28 @@ public:
 	/**
 	*	@brief
 	*/
-	unsigned getNumberOfPoints() { return unsigned(_points.size()); }
+	unsigned getNumberOfPoints() { return unsigned(_pointsReleased ? _numReleasedPoints : (_mappedPoints ? _numMappedPoints : _points.size())); }
 
 	/**
-	*	@return
+	*	@return Pointer to the first point, either from the mapped binary file or from the point vector. Released points must be restored first.
+	*/
+	const PointModel* getPointData() { return _mappedPoints ? _mappedPoints : _points.data(); }
+
+	/**
+	*	@return Task which writes the point cloud (progress, cancellation), or nullptr if it was never written.
+	*/
+	BackgroundTask* getWritingTask() { return _writingTask.get(); }
+
+	/**
+	*	@return True if the host copy of the points was released.
+	*/
+	bool isGPUResident() { return _pointsReleased; }
+
+	/**
+	*	@brief Copies the memory-mapped points, if any, into the point vector and releases the mapping, so that points can be modified. 
+	*	Released points are restored from the cache.
+	*	@return Vector of points.
 	*/
-	std::vector<PointModel>* getPoints() { return &_points; }
+	std::vector<PointModel>* unmapPoints();
 };
 
@@ -7,32 +7,33 @@
 #include "Graphics/Core/ShaderList.h"
 #include "Interface/Window.h"
 
+// [Static members initialization]
+
+const GLuint PointCloudAggregator::FRAME_PARAMETERS_BINDING = 0;
+const float PointCloudAggregator::WINDOW_SIZE_SHADER_DELAY = 500.0f;
+
 // [Public methods]
 
 PointCloudAggregator::PointCloudAggregator() :
-	_pointCloud(nullptr), _textureID(-1), _depthBufferSSBO(-1)
+	_pointCloud(nullptr), _openChunkCapacity(0), _openChunkPoints(0), _progressivePoints(0), _firstUnprocessedChunk(0), _textureID(-1), _depthBufferSSBO(-1), _frameCommandsHQR(false), _changedWindowSize(false), _constantWindowSize(false), _shaderWindowSize(0)
 {
-	ShaderList* shaderList	= ShaderList::getInstance();
 	Window* window			= Window::getInstance();
 
 	_renderingParameters	= Renderer::getInstance()->getRenderingParameters();
-
-	_addColorsHQRShader		= shaderList->getComputeShader(RendEnum::ADD_COLORS_HQR);
-	_resetDepthBufferShader = shaderList->getComputeShader(RendEnum::RESET_DEPTH_BUFFER_SHADER);
-	_resetDepthBufferHQRShader = shaderList->getComputeShader(RendEnum::RESET_DEPTH_BUFFER_HQR_SHADER);
-	_projectionShader		= shaderList->getComputeShader(RendEnum::PROJECTION_SHADER);
-	_projectionHQRShader	= shaderList->getComputeShader(RendEnum::PROJECTION_HQR_SHADER);
-	_storeTexture			= shaderList->getComputeShader(RendEnum::STORE_TEXTURE_SHADER);
-	_storeHQRTexture		= shaderList->getComputeShader(RendEnum::STORE_TEXTURE_HQR_SHADER);
-	_supportBuffer.resize(this->getAllowedNumberOfPoints());
-
 	_windowSize				= window->getSize();
 
+	this->loadShaders(PointCloudParameters::_constantWindowSize);
+
 	_color01SSBO			= ComputeShader::setWriteBuffer(uint64_t(), _windowSize.x * _windowSize.y, GL_DYNAMIC_DRAW);
 	_color02SSBO			= ComputeShader::setWriteBuffer(uint64_t(), _windowSize.x * _windowSize.y, GL_DYNAMIC_DRAW);
 	_depthBufferSSBO		= ComputeShader::setWriteBuffer(uint64_t(), _windowSize.x * _windowSize.y, GL_DYNAMIC_DRAW);
 	_rawDepthBufferSSBO		= ComputeShader::setWriteBuffer(GLuint(), _windowSize.x * _windowSize.y, GL_DYNAMIC_DRAW);
 
+	glGenBuffers(1, &_frameParametersUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, _frameParametersUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameParameters), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
 	// Window texture
 	glGenTextures(1, &_textureID);
 	glBindTexture(GL_TEXTURE_2D, _textureID);
@@ -47,6 +48,7 @@ PointCloudAggregator::~PointCloudAggregator()
 	glDeleteBuffers(1, &_color02SSBO);
 	glDeleteBuffers(1, &_depthBufferSSBO);
 	glDeleteBuffers(1, &_rawDepthBufferSSBO);
+	glDeleteBuffers(1, &_frameParametersUBO);
 	glDeleteTextures(1, &_textureID);
 }
 
@@ -56,6 +58,35 @@ void PointCloudAggregator::changedSize(const uint16_t width, const uint16_t heig
 	_changedWindowSize = true;
 }
 
+void PointCloudAggregator::deleteChunks(const size_t firstChunk, const size_t numChunks)
+{
+	if (numChunks == 0 || firstChunk + numChunks > _firstUnprocessedChunk) return;
+
+	glDeleteBuffers(GLsizei(numChunks), _pointCloudSSBO.data() + firstChunk);
+
+	_pointCloudSSBO.erase(_pointCloudSSBO.begin() + firstChunk, _pointCloudSSBO.begin() + firstChunk + numChunks);
+	_pointCloudChunkSize.erase(_pointCloudChunkSize.begin() + firstChunk, _pointCloudChunkSize.begin() + firstChunk + numChunks);
+	_pointCloudChunkAABB.erase(_pointCloudChunkAABB.begin() + firstChunk, _pointCloudChunkAABB.begin() + firstChunk + numChunks);
+
+	_firstUnprocessedChunk -= numChunks;
+	_frameCommands.clear();
+
+	// Pending uploads only target open chunks, which come after the deleted ones
+	for (PendingUpload& upload : _pendingUploads) upload._chunk -= numChunks;
+}
+
+void PointCloudAggregator::finishProgressiveUpload(const AABB& aabb)
+{
+	this->applyPendingUploads(true);
+	this->processPointChunks(_firstUnprocessedChunk, aabb);
+
+	_firstUnprocessedChunk = _pointCloudSSBO.size();
+	_openChunkCapacity = 0;
+	_openChunkPoints = 0;
+	_progressivePoints = 0;
+	_frameCommands.clear();
+}
+
 void PointCloudAggregator::render(const mat4& projectionMatrix)
 {
 	if (_changedWindowSize)
@@ -64,16 +95,69 @@ void PointCloudAggregator::render(const mat4& projectionMatrix)
 		_changedWindowSize = false;
 	}
 
-	if (PointCloudParameters::_enableHQR)
+	// Kernels with a constant window size are only compiled once the window stops being resized
+	if (_constantWindowSize != PointCloudParameters::_constantWindowSize && 
+		(!PointCloudParameters::_constantWindowSize || std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _windowResizeTime).count() >= WINDOW_SIZE_SHADER_DELAY))
 	{
-		this->projectPointCloudHQR(projectionMatrix);
-		this->writeColorsTextureHQR();
+		this->loadShaders(PointCloudParameters::_constantWindowSize);
+		_frameCommands.clear();
 	}
-	else
+
+	this->applyPendingUploads(false);
+
+	if (_frameCommands.isEmpty() || _frameCommandsHQR != PointCloudParameters::_enableHQR)
 	{
-		this->projectPointCloud(projectionMatrix);
-		this->writeColorsTexture();
+		this->recordFrameCommands();
+	}
+
+	// Chunks (e.g. tiles of a dataset) outside the view frustum are skipped. Chunks appended after the commands were recorded have no commands 
+	// yet, as they are recorded again once their upload is applied
+	const size_t numRecordedChunks = std::min(_visibleChunks.size(), _pointCloudChunkAABB.size());
+
+	for (size_t chunk = 0; chunk < numRecordedChunks; ++chunk)
+	{
+		_visibleChunks[chunk] = _pointCloudChunkAABB[chunk].intersectsFrustum(projectionMatrix);
+	}
+
+	this->updateFrameParameters(projectionMatrix);
+	this->bindTexture();
+	_frameCommands.execute(_visibleChunks);
+}
+
+void PointCloudAggregator::beginProgressiveUpload(PointCloud* pointCloud)
+{
+	_pointCloud = pointCloud;
+
+	this->deletePointCloudBuffers();
+}
+
+bool PointCloudAggregator::readPoints(std::vector<Point>& points)
+{
+	this->applyPendingUploads(true);
+
+	size_t numPoints = 0;
+	for (const GLuint chunkSize : _pointCloudChunkSize) numPoints += chunkSize;
+
+	points.resize(numPoints);
+	numPoints = 0;
+
+	// The copy of the next chunk is issued before waiting for the current one, so that copying and consuming chunks overlap
+	GPUReadback<Point> readback, nextReadback;
+	if (!_pointCloudSSBO.empty()) nextReadback = ComputeShader::readDataAsync(_pointCloudSSBO[0], Point(), _pointCloudChunkSize[0]);
+
+	for (size_t chunkIdx = 0; chunkIdx < _pointCloudSSBO.size(); ++chunkIdx)
+	{
+		readback = std::move(nextReadback);
+		if (chunkIdx + 1 < _pointCloudSSBO.size()) nextReadback = ComputeShader::readDataAsync(_pointCloudSSBO[chunkIdx + 1], Point(), _pointCloudChunkSize[chunkIdx + 1]);
+
+		const Point* chunkPoints = readback.get();
+		if (!chunkPoints) return false;
+
+		std::copy(chunkPoints, chunkPoints + readback.getArraySize(), points.begin() + numPoints);
+		numPoints += readback.getArraySize();
 	}
+
+	return !_pointCloudSSBO.empty() && glGetError() == GL_NO_ERROR;
 }
 
 void PointCloudAggregator::setPointCloud(PointCloud* pointCloud)
@@ -84,15 +168,46 @@ void PointCloudAggregator::setPointCloud(PointCloud* pointCloud)
 	this->writePointCloudGPU();
 }
 
+void PointCloudAggregator::uploadChunk(const Point* points, const unsigned numPoints, const size_t totalPoints)
+{
+	unsigned firstPoint = 0;
+
+	while (firstPoint < numPoints)
+	{
+		// The last chunk is closed once it is full, and the next one is allocated for the remaining points of the cloud
+		if (_pointCloudSSBO.size() == _firstUnprocessedChunk || _openChunkPoints == _openChunkCapacity)
+		{
+			const size_t remainingPoints = std::max(totalPoints - std::min(_progressivePoints, totalPoints), size_t(numPoints - firstPoint));
+
+			_openChunkCapacity = unsigned(std::min(remainingPoints, size_t(this->getAllowedNumberOfPoints())));
+			_pointCloudSSBO.push_back(ComputeShader::setWriteBuffer(Point(), _openChunkCapacity, GL_STATIC_DRAW));
+			_pointCloudChunkSize.push_back(0);
+			_pointCloudChunkAABB.push_back(AABB());
+			_openChunkPoints = 0;
+		}
+
+		// The copy into staging memory runs in background, and points are rendered once it is issued (see applyPendingUploads())
+		const unsigned chunkSize = std::min(_openChunkCapacity - _openChunkPoints, numPoints - firstPoint);
+		const uint64_t ticket = GPUUploadRing::getInstance()->uploadAsync(_pointCloudSSBO.back(), GLintptr(sizeof(Point)) * _openChunkPoints, points + firstPoint, GLsizeiptr(sizeof(Point)) * chunkSize);
+		_pendingUploads.push_back(PendingUpload{ ticket, _pointCloudSSBO.size() - 1, chunkSize });
+
+		for (unsigned pointIdx = firstPoint; pointIdx < firstPoint + chunkSize; ++pointIdx) _pointCloudChunkAABB.back().update(points[pointIdx]._point);
+
+		_openChunkPoints += chunkSize;
+		_progressivePoints += chunkSize;
+		firstPoint += chunkSize;
+	}
+}
+
 // [Protected methods]
 
 unsigned PointCloudAggregator::getAllowedNumberOfPoints()
 {
-	unsigned pointSize = sizeof(PointCloud::PointModel);
-	GLint limitedMemory;
-	glGetIntegerv(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &limitedMemory);
+	// The limit may exceed 2 GB, which overflows the 32-bit query
+	GLint64 limitedMemory;
+	glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &limitedMemory);
 
-	return std::floor(limitedMemory / pointSize);
+	return unsigned(std::min(uint64_t(limitedMemory) / sizeof(PointCloud::PointModel), uint64_t(UINT_MAX)));
 }
 
 void PointCloudAggregator::bindTexture()
@@ -100,25 +215,48 @@ void PointCloudAggregator::bindTexture()
 	glBindImageTexture(0, _textureID, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
 }
 
-GLuint PointCloudAggregator::calculateMortonCodes(const GLuint pointsSSBO, unsigned numPoints)
+GPUBuffer PointCloudAggregator::calculateMortonCodes(const GLuint pointsSSBO, unsigned numPoints, const AABB& aabb)
 {
 	ComputeShader* computeMortonShader = ShaderList::getInstance()->getComputeShader(RendEnum::COMPUTE_MORTON_CODES_PCL);
 
 	const int numGroups = ComputeShader::getNumGroups(numPoints);
-	const GLuint mortonCodeBuffer = ComputeShader::setWriteBuffer(unsigned(), numPoints);
+	GPUBuffer mortonCodeBuffer = ComputeShader::acquireWriteBuffer(unsigned(), numPoints);
 
-	computeMortonShader->bindBuffers(std::vector<GLuint> { pointsSSBO, mortonCodeBuffer });
+	computeMortonShader->bindBuffers(std::vector<GLuint> { pointsSSBO, mortonCodeBuffer.getID() });
 	computeMortonShader->use();
 	computeMortonShader->setUniform("arraySize", numPoints);
-	computeMortonShader->setUniform("sceneMaxBoundary", _pointCloud->getAABB().max());
-	computeMortonShader->setUniform("sceneMinBoundary", _pointCloud->getAABB().min());
+	computeMortonShader->setUniform("sceneMaxBoundary", aabb.max());
+	computeMortonShader->setUniform("sceneMinBoundary", aabb.min());
 	computeMortonShader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
 	return mortonCodeBuffer;
 }
 
+void PointCloudAggregator::applyPendingUploads(const bool wait)
+{
+	if (_pendingUploads.empty()) return;
+
+	const uint64_t submittedTicket = GPUUploadRing::getInstance()->submitPendingCopies(wait);
+	size_t numApplied = 0;
+
+	while (numApplied < _pendingUploads.size() && _pendingUploads[numApplied]._ticket <= submittedTicket)
+	{
+		_pointCloudChunkSize[_pendingUploads[numApplied]._chunk] += _pendingUploads[numApplied]._numPoints;
+		++numApplied;
+	}
+
+	if (numApplied)
+	{
+		_pendingUploads.erase(_pendingUploads.begin(), _pendingUploads.begin() + numApplied);
+		_frameCommands.clear();
+	}
+}
+
 void PointCloudAggregator::deletePointCloudBuffers()
 {
+	// Copies must not target deleted buffers, nor read points which are about to be released
+	if (!_pendingUploads.empty()) GPUUploadRing::getInstance()->submitPendingCopies(true);
+
 	for (GLuint ssbo : _pointCloudSSBO)
 	{
 		glDeleteBuffers(1, &ssbo);
@@ -126,83 +264,168 @@ void PointCloudAggregator::deletePointCloudBuffers()
 
 	_pointCloudSSBO.clear();
 	_pointCloudChunkSize.clear();
+	_pointCloudChunkAABB.clear();
+	_pendingUploads.clear();
+	_frameCommands.clear();
+
+	_openChunkCapacity = 0;
+	_openChunkPoints = 0;
+	_progressivePoints = 0;
+	_firstUnprocessedChunk = 0;
 }
 
-void PointCloudAggregator::projectPointCloud(const mat4& projectionMatrix)
+std::vector<ShaderList::ComputePermutation> PointCloudAggregator::getShaderPermutations(const ShaderProgram::ShaderDefines& defines)
 {
-	unsigned chunk = 0, accumSize = 0;
-	const int numGroupsImage = ComputeShader::getNumGroups(_windowSize.x * _windowSize.y);
-	
+	ShaderProgram::ShaderDefines hqrDefines = defines;
+	hqrDefines["HQR"] = "1";
+
+	return std::vector<ShaderList::ComputePermutation> {
+		{ RendEnum::ADD_COLORS_HQR, defines }, { RendEnum::RESET_DEPTH_BUFFER_SHADER, defines }, { RendEnum::RESET_DEPTH_BUFFER_SHADER, hqrDefines },
+		{ RendEnum::PROJECTION_SHADER, defines }, { RendEnum::PROJECTION_HQR_SHADER, defines }, { RendEnum::STORE_TEXTURE_SHADER, defines },
+		{ RendEnum::STORE_TEXTURE_SHADER, hqrDefines } };
+}
+
+void PointCloudAggregator::loadShaders(const bool constantWindowSize)
+{
+	ShaderList* shaderList = ShaderList::getInstance();
+	ShaderProgram::ShaderDefines defines { { "LOCAL_SIZE_X", std::to_string(ComputeShader::getMaxGroupSize()) } };
+
+	// Each window size would otherwise leave its permutations behind, both in memory and in the binary cache
+	if (_shaderWindowSize != uvec2(0) && (!constantWindowSize || _shaderWindowSize != uvec2(_windowSize)))
+	{
+		ShaderProgram::ShaderDefines previousDefines = defines;
+		previousDefines["WINDOW_WIDTH"] = std::to_string(_shaderWindowSize.x) + "u";
+		previousDefines["WINDOW_HEIGHT"] = std::to_string(_shaderWindowSize.y) + "u";
+
+		for (const ShaderList::ComputePermutation& permutation : getShaderPermutations(previousDefines))
+		{
+			shaderList->releaseComputeShader(permutation.first, permutation.second);
+		}
+
+		_shaderWindowSize = uvec2(0);
+	}
+
+	if (constantWindowSize)
+	{
+		defines["WINDOW_WIDTH"] = std::to_string(_windowSize.x) + "u";
+		defines["WINDOW_HEIGHT"] = std::to_string(_windowSize.y) + "u";
+		_shaderWindowSize = _windowSize;
+	}
+
+	_constantWindowSize = constantWindowSize;
+
+	// Permutations are compiled in parallel before being retrieved
+	const std::vector<ShaderList::ComputePermutation> permutations = getShaderPermutations(defines);
+	shaderList->warmUp(permutations);
+
+	_addColorsHQRShader			= shaderList->getComputeShader(permutations[0].first, permutations[0].second);
+	_resetDepthBufferShader		= shaderList->getComputeShader(permutations[1].first, permutations[1].second);
+	_resetDepthBufferHQRShader	= shaderList->getComputeShader(permutations[2].first, permutations[2].second);
+	_projectionShader			= shaderList->getComputeShader(permutations[3].first, permutations[3].second);
+	_projectionHQRShader		= shaderList->getComputeShader(permutations[4].first, permutations[4].second);
+	_storeTexture				= shaderList->getComputeShader(permutations[5].first, permutations[5].second);
+	_storeHQRTexture			= shaderList->getComputeShader(permutations[6].first, permutations[6].second);
+}
+
+void PointCloudAggregator::processPointChunks(const size_t firstChunk, const AABB& aabb)
+{
+	if (PointCloudParameters::_reducePointCloud)
+	{
+		std::vector<GPUBuffer> indexSSBO;
+		std::vector<GPUReadback<GLuint>> numPointsReadback;
+
+		// Every chunk is reduced before waiting for the remaining points of the first one, so that the GPU keeps reducing meanwhile
+		for (size_t chunk = firstChunk; chunk < _pointCloudSSBO.size(); ++chunk)
+		{
+			indexSSBO.push_back(ComputeShader::acquireWriteBuffer(GLuint(), _pointCloudChunkSize[chunk]));
+			numPointsReadback.push_back(this->reducePointChunk(_pointCloudSSBO[chunk], indexSSBO.back().getID(), _pointCloudChunkSize[chunk], aabb));
+		}
+
+		for (size_t chunk = firstChunk; chunk < _pointCloudSSBO.size(); ++chunk)
+		{
+			_pointCloudChunkSize[chunk] = *numPointsReadback[chunk - firstChunk].get();
+			this->transferPointChunk(_pointCloudSSBO[chunk], indexSSBO[chunk - firstChunk].getID(), _pointCloudChunkSize[chunk]);
+		}
+	}
+
+	if (PointCloudParameters::_sortPointCloud)
+	{
+		for (size_t chunk = firstChunk; chunk < _pointCloudSSBO.size(); ++chunk)
+		{
+			this->sortPoints(_pointCloudSSBO[chunk], _pointCloudChunkSize[chunk], aabb);
+		}
+	}
+}
+
+void PointCloudAggregator::projectPointCloud()
+{
+	const unsigned numGroupsImage = ComputeShader::getNumGroups(_windowSize.x * _windowSize.y);
+	const uvec3 workGroupSize(ComputeShader::getMaxGroupSize(), 1, 1);
+
 	// 1. Fill buffer of 64 bits with UINT64_MAX, i.e. the null index is UINT_MAX
-	_resetDepthBufferShader->bindBuffers(std::vector<GLuint> { _depthBufferSSBO });
-	_resetDepthBufferShader->use();
-	_resetDepthBufferShader->setUniform("windowSize", _windowSize);
-	_resetDepthBufferShader->execute(numGroupsImage, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
-	
-	for (GLuint pointsSSBO: _pointCloudSSBO)
+	_frameCommands.dispatch(_resetDepthBufferShader, std::vector<GLuint> { _depthBufferSSBO }, uvec3(numGroupsImage, 1, 1), workGroupSize);
+
+	for (unsigned chunk = 0; chunk < _pointCloudSSBO.size(); ++chunk)
 	{
 		const unsigned numPoints = _pointCloudChunkSize[chunk];
-		const int numGroupsPoints = ComputeShader::getNumGroups(numPoints);
+		const unsigned numGroupsPoints = ComputeShader::getNumGroups(numPoints);
 
 		// 2. Transform points and use atomicMin to retrieve the nearest point
-		_projectionShader->bindBuffers(std::vector<GLuint> { _depthBufferSSBO, pointsSSBO });
-		_projectionShader->use();
-		_projectionShader->setUniform("cameraMatrix", projectionMatrix);
-		_projectionShader->setUniform("numPoints", numPoints);
-		_projectionShader->setUniform("windowSize", _windowSize);
-		_projectionShader->execute(numGroupsPoints, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
-
-		accumSize += _pointCloudChunkSize[chunk++];
+		_frameCommands.dispatch(_projectionShader, std::vector<GLuint> { _depthBufferSSBO, _pointCloudSSBO[chunk] }, uvec3(numGroupsPoints, 1, 1), workGroupSize, chunk);
+		_frameCommands.setUniform("numPoints", numPoints);
 	}
 }
 
-void PointCloudAggregator::projectPointCloudHQR(const mat4& projectionMatrix)
+void PointCloudAggregator::projectPointCloudHQR()
 {
-	unsigned chunk = 0, accumSize = 0;
-	const int numGroupsImage = ComputeShader::getNumGroups(_windowSize.x * _windowSize.y);
+	const unsigned numGroupsImage = ComputeShader::getNumGroups(_windowSize.x * _windowSize.y);
+	const uvec3 workGroupSize(ComputeShader::getMaxGroupSize(), 1, 1);
 
 	// 1. Fill buffer of 32 bits with UINT_MAX
-	_resetDepthBufferHQRShader->bindBuffers(std::vector<GLuint> { _rawDepthBufferSSBO, _color01SSBO, _color02SSBO });
-	_resetDepthBufferHQRShader->use();
-	_resetDepthBufferHQRShader->setUniform("windowSize", _windowSize);
-	_resetDepthBufferHQRShader->execute(numGroupsImage, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+	_frameCommands.dispatch(_resetDepthBufferHQRShader, std::vector<GLuint> { _rawDepthBufferSSBO, _color01SSBO, _color02SSBO }, uvec3(numGroupsImage, 1, 1), workGroupSize);
 
-	for (GLuint pointsSSBO : _pointCloudSSBO)
+	for (unsigned chunk = 0; chunk < _pointCloudSSBO.size(); ++chunk)
 	{
 		const unsigned numPoints = _pointCloudChunkSize[chunk];
-		const int numGroupsPoints = ComputeShader::getNumGroups(numPoints);
+		const unsigned numGroupsPoints = ComputeShader::getNumGroups(numPoints);
 
 		// 2. Transform points and use atomicMin to retrieve the nearest point
-		_projectionHQRShader->bindBuffers(std::vector<GLuint> { _rawDepthBufferSSBO, pointsSSBO });
-		_projectionHQRShader->use();
-		_projectionHQRShader->setUniform("cameraMatrix", projectionMatrix);
-		_projectionHQRShader->setUniform("numPoints", numPoints);
-		_projectionHQRShader->setUniform("windowSize", _windowSize);
-		_projectionHQRShader->execute(numGroupsPoints, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+		_frameCommands.dispatch(_projectionHQRShader, std::vector<GLuint> { _rawDepthBufferSSBO, _pointCloudSSBO[chunk] }, uvec3(numGroupsPoints, 1, 1), workGroupSize, chunk);
+		_frameCommands.setUniform("numPoints", numPoints);
 
 		// 3. Accumulate colors once the minimum depth is defined
-		_addColorsHQRShader->bindBuffers(std::vector<GLuint> { _rawDepthBufferSSBO, _color01SSBO, _color02SSBO, pointsSSBO });
-		_addColorsHQRShader->use();
-		_addColorsHQRShader->setUniform("cameraMatrix", projectionMatrix);
-		_addColorsHQRShader->setUniform("distanceThreshold", PointCloudParameters::_distanceThreshold);
-		_addColorsHQRShader->setUniform("numPoints", numPoints);
-		_addColorsHQRShader->setUniform("windowSize", _windowSize);
-		_addColorsHQRShader->execute(numGroupsPoints, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
-
-		accumSize += _pointCloudChunkSize[chunk++];
+		_frameCommands.dispatch(_addColorsHQRShader, std::vector<GLuint> { _rawDepthBufferSSBO, _color01SSBO, _color02SSBO, _pointCloudSSBO[chunk] }, uvec3(numGroupsPoints, 1, 1), workGroupSize, chunk);
+		_frameCommands.setUniform("numPoints", numPoints);
 	}
 }
 
-void PointCloudAggregator::reducePointChunk(GLuint& pointsSSBO, const GLuint indexSSBO, unsigned& numPoints)
+void PointCloudAggregator::recordFrameCommands()
+{
+	_frameCommands.clear();
+	_frameCommandsHQR = PointCloudParameters::_enableHQR;
+	_visibleChunks.assign(_pointCloudSSBO.size(), true);
+
+	if (_frameCommandsHQR)
+	{
+		this->projectPointCloudHQR();
+		this->writeColorsTextureHQR();
+	}
+	else
+	{
+		this->projectPointCloud();
+		this->writeColorsTexture();
+	}
+}
+
+GPUReadback<GLuint> PointCloudAggregator::reducePointChunk(const GLuint pointsSSBO, const GLuint indexSSBO, const unsigned numPoints, const AABB& aabb)
 {
 	ComputeShader* reduceShader			= ShaderList::getInstance()->getComputeShader(RendEnum::REDUCE_POINT_BUFFER_SHADER);
 	ComputeShader* iotaShader			= ShaderList::getInstance()->getComputeShader(RendEnum::IOTA_SHADER);
-	ComputeShader* transferPointsShader = ShaderList::getInstance()->getComputeShader(RendEnum::TRANSFER_POINTS_SHADER);
 	const int numGroups					= ComputeShader::getNumGroups(numPoints);
 	const GLuint nullCount				= 0;
 
-	GLuint countPointSSBO = ComputeShader::setReadBuffer(&numPoints, 1, GL_DYNAMIC_DRAW);
-	GLuint countPointAuxSSBO = ComputeShader::setReadBuffer(&nullCount, 1, GL_DYNAMIC_DRAW);
+	GPUBuffer countPointSSBO = ComputeShader::acquireReadBuffer(&numPoints, 1);
+	GPUBuffer countPointAuxSSBO = ComputeShader::acquireReadBuffer(&nullCount, 1);
 
 	iotaShader->bindBuffers(std::vector<GLuint> { indexSSBO });
 	iotaShader->use();
@@ -210,74 +433,72 @@ void PointCloudAggregator::reducePointChunk(GLuint& pointsSSBO, const GLuint ind
 	iotaShader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
 	reduceShader->use();
-	reduceShader->setUniform("sceneMaxBoundary", _pointCloud->getAABB().max());
-	reduceShader->setUniform("sceneMinBoundary", _pointCloud->getAABB().min());
+	reduceShader->setUniform("sceneMaxBoundary", aabb.max());
+	reduceShader->setUniform("sceneMinBoundary", aabb.min());
 	
 	for (int iteration = 0; iteration < PointCloudParameters::_reduceIterations; ++iteration)
 	{
-		reduceShader->bindBuffers(std::vector<GLuint> { pointsSSBO, indexSSBO, countPointSSBO, countPointAuxSSBO });
+		reduceShader->bindBuffers(std::vector<GLuint> { pointsSSBO, indexSSBO, countPointSSBO.getID(), countPointAuxSSBO.getID() });
 		reduceShader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
 		std::swap(countPointSSBO, countPointAuxSSBO);
-		ComputeShader::updateReadBuffer(countPointAuxSSBO, &nullCount, 1, GL_DYNAMIC_DRAW);
+		ComputeShader::updateBufferSubData(countPointAuxSSBO.getID(), &nullCount, 1);
 	}
 
-	numPoints = *ComputeShader::readData(countPointSSBO, GLint());
-	GLuint pointAuxSSBO = ComputeShader::setWriteBuffer(PointCloud::PointModel(), numPoints, GL_DYNAMIC_DRAW);
+	// Counters are given back to the pool once the copy is issued
+	return ComputeShader::readDataAsync(countPointSSBO.getID(), GLuint(), 1);
+}
 
-	transferPointsShader->bindBuffers(std::vector<GLuint> { pointsSSBO, pointAuxSSBO, indexSSBO });
+void PointCloudAggregator::sortPoints(GLuint& pointsSSBO, unsigned numPoints, const AABB& aabb)
+{
+	ComputeShader* transferPointsShader = ShaderList::getInstance()->getComputeShader(RendEnum::TRANSFER_POINTS_SHADER);
+	const int numGroups					= ComputeShader::getNumGroups(numPoints);
+
+	const GPUBuffer pointCodeSSBO		= this->calculateMortonCodes(pointsSSBO, numPoints, aabb);
+	const GPUBuffer indicesBufferSSBO	= this->sortFacesByMortonCode(pointCodeSSBO.getID(), numPoints);
+
+	// Points are gathered in GPU, so that no CPU copy of the chunk is needed
+	GLuint sortedPointsSSBO = ComputeShader::setWriteBuffer(PointCloud::PointModel(), numPoints, GL_STATIC_DRAW);
+
+	transferPointsShader->bindBuffers(std::vector<GLuint> { pointsSSBO, sortedPointsSSBO, indicesBufferSSBO.getID() });
 	transferPointsShader->use();
 	transferPointsShader->setUniform("arraySize", numPoints);
 	transferPointsShader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
 	glDeleteBuffers(1, &pointsSSBO);
-	glDeleteBuffers(1, &countPointSSBO);
-	glDeleteBuffers(1, &countPointAuxSSBO);
-	pointsSSBO = pointAuxSSBO;
+	pointsSSBO = sortedPointsSSBO;
 }
 
-void PointCloudAggregator::sortPoints(const GLuint pointsSSBO, unsigned numPoints)
+void PointCloudAggregator::transferPointChunk(GLuint& pointsSSBO, const GLuint indexSSBO, const unsigned numPoints)
 {
-	const GLuint pointCodeSSBO	= this->calculateMortonCodes(pointsSSBO, numPoints);
-
-	const GLuint indicesBufferSSBO = this->sortFacesByMortonCode(pointCodeSSBO, numPoints);
-	GLuint* indices = ComputeShader::readData(indicesBufferSSBO, GLuint());
-	std::vector<GLuint> bufferIndices = std::vector<GLuint>(indices, indices + numPoints);
-
-	PointCloud::PointModel* previousPoints;
-	if (PointCloudParameters::_reducePointCloud)
-	{
-		previousPoints = ComputeShader::readData(pointsSSBO, PointCloud::PointModel());
-	}
-	else
-	{
-		previousPoints = _pointCloud->getPoints()->data();
-	}
+	ComputeShader* transferPointsShader = ShaderList::getInstance()->getComputeShader(RendEnum::TRANSFER_POINTS_SHADER);
+	const int numGroups					= ComputeShader::getNumGroups(numPoints);
 
-	for (int pointIdx = 0; pointIdx < numPoints; ++pointIdx)
-	{
-		_supportBuffer.at(pointIdx) = previousPoints[indices[pointIdx]];
-	}
+	GLuint pointAuxSSBO = ComputeShader::setWriteBuffer(PointCloud::PointModel(), numPoints, GL_DYNAMIC_DRAW);
 
-	ComputeShader::updateReadBuffer(pointsSSBO, _supportBuffer.data(), numPoints, GL_STATIC_DRAW);
+	transferPointsShader->bindBuffers(std::vector<GLuint> { pointsSSBO, pointAuxSSBO, indexSSBO });
+	transferPointsShader->use();
+	transferPointsShader->setUniform("arraySize", numPoints);
+	transferPointsShader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
-	glDeleteBuffers(1, &indicesBufferSSBO);
+	glDeleteBuffers(1, &pointsSSBO);
+	pointsSSBO = pointAuxSSBO;
 }
 
-GLuint PointCloudAggregator::sortFacesByMortonCode(const GLuint mortonCodes, unsigned numPoints)
+GPUBuffer PointCloudAggregator::sortFacesByMortonCode(const GLuint mortonCodes, unsigned numPoints)
 {
 	ComputeShader* bitMaskShader = ShaderList::getInstance()->getComputeShader(RendEnum::BIT_MASK_RADIX_SORT);
 	ComputeShader* reduceShader = ShaderList::getInstance()->getComputeShader(RendEnum::REDUCE_PREFIX_SCAN);
 	ComputeShader* downSweepShader = ShaderList::getInstance()->getComputeShader(RendEnum::DOWN_SWEEP_PREFIX_SCAN);
 	ComputeShader* resetPositionShader = ShaderList::getInstance()->getComputeShader(RendEnum::RESET_LAST_POSITION_PREFIX_SCAN);
 	ComputeShader* reallocatePositionShader = ShaderList::getInstance()->getComputeShader(RendEnum::REALLOCATE_RADIX_SORT);
+	ComputeShader* iotaShader = ShaderList::getInstance()->getComputeShader(RendEnum::IOTA_SHADER);
 
 	const unsigned numBits	= 30;			// 10 bits per coordinate (3D)
 	unsigned arraySize		= numPoints;
 	unsigned currentBits	= 0;
 	const int numGroups		= ComputeShader::getNumGroups(arraySize);
 	const int maxGroupSize	= ComputeShader::getMaxGroupSize();
-	GLuint* indices			= new GLuint[arraySize];
 
 	// Binary tree parameters
 	const unsigned startThreads = unsigned(std::ceil(arraySize / 2.0f));
@@ -285,27 +506,30 @@ GLuint PointCloudAggregator::sortFacesByMortonCode(const GLuint mortonCodes, uns
 	const unsigned numGroups2Log = unsigned(ComputeShader::getNumGroups(startThreads));
 	unsigned numThreads = 0, iteration;
 
-	// Fill indices array from zero to arraySize - 1
-	for (int i = 0; i < arraySize; ++i) { indices[i] = i; }
+	// Scratch buffers are borrowed from the pool, so that sorting consecutive chunks does not allocate new storage
+	GPUBuffer indicesBuffer_1	= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);
+	GPUBuffer indicesBuffer_2	= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);				// Substitutes indicesBuffer_1 for the next iteration
+	const GPUBuffer pBitsBuffer	= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);
+	const GPUBuffer nBitsBuffer	= ComputeShader::acquireWriteBuffer(GLuint(), arraySize);
+	const GLuint pBitsBufferID = pBitsBuffer.getID(), nBitsBufferID = nBitsBuffer.getID();
 
-	GLuint indicesBufferID_1, indicesBufferID_2, pBitsBufferID, nBitsBufferID, positionBufferID;
-	indicesBufferID_1 = ComputeShader::setWriteBuffer(GLuint(), arraySize);
-	indicesBufferID_2 = ComputeShader::setReadBuffer(indices, arraySize);					// Substitutes indicesBufferID_1 for the next iteration
-	pBitsBufferID = ComputeShader::setWriteBuffer(GLuint(), arraySize);
-	nBitsBufferID = ComputeShader::setWriteBuffer(GLuint(), arraySize);
-	positionBufferID = ComputeShader::setWriteBuffer(GLuint(), arraySize);
+	// Fill indices array from zero to arraySize - 1, without any CPU array
+	iotaShader->bindBuffers(std::vector<GLuint> { indicesBuffer_2.getID() });
+	iotaShader->use();
+	iotaShader->setUniform("arraySize", arraySize);
+	iotaShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
 
 	while (currentBits < numBits)
 	{
 		std::vector<GLuint> threadCount{ startThreads };
 		threadCount.reserve(numExec);
 
-		std::swap(indicesBufferID_1, indicesBufferID_2);							// indicesBufferID_2 is initialized with indices cause it's swapped here
+		std::swap(indicesBuffer_1, indicesBuffer_2);								// indicesBuffer_2 is initialized with indices cause it's swapped here
 
 		// FIRST STEP: BIT MASK, check if a morton code gives zero or one for a certain mask (iteration)
 		unsigned bitMask = 1 << currentBits++;
 
-		bitMaskShader->bindBuffers(std::vector<GLuint> { mortonCodes, indicesBufferID_1, pBitsBufferID, nBitsBufferID });
+		bitMaskShader->bindBuffers(std::vector<GLuint> { mortonCodes, indicesBuffer_1.getID(), pBitsBufferID, nBitsBufferID });
 		bitMaskShader->use();
 		bitMaskShader->setUniform("arraySize", arraySize);
 		bitMaskShader->setUniform("bitMask", bitMask);
@@ -347,20 +571,28 @@ GLuint PointCloudAggregator::sortFacesByMortonCode(const GLuint mortonCodes, uns
 			downSweepShader->execute(numGroups2Log, 1, 1, maxGroupSize, 1, 1);
 		}
 
-		reallocatePositionShader->bindBuffers(std::vector<GLuint> { pBitsBufferID, nBitsBufferID, indicesBufferID_1, indicesBufferID_2 });
+		reallocatePositionShader->bindBuffers(std::vector<GLuint> { pBitsBufferID, nBitsBufferID, indicesBuffer_1.getID(), indicesBuffer_2.getID() });
 		reallocatePositionShader->use();
 		reallocatePositionShader->setUniform("arraySize", arraySize);
 		reallocatePositionShader->execute(numGroups, 1, 1, maxGroupSize, 1, 1);
 	}
 
-	glDeleteBuffers(1, &indicesBufferID_1);
-	glDeleteBuffers(1, &pBitsBufferID);
-	glDeleteBuffers(1, &nBitsBufferID);
-	glDeleteBuffers(1, &positionBufferID);
-
-	delete[] indices;
+	return indicesBuffer_2;
+}
 
-	return indicesBufferID_2;
+void PointCloudAggregator::updateFrameParameters(const mat4& projectionMatrix)
+{
+	FrameParameters frameParameters;
+	frameParameters._cameraMatrix		= projectionMatrix;
+	frameParameters._backgroundColor	= vec4(_renderingParameters->_backgroundColor, 1.0f);
+	frameParameters._windowSize			= _windowSize;
+	frameParameters._distanceThreshold	= PointCloudParameters::_distanceThreshold;
+	frameParameters._padding			= .0f;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, _frameParametersUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameParameters), &frameParameters);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_PARAMETERS_BINDING, _frameParametersUBO);
 }
 
 void PointCloudAggregator::updateWindowBuffers()
@@ -374,61 +606,66 @@ void PointCloudAggregator::updateWindowBuffers()
 	glBindTexture(GL_TEXTURE_2D, _textureID);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _windowSize.x, _windowSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
 	glGenerateMipmap(GL_TEXTURE_2D);
+
+	// Meanwhile, kernels read the window size from the frame parameters
+	if (_constantWindowSize) this->loadShaders(false);
+	_windowResizeTime = std::chrono::steady_clock::now();
+	_frameCommands.clear();
 }
 
 void PointCloudAggregator::writeColorsTexture()
 {
-	const int numGroupsImage = ComputeShader::getNumGroups(_windowSize.x * _windowSize.y);
-	
-	_storeTexture->bindBuffers(std::vector<GLuint> { _depthBufferSSBO });
+	const unsigned numGroupsImage = ComputeShader::getNumGroups(_windowSize.x * _windowSize.y);
+
+	// The image unit is program state, so it is kept between replays
 	_storeTexture->use();
-	this->bindTexture();
-	_storeTexture->setUniform("backgroundColor", _renderingParameters->_backgroundColor);
 	_storeTexture->setUniform("texImage", GLint(0));
-	_storeTexture->setUniform("windowSize", _windowSize);
-	_storeTexture->execute(numGroupsImage, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+	_frameCommands.dispatch(_storeTexture, std::vector<GLuint> { _depthBufferSSBO }, uvec3(numGroupsImage, 1, 1), uvec3(ComputeShader::getMaxGroupSize(), 1, 1));
 }
 
 void PointCloudAggregator::writeColorsTextureHQR()
 {
-	const int numGroupsImage = ComputeShader::getNumGroups(_windowSize.x * _windowSize.y);
+	const unsigned numGroupsImage = ComputeShader::getNumGroups(_windowSize.x * _windowSize.y);
 
-	_storeHQRTexture->bindBuffers(std::vector<GLuint> { _color01SSBO, _color02SSBO });
+	// The image unit is program state, so it is kept between replays
 	_storeHQRTexture->use();
-	this->bindTexture();
-	_storeHQRTexture->setUniform("backgroundColor", _renderingParameters->_backgroundColor);
 	_storeHQRTexture->setUniform("texImage", GLint(0));
-	_storeHQRTexture->setUniform("windowSize", _windowSize);
-	_storeHQRTexture->execute(numGroupsImage, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+	_frameCommands.dispatch(_storeHQRTexture, std::vector<GLuint> { _color01SSBO, _color02SSBO }, uvec3(numGroupsImage, 1, 1), uvec3(ComputeShader::getMaxGroupSize(), 1, 1));
 }
 
-void PointCloudAggregator::writePointCloudGPU()
+void PointCloudAggregator::writePointChunkGPU(const Point* points, const unsigned numPoints, const AABB& aabb)
 {
-	unsigned currentNumPoints, leftPoints = _pointCloud->getNumberOfPoints(), currentNumPointAux;
-	unsigned numPoints = std::min(this->getAllowedNumberOfPoints(), _pointCloud->getNumberOfPoints());
-	std::vector<PointCloud::PointModel>* points = _pointCloud->getPoints();
-	GLuint indexSSBO = ComputeShader::setWriteBuffer(GLuint(), numPoints, GL_DYNAMIC_DRAW);
+	GLuint pointBufferSSBO = ComputeShader::setWriteBuffer(Point(), numPoints, GL_STATIC_DRAW);
 
-	while (leftPoints > 0)
-	{
-		currentNumPoints = std::min(numPoints, leftPoints), currentNumPointAux = currentNumPoints;
+	// Points are streamed through the upload ring, so that the frame does not wait for the driver to copy them
+	GPUUploadRing::getInstance()->upload(pointBufferSSBO, 0, points, GLsizeiptr(sizeof(Point)) * numPoints);
 
-		GLuint pointBufferSSBO = ComputeShader::setReadBuffer(&(points->at(points->size() - leftPoints)), currentNumPoints, GL_DYNAMIC_DRAW);
+	_pointCloudSSBO.push_back(pointBufferSSBO);
+	_pointCloudChunkSize.push_back(numPoints);
+	_pointCloudChunkAABB.push_back(aabb);
+}
 
-		if (PointCloudParameters::_reducePointCloud)
-		{
-			this->reducePointChunk(pointBufferSSBO, indexSSBO, currentNumPointAux);
-		}
+void PointCloudAggregator::writePointCloudGPU()
+{
+	// Chunks of datasets come from several point clouds, which are uploaded by the dataset itself
+	if (!_pointCloud) return;
 
-		if (PointCloudParameters::_sortPointCloud)
-		{
-			this->sortPoints(pointBufferSSBO, currentNumPointAux);
-		}
+	// GPU-resident clouds are read again from their cache, since previous buffers are already deleted
+	const bool gpuResident = _pointCloud->isGPUResident();
+	if (!_pointCloud->restorePoints()) return;
+
+	const unsigned maxPoints = this->getAllowedNumberOfPoints(), numPoints = _pointCloud->getNumberOfPoints();
+	const PointCloud::PointModel* points = _pointCloud->getPointData();
 
-		_pointCloudSSBO.push_back(pointBufferSSBO);
-		_pointCloudChunkSize.push_back(currentNumPointAux);
-		leftPoints -= currentNumPoints;
+	for (unsigned firstPoint = 0; firstPoint < numPoints; firstPoint += maxPoints)
+	{
+		this->writePointChunkGPU(points + firstPoint, std::min(maxPoints, numPoints - firstPoint), _pointCloud->getAABB());
 	}
 
-	glDeleteBuffers(1, &indexSSBO);
+	this->processPointChunks(_firstUnprocessedChunk, _pointCloud->getAABB());
+
+	_firstUnprocessedChunk = _pointCloudSSBO.size();
+	_frameCommands.clear();
+
+	if (gpuResident) _pointCloud->releasePoints(std::bind(&PointCloudAggregator::readPoints, this, std::placeholders::_1));
 }
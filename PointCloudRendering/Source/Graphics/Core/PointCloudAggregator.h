@@ -1,6 +1,10 @@
 #pragma once
 
+#include "Graphics/Core/ComputeCommandList.h"
+#include "Graphics/Core/GPUBufferPool.h"
+#include "Graphics/Core/GPUReadback.h"
 #include "Graphics/Core/PointCloud.h"
+#include "Graphics/Core/ShaderList.h"
 
 /**
 *	@file PointCloudAggregator.h
@@ -15,14 +19,39 @@ typedef PointCloud::PointModel Point;
 */
 class PointCloudAggregator
 {
+protected:
+	struct FrameParameters
+	{
+		mat4					_cameraMatrix;						//!< Projection of the points
+		vec4					_backgroundColor;					//!< Color of empty pixels, with an unused alpha channel
+		uvec2					_windowSize;						//!< Size of the depth and color buffers
+		float					_distanceThreshold;					//!< Depth ratio of points accumulated into the same surface (HQR)
+		float					_padding;							//!< std140 alignment
+	};
+
+	struct PendingUpload
+	{
+		uint64_t				_ticket;							//!< Upload of GPUUploadRing
+		size_t					_chunk;								//!< Chunk which receives the points
+		GLuint					_numPoints;							//!< Points appended to the chunk once the upload is issued
+	};
+
+	const static GLuint		FRAME_PARAMETERS_BINDING;			//!< Uniform buffer binding of FrameParameters, as declared in Templates/frameParameters.glsl
+	const static float		WINDOW_SIZE_SHADER_DELAY;			//!< Time (ms) that the window size must remain unchanged before kernels are compiled for it
+
 protected:
 	PointCloud*				_pointCloud;
 	
 	// SSBO
 	std::vector<GLuint>		_pointCloudSSBO;
 	std::vector<GLuint>		_pointCloudChunkSize;
+	std::vector<AABB>		_pointCloudChunkAABB;				//!< Boundaries of each chunk, used to skip those outside the view frustum
+	GLuint					_openChunkCapacity;					//!< Points allocated for the last chunk, which is filled by successive uploads
+	GLuint					_openChunkPoints;					//!< Points written into the last chunk, including those whose upload is still pending
+	std::vector<PendingUpload> _pendingUploads;					//!< Uploads whose points are not rendered yet, as their GPU copy has not been issued
+	size_t					_progressivePoints;					//!< Points uploaded since the progressive upload began
+	size_t					_firstUnprocessedChunk;				//!< Chunks from this one are neither reduced nor sorted, as the boundaries of their cloud are not known yet
 	GLuint					_depthBufferSSBO, _rawDepthBufferSSBO, _color01SSBO, _color02SSBO;
-	std::vector<Point>		_supportBuffer;
 
 	// OpenGL Texture
 	GLuint					_textureID;
@@ -32,6 +61,15 @@ protected:
 	ComputeShader*			_projectionShader, *_projectionHQRShader;
 	ComputeShader*			_resetDepthBufferShader, * _resetDepthBufferHQRShader;
 	ComputeShader*			_storeTexture, *_storeHQRTexture;
+	bool					_constantWindowSize;				//!< Loaded kernels were compiled with the window size as a constant, instead of a uniform
+	uvec2					_shaderWindowSize;					//!< Window size of the last permutations compiled with a constant size, or zero if none
+	std::chrono::steady_clock::time_point _windowResizeTime;	//!< Last change of the window size
+	GLuint					_frameParametersUBO;				//!< Parameters shared by every kernel, uploaded once per frame
+
+	// Frame commands
+	ComputeCommandList		_frameCommands;						//!< Dispatches of a frame, recorded again when chunks, window size or shaders change
+	bool					_frameCommandsHQR;					//!< Recorded commands implement the HQR pipeline
+	std::vector<bool>		_visibleChunks;						//!< Chunks within the view frustum, whose commands are replayed
 
 	// Window
 	RenderingParameters*	_renderingParameters;
@@ -51,39 +89,77 @@ protected:
 	void bindTexture();
 
 	/**
-	*	@brief
+	*	@return Pooled buffer with the Morton code of each point.
 	*/
-	GLuint calculateMortonCodes(const GLuint pointsSSBO, unsigned numPoints);
+	GPUBuffer calculateMortonCodes(const GLuint pointsSSBO, unsigned numPoints, const AABB& aabb);
 
 	/**
 	*	@brief  
 	*/
 	void deletePointCloudBuffers();
+
+	/**
+	*	@brief Renders the points of the uploads whose GPU copy has already been issued.
+	*	@param wait Waits for every pending upload.
+	*/
+	void applyPendingUploads(const bool wait);
 	
 	/**
-	*	@brief Projects the point cloud SSBOs into a window plane. 
+	*	@return Permutations of the per-frame kernels for the given defines.
 	*/
-	void projectPointCloud(const mat4& projectionMatrix);
+	static std::vector<ShaderList::ComputePermutation> getShaderPermutations(const ShaderProgram::ShaderDefines& defines);
 
 	/**
-	*	@brief Projects the point cloud SSBOs into a window plane.
+	*	@brief Retrieves the permutations of the per-frame kernels, with fixed work group size and, if requested, constant window size.
+	*	Permutations built for a previous window size are released, as well as their cached binaries.
 	*/
-	void projectPointCloudHQR(const mat4& projectionMatrix);
+	void loadShaders(const bool constantWindowSize);
 
 	/**
-	*	@brief  
+	*	@brief Reduces and sorts the chunks from the given one, if requested, according to the boundaries of their whole point cloud.
+	*/
+	void processPointChunks(const size_t firstChunk, const AABB& aabb);
+
+	/**
+	*	@brief Records the projection of the point cloud SSBOs into a window plane. 
+	*/
+	void projectPointCloud();
+
+	/**
+	*	@brief Records the projection of the point cloud SSBOs into a window plane.
 	*/
-	void reducePointChunk(GLuint& pointsSSBO, const GLuint indexSSBO, unsigned& numPoints);
+	void projectPointCloudHQR();
 
 	/**
-	*	@brief
+	*	@brief Records the dispatches of the active pipeline, which are then replayed each frame.
 	*/
-	void sortPoints(const GLuint pointsSSBO, unsigned numPoints);
+	void recordFrameCommands();
 
 	/**
-	*	@brief
+	*	@brief Gathers into the index buffer the points which remain after reducing a chunk, without waiting for the GPU.
+	*	@return Readback of the number of remaining points.
 	*/
-	GLuint sortFacesByMortonCode(const GLuint mortonCodes, unsigned numPoints);
+	GPUReadback<GLuint> reducePointChunk(const GLuint pointsSSBO, const GLuint indexSSBO, const unsigned numPoints, const AABB& aabb);
+
+	/**
+	*	@brief Sorts a chunk according to the Morton codes of its points. Points are gathered into a new buffer, which replaces the given one.
+	*/
+	void sortPoints(GLuint& pointsSSBO, unsigned numPoints, const AABB& aabb);
+
+	/**
+	*	@return Pooled buffer with the indices of the points sorted by their Morton codes.
+	*/
+	GPUBuffer sortFacesByMortonCode(const GLuint mortonCodes, unsigned numPoints);
+
+	/**
+	*	@brief Replaces a chunk with the points referenced by the first indices of the given buffer.
+	*/
+	void transferPointChunk(GLuint& pointsSSBO, const GLuint indexSSBO, const unsigned numPoints);
+
+	/**
+	*	@brief Uploads the parameters of the current frame and binds them to every kernel, instead of setting them per chunk and pass.
+	*/
+	void updateFrameParameters(const mat4& projectionMatrix);
 	
 	/**
 	*	@brief  
@@ -91,12 +167,12 @@ protected:
 	void updateWindowBuffers();
 
 	/**
-	*	@brief Writes colors from the point cloud into a texture. 
+	*	@brief Records the writing of colors from the point cloud into a texture. 
 	*/
 	void writeColorsTexture();
 
 	/**
-	*	@brief Writes colors from the point cloud into a texture.
+	*	@brief Records the writing of colors from the point cloud into a texture.
 	*/
 	void writeColorsTextureHQR();
 
@@ -105,6 +181,11 @@ protected:
 	*/
 	void writePointCloudGPU();
 
+	/**
+	*	@brief Transfers a chunk which fits in a single SSBO, which is then reduced and sorted along with the rest of its point cloud.
+	*/
+	void writePointChunkGPU(const Point* points, const unsigned numPoints, const AABB& aabb);
+
 public:
 	/**
 	*	@brief  
@@ -116,24 +197,66 @@ public:
 	*/
 	virtual ~PointCloudAggregator();
 
+	/**
+	*	@brief Discards the uploaded points, so that a point cloud can be uploaded through uploadChunk() while it is being loaded.
+	*	@param pointCloud Point cloud being loaded, or nullptr if chunks come from several point clouds (e.g. tiles of a dataset).
+	*/
+	void beginProgressiveUpload(PointCloud* pointCloud);
+
 	/**
 	*	@brief Modifies size of buffer affected by the size of the window. 
 	*/
 	void changedSize(const uint16_t width, const uint16_t height);
 
+	/**
+	*	@brief Deletes a range of closed chunks, e.g. those of an evicted tile. Next chunks are moved backwards.
+	*/
+	void deleteChunks(const size_t firstChunk, const size_t numChunks);
+
+	/**
+	*	@brief Closes the chunks uploaded through uploadChunk(), reducing and sorting them with the boundaries of the whole point cloud,
+	*	so that every chunk shares the same grid. Next uploads start a new chunk.
+	*/
+	void finishProgressiveUpload(const AABB& aabb);
+
+	/**
+	*	@brief Waits for pending uploads, so that the points given to uploadChunk() can be released or overwritten.
+	*/
+	void flushUploads() { this->applyPendingUploads(true); }
+
 	/**
 	*	@return Identifier of image texture with point cloud colors. 
 	*/
 	GLuint getTexture() { return _textureID; }
 
+	/**
+	*	@return Number of uploaded chunks, including the one which is being filled.
+	*/
+	size_t getNumChunks() const { return _pointCloudSSBO.size(); }
+
+	/**
+	*	@brief Reads back every uploaded chunk, e.g. to retrieve points whose host copy was released. Points are given as they are
+	*	stored in GPU, i.e. sorted and reduced if requested when they were uploaded.
+	*	@return False if the buffers could not be read.
+	*/
+	bool readPoints(std::vector<Point>& points);
+
 	/**
 	*	@brief Triggers the rendering of a new frame. 
 	*/
 	void render(const mat4& projectionMatrix);
 
 	/**
-	*	@brief
+	*	@brief Uploads the whole point cloud.
 	*/
 	void setPointCloud(PointCloud* pointCloud);
+
+	/**
+	*	@brief Uploads a range of points of the current point cloud, which is rendered along with the previous ones. Ranges are appended
+	*	to the last chunk, which is allocated for the remaining points, so that the number of chunks only depends on the SSBO size limit.
+	*	Points are copied into the staging memory in background, so they must stay valid until flushUploads() or finishProgressiveUpload().
+	*	@param totalPoints Number of points of the cloud being uploaded.
+	*/
+	void uploadChunk(const Point* points, const unsigned numPoints, const size_t totalPoints);
 };
 
@@ -0,0 +1,436 @@
+#include "stdafx.h"
+#include "PointCloudDataset.h"
+
+#include <filesystem>
+#include "Graphics/Application/PointCloudParameters.h"
+#include "Graphics/Core/CompressedPointCache.h"
+#include "Graphics/Core/LASReader.h"
+#include "Graphics/Core/PLYReader.h"
+#include "Utilities/MemoryMappedFile.h"
+
+// [Static members initialization]
+
+const std::string PointCloudDataset::MANIFEST_EXTENSION = ".tiles";
+const unsigned PointCloudDataset::MAX_CONCURRENT_LOADS = 4;
+
+/// [Public methods]
+
+PointCloudDataset::PointCloudDataset(PointCloudAggregator* aggregator) :
+	_aggregator(aggregator), _localOrigin(.0)
+{
+}
+
+PointCloudDataset::~PointCloudDataset()
+{
+	this->cancelLoading();
+}
+
+void PointCloudDataset::cancelLoading()
+{
+	for (std::unique_ptr<Tile>& tile : _tiles)
+	{
+		if (tile->_loadingTask)
+		{
+			tile->_loadingTask.reset();					// Cancels and waits for the job
+			tile->_pointCloud.reset();
+			tile->_state = TILE_UNLOADED;
+		}
+		else if (tile->_state == TILE_UPLOADING)
+		{
+			const AABB aabb = tile->_pointCloud->getAABB();
+			const vec3 translation = vec3(tile->_localOrigin - _localOrigin);
+
+			// Points of the next tile must not be appended to the chunk of this one
+			_aggregator->finishProgressiveUpload(AABB(aabb.min() + translation, aabb.max() + translation));
+			tile->_numChunks = tile->_uploadedPoints ? _aggregator->getNumChunks() - tile->_firstChunk : 0;
+			tile->_pointCloud.reset();
+			tile->_state = TILE_FAILED;					// Its first points are already rendered, so it is not loaded again
+		}
+	}
+}
+
+float PointCloudDataset::getLoadingProgress() const
+{
+	if (_tiles.empty()) return 1.0f;
+
+	float progress = .0f;
+
+	// Tiles being read contribute with the progress of their task
+	for (const std::unique_ptr<Tile>& tile : _tiles)
+	{
+		if (tile->_state == TILE_UPLOADED || tile->_state == TILE_FAILED) progress += 1.0f;
+		else if (tile->_state == TILE_LOADING && tile->_loadingTask) progress += tile->_loadingTask->getProgress();
+	}
+
+	return progress / _tiles.size();
+}
+
+unsigned PointCloudDataset::getNumUploadedTiles() const
+{
+	return unsigned(std::count_if(_tiles.begin(), _tiles.end(), [](const std::unique_ptr<Tile>& tile) { return tile->_state == TILE_UPLOADED; }));
+}
+
+bool PointCloudDataset::isLoading() const
+{
+	return std::any_of(_tiles.begin(), _tiles.end(), [](const std::unique_ptr<Tile>& tile) { return tile->_state == TILE_LOADING || tile->_state == TILE_UPLOADING; });
+}
+
+bool PointCloudDataset::isDataset(const std::string& path)
+{
+	return std::filesystem::is_directory(path) || std::filesystem::path(path).extension() == MANIFEST_EXTENSION;
+}
+
+bool PointCloudDataset::open(const std::string& path)
+{
+	this->cancelLoading();
+
+	_tiles.clear();
+	_aabb = AABB();
+	_localOrigin = glm::dvec3(.0);
+
+	const bool indexed = std::filesystem::is_directory(path) ? this->indexDirectory(path) : this->indexManifest(path);
+
+	if (!indexed || _tiles.empty())
+	{
+		std::cerr << "No point cloud tiles were found in " << path << std::endl;
+		return false;
+	}
+
+	// Headers are small, but there may be hundreds of them
+	std::for_each(std::execution::par, _tiles.begin(), _tiles.end(), [](std::unique_ptr<Tile>& tile) { PointCloudDataset::readTileHeader(*tile); });
+
+	// Tiles are translated to the origin of the first one which declares it, so that coordinates keep their precision as floats. 
+	// Otherwise, the minimum corner of the known boundaries is taken
+	auto originTile = std::find_if(_tiles.begin(), _tiles.end(), [](const std::unique_ptr<Tile>& tile) { return tile->_knownOrigin; });
+
+	if (originTile != _tiles.end())
+	{
+		_localOrigin = (*originTile)->_localOrigin;
+	}
+	else
+	{
+		glm::dvec3 minPoint(DBL_MAX);
+
+		for (const std::unique_ptr<Tile>& tile : _tiles)
+		{
+			if (tile->_knownAABB) minPoint = glm::min(minPoint, tile->_localOrigin + glm::dvec3(tile->_aabb.min()));
+		}
+
+		if (minPoint.x != DBL_MAX) _localOrigin = minPoint;
+	}
+
+	for (std::unique_ptr<Tile>& tile : _tiles)
+	{
+		if (tile->_knownAABB)
+		{
+			const vec3 translation = vec3(tile->_localOrigin - _localOrigin);
+
+			tile->_aabb = AABB(tile->_aabb.min() + translation, tile->_aabb.max() + translation);
+			_aabb.update(tile->_aabb);
+		}
+	}
+
+	std::cout << "Indexed " << _tiles.size() << " tiles from " << path << std::endl;
+
+	return true;
+}
+
+void PointCloudDataset::update(const mat4& viewProjection)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	std::vector<std::pair<float, Tile*>> candidates;
+	unsigned numLoadingTiles = 0;
+
+	for (std::unique_ptr<Tile>& tile : _tiles)
+	{
+		if (tile->_state == TILE_LOADING && tile->_loadingTask->isFinished())
+		{
+			const bool success = tile->_loadingTask->wait();
+
+			tile->_loadingTask.reset();
+			tile->_state = success ? TILE_UPLOADING : TILE_FAILED;
+
+			if (!success)
+			{
+				tile->_pointCloud.reset();
+				std::cerr << "Tile " << tile->_path << " could not be loaded." << std::endl;
+			}
+			else if (!tile->_knownAABB)
+			{
+				// Boundaries of tiles without header information are known once they are loaded; their cache provides them next time
+				const AABB aabb = tile->_pointCloud->getAABB();
+				const vec3 translation = vec3(tile->_localOrigin - _localOrigin);
+
+				tile->_aabb = AABB(aabb.min() + translation, aabb.max() + translation);
+				tile->_knownAABB = true;
+				_aabb.update(tile->_aabb);
+
+				if (!tile->_aabb.intersectsFrustum(viewProjection))
+				{
+					tile->_pointCloud.reset();
+					tile->_state = TILE_UNLOADED;
+				}
+			}
+		}
+
+		if (tile->_state == TILE_LOADING)
+		{
+			++numLoadingTiles;
+		}
+		else if (tile->_state == TILE_UNLOADED && (!tile->_knownAABB || tile->_aabb.intersectsFrustum(viewProjection)))
+		{
+			// Nearest tiles are loaded first; w is the depth of the tile center in view space
+			const vec4 center = viewProjection * vec4(tile->_aabb.center(), 1.0f);
+			candidates.push_back(std::make_pair(tile->_knownAABB ? center.w : FLT_MAX, tile.get()));
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, Tile*>& a, const std::pair<float, Tile*>& b) { return a.first < b.first; });
+
+	for (unsigned candidateIdx = 0; candidateIdx < candidates.size() && numLoadingTiles < MAX_CONCURRENT_LOADS; ++candidateIdx, ++numLoadingTiles)
+	{
+		this->launchLoading(candidates[candidateIdx].second);
+	}
+
+	// Uploads are restricted to the OpenGL thread, and limited to a frame budget
+	for (std::unique_ptr<Tile>& tile : _tiles)
+	{
+		if (tile->_state == TILE_UPLOADING && !this->uploadTile(*tile, startTime)) break;
+	}
+
+	this->evictTiles(viewProjection);
+}
+
+/// [Protected methods]
+
+void PointCloudDataset::evictTiles(const mat4& viewProjection)
+{
+	const size_t pointBudget = size_t(PointCloudParameters::_datasetPointBudget) * 1000000;
+	std::vector<std::pair<float, Tile*>> candidates;
+	size_t numPoints = 0;
+
+	for (std::unique_ptr<Tile>& tile : _tiles)
+	{
+		if (tile->_state != TILE_UPLOADED) continue;
+
+		numPoints += tile->_numPoints;
+
+		if (!tile->_aabb.intersectsFrustum(viewProjection))
+		{
+			const vec4 center = viewProjection * vec4(tile->_aabb.center(), 1.0f);
+			candidates.push_back(std::make_pair(std::abs(center.w), tile.get()));
+		}
+	}
+
+	if (numPoints <= pointBudget) return;
+
+	std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, Tile*>& a, const std::pair<float, Tile*>& b) { return a.first > b.first; });
+
+	for (unsigned candidateIdx = 0; candidateIdx < candidates.size() && numPoints > pointBudget; ++candidateIdx)
+	{
+		Tile* evictedTile = candidates[candidateIdx].second;
+		_aggregator->deleteChunks(evictedTile->_firstChunk, evictedTile->_numChunks);
+
+		// Chunks of the following tiles are moved backwards
+		for (std::unique_ptr<Tile>& tile : _tiles)
+		{
+			if (tile->_firstChunk > evictedTile->_firstChunk) tile->_firstChunk -= evictedTile->_numChunks;
+		}
+
+		numPoints -= evictedTile->_numPoints;
+		evictedTile->_state = TILE_UNLOADED;
+		evictedTile->_uploadedPoints = evictedTile->_numChunks = 0;
+	}
+}
+
+bool PointCloudDataset::indexDirectory(const std::string& path)
+{
+	std::map<std::string, std::filesystem::path> tilePaths;
+
+	// Extensions by priority: caches next to their source refer to the same tile
+	auto priority = [](std::string extension) -> int
+	{
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		return extension == BINARY_EXTENSION ? 0 : (extension == COMPRESSED_CACHE_EXTENSION ? 1 : 2);
+	};
+
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path))
+	{
+		if (!entry.is_regular_file() || !this->isTileExtension(entry.path().extension().string())) continue;
+
+		// Sources and their caches share the same cache path
+		const std::filesystem::path& tilePath = entry.path();
+		const std::string stem = PointCloud::getCachePath(tilePath.string(), BINARY_EXTENSION);
+		auto previousPath = tilePaths.find(stem);
+
+		if (previousPath == tilePaths.end() || priority(previousPath->second.extension().string()) < priority(tilePath.extension().string()))
+		{
+			tilePaths[stem] = tilePath;
+		}
+	}
+
+	for (const auto& tilePath : tilePaths)
+	{
+		_tiles.push_back(std::unique_ptr<Tile>(new Tile{ tilePath.second.string(), AABB(), false, glm::dvec3(.0), false, 0, TILE_UNLOADED, nullptr, nullptr, 0, 0, 0 }));
+	}
+
+	return true;
+}
+
+bool PointCloudDataset::indexManifest(const std::string& path)
+{
+	std::ifstream fin(path, std::ios::in);
+
+	if (!fin.is_open())
+	{
+		std::cerr << "Manifest " << path << " could not be opened." << std::endl;
+		return false;
+	}
+
+	const std::filesystem::path folder = std::filesystem::path(path).parent_path();
+	std::string line;
+
+	while (std::getline(fin, line))
+	{
+		std::istringstream stream(line);
+		std::string tilePath;
+		vec3 minPoint, maxPoint;
+
+		if (!(stream >> tilePath) || tilePath[0] == '#') continue;
+
+		if (std::filesystem::path(tilePath).is_relative()) tilePath = (folder / tilePath).string();
+
+		// Boundaries from the manifest are used when the tile header does not include them
+		const bool knownAABB = bool(stream >> minPoint.x >> minPoint.y >> minPoint.z >> maxPoint.x >> maxPoint.y >> maxPoint.z);
+
+		_tiles.push_back(std::unique_ptr<Tile>(new Tile{ tilePath, knownAABB ? AABB(minPoint, maxPoint) : AABB(), knownAABB, glm::dvec3(.0), false, 0, TILE_UNLOADED, nullptr, nullptr, 0, 0, 0 }));
+	}
+
+	return true;
+}
+
+bool PointCloudDataset::isTileExtension(std::string extension)
+{
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	return extension == BINARY_EXTENSION || extension == COMPRESSED_CACHE_EXTENSION || extension == LAS_EXTENSION || extension == PLY_EXTENSION;
+}
+
+void PointCloudDataset::launchLoading(Tile* tile)
+{
+	tile->_state = TILE_LOADING;
+	tile->_uploadedPoints = 0;
+	tile->_pointCloud.reset(new PointCloud(tile->_path, true));
+
+	tile->_loadingTask.reset(new BackgroundTask("Loading " + tile->_path, [tile](BackgroundTask& task) -> bool
+		{
+			size_t readPoints = 0;
+
+			tile->_pointCloud->setChunkCallback([&task, &readPoints](const PointCloud::PointModel* points, size_t numPoints, size_t totalPoints)
+				{
+					readPoints += numPoints;
+					task.setProgress(float(readPoints) / std::max(totalPoints, size_t(1)));
+
+					return !task.isCancelled();
+				});
+
+			return tile->_pointCloud->load();
+		}));
+}
+
+void PointCloudDataset::readTileHeader(Tile& tile)
+{
+	std::filesystem::path tilePath(tile._path), binaryPath = PointCloud::getCachePath(tile._path, BINARY_EXTENSION);
+	std::string extension = tilePath.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	// Cached files provide the boundaries of any format
+	CompressedPointCache::Header cacheHeader;
+	PointCloud::BinaryHeader binaryHeader;
+
+	if (CompressedPointCache::readHeader(PointCloud::getCachePath(tile._path, COMPRESSED_CACHE_EXTENSION), cacheHeader))
+	{
+		tile._numPoints = cacheHeader._numPoints;
+		tile._localOrigin = glm::dvec3(cacheHeader._localOrigin[0], cacheHeader._localOrigin[1], cacheHeader._localOrigin[2]);
+		tile._knownOrigin = true;
+		tile._aabb = AABB(cacheHeader._minPoint, cacheHeader._maxPoint);
+		tile._knownAABB = true;
+	}
+	else if (PointCloud::readBinaryHeader(binaryPath.string(), binaryHeader))
+	{
+		tile._numPoints = binaryHeader._numPoints;
+		tile._localOrigin = glm::dvec3(binaryHeader._localOrigin[0], binaryHeader._localOrigin[1], binaryHeader._localOrigin[2]);
+		tile._knownOrigin = true;
+		tile._aabb = AABB(binaryHeader._minPoint, binaryHeader._maxPoint);
+		tile._knownAABB = true;
+	}
+	else if (extension == LAS_EXTENSION)
+	{
+		MemoryMappedFile mappedFile;
+		LASReader::Header header;
+
+		if (mappedFile.open(tile._path, false) && LASReader::readHeader(mappedFile.data(), mappedFile.size(), header))
+		{
+			// LAS points are read relative to the minimum corner of the header
+			tile._numPoints = header._numPoints;
+			tile._localOrigin = header._minPoint;
+			tile._knownOrigin = true;
+			tile._aabb = AABB(vec3(.0f), vec3(header._maxPoint - header._minPoint));
+			tile._knownAABB = true;
+		}
+	}
+	else if (extension == PLY_EXTENSION)
+	{
+		std::ifstream fin(tile._path, std::ios::in | std::ios::binary);
+		PLYReader::Header header;
+
+		if (fin.is_open() && PLYReader::readHeader(fin, header))
+		{
+			tile._numPoints = header._numVertices;
+		}
+	}
+}
+
+bool PointCloudDataset::uploadTile(Tile& tile, const std::chrono::high_resolution_clock::time_point& startTime)
+{
+	const size_t numPoints = tile._pointCloud->getNumberOfPoints();
+	const PointCloud::PointModel* points = tile._pointCloud->getPointData();
+	const vec3 translation = vec3(tile._localOrigin - _localOrigin);
+
+	if (tile._uploadedPoints == 0) tile._firstChunk = _aggregator->getNumChunks();
+
+	while (tile._uploadedPoints < numPoints)
+	{
+		if (std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count() >= PointCloudParameters::_uploadBudget)
+		{
+			return false;
+		}
+
+		const size_t chunkSize = std::min(numPoints - tile._uploadedPoints, size_t(PointCloudParameters::_uploadChunkSize));
+		const PointCloud::PointModel* chunkPoints = points + tile._uploadedPoints;
+
+		// Points are moved next to the origin of the dataset range by range, so that mapped tiles are not copied at once
+		if (translation != vec3(.0f))
+		{
+			_aggregator->flushUploads();						// The previous range may still be read from this buffer
+			_translatedPoints.resize(chunkSize);
+			std::transform(std::execution::par_unseq, chunkPoints, chunkPoints + chunkSize, _translatedPoints.begin(), [&translation](PointCloud::PointModel point) { point._point += translation; return point; });
+			chunkPoints = _translatedPoints.data();
+		}
+
+		_aggregator->uploadChunk(chunkPoints, unsigned(chunkSize), numPoints);
+		tile._uploadedPoints += chunkSize;
+	}
+
+	const AABB aabb = tile._pointCloud->getAABB();
+	_aggregator->finishProgressiveUpload(AABB(aabb.min() + translation, aabb.max() + translation));
+
+	tile._numChunks = _aggregator->getNumChunks() - tile._firstChunk;
+
+	// Points are kept in GPU only
+	tile._numPoints = numPoints;
+	tile._pointCloud.reset();
+	tile._state = TILE_UPLOADED;
+
+	return true;
+}
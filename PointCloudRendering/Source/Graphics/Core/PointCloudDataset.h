@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Geometry/3D/AABB.h"
+#include "Graphics/Core/PointCloud.h"
+#include "Graphics/Core/PointCloudAggregator.h"
+#include "Utilities/BackgroundTask.h"
+
+/**
+*	@file PointCloudDataset.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Survey split into several point cloud tiles, given as a directory or as a manifest file. Only the headers of the tiles
+*	are read when the dataset is opened. Tiles are loaded in parallel once they become visible, and their points are uploaded to
+*	the aggregator, which renders every tile into the same depth buffer.
+*/
+class PointCloudDataset
+{
+public:
+	enum TileState : uint8_t
+	{
+		TILE_UNLOADED, TILE_LOADING, TILE_UPLOADING, TILE_UPLOADED, TILE_FAILED
+	};
+
+	struct Tile
+	{
+		std::string						_path;					//!< Path of the tile file
+		AABB							_aabb;					//!< Boundaries relative to the origin of the dataset
+		bool							_knownAABB;				//!< False if neither the header nor the manifest provide the boundaries
+		glm::dvec3						_localOrigin;			//!< Origin of the tile coordinates
+		bool							_knownOrigin;			//!< False if the header does not provide the origin, i.e. coordinates are absolute
+		size_t							_numPoints;				//!< Number of points declared in the header, zero if unknown
+		TileState						_state;					//!< Loading state
+		std::unique_ptr<PointCloud>		_pointCloud;			//!< Loaded points, released once they are uploaded
+		std::unique_ptr<BackgroundTask>	_loadingTask;			//!< Job which loads the tile
+		size_t							_uploadedPoints;		//!< Number of points already uploaded
+		size_t							_firstChunk;			//!< First aggregator chunk with points of this tile
+		size_t							_numChunks;				//!< Number of aggregator chunks of this tile, once it is uploaded
+	};
+
+protected:
+	const static std::string	MANIFEST_EXTENSION;				//!< Extension of manifest files, which list a tile per line
+	const static unsigned		MAX_CONCURRENT_LOADS;			//!< Maximum number of tiles loaded at the same time
+
+protected:
+	PointCloudAggregator*				_aggregator;			//!< Destination of the tile points
+	AABB								_aabb;					//!< Boundaries of the tiles whose extent is known
+	glm::dvec3							_localOrigin;			//!< Every tile is translated to be relative to this origin
+	std::vector<std::unique_ptr<Tile>>	_tiles;					//!< Indexed tiles. Pointers keep their address while they are loaded in background
+	std::vector<PointCloud::PointModel>	_translatedPoints;		//!< Range of points moved to the dataset origin before being uploaded
+
+protected:
+	/**
+	*	@brief Evicts uploaded tiles outside the view frustum, farthest first, while the dataset exceeds the GPU point budget.
+	*/
+	void evictTiles(const mat4& viewProjection);
+
+	/**
+	*	@brief Finds the tiles within a directory.
+	*/
+	bool indexDirectory(const std::string& path);
+
+	/**
+	*	@brief Reads a manifest. Each line contains a tile path, relative to the manifest, optionally followed by its minimum and maximum corners.
+	*/
+	bool indexManifest(const std::string& path);
+
+	/**
+	*	@return True if the extension belongs to a point cloud format which can be used as a tile.
+	*/
+	static bool isTileExtension(std::string extension);
+
+	/**
+	*	@brief Launches the background loading of a tile.
+	*/
+	void launchLoading(Tile* tile);
+
+	/**
+	*	@brief Reads the number of points, boundaries and origin of a tile, if its format stores them in the header.
+	*/
+	static void readTileHeader(Tile& tile);
+
+	/**
+	*	@brief Uploads points of a loaded tile until the time budget is spent.
+	*	@return False if the budget was spent before uploading the whole tile.
+	*/
+	bool uploadTile(Tile& tile, const std::chrono::high_resolution_clock::time_point& startTime);
+
+public:
+	/**
+	*	@brief Constructor.
+	*	@param aggregator Renderer of the tile points.
+	*/
+	PointCloudDataset(PointCloudAggregator* aggregator);
+
+	/**
+	*	@brief Destructor. Cancels the tiles which are being loaded.
+	*/
+	virtual ~PointCloudDataset();
+
+	/**
+	*	@brief Cancels every tile which is being loaded.
+	*/
+	void cancelLoading();
+
+	/**
+	*	@brief Indexes the tiles of a directory or manifest, reading only their headers.
+	*	@return True if any tile was found.
+	*/
+	bool open(const std::string& path);
+
+	/**
+	*	@return True if the path is a directory or a manifest of tiles rather than a single point cloud.
+	*/
+	static bool isDataset(const std::string& path);
+
+	/**
+	*	@brief Launches the loading of visible tiles, nearest first, and uploads those already loaded within the frame budget. Tiles 
+	*	without known boundaries are loaded last, and only uploaded if they turn out to be visible.
+	*	@param viewProjection Matrix used to decide which tiles are visible.
+	*/
+	void update(const mat4& viewProjection);
+
+	// Getters
+
+	/**
+	*	@return Boundaries of the dataset, relative to its local origin.
+	*/
+	AABB getAABB() const { return _aabb; }
+
+	/**
+	*	@return Fraction of tiles whose loading has finished.
+	*/
+	float getLoadingProgress() const;
+
+	/**
+	*	@return Origin that must be added to the points to retrieve their original coordinates.
+	*/
+	glm::dvec3 getLocalOrigin() const { return _localOrigin; }
+
+	/**
+	*	@return Number of indexed tiles.
+	*/
+	unsigned getNumTiles() const { return unsigned(_tiles.size()); }
+
+	/**
+	*	@return Number of tiles already uploaded.
+	*/
+	unsigned getNumUploadedTiles() const;
+
+	/**
+	*	@return True while any tile is being loaded or uploaded.
+	*/
+	bool isLoading() const;
+};
+
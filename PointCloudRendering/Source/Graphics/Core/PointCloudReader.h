@@ -0,0 +1,112 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Geometry/3D/AABB.h"
+#include "Graphics/Core/PointCloud.h"
+
+/**
+*	@file PointCloudReader.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Abstract reader of a point cloud format. Readers write directly into the final point vector.
+*/
+class PointCloudReader
+{
+public:
+	typedef PointCloud::PointModel PointModel;
+
+	/**
+	*	@brief Notifies that a range of points is already written. Returns false if reading must be stopped.
+	*/
+	typedef std::function<bool(size_t firstPoint, size_t numPoints, size_t totalPoints)> ChunkCallback;
+
+protected:
+	ChunkCallback		_chunkCallback;						//!< Receives ranges of points as soon as they are read
+	mat4				_modelMatrix;						//!< Transformation applied to every read point
+
+protected:
+	/**
+	*	@brief Applies the model matrix to a range of points and computes their bounding box. Ranges are meant to be processed 
+	*	by different threads and merged afterwards.
+	*/
+	AABB computeBoundaries(PointModel* points, const size_t numPoints) const;
+
+	/**
+	*	@brief Merges the bounding boxes of several ranges, ignoring those from empty ranges.
+	*/
+	static AABB mergeBoundaries(const std::vector<AABB>& aabbs);
+
+	/**
+	*	@brief Communicates a range of read points, if a callback was given.
+	*	@return False if reading must be stopped.
+	*/
+	bool notifyChunk(const size_t firstPoint, const size_t numPoints, const size_t totalPoints) { return !_chunkCallback || _chunkCallback(firstPoint, numPoints, totalPoints); }
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	PointCloudReader() : _modelMatrix(1.0f) {}
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~PointCloudReader() {}
+
+	/**
+	*	@brief Reads a point cloud file. To be defined.
+	*	@param filename Path of the file, including its extension.
+	*	@param points Vector where points are written. It is resized once by the reader.
+	*	@param aabb Bounding box of the read points.
+	*	@return True if the file could be read.
+	*/
+	virtual bool read(const std::string& filename, std::vector<PointModel>& points, AABB& aabb) = 0;
+
+	/**
+	*	@brief Sets the function which receives ranges of points as they are read. Readers which cannot provide partial 
+	*	results do not call it; ranges are always consecutive and given in order.
+	*/
+	void setChunkCallback(const ChunkCallback& chunkCallback) { _chunkCallback = chunkCallback; }
+
+	/**
+	*	@brief Sets the transformation which is applied to points before notifying them.
+	*/
+	void setModelMatrix(const mat4& modelMatrix) { _modelMatrix = modelMatrix; }
+};
+
+inline AABB PointCloudReader::computeBoundaries(PointModel* points, const size_t numPoints) const
+{
+	vec3 minPoint(FLT_MAX), maxPoint(-FLT_MAX);
+
+	if (_modelMatrix != mat4(1.0f))
+	{
+		for (size_t pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+		{
+			points[pointIdx]._point = vec3(_modelMatrix * vec4(points[pointIdx]._point, 1.0f));
+		}
+	}
+
+	for (size_t pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+	{
+		minPoint = glm::min(minPoint, points[pointIdx]._point);
+		maxPoint = glm::max(maxPoint, points[pointIdx]._point);
+	}
+
+	return AABB(minPoint, maxPoint);
+}
+
+inline AABB PointCloudReader::mergeBoundaries(const std::vector<AABB>& aabbs)
+{
+	AABB aabb;
+
+	for (const AABB& partialAABB : aabbs)
+	{
+		if (partialAABB.min().x <= partialAABB.max().x) aabb.update(partialAABB);
+	}
+
+	return aabb;
+}
+
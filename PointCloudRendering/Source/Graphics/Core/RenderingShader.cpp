@@ -19,83 +19,81 @@ void RenderingShader::applyActiveSubroutines()
 }
 
 GLuint RenderingShader::createShaderProgram(const char* filename)
+{
+	if (!this->submitShaderProgram(filename))
+	{
+		return 0;
+	}
+
+	return this->finishShaderProgram(filename);
+}
+
+GLuint RenderingShader::finishShaderProgram(const char* filename)
+{
+	if (!this->finishLink(filename))
+	{
+		return 0;
+	}
+
+	// Reserve space for subroutines
+	GLint numSubroutines;
+	glGetProgramStageiv(_handler, GL_VERTEX_SHADER, GL_ACTIVE_SUBROUTINE_UNIFORMS, &numSubroutines);
+	_activeSubroutineUniform[VERTEX_SHADER].resize(numSubroutines);
+	std::fill(_activeSubroutineUniform[VERTEX_SHADER].begin(), _activeSubroutineUniform[VERTEX_SHADER].end(), -1);				// Non valid ID
+ 
+	glGetProgramStageiv(_handler, GL_FRAGMENT_SHADER, GL_ACTIVE_SUBROUTINE_UNIFORMS, &numSubroutines);
+	_activeSubroutineUniform[FRAGMENT_SHADER].resize(numSubroutines);
+	std::fill(_activeSubroutineUniform[FRAGMENT_SHADER].begin(), _activeSubroutineUniform[FRAGMENT_SHADER].end(), -1);
+
+	glGetProgramStageiv(_handler, GL_GEOMETRY_SHADER, GL_ACTIVE_SUBROUTINE_UNIFORMS, &numSubroutines);
+	_activeSubroutineUniform[GEOMETRY_SHADER].resize(numSubroutines);
+	std::fill(_activeSubroutineUniform[GEOMETRY_SHADER].begin(), _activeSubroutineUniform[GEOMETRY_SHADER].end(), -1);
+
+	return _handler;
+}
+
+bool RenderingShader::submitShaderProgram(const char* filename)
 {
 	if (_handler <= 0) {										// Shader identifier
 		_handler = glCreateProgram();
 
 		if (_handler == 0) {
 			fprintf(stderr, "Cannot create shader program: %s!\n", filename);
-			return 0;
+			return false;
 		}
 	}
 
+	std::vector<std::pair<GLenum, std::string>> stages;
+	std::string source;
+
 	// [Vertex shader]
 	char fileNameComplete[256];
 	strcpy_s(fileNameComplete, filename);
 	strcat_s(fileNameComplete, "-vert.glsl");
 
-	const GLuint vertexShaderObject = compileShader(fileNameComplete, GL_VERTEX_SHADER);
-	if (vertexShaderObject == 0) {
-		return 0;
+	if (!this->readShaderSource(fileNameComplete, GL_VERTEX_SHADER, source)) {
+		return false;
 	}
 
+	stages.push_back(std::make_pair(GL_VERTEX_SHADER, source));
+
 	// [Fragment shader]
 	strcpy_s(fileNameComplete, filename);
 	strcat_s(fileNameComplete, "-frag.glsl");
 
-	const GLuint fragmentShaderObject = compileShader(fileNameComplete, GL_FRAGMENT_SHADER);
-	if (fragmentShaderObject == 0) {
-		return 0;
+	if (!this->readShaderSource(fileNameComplete, GL_FRAGMENT_SHADER, source)) {
+		return false;
 	}
 
+	stages.push_back(std::make_pair(GL_FRAGMENT_SHADER, source));
+
 	// [Geometry shader, optional]
 	strcpy_s(fileNameComplete, filename);
 	strcat_s(fileNameComplete, "-geo.glsl");
-	const GLuint geometryShaderObject = compileShader(fileNameComplete, GL_GEOMETRY_SHADER);
-
-	glAttachShader(_handler, vertexShaderObject);						// Associate shaders with shader program
-	glAttachShader(_handler, fragmentShaderObject);
-	if (geometryShaderObject != 0) glAttachShader(_handler, geometryShaderObject);
-
-	glLinkProgram(_handler);											// Link shader program to check errors
-	GLint linkSuccess = 0;
-	glGetProgramiv(_handler, GL_LINK_STATUS, &linkSuccess);
-
-	if (linkSuccess == GL_FALSE)
-	{
-		GLint logLen = 0;
-		glGetProgramiv(_handler, GL_INFO_LOG_LENGTH, &logLen);
 
-		if (logLen > 0) {
-			char* cLogString = new char[logLen];
-			GLint written = 0;
-			glGetProgramInfoLog(_handler, logLen, &written, cLogString);
-			_logString.assign(cLogString);
-			delete[] cLogString;
-
-			std::cout << "Cannot link shader " << filename << ":" << std::endl << _logString << std::endl;
-		}
-
-		return 0;
-	}
-	else
-	{
-		_linked = true;
+	if (this->readShaderSource(fileNameComplete, GL_GEOMETRY_SHADER, source)) {
+		stages.push_back(std::make_pair(GL_GEOMETRY_SHADER, source));
 	}
 
-	// Reserve space for subroutines
-	GLint numSubroutines;
-	glGetProgramStageiv(_handler, GL_VERTEX_SHADER, GL_ACTIVE_SUBROUTINE_UNIFORMS, &numSubroutines);
-	_activeSubroutineUniform[VERTEX_SHADER].resize(numSubroutines);
-	std::fill(_activeSubroutineUniform[VERTEX_SHADER].begin(), _activeSubroutineUniform[VERTEX_SHADER].end(), -1);				// Non valid ID
- 
-	glGetProgramStageiv(_handler, GL_FRAGMENT_SHADER, GL_ACTIVE_SUBROUTINE_UNIFORMS, &numSubroutines);
-	_activeSubroutineUniform[FRAGMENT_SHADER].resize(numSubroutines);
-	std::fill(_activeSubroutineUniform[FRAGMENT_SHADER].begin(), _activeSubroutineUniform[FRAGMENT_SHADER].end(), -1);
-
-	glGetProgramStageiv(_handler, GL_GEOMETRY_SHADER, GL_ACTIVE_SUBROUTINE_UNIFORMS, &numSubroutines);
-	_activeSubroutineUniform[GEOMETRY_SHADER].resize(numSubroutines);
-	std::fill(_activeSubroutineUniform[GEOMETRY_SHADER].begin(), _activeSubroutineUniform[GEOMETRY_SHADER].end(), -1);
-
-	return _handler;
+	return this->submitLink(stages);
 }
@@ -34,5 +34,15 @@ public:
 	*	@filename filename Shader program name. Example: pointCloud => pointCloud-vert.glsl, pointCloud-frag.glsl...
 	*/
 	virtual GLuint createShaderProgram(const char* filename);
+
+	/**
+	*	@brief Checks the linking of the program and reserves space for its subroutines.
+	*/
+	virtual GLuint finishShaderProgram(const char* filename);
+
+	/**
+	*	@brief Reads the vertex, fragment and optional geometry shaders and requests their compilation, unless the program is found in the binary cache.
+	*/
+	virtual bool submitShaderProgram(const char* filename);
 };
 
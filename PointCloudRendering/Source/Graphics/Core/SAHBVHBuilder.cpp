@@ -0,0 +1,297 @@
+#include "stdafx.h"
+#include "SAHBVHBuilder.h"
+
+// [Static variables initialization]
+
+const unsigned SAHBVHBuilder::NULL_CLUSTER_INDEX = 0xFFFFFFF;
+const unsigned SAHBVHBuilder::NUM_BINS = 32;
+const unsigned SAHBVHBuilder::MAX_SAH_DEPTH = 64;
+const unsigned SAHBVHBuilder::PARALLEL_BINNING_SIZE = 1 << 16;
+const unsigned SAHBVHBuilder::PARALLEL_SUBTREE_SIZE = 1 << 12;
+const float SAHBVHBuilder::INTERSECTION_COST = 1.0f;
+const float SAHBVHBuilder::TRAVERSAL_COST = 1.0f;
+
+/// [Public methods]
+
+SAHBVHBuilder::SAHBVHBuilder(const unsigned numThreads) :
+	_pool(numThreads), _cluster(nullptr), _numFaces(0)
+{
+}
+
+bool SAHBVHBuilder::build(const std::vector<FaceGPUData>& face, std::vector<BVHCluster>& cluster)
+{
+	cluster.clear();
+	if (face.empty()) return false;
+
+	_numFaces = unsigned(face.size());
+	_reference.resize(_numFaces);
+	cluster.resize(_numFaces * 2 - 1);
+	_cluster = cluster.data();
+
+	// Root bounds are reduced from the bounds of each chunk
+	const unsigned numChunks = this->getNumChunks(_numFaces), chunkSize = (_numFaces + numChunks - 1) / numChunks;
+	std::vector<Bounds> chunkAABB(numChunks), chunkCentroidAABB(numChunks);
+
+	{
+		ThreadPool::TaskGroup taskGroup(&_pool);
+
+		for (unsigned chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+		{
+			taskGroup.run([&, chunkIdx]()
+				{
+					for (unsigned faceIdx = chunkIdx * chunkSize; faceIdx < std::min(_numFaces, (chunkIdx + 1) * chunkSize); ++faceIdx)
+					{
+						FaceReference& reference = _reference[faceIdx];
+						reference._minPoint = face[faceIdx]._minPoint;
+						reference._maxPoint = face[faceIdx]._maxPoint;
+						reference._faceIndex = faceIdx;
+
+						const vec3 centroid = reference.getCentroid();
+						chunkAABB[chunkIdx].update(reference._minPoint, reference._maxPoint);
+						chunkCentroidAABB[chunkIdx].update(centroid, centroid);
+					}
+				});
+		}
+
+		taskGroup.wait();
+	}
+
+	Bounds aabb, centroidAABB;
+
+	for (unsigned chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+	{
+		aabb.update(chunkAABB[chunkIdx]);
+		centroidAABB.update(chunkCentroidAABB[chunkIdx]);
+	}
+
+	this->buildSubtree(0, _numFaces, _numFaces, aabb, centroidAABB, 0);
+
+	_cluster = nullptr;
+	std::vector<FaceReference>().swap(_reference);
+
+	return true;
+}
+
+float SAHBVHBuilder::computeSAHCost(const std::vector<BVHCluster>& cluster)
+{
+	if (cluster.empty()) return .0f;
+
+	Bounds rootAABB;
+	rootAABB.update(cluster.back()._minPoint, cluster.back()._maxPoint);
+
+	const float rootArea = rootAABB.getSurfaceArea();
+	if (rootArea <= glm::epsilon<float>()) return .0f;
+
+	double cost = .0;
+
+	for (const BVHCluster& node : cluster)
+	{
+		Bounds aabb;
+		aabb.update(node._minPoint, node._maxPoint);
+
+		cost += aabb.getSurfaceArea() * (node._prevIndex1 == NULL_CLUSTER_INDEX ? INTERSECTION_COST : TRAVERSAL_COST);
+	}
+
+	return float(cost / rootArea);
+}
+
+/// [Protected methods]
+
+void SAHBVHBuilder::binFaces(const unsigned begin, const unsigned end, const vec3& origin, const vec3& scale, const unsigned numBins, std::vector<Bin>& bin)
+{
+	for (unsigned refIdx = begin; refIdx < end; ++refIdx)
+	{
+		const FaceReference& reference = _reference[refIdx];
+		const vec3 centroid = reference.getCentroid();
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (scale[axis] <= .0f) continue;
+
+			Bin& faceBin = bin[axis * numBins + getBinIndex(centroid[axis], origin[axis], scale[axis], numBins)];
+			faceBin._aabb.update(reference._minPoint, reference._maxPoint);
+			faceBin._centroidAABB.update(centroid, centroid);
+			++faceBin._numFaces;
+		}
+	}
+}
+
+void SAHBVHBuilder::buildSubtree(const unsigned begin, const unsigned end, const unsigned firstNode, const Bounds& aabb, const Bounds& centroidAABB, const unsigned depth)
+{
+	BVHCluster& node = _cluster[getNodeIndex(begin, end, firstNode)];
+
+	if (end - begin == 1)
+	{
+		node._minPoint = _reference[begin]._minPoint;
+		node._maxPoint = _reference[begin]._maxPoint;
+		node._prevIndex1 = node._prevIndex2 = NULL_CLUSTER_INDEX;
+		node._faceIndex = _reference[begin]._faceIndex;
+
+		return;
+	}
+
+	unsigned middle;
+	Bounds childAABB[2], childCentroidAABB[2];
+
+	if (depth >= MAX_SAH_DEPTH || !this->splitBinned(begin, end, centroidAABB, middle, childAABB, childCentroidAABB))
+	{
+		this->splitMedian(begin, end, centroidAABB, middle, childAABB, childCentroidAABB);
+	}
+
+	node._minPoint = aabb._minPoint;
+	node._maxPoint = aabb._maxPoint;
+	const unsigned rightFirstNode = firstNode + middle - begin - 1;
+	node._prevIndex1 = getNodeIndex(begin, middle, firstNode);
+	node._prevIndex2 = getNodeIndex(middle, end, rightFirstNode);
+	node._faceIndex = NULL_CLUSTER_INDEX;
+
+	if (end - begin >= PARALLEL_SUBTREE_SIZE)
+	{
+		// Left child may be stolen by an idle worker while this thread goes on with the right one
+		ThreadPool::TaskGroup taskGroup(&_pool);
+		taskGroup.run([&]() { this->buildSubtree(begin, middle, firstNode, childAABB[0], childCentroidAABB[0], depth + 1); });
+		this->buildSubtree(middle, end, rightFirstNode, childAABB[1], childCentroidAABB[1], depth + 1);
+		taskGroup.wait();
+	}
+	else
+	{
+		this->buildSubtree(begin, middle, firstNode, childAABB[0], childCentroidAABB[0], depth + 1);
+		this->buildSubtree(middle, end, rightFirstNode, childAABB[1], childCentroidAABB[1], depth + 1);
+	}
+}
+
+unsigned SAHBVHBuilder::getBinIndex(const float coordinate, const float origin, const float scale, const unsigned numBins)
+{
+	return std::min(numBins - 1, unsigned(std::max(.0f, (coordinate - origin) * scale)));
+}
+
+unsigned SAHBVHBuilder::getNumChunks(const unsigned numFaces) const
+{
+	return std::max(1u, std::min(_pool.getNumThreads() * 4, numFaces / (PARALLEL_BINNING_SIZE / 16)));
+}
+
+bool SAHBVHBuilder::splitBinned(const unsigned begin, const unsigned end, const Bounds& centroidAABB, unsigned& middle, Bounds* childAABB, Bounds* childCentroidAABB)
+{
+	const vec3 extent = centroidAABB._maxPoint - centroidAABB._minPoint;
+	const unsigned numBins = std::min(NUM_BINS, end - begin);					// Small nodes need no more planes than faces
+	vec3 scale;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		scale[axis] = extent[axis] > glm::epsilon<float>() ? numBins / extent[axis] : .0f;
+	}
+
+	if (scale == vec3(.0f)) return false;
+
+	// Large nodes, i.e. the first levels, are binned in chunks so that every worker takes part before subtrees are spawned
+	std::vector<Bin> bin(3 * numBins);
+
+	if (end - begin >= PARALLEL_BINNING_SIZE)
+	{
+		const unsigned numChunks = this->getNumChunks(end - begin), chunkSize = (end - begin + numChunks - 1) / numChunks;
+		std::vector<std::vector<Bin>> chunkBin(numChunks, std::vector<Bin>(3 * numBins));
+
+		{
+			ThreadPool::TaskGroup taskGroup(&_pool);
+
+			for (unsigned chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+			{
+				const unsigned chunkBegin = begin + chunkIdx * chunkSize, chunkEnd = std::min(end, chunkBegin + chunkSize);
+				taskGroup.run([&, chunkIdx, chunkBegin, chunkEnd]() { this->binFaces(chunkBegin, chunkEnd, centroidAABB._minPoint, scale, numBins, chunkBin[chunkIdx]); });
+			}
+
+			taskGroup.wait();
+		}
+
+		for (unsigned chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+		{
+			for (unsigned binIdx = 0; binIdx < bin.size(); ++binIdx)
+			{
+				bin[binIdx]._aabb.update(chunkBin[chunkIdx][binIdx]._aabb);
+				bin[binIdx]._centroidAABB.update(chunkBin[chunkIdx][binIdx]._centroidAABB);
+				bin[binIdx]._numFaces += chunkBin[chunkIdx][binIdx]._numFaces;
+			}
+		}
+	}
+	else
+	{
+		this->binFaces(begin, end, centroidAABB._minPoint, scale, numBins, bin);
+	}
+
+	// Sweep from the right to accumulate the cost of each right side, and then from the left to find the cheapest plane
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	unsigned bestSplit = 0;
+	std::vector<float> rightCost(numBins);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (scale[axis] <= .0f) continue;
+
+		const Bin* axisBin = bin.data() + axis * numBins;
+		Bounds leftAABB, rightAABB;
+		unsigned numLeftFaces = 0, numRightFaces = 0;
+
+		for (unsigned split = numBins - 1; split > 0; --split)
+		{
+			rightAABB.update(axisBin[split]._aabb);
+			numRightFaces += axisBin[split]._numFaces;
+			rightCost[split] = numRightFaces ? rightAABB.getSurfaceArea() * numRightFaces : -1.0f;
+		}
+
+		for (unsigned split = 1; split < numBins; ++split)
+		{
+			leftAABB.update(axisBin[split - 1]._aabb);
+			numLeftFaces += axisBin[split - 1]._numFaces;
+
+			if (!numLeftFaces || rightCost[split] < .0f) continue;
+
+			const float cost = leftAABB.getSurfaceArea() * numLeftFaces + rightCost[split];
+
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	if (bestAxis < 0) return false;
+
+	for (unsigned binIdx = 0; binIdx < numBins; ++binIdx)
+	{
+		const Bin& axisBin = bin[bestAxis * numBins + binIdx];
+		childAABB[binIdx >= bestSplit].update(axisBin._aabb);
+		childCentroidAABB[binIdx >= bestSplit].update(axisBin._centroidAABB);
+	}
+
+	const float origin = centroidAABB._minPoint[bestAxis], axisScale = scale[bestAxis];
+	middle = unsigned(std::partition(_reference.begin() + begin, _reference.begin() + end, [&](const FaceReference& reference) 
+		{ 
+			return getBinIndex(reference.getCentroid()[bestAxis], origin, axisScale, numBins) < bestSplit;
+		}) - _reference.begin());
+
+	return true;
+}
+
+void SAHBVHBuilder::splitMedian(const unsigned begin, const unsigned end, const Bounds& centroidAABB, unsigned& middle, Bounds* childAABB, Bounds* childCentroidAABB)
+{
+	const vec3 extent = centroidAABB._maxPoint - centroidAABB._minPoint;
+	const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+	middle = begin + (end - begin) / 2;
+	std::nth_element(_reference.begin() + begin, _reference.begin() + middle, _reference.begin() + end, [axis](const FaceReference& reference1, const FaceReference& reference2)
+		{
+			return reference1._minPoint[axis] + reference1._maxPoint[axis] < reference2._minPoint[axis] + reference2._maxPoint[axis];
+		});
+
+	for (unsigned refIdx = begin; refIdx < end; ++refIdx)
+	{
+		const FaceReference& reference = _reference[refIdx];
+		const vec3 centroid = reference.getCentroid();
+
+		childAABB[refIdx >= middle].update(reference._minPoint, reference._maxPoint);
+		childCentroidAABB[refIdx >= middle].update(centroid, centroid);
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+#include "Utilities/ThreadPool.h"
+
+/**
+*	@file SAHBVHBuilder.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief CPU alternative to the GPU cluster merging, which needs no OpenGL context. Nodes are split top-down with a binned 
+*	surface area heuristic, and subtrees are built as tasks of a work-stealing pool. The output has the same layout as the GPU 
+*	builder: a leaf per face in the first positions, followed by inner nodes which are always stored after their children.
+*/
+class SAHBVHBuilder
+{
+public:
+	typedef Model3D::BVHCluster BVHCluster;
+	typedef Model3D::FaceGPUData FaceGPUData;
+
+	const static unsigned	NULL_CLUSTER_INDEX;				//!< Child index of leaves, as in the BVH generation shaders
+
+protected:
+	struct Bounds
+	{
+		vec3		_minPoint;
+		vec3		_maxPoint;
+
+		Bounds() : _minPoint(FLT_MAX), _maxPoint(-FLT_MAX) {}
+
+		float getSurfaceArea() const
+		{
+			const vec3 size = glm::max(_maxPoint - _minPoint, vec3(.0f));
+
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		void update(const vec3& minPoint, const vec3& maxPoint)
+		{
+			_minPoint = glm::min(_minPoint, minPoint);
+			_maxPoint = glm::max(_maxPoint, maxPoint);
+		}
+
+		void update(const Bounds& bounds) { this->update(bounds._minPoint, bounds._maxPoint); }
+	};
+
+	struct Bin
+	{
+		Bounds		_aabb;									//!< Bounds of the faces
+		Bounds		_centroidAABB;							//!< Bounds of the face centroids
+		unsigned	_numFaces;
+
+		Bin() : _numFaces(0) {}
+	};
+
+	struct FaceReference
+	{
+		vec3		_minPoint;								//!< Copy of the face AABB, so that faces are not randomly accessed while partitioned
+		unsigned	_faceIndex;								//!< Index in the face array
+		vec3		_maxPoint;
+
+		vec3 getCentroid() const { return (_minPoint + _maxPoint) / 2.0f; }
+	};
+
+protected:
+	const static unsigned	NUM_BINS;						//!< Candidate split planes per axis, plus one, for nodes with enough faces
+	const static unsigned	MAX_SAH_DEPTH;					//!< Deeper nodes are split by the median, so that the recursion is bounded
+	const static unsigned	PARALLEL_BINNING_SIZE;			//!< Minimum number of faces of a node to bin them in parallel
+	const static unsigned	PARALLEL_SUBTREE_SIZE;			//!< Minimum number of faces of a node to build its children as separate tasks
+	const static float		INTERSECTION_COST;				//!< Cost of testing a face, relative to TRAVERSAL_COST
+	const static float		TRAVERSAL_COST;					//!< Cost of visiting an inner node
+
+protected:
+	ThreadPool					_pool;						//!< Workers which build subtrees and bin large nodes
+
+	// [Build state]
+	BVHCluster*					_cluster;					//!< Output nodes
+	unsigned					_numFaces;					//!< Number of input faces
+	std::vector<FaceReference>	_reference;					//!< Faces partitioned during the build; position i ends up as leaf i
+
+protected:
+	/**
+	*	@brief Accumulates the faces within a range into bins along every axis.
+	*	@param scale Number of bins per unit of each axis, zero for axes where centroids cannot be split.
+	*/
+	void binFaces(const unsigned begin, const unsigned end, const vec3& origin, const vec3& scale, const unsigned numBins, std::vector<Bin>& bin);
+
+	/**
+	*	@brief Builds the subtree for a range of face references, whose root is written at getNodeIndex(begin, end, firstNode).
+	*	@param firstNode First index of the inner nodes of this subtree.
+	*/
+	void buildSubtree(const unsigned begin, const unsigned end, const unsigned firstNode, const Bounds& aabb, const Bounds& centroidAABB, const unsigned depth);
+
+	/**
+	*	@return Bin of a centroid coordinate along an axis.
+	*/
+	static unsigned getBinIndex(const float coordinate, const float origin, const float scale, const unsigned numBins);
+
+	/**
+	*	@return Number of ranges where the faces are split for parallel work.
+	*/
+	unsigned getNumChunks(const unsigned numFaces) const;
+
+	/**
+	*	@return Index of the node which wraps a range of face references. Each subtree owns as many consecutive inner nodes as faces 
+	*	minus one and its root is the last of them, so that subtrees are built concurrently while the root of the tree remains the last node.
+	*/
+	static unsigned getNodeIndex(const unsigned begin, const unsigned end, const unsigned firstNode) { return end - begin == 1 ? begin : firstNode + end - begin - 2; }
+
+	/**
+	*	@brief Splits a range of face references at the plane of minimum SAH cost.
+	*	@return False if centroids cannot be told apart by the bins, so that no split was made.
+	*/
+	bool splitBinned(const unsigned begin, const unsigned end, const Bounds& centroidAABB, unsigned& middle, Bounds* childAABB, Bounds* childCentroidAABB);
+
+	/**
+	*	@brief Splits a range of face references in halves along the largest axis of their centroids.
+	*/
+	void splitMedian(const unsigned begin, const unsigned end, const Bounds& centroidAABB, unsigned& middle, Bounds* childAABB, Bounds* childCentroidAABB);
+
+public:
+	/**
+	*	@brief Constructor.
+	*	@param numThreads Number of workers, as many as hardware threads if zero.
+	*/
+	SAHBVHBuilder(const unsigned numThreads = 0);
+
+	/**
+	*	@brief Builds a BVH with a leaf per face.
+	*	@param cluster Nodes of the tree, with the root as the last one.
+	*	@return False if there are no faces.
+	*/
+	bool build(const std::vector<FaceGPUData>& face, std::vector<BVHCluster>& cluster);
+
+	/**
+	*	@return SAH cost of a tree, i.e. expected cost of a random ray which hits the root, so that trees from any builder can be compared.
+	*/
+	static float computeSAHCost(const std::vector<BVHCluster>& cluster);
+};
+
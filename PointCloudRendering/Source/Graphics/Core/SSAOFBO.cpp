@@ -5,98 +5,61 @@
 #include "Interface/Window.h"
 #include "Utilities/FileManagement.h"
 
+// [Static members initialization]
+
+const SSAOFBO::SSAOPreset SSAOFBO::SSAO_PRESET[] = { { 4, 16 }, { 2, 32 }, { 1, 64 } };
+
+std::vector<float> SSAOFBO::_ssaoTime (CGAppEnum::numSSAOQualities(), .0f);
+
 /// Public methods
 
-SSAOFBO::SSAOFBO() : FBO(DEFAULT_SIZE, DEFAULT_SIZE)			// Size is updated every frame
+SSAOFBO::SSAOFBO() : FBO(DEFAULT_SIZE, DEFAULT_SIZE), _activeTimerQuery(0), _timerRunning(false)			// Size is updated every frame
 {
 	_rendParams = Renderer::getInstance()->getRenderingParameters();
 	_size = Window::getInstance()->getSize();
+	_ssaoDivisor = this->getSSAOPreset()._resolutionDivisor;
 
-	// Multisampled FBO ----------------------
-	glGenFramebuffers(1, &_multisampledFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, _multisampledFBO);
-
-	glGenRenderbuffers(1, &_mColorBuffer);
-	glBindRenderbuffer(GL_RENDERBUFFER, _mColorBuffer);
-	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 0, GL_RGBA8, _size.x, _size.y);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenQueries(NUM_TIMER_QUERIES, _timerQuery);
+	std::fill(_timerQueryQuality, _timerQueryQuality + NUM_TIMER_QUERIES, -1);
 
-	glGenRenderbuffers(1, &_mDepthBuffer);
-	glBindRenderbuffer(GL_RENDERBUFFER, _mDepthBuffer);
-	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 0, GL_DEPTH_COMPONENT, _size.x, _size.y);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _mColorBuffer);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _mDepthBuffer);
-
-	_success &= this->checkFBOstate();
+	// G-buffer ------------------- Albedo, position and normal as render targets of the same pass
+	glGenFramebuffers(1, &_gBufferFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, _gBufferFBO);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glGenTextures(3, _colorBuffer);
 
-	// G-buffer ------------------- [0]
-	glGenFramebuffers(1, &_gBufferFBO[0]);
-	glBindFramebuffer(GL_FRAMEBUFFER, _gBufferFBO[0]);
+	for (unsigned colorBuffer = 0; colorBuffer < 3; ++colorBuffer)
+	{
+		glBindTexture(GL_TEXTURE_2D, _colorBuffer[colorBuffer]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _size.x, _size.y, 0, GL_RGBA, GL_FLOAT, nullptr);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + colorBuffer, GL_TEXTURE_2D, _colorBuffer[colorBuffer], 0);
+	}
 
-	glGenTextures(1, &_colorBuffer[0]);
-	glBindTexture(GL_TEXTURE_2D, _colorBuffer[0]);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _size.x, _size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorBuffer[0], 0);
-
-	// G-buffer ------------------- [1]
-	glGenFramebuffers(1, &_gBufferFBO[1]);
-	glBindFramebuffer(GL_FRAMEBUFFER, _gBufferFBO[1]);
-
-	glGenTextures(1, &_colorBuffer[1]);
-	glBindTexture(GL_TEXTURE_2D, _colorBuffer[1]);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _size.x, _size.y, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorBuffer[1], 0);
+	const GLenum attachmentsGBuffer[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+	glDrawBuffers(3, attachmentsGBuffer);
 
 	// Depth buffer
-	glGenRenderbuffers(1, &_depthTexture[0]);
-	glBindRenderbuffer(GL_RENDERBUFFER, _depthTexture[0]);
+	glGenRenderbuffers(1, &_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _size.x, _size.y);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthTexture[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
 	_success &= this->checkFBOstate();
 
-	// G-buffer ------------------- [2]
-	glGenFramebuffers(1, &_gBufferFBO[2]);
-	glBindFramebuffer(GL_FRAMEBUFFER, _gBufferFBO[2]);
-
-	glGenTextures(1, &_colorBuffer[2]);
-	glBindTexture(GL_TEXTURE_2D, _colorBuffer[2]);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _size.x, _size.y, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorBuffer[2], 0);
-
-	// Depth buffer
-	glGenRenderbuffers(1, &_depthTexture[1]);
-	glBindRenderbuffer(GL_RENDERBUFFER, _depthTexture[1]);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _size.x, _size.y);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthTexture[1]);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	
-	_success &= this->checkFBOstate();
-
 	// SSAO framebuffer ------------------------
 	glGenFramebuffers(1, &_ssaoFramebufferID);
 	glBindFramebuffer(GL_FRAMEBUFFER, _ssaoFramebufferID);
 
+	const ivec2 ssaoSize = this->getSSAOSize();
+
 	glGenTextures(1, &_ssaoColorBuffer);
 	glBindTexture(GL_TEXTURE_2D, _ssaoColorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _size.x, _size.y, 0, GL_RGBA, GL_FLOAT, nullptr);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, ssaoSize.x, ssaoSize.y, 0, GL_RGBA, GL_FLOAT, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _ssaoColorBuffer, 0);
@@ -104,7 +67,7 @@ SSAOFBO::SSAOFBO() : FBO(DEFAULT_SIZE, DEFAULT_SIZE)			// Size is updated every
 	unsigned int attachmentsSSAO = GL_COLOR_ATTACHMENT0;
 	glDrawBuffers(1, &attachmentsSSAO);
 
-	_success = this->checkFBOstate();
+	_success &= this->checkFBOstate();
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
@@ -112,7 +75,11 @@ SSAOFBO::SSAOFBO() : FBO(DEFAULT_SIZE, DEFAULT_SIZE)			// Size is updated every
 SSAOFBO::~SSAOFBO()
 {
 	glDeleteTextures(3, _colorBuffer);
-	//glDeleteRenderbuffers(1, &_depthTexture);
+	glDeleteTextures(1, &_ssaoColorBuffer);
+	glDeleteRenderbuffers(1, &_depthBuffer);
+	glDeleteFramebuffers(1, &_gBufferFBO);
+	glDeleteFramebuffers(1, &_ssaoFramebufferID);
+	glDeleteQueries(NUM_TIMER_QUERIES, _timerQuery);
 }
 
 bool SSAOFBO::bindFBO()
@@ -125,45 +92,77 @@ bool SSAOFBO::bindFBO()
 	return true;
 }
 
-bool SSAOFBO::bindGBufferFBO(const unsigned index)
+bool SSAOFBO::bindGBufferFBO()
 {
 	if (!_success)
 	{
 		return false;
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, _gBufferFBO[index]);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	const vec4 albedoBackground = vec4(_rendParams->_backgroundColor, 1.0f), geometryBackground = vec4(BLACK_BACKGROUND, .0f);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, _gBufferFBO);
+	glClearBufferfv(GL_COLOR, 0, &albedoBackground[0]);
+	glClearBufferfv(GL_COLOR, 1, &geometryBackground[0]);
+	glClearBufferfv(GL_COLOR, 2, &geometryBackground[0]);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// Lights are accumulated through blending, which must not alter positions and normals
+	glDisablei(GL_BLEND, 1);
+	glDisablei(GL_BLEND, 2);
+	this->writeGeometryAttachments(true);
 
 	return true;
 }
 
-bool SSAOFBO::bindMultisamplingFBO()
+bool SSAOFBO::bindSSAOFBO()
 {
 	if (!_success)
 	{
 		return false;
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, _multisampledFBO);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	const unsigned divisor = this->getSSAOPreset()._resolutionDivisor;
 
-	return true;
-}
-
-bool SSAOFBO::bindSSAOFBO()
-{
-	if (!_success)
+	if (divisor != _ssaoDivisor)
 	{
-		return false;
+		_ssaoDivisor = divisor;
+		const ivec2 ssaoSize = this->getSSAOSize();
+
+		glBindTexture(GL_TEXTURE_2D, _ssaoColorBuffer);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, ssaoSize.x, ssaoSize.y, 0, GL_RGBA, GL_FLOAT, nullptr);
 	}
 
+	const ivec2 ssaoSize = this->getSSAOSize();
+
 	glBindFramebuffer(GL_FRAMEBUFFER, _ssaoFramebufferID);
+	glViewport(0, 0, ssaoSize.x, ssaoSize.y);
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	return true;
 }
 
+void SSAOFBO::beginSSAOTimer()
+{
+	this->readTimerQueries();
+
+	// Waiting for the result would stall the CPU until the GPU catches up, so the frame is skipped instead
+	_timerRunning = _timerQueryQuality[_activeTimerQuery] < 0;
+	if (!_timerRunning) return;
+
+	glBeginQuery(GL_TIME_ELAPSED, _timerQuery[_activeTimerQuery]);
+	_timerQueryQuality[_activeTimerQuery] = _rendParams->_ssaoQuality;
+}
+
+void SSAOFBO::endSSAOTimer()
+{
+	if (!_timerRunning) return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	_activeTimerQuery = (_activeTimerQuery + 1) % NUM_TIMER_QUERIES;
+	_timerRunning = false;
+}
+
 void SSAOFBO::bindGBufferTextures(RenderingShader* shader)
 {
 	shader->setUniform("texPosition", 0);
@@ -184,73 +183,77 @@ void SSAOFBO::bindSSAOTexture(RenderingShader* shader)
 	shader->setUniform("texSSAO", 1);
 	glActiveTexture(GL_TEXTURE1);
 	glBindTexture(GL_TEXTURE_2D, _ssaoColorBuffer);
+
+	if (this->isSSAOUpsampled())
+	{
+		shader->setUniform("texPosition", 2);
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, _colorBuffer[1]);
+
+		shader->setUniform("texNormal", 3);
+		glActiveTexture(GL_TEXTURE3);
+		glBindTexture(GL_TEXTURE_2D, _colorBuffer[2]);
+	}
+}
+
+SSAOFBO::SSAOPreset SSAOFBO::getSSAOPreset() const
+{
+	return SSAO_PRESET[glm::clamp(_rendParams->_ssaoQuality, 0, CGAppEnum::numSSAOQualities() - 1)];
 }
 
 void SSAOFBO::modifySize(const uint16_t width, const uint16_t height)
 {
 	FBO::modifySize(width, height);
 
-	// Multisampling buffer
-	glBindFramebuffer(GL_FRAMEBUFFER, _multisampledFBO);
-
-	glBindRenderbuffer(GL_RENDERBUFFER, _mColorBuffer);
-	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 0, GL_RGBA8, _size.x, _size.y);
-
-	glBindRenderbuffer(GL_RENDERBUFFER, _mDepthBuffer);
-	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 0, GL_DEPTH_COMPONENT, _size.x, _size.y);
-
 	// GBuffer
-	glBindFramebuffer(GL_FRAMEBUFFER, _id);
-
 	for (unsigned colorBuffer = 0; colorBuffer < 3; colorBuffer++)
 	{
 		glBindTexture(GL_TEXTURE_2D, _colorBuffer[colorBuffer]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, _size.x, _size.y, 0, GL_RGBA, colorBuffer ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr);			// Size is already updated
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _size.x, _size.y, 0, GL_RGBA, GL_FLOAT, nullptr);			// Size is already updated
 	}
 
-	for (unsigned depthBuffer = 0; depthBuffer < 2; depthBuffer++)
-	{
-		glBindRenderbuffer(GL_RENDERBUFFER, _depthTexture[depthBuffer]);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _size.x, _size.y);
-	}
+	glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _size.x, _size.y);
 
 	// SSAO buffer
+	const ivec2 ssaoSize = this->getSSAOSize();
 	glBindFramebuffer(GL_FRAMEBUFFER, _ssaoFramebufferID);
 
 	glBindTexture(GL_TEXTURE_2D, _ssaoColorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _size.x, _size.y, 0, GL_RGBA, GL_FLOAT, nullptr);		// Size is already updated
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, ssaoSize.x, ssaoSize.y, 0, GL_RGBA, GL_FLOAT, nullptr);		// Size is already updated
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
 }
 
-void SSAOFBO::writeGBuffer(const unsigned index)
+void SSAOFBO::writeGeometryAttachments(const bool write)
 {
-	if (!_success)
-	{
-		return;
-	}
+	glColorMaski(1, write, write, write, write);
+	glColorMaski(2, write, write, write, write);
+}
 
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, _multisampledFBO);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _gBufferFBO[index]);
-	glBlitFramebuffer(0, 0, _size.x, _size.y, 0, 0, _size.x, _size.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
-	//glBindFramebuffer(GL_FRAMEBUFFER, _gBufferFBO[index]);
+/// Protected methods
 
-	//std::vector<GLubyte>* pixels = new std::vector<GLubyte>((int)_size.x * (int)_size.y * 4);
-	//glReadPixels(0, 0, _size.x, _size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+void SSAOFBO::readTimerQueries()
+{
+	for (unsigned query = 0; query < NUM_TIMER_QUERIES; ++query)
+	{
+		if (_timerQueryQuality[query] < 0) continue;
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(_timerQuery[query], GL_QUERY_RESULT_AVAILABLE, &available);
 
-	//// Correct image orientation
-	//Image::flipImageVertically(*pixels, _size.x, _size.y, 4);
+		if (available)
+		{
+			GLuint64 elapsedTime = 0;
+			glGetQueryObjectui64v(_timerQuery[query], GL_QUERY_RESULT, &elapsedTime);
 
-	//// Launch image writing in a thread
-	//std::thread writeImageThread(&SSAOFBO::threadedWriteImage, this, pixels, "Prueba.png", _size.x, _size.y);
-	//writeImageThread.detach();
+			_ssaoTime[_timerQueryQuality[query]] = elapsedTime / 1e6f;
+			_timerQueryQuality[query] = -1;
+		}
+	}
 }
 
-/// Protected methods
-
 void SSAOFBO::threadedWriteImage(std::vector<GLubyte>* pixels, const std::string& filename, const uint16_t width, const uint16_t height)
 {
 	FileManagement::saveImage(filename, pixels, width, height);
@@ -10,29 +10,50 @@
 */
 
 /**
-*	@brief FBO which wraps the G-buffer textures for ambient occlusion.
+*	@brief FBO which wraps the G-buffer textures for ambient occlusion. Albedo, view-space position and normal are written by a single
+*	geometry pass into multiple render targets.
 */
 class SSAOFBO: public FBO
 {
+public:
+	struct SSAOPreset
+	{
+		unsigned	_resolutionDivisor;					//!< Occlusion is computed at the window size divided by this factor
+		int			_kernelSize;						//!< Number of samples of each pixel, up to the 64 kernels of Model3D
+	};
+
 protected:
 	const vec3 BLACK_BACKGROUND = vec3(.0f);			//!< Clear color for normal and position textures
 	const unsigned DEFAULT_SIZE = 2048;					//!< Default width / height
+	const static unsigned NUM_TIMER_QUERIES = 3;		//!< Frames whose timer queries can be in flight at once
+
+	const static SSAOPreset	SSAO_PRESET[];				//!< Preset of each CGAppEnum::SSAOQuality
+
+	static std::vector<float>	_ssaoTime;				//!< Last GPU time (ms) of occlusion and composition with each preset, so that they can be compared
 
 protected:
-	GLuint					_gBufferFBO[3];				//!< 
+	GLuint					_gBufferFBO;				//!< Framebuffer of the geometry pass, with a color attachment per G-buffer texture
 	GLuint					_colorBuffer[3];			//!< Albedo, position and normal
-	GLuint					_depthTexture[3];			//!< Identifier on GPU of depth texture for main FBO
-
-	GLuint					_multisampledFBO;			//!<
-	GLuint					_mColorBuffer;			//!<
-	GLuint					_mDepthBuffer;				//!< Multisampling buffers
+	GLuint					_depthBuffer;				//!< Depth renderbuffer of the geometry pass
 
 	GLuint					_ssaoFramebufferID;			//!< 
-	GLuint					_ssaoColorBuffer;			//!< 
+	GLuint					_ssaoColorBuffer;			//!< Occlusion factor, whose size depends on the active preset
+	unsigned				_ssaoDivisor;				//!< Resolution divisor of the occlusion texture
+
+	// [Timing]
+	GLuint					_timerQuery[NUM_TIMER_QUERIES];			//!< Queries are used as a ring, so that results are read some frames later without stalling
+	int						_timerQueryQuality[NUM_TIMER_QUERIES];	//!< Preset measured by each query, -1 if it has not been issued or its result was read
+	unsigned				_activeTimerQuery;			//!< Query which measures the current frame
+	bool					_timerRunning;				//!< The current frame is being measured, as its query was free
 
 	RenderingParameters*	_rendParams;
 
 protected:
+	/**
+	*	@brief Reads the finished timer queries, polling their availability so that the pipeline is never flushed.
+	*/
+	void readTimerQueries();
+
 	/**
 	*	@brief Writes an image in file system in an isolated thread, so the application doesn't get stuck.
 	*	@param pixels Pixels of image to be written.
@@ -59,19 +80,24 @@ public:
 	virtual bool bindFBO();
 
 	/**
-	*	@brief 
+	*	@brief Binds and clears the G-buffer, so that the geometry pass writes albedo, position and normal at once.
 	*/
-	bool bindGBufferFBO(const unsigned index);
+	bool bindGBufferFBO();
 
 	/**
-	*	@brief 
+	*	@brief Binds the occlusion framebuffer, resizing it first if the preset changed, and sets the viewport to its size.
+	*/
+	bool bindSSAOFBO();
+
+	/**
+	*	@brief Starts measuring the GPU time of occlusion and composition. The frame is not measured if the next query is still in flight.
 	*/
-	bool bindMultisamplingFBO();
+	void beginSSAOTimer();
 
 	/**
-	*	@brief
+	*	@brief Stops measuring the GPU time of occlusion and composition.
 	*/
-	bool bindSSAOFBO();
+	void endSSAOTimer();
 
 	/**
 	*	@brief 
@@ -79,10 +105,36 @@ public:
 	void bindGBufferTextures(RenderingShader* shader);
 
 	/**
-	*	@brief
+	*	@brief Binds albedo and occlusion textures. Positions and normals are also bound if occlusion has a lower resolution,
+	*	as they guide the bilateral upsampling.
 	*/
 	void bindSSAOTexture(RenderingShader* shader);
 
+	/**
+	*	@return Preset of the active quality.
+	*/
+	SSAOPreset getSSAOPreset() const;
+
+	/**
+	*	@return G-buffer texture with view-space positions.
+	*/
+	GLuint getPositionTexture() const { return _colorBuffer[1]; }
+
+	/**
+	*	@return Size of the occlusion texture for the current window size and divisor.
+	*/
+	ivec2 getSSAOSize() const { return glm::max(_size / int(_ssaoDivisor), ivec2(1)); }
+
+	/**
+	*	@return Last GPU time (ms) of occlusion and composition with the given quality, or zero if it has not been measured.
+	*/
+	static float getSSAOTime(const int quality) { return _ssaoTime[quality]; }
+
+	/**
+	*	@return True if occlusion is computed at a lower resolution than the window and must be upsampled.
+	*/
+	bool isSSAOUpsampled() const { return _ssaoDivisor > 1; }
+
 	/**
 	*	@brief Modifies the size of color textures.
 	*	@param width New width.
@@ -91,8 +143,8 @@ public:
 	virtual void modifySize(const uint16_t width, const uint16_t height);
 
 	/**
-	*	@brief 
+	*	@brief Enables or disables the writing of position and normal, e.g. for points and lines drawn along with the triangle mesh.
 	*/
-	void writeGBuffer(const unsigned index);
+	void writeGeometryAttachments(const bool write);
 };
 
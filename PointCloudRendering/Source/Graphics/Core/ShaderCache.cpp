@@ -0,0 +1,196 @@
+#include "stdafx.h"
+#include "ShaderCache.h"
+
+#include <filesystem>
+#include <iomanip>
+
+// [Static members initialization]
+
+const char ShaderCache::CACHE_MAGIC[8] = { 'P', 'C', 'R', 'P', 'R', 'O', 'G', '\0' };
+const uint32_t ShaderCache::CACHE_VERSION = 1;
+const std::string ShaderCache::CACHE_FOLDER = "Assets/Shaders/Cache/";
+const std::string ShaderCache::CACHE_EXTENSION = ".bin";
+
+/// [Public methods]
+
+ShaderCache::~ShaderCache()
+{
+}
+
+void ShaderCache::clear()
+{
+	std::error_code error;
+
+	for (const auto& entry : std::filesystem::directory_iterator(CACHE_FOLDER, error))
+	{
+		if (entry.path().extension() == CACHE_EXTENSION) std::filesystem::remove(entry.path(), error);
+	}
+}
+
+uint64_t ShaderCache::computeKey(const std::vector<std::string>& sources)
+{
+	if (_driverSignature.empty()) this->initialize();
+
+	// FNV-1a, where each stage is followed by a separator so that moving code between stages changes the key
+	uint64_t hash = 14695981039346656037ull;
+	auto hashString = [&hash](const std::string& string)
+	{
+		for (const char character : string) hash = (hash ^ uint8_t(character)) * 1099511628211ull;
+		hash = (hash ^ 0xFF) * 1099511628211ull;
+	};
+
+	hashString(_driverSignature);
+	for (const std::string& source : sources) hashString(source);
+
+	return hash;
+}
+
+bool ShaderCache::load(const GLuint program, const uint64_t key)
+{
+	if (_driverSignature.empty()) this->initialize();
+	if (!_enabled || !_supported) return false;
+
+	const std::string path = this->getPath(key);
+	std::ifstream fin(path, std::ios::in | std::ios::binary);
+
+	if (!fin.is_open())
+	{
+		++_statistics._numMisses;
+		return false;
+	}
+
+	fin.seekg(0, std::ios::end);
+	const std::streamoff fileSize = fin.tellg();
+	fin.seekg(0, std::ios::beg);
+
+	Header header;
+	std::vector<char> binary;
+	bool valid = fileSize >= std::streamoff(sizeof(Header)) && bool(fin.read((char*)&header, sizeof(Header)));
+
+	// The binary must fill the rest of the file exactly; otherwise, the size is not trusted for the allocation and the file is rebuilt
+	if (!valid || header._size != uint64_t(fileSize - sizeof(Header)))
+	{
+		std::error_code error;
+
+		fin.close();
+		std::filesystem::remove(path, error);
+		++_statistics._numMisses;
+
+		return false;
+	}
+
+	valid = std::equal(header._magic, header._magic + sizeof(CACHE_MAGIC), CACHE_MAGIC) && header._version == CACHE_VERSION && header._key == key;
+
+	if (valid)
+	{
+		binary.resize(header._size);
+		valid = bool(fin.read(binary.data(), binary.size()));
+	}
+
+	fin.close();
+
+	if (valid)
+	{
+		GLint linkSuccess = GL_FALSE;
+
+		glProgramBinary(program, header._format, binary.data(), GLsizei(binary.size()));
+		glGetProgramiv(program, GL_LINK_STATUS, &linkSuccess);
+
+		valid = linkSuccess == GL_TRUE;
+	}
+
+	if (!valid)
+	{
+		std::error_code error;
+
+		std::filesystem::remove(path, error);
+		++_statistics._numRejected;
+
+		return false;
+	}
+
+	++_statistics._numHits;
+
+	return true;
+}
+
+void ShaderCache::remove(const uint64_t key)
+{
+	std::error_code error;
+	std::filesystem::remove(this->getPath(key), error);
+}
+
+void ShaderCache::store(const GLuint program, const uint64_t key)
+{
+	if (_driverSignature.empty()) this->initialize();
+	if (!_enabled || !_supported) return;
+
+	GLint binaryLength = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+
+	if (binaryLength <= 0) return;
+
+	Header header;
+	std::vector<char> binary(binaryLength);
+	GLenum format = 0;
+
+	glGetProgramBinary(program, binaryLength, nullptr, &format, binary.data());
+
+	std::copy(CACHE_MAGIC, CACHE_MAGIC + sizeof(CACHE_MAGIC), header._magic);
+	header._version = CACHE_VERSION;
+	header._format = format;
+	header._key = key;
+	header._size = binary.size();
+
+	std::error_code error;
+	std::filesystem::create_directories(CACHE_FOLDER, error);
+
+	// Written under a temporary name, so that an interrupted write never leaves a truncated binary behind
+	const std::string path = this->getPath(key), temporaryPath = path + ".tmp";
+	std::ofstream fout(temporaryPath, std::ios::out | std::ios::binary);
+
+	if (!fout.is_open())
+	{
+		std::cerr << "Failed to open " << temporaryPath << "." << std::endl;
+		return;
+	}
+
+	fout.write((char*)&header, sizeof(Header));
+	fout.write(binary.data(), binary.size());
+
+	const bool success = bool(fout);
+	fout.close();
+
+	if (success) std::filesystem::rename(temporaryPath, path, error);
+	if (!success || error) std::filesystem::remove(temporaryPath, error);
+	else ++_statistics._numStored;
+}
+
+/// [Protected methods]
+
+ShaderCache::ShaderCache() : _enabled(true), _supported(false), _statistics{ 0, 0, 0, 0 }
+{
+}
+
+std::string ShaderCache::getPath(const uint64_t key) const
+{
+	std::stringstream path;
+	path << CACHE_FOLDER << std::hex << std::setw(16) << std::setfill('0') << key << CACHE_EXTENSION;
+
+	return path.str();
+}
+
+void ShaderCache::initialize()
+{
+	auto glString = [](const GLenum name) -> std::string
+	{
+		const GLubyte* string = glGetString(name);
+		return string ? std::string((const char*)string) : std::string();
+	};
+
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+
+	_driverSignature = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+	_supported = numFormats > 0;
+}
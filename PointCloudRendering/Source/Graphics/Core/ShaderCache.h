@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Utilities/Singleton.h"
+
+/**
+*	@file ShaderCache.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief On-disk cache of linked shader programs, retrieved through glGetProgramBinary. Each program is stored in its own file, named after
+*	a hash of its preprocessed sources together with the vendor, renderer and version of the driver, so that any change of code or driver
+*	leads to a different key. Binaries are validated when they are loaded; those rejected by the driver are removed, and the program is
+*	then compiled from source as usual.
+*/
+class ShaderCache: public Singleton<ShaderCache>
+{
+	friend class Singleton<ShaderCache>;
+
+public:
+	struct Statistics
+	{
+		unsigned	_numHits;						//!< Programs loaded from the cache
+		unsigned	_numMisses;						//!< Programs which were not cached yet
+		unsigned	_numRejected;					//!< Cached binaries discarded since they were corrupted or rejected by the driver
+		unsigned	_numStored;						//!< Programs written into the cache
+	};
+
+protected:
+	struct Header
+	{
+		char		_magic[8];						//!< CACHE_MAGIC
+		uint32_t	_version;						//!< CACHE_VERSION
+		uint32_t	_format;						//!< Binary format given by the driver
+		uint64_t	_key;							//!< Key of the program, as an additional check against hash collisions of filenames
+		uint64_t	_size;							//!< Size of the binary which follows the header (bytes)
+	};
+
+	const static char			CACHE_MAGIC[8];				//!< Identifier of cached programs
+	const static uint32_t		CACHE_VERSION;				//!< Current version of the file layout
+	const static std::string	CACHE_FOLDER;				//!< Folder where binaries are stored
+	const static std::string	CACHE_EXTENSION;			//!< Extension of cached binaries
+
+protected:
+	std::string		_driverSignature;				//!< Vendor, renderer and version of the driver, queried once
+	bool			_enabled;						//!< Programs are neither read nor written if disabled
+	bool			_supported;						//!< False if the driver does not provide any binary format
+	Statistics		_statistics;					//!< Usage of the cache
+
+protected:
+	/**
+	*	@brief Default constructor.
+	*/
+	ShaderCache();
+
+	/**
+	*	@return Path of the binary of a program.
+	*/
+	std::string getPath(const uint64_t key) const;
+
+	/**
+	*	@brief Queries the driver signature and the number of binary formats, once the OpenGL context is ready.
+	*/
+	void initialize();
+
+public:
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~ShaderCache();
+
+	/**
+	*	@brief Removes every cached binary.
+	*/
+	void clear();
+
+	/**
+	*	@return Key of a program from the preprocessed sources of its stages.
+	*/
+	uint64_t computeKey(const std::vector<std::string>& sources);
+
+	/**
+	*	@return Usage of the cache.
+	*/
+	const Statistics& getStatistics() const { return _statistics; }
+
+	/**
+	*	@return True if programs are read from and written into the cache.
+	*/
+	bool isEnabled() const { return _enabled; }
+
+	/**
+	*	@brief Links a program from its cached binary.
+	*	@return False if the program is not cached or its binary is not valid anymore, so that it must be compiled from source.
+	*/
+	bool load(const GLuint program, const uint64_t key);
+
+	/**
+	*	@brief Removes the cached binary of a program, e.g. a permutation which is not expected to be used again.
+	*/
+	void remove(const uint64_t key);
+
+	/**
+	*	@brief Enables or disables the cache.
+	*/
+	void setEnabled(const bool enabled) { _enabled = enabled; }
+
+	/**
+	*	@brief Writes the binary of a linked program. The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+	*/
+	void store(const GLuint program, const uint64_t key);
+};
+
@@ -1,11 +1,14 @@
 #include "stdafx.h"
 #include "ShaderList.h"
 
+#include "Graphics/Core/ShaderCache.h"
+
 // [Static members initialization]
 
 std::unordered_map<uint8_t, std::string> ShaderList::COMP_SHADER_SOURCE {
 		{RendEnum::ADD_COLORS_HQR, "Assets/Shaders/Compute/PointCloud/addColorsHQR"},
 		{RendEnum::BIT_MASK_RADIX_SORT, "Assets/Shaders/Compute/RadixSort/bitMask-radixSort"},
+		{RendEnum::BUILD_HI_Z, "Assets/Shaders/Compute/Culling/buildHiZ"},
 		{RendEnum::BUILD_CLUSTER_BUFFER, "Assets/Shaders/Compute/BVHGeneration/buildClusterBuffer"},
 		{RendEnum::CLUSTER_MERGING, "Assets/Shaders/Compute/BVHGeneration/clusterMerging"},
 		{RendEnum::COMPUTE_FACE_AABB, "Assets/Shaders/Compute/Model/computeFaceAABB"},
@@ -14,6 +17,7 @@ std::unordered_map<uint8_t, std::string> ShaderList::COMP_SHADER_SOURCE {
 		{RendEnum::COMPUTE_MORTON_CODES_PCL, "Assets/Shaders/Compute/PointCloud/computeMortonCodes"},
 		{RendEnum::COMPUTE_TANGENTS_1, "Assets/Shaders/Compute/Model/computeTangents_1"},
 		{RendEnum::COMPUTE_TANGENTS_2, "Assets/Shaders/Compute/Model/computeTangents_2"},
+		{RendEnum::CULL_DRAW_COMMANDS, "Assets/Shaders/Compute/Culling/cullDrawCommands"},
 		{RendEnum::DOWN_SWEEP_PREFIX_SCAN, "Assets/Shaders/Compute/PrefixScan/downSweep-prefixScan"},
 		{RendEnum::END_LOOP_COMPUTATIONS, "Assets/Shaders/Compute/BVHGeneration/endLoopComputations"},
 		{RendEnum::FIND_BEST_NEIGHBOR, "Assets/Shaders/Compute/BVHGeneration/findBestNeighbor"},
@@ -30,23 +34,36 @@ std::unordered_map<uint8_t, std::string> ShaderList::COMP_SHADER_SOURCE {
 		{RendEnum::REDUCE_PREFIX_SCAN, "Assets/Shaders/Compute/PrefixScan/reduce-prefixScan"},
 		{RendEnum::RESET_BUFFER_INDEX, "Assets/Shaders/Compute/Generic/resetBufferIndex"},
 		{RendEnum::RESET_DEPTH_BUFFER_SHADER, "Assets/Shaders/Compute/PointCloud/resetDepthBuffer"},
-		{RendEnum::RESET_DEPTH_BUFFER_HQR_SHADER, "Assets/Shaders/Compute/PointCloud/resetDepthBufferHQR"},
 		{RendEnum::RESET_LAST_POSITION_PREFIX_SCAN, "Assets/Shaders/Compute/PrefixScan/resetLastPosition-prefixScan"},
 		{RendEnum::STORE_TEXTURE_SHADER, "Assets/Shaders/Compute/PointCloud/storeTexture"},
-		{RendEnum::STORE_TEXTURE_HQR_SHADER, "Assets/Shaders/Compute/PointCloud/storeTextureHQR"},
 		{RendEnum::TRANSFER_POINTS_SHADER, "Assets/Shaders/Compute/PointCloud/transferPoints"},
 };
 
 std::unordered_map<uint8_t, std::string> ShaderList::REND_SHADER_SOURCE {
+		{RendEnum::BILATERAL_UPSAMPLE_SSAO_SHADER, "Assets/Shaders/2D/bilateralUpsampleSSAOShader"},
+		{RendEnum::BLUR_SSAO_SHADER, "Assets/Shaders/2D/blurSSAOShader"},
 		{RendEnum::DEBUG_QUAD_SHADER, "Assets/Shaders/Triangles/debugQuad"},
 		{RendEnum::POINT_CLOUD_SHADER, "Assets/Shaders/Points/pointCloud"},
+		{RendEnum::SHADOWS_GROUP_SHADER, "Assets/Shaders/Triangles/shadowMap"},
+		{RendEnum::SHADOWS_SHADER, "Assets/Shaders/Triangles/shadowMap"},
+		{RendEnum::SSAO_SHADER, "Assets/Shaders/2D/ssaoShader"},
 		{RendEnum::TRIANGLE_MESH_SHADER, "Assets/Shaders/Triangles/triangleMesh"},
-		{RendEnum::TRIANGLE_MESH_POSITION_SHADER, "Assets/Shaders/Triangles/triangleMeshPosition"},
+		{RendEnum::TRIANGLE_MESH_GROUP_SHADER, "Assets/Shaders/Triangles/triangleMesh"},
 		{RendEnum::WIREFRAME_SHADER, "Assets/Shaders/Lines/wireframe"}
 };
 
+std::unordered_map<uint8_t, ShaderProgram::ShaderDefines> ShaderList::REND_SHADER_DEFINES {
+		{RendEnum::SHADOWS_GROUP_SHADER, {{"MULTI_DRAW", "1"}}},
+		{RendEnum::TRIANGLE_MESH_GROUP_SHADER, {{"MULTI_DRAW", "1"}}}
+};
+
+std::unordered_set<uint8_t> ShaderList::COMP_SHADER_PERMUTED {
+		RendEnum::ADD_COLORS_HQR, RendEnum::PROJECTION_SHADER, RendEnum::PROJECTION_HQR_SHADER, RendEnum::RESET_DEPTH_BUFFER_SHADER, RendEnum::STORE_TEXTURE_SHADER
+};
+
 std::vector<std::unique_ptr<ComputeShader>> ShaderList::_computeShader (RendEnum::numComputeShaderTypes());
 std::vector<std::unique_ptr<RenderingShader>> ShaderList::_renderingShader (RendEnum::numRenderingShaderTypes());
+std::unordered_map<std::string, std::unique_ptr<ComputeShader>> ShaderList::_computeShaderPermutation;
 
 /// [Protected methods]
 
@@ -54,6 +71,43 @@ ShaderList::ShaderList()
 {
 }
 
+std::string ShaderList::getPermutationKey(const RendEnum::CompShaderTypes shader, const ShaderProgram::ShaderDefines& defines)
+{
+	std::string key = std::to_string(shader);
+	for (const auto& define : defines) key += ";" + define.first + "=" + define.second;
+
+	return key;
+}
+
+void ShaderList::finishShaderPrograms(const std::vector<std::pair<ShaderProgram*, const char*>>& submittedShaders)
+{
+	for (const auto& submittedShader : submittedShaders)
+	{
+		submittedShader.first->finishShaderProgram(submittedShader.second);
+	}
+}
+
+void ShaderList::warmUp(const std::vector<ComputePermutation>& permutations)
+{
+	std::vector<std::pair<ShaderProgram*, const char*>> submittedShaders;
+
+	if (GLEW_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+	for (const ComputePermutation& permutation : permutations)
+	{
+		std::unique_ptr<ComputeShader>& shader = _computeShaderPermutation[getPermutationKey(permutation.first, permutation.second)];
+		if (shader.get()) continue;
+
+		const char* filename = COMP_SHADER_SOURCE.at(permutation.first).c_str();
+
+		shader.reset(new ComputeShader());
+		shader->setDefines(permutation.second);
+		if (shader->submitShaderProgram(filename)) submittedShaders.push_back(std::make_pair(shader.get(), filename));
+	}
+
+	finishShaderPrograms(submittedShaders);
+}
+
 /// [Public methods]
 
 ComputeShader* ShaderList::getComputeShader(const RendEnum::CompShaderTypes shader)
@@ -71,6 +125,22 @@ ComputeShader* ShaderList::getComputeShader(const RendEnum::CompShaderTypes shad
 	return _computeShader[shaderID].get();
 }
 
+ComputeShader* ShaderList::getComputeShader(const RendEnum::CompShaderTypes shader, const ShaderProgram::ShaderDefines& defines)
+{
+	if (defines.empty()) return this->getComputeShader(shader);
+
+	std::unique_ptr<ComputeShader>& permutation = _computeShaderPermutation[getPermutationKey(shader, defines)];
+
+	if (!permutation.get())
+	{
+		permutation.reset(new ComputeShader());
+		permutation->setDefines(defines);
+		permutation->createShaderProgram(COMP_SHADER_SOURCE.at(shader).c_str());
+	}
+
+	return permutation.get();
+}
+
 RenderingShader* ShaderList::getRenderingShader(const RendEnum::RendShaderTypes shader)
 {
 	const int shaderID = shader;
@@ -78,6 +148,7 @@ RenderingShader* ShaderList::getRenderingShader(const RendEnum::RendShaderTypes
 	if (!_renderingShader[shader].get())
 	{
 		RenderingShader* shader = new RenderingShader();
+		if (REND_SHADER_DEFINES.count(shaderID)) shader->setDefines(REND_SHADER_DEFINES.at(shaderID));
 		shader->createShaderProgram(REND_SHADER_SOURCE.at(shaderID).c_str());
 
 		_renderingShader[shaderID].reset(shader);
@@ -85,3 +156,47 @@ RenderingShader* ShaderList::getRenderingShader(const RendEnum::RendShaderTypes
 
 	return _renderingShader[shader].get();
 }
+
+void ShaderList::releaseComputeShader(const RendEnum::CompShaderTypes shader, const ShaderProgram::ShaderDefines& defines)
+{
+	auto permutation = _computeShaderPermutation.find(getPermutationKey(shader, defines));
+	if (permutation == _computeShaderPermutation.end()) return;
+
+	if (permutation->second.get())
+	{
+		ShaderCache::getInstance()->remove(permutation->second->getBinaryKey());
+		if (permutation->second->getHandler() > 0) glDeleteProgram(permutation->second->getHandler());
+	}
+
+	_computeShaderPermutation.erase(permutation);
+}
+
+void ShaderList::warmUp()
+{
+	std::vector<std::pair<ShaderProgram*, const char*>> submittedShaders;
+
+	if (GLEW_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFF);			// As many threads as the driver decides
+
+	for (const auto& source : COMP_SHADER_SOURCE)
+	{
+		if (_computeShader[source.first].get() || COMP_SHADER_PERMUTED.count(source.first)) continue;
+
+		ComputeShader* shader = new ComputeShader();
+		if (shader->submitShaderProgram(source.second.c_str())) submittedShaders.push_back(std::make_pair(shader, source.second.c_str()));
+
+		_computeShader[source.first].reset(shader);
+	}
+
+	for (const auto& source : REND_SHADER_SOURCE)
+	{
+		if (_renderingShader[source.first].get()) continue;
+
+		RenderingShader* shader = new RenderingShader();
+		if (REND_SHADER_DEFINES.count(source.first)) shader->setDefines(REND_SHADER_DEFINES.at(source.first));
+		if (shader->submitShaderProgram(source.second.c_str())) submittedShaders.push_back(std::make_pair(shader, source.second.c_str()));
+
+		_renderingShader[source.first].reset(shader);
+	}
+
+	finishShaderPrograms(submittedShaders);
+}
@@ -18,13 +18,19 @@ class ShaderList: public Singleton<ShaderList>
 {
 	friend class Singleton<ShaderList>;
 
+public:
+	typedef std::pair<RendEnum::CompShaderTypes, ShaderProgram::ShaderDefines> ComputePermutation;
+
 protected:
 	static std::unordered_map<uint8_t, std::string> COMP_SHADER_SOURCE;					//!< Path where we can get each compute shader
 	static std::unordered_map<uint8_t, std::string> REND_SHADER_SOURCE;					//!< Path where we can get each rendering shader
+	static std::unordered_map<uint8_t, ShaderProgram::ShaderDefines> REND_SHADER_DEFINES;	//!< Defines of rendering shaders which are permutations of another source
+	static std::unordered_set<uint8_t> COMP_SHADER_PERMUTED;									//!< Compute shaders which are only used through permutations, so they are not warmed up
 
 protected:
 	static std::vector<std::unique_ptr<ComputeShader>>		_computeShader;				//!< Already loaded compute shaders
 	static std::vector<std::unique_ptr<RenderingShader>>	_renderingShader;			//!< Already loaded rendering shader
+	static std::unordered_map<std::string, std::unique_ptr<ComputeShader>> _computeShaderPermutation;	//!< Already loaded compute shaders with custom defines
 
 protected:
 	/**
@@ -32,15 +38,47 @@ protected:
 	*/
 	ShaderList();
 
+	/**
+	*	@return Identifier of a compute shader permutation.
+	*/
+	static std::string getPermutationKey(const RendEnum::CompShaderTypes shader, const ShaderProgram::ShaderDefines& defines);
+
+	/**
+	*	@brief Finishes the given programs, whose compilation was already requested.
+	*/
+	static void finishShaderPrograms(const std::vector<std::pair<ShaderProgram*, const char*>>& submittedShaders);
+
 public:
 	/**
 	*	@return Compute shader defined by the identifier.
 	*/
 	ComputeShader* getComputeShader(const RendEnum::CompShaderTypes shader);
 
+	/**
+	*	@return Permutation of a compute shader, compiled with the given defines. Each permutation is built once.
+	*/
+	ComputeShader* getComputeShader(const RendEnum::CompShaderTypes shader, const ShaderProgram::ShaderDefines& defines);
+
 	/**
 	*	@return Rendering shader defined by the identifier.
 	*/
 	RenderingShader* getRenderingShader(const RendEnum::RendShaderTypes shader);
+
+	/**
+	*	@brief Deletes a permutation of a compute shader, along with its cached binary, once it is not expected to be used again.
+	*/
+	void releaseComputeShader(const RendEnum::CompShaderTypes shader, const ShaderProgram::ShaderDefines& defines);
+
+	/**
+	*	@brief Builds every shader which has not been loaded yet. Compilations are requested before checking any of them, so that drivers
+	*	supporting ARB_parallel_shader_compile build them in parallel; programs found in the binary cache are just loaded. Compute shaders
+	*	which are only used through permutations are skipped, as their defines are not known yet.
+	*/
+	void warmUp();
+
+	/**
+	*	@brief Builds those permutations which have not been loaded yet, requesting every compilation before checking any of them.
+	*/
+	void warmUp(const std::vector<ComputePermutation>& permutations);
 };
 
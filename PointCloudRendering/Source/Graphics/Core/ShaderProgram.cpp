@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "ShaderProgram.h"
 
+#include "Graphics/Core/ShaderCache.h"
+
 // [Static variables initialization]
 
 const std::string ShaderProgram::MODULE_HEADER = "#include";
@@ -12,7 +14,7 @@ std::unordered_map<std::string, std::string> ShaderProgram::_moduleCode;
 /// [Public methods]
 
 ShaderProgram::ShaderProgram()
-	: _handler(0), _linked(false), _logString("")
+	: _handler(0), _linked(false), _logString(""), _binaryKey(0)
 {
 }
 
@@ -38,7 +40,7 @@ bool ShaderProgram::setSubroutineUniform(const GLenum shaderType, const std::str
 
 bool ShaderProgram::setUniform(const std::string& name, GLfloat value)
 {
-	GLint location = glGetUniformLocation(_handler, name.c_str());
+	const GLint location = this->getUniformLocation(name);
 
 	if (location >= 0)
 	{
@@ -54,7 +56,7 @@ bool ShaderProgram::setUniform(const std::string& name, GLfloat value)
 
 bool ShaderProgram::setUniform(const std::string& name, GLint value)
 {
-	GLint location = glGetUniformLocation(_handler, name.c_str());
+	const GLint location = this->getUniformLocation(name);
 
 	if (location >= 0)
 	{
@@ -70,7 +72,7 @@ bool ShaderProgram::setUniform(const std::string& name, GLint value)
 
 bool ShaderProgram::setUniform(const std::string& name, const GLuint value)
 {
-	GLint location = glGetUniformLocation(_handler, name.c_str());
+	const GLint location = this->getUniformLocation(name);
 
 	if (location >= 0)
 	{
@@ -86,7 +88,7 @@ bool ShaderProgram::setUniform(const std::string& name, const GLuint value)
 
 bool ShaderProgram::setUniform(const std::string& name, const mat4& value)
 {
-	GLint location = glGetUniformLocation(_handler, name.c_str());
+	const GLint location = this->getUniformLocation(name);
 
 	if (location >= 0)
 	{
@@ -102,7 +104,7 @@ bool ShaderProgram::setUniform(const std::string& name, const mat4& value)
 
 bool ShaderProgram::setUniform(const std::string& name, const vec2& value)
 {
-	GLint location = glGetUniformLocation(_handler, name.c_str());
+	const GLint location = this->getUniformLocation(name);
 
 	if (location >= 0)
 	{
@@ -118,7 +120,7 @@ bool ShaderProgram::setUniform(const std::string& name, const vec2& value)
 
 bool ShaderProgram::setUniform(const std::string& name, const uvec2& value)
 {
-	GLint location = glGetUniformLocation(_handler, name.c_str());
+	const GLint location = this->getUniformLocation(name);
 
 	if (location >= 0)
 	{
@@ -132,9 +134,25 @@ bool ShaderProgram::setUniform(const std::string& name, const uvec2& value)
 	return false;
 }
 
+bool ShaderProgram::setUniform(const std::string& name, const ivec2& value)
+{
+	const GLint location = this->getUniformLocation(name);
+
+	if (location >= 0)
+	{
+		glUniform2iv(location, 1, &value[0]);
+
+		return true;
+	}
+
+	std::cout << "Cannot find localization for: " << name << std::endl;
+
+	return false;
+}
+
 bool ShaderProgram::setUniform(const std::string& name, const vec3& value)
 {
-	GLint location = glGetUniformLocation(_handler, name.c_str());
+	const GLint location = this->getUniformLocation(name);
 
 	if (location >= 0)
 	{
@@ -150,7 +168,7 @@ bool ShaderProgram::setUniform(const std::string& name, const vec3& value)
 
 bool ShaderProgram::setUniform(const std::string& name, const vec4& value)
 {
-	GLint location = glGetUniformLocation(_handler, name.c_str());
+	const GLint location = this->getUniformLocation(name);
 
 	if (location >= 0)
 	{
@@ -180,40 +198,8 @@ bool ShaderProgram::use()
 
 /// [Protected methods]
 
-GLuint ShaderProgram::compileShader(const char* filename, const GLenum shaderType)
+bool ShaderProgram::checkCompileStatus(const GLuint shaderHandler, const GLenum shaderType)
 {
-	if (!fileExists(filename))
-	{
-		if (shaderType != GL_GEOMETRY_SHADER)
-			fprintf(stderr, "Shader source file %s not found.\n", filename);
-
-		return 0;
-	}
-
-	std::string shaderSourceString;
-	if (!loadFileContent(std::string(filename), shaderSourceString))						// Read shader code
-	{
-		fprintf(stderr, "Cannot open shader source file.\n");
-		return 0;
-	}
-
-	if (!includeLibraries(shaderSourceString))												// Libraries code not found 
-	{
-		fprintf(stderr, "Cannot include the specified modules.\n");
-		return 0;
-	}
-
-	GLuint shaderHandler = glCreateShader(shaderType);
-	if (shaderHandler == 0)
-	{
-		fprintf(stderr, "Cannot create shader object.\n");
-		return 0;
-	}
-
-	const char* shaderSourceCString = shaderSourceString.c_str();							// Compile shader code
-	glShaderSource(shaderHandler, 1, &shaderSourceCString, NULL);
-	glCompileShader(shaderHandler);
-
 	GLint compileResult;
 	glGetShaderiv(shaderHandler, GL_COMPILE_STATUS, &compileResult);					// Result
 
@@ -236,6 +222,23 @@ GLuint ShaderProgram::compileShader(const char* filename, const GLenum shaderTyp
 		}
 	}
 
+	return compileResult == GL_TRUE;
+}
+
+GLuint ShaderProgram::compileShader(const char* filename, const GLenum shaderType)
+{
+	std::string shaderSourceString;
+	if (!this->readShaderSource(filename, shaderType, shaderSourceString))
+	{
+		return 0;
+	}
+
+	const GLuint shaderHandler = this->submitShader(shaderSourceString, shaderType);
+	if (shaderHandler != 0)
+	{
+		this->checkCompileStatus(shaderHandler, shaderType);
+	}
+
 	return shaderHandler;
 }
 
@@ -264,6 +267,27 @@ ShaderProgram::ShaderTypes ShaderProgram::fromOpenGLToShaderTypes(const GLenum s
 	return VERTEX_SHADER;
 }
 
+GLint ShaderProgram::getUniformLocation(const std::string& name) const
+{
+	const auto location = _uniformLocation.find(name);
+
+	return location != _uniformLocation.end() ? location->second : -1;
+}
+
+void ShaderProgram::injectDefines(std::string& shaderContent)
+{
+	if (_defines.empty()) return;
+
+	std::string defineLines;
+	for (const auto& define : _defines) defineLines += "#define " + define.first + " " + define.second + "\n";
+
+	size_t pos = shaderContent.find("#version");
+	pos = pos == std::string::npos ? 0 : shaderContent.find('\n', pos);
+	pos = pos == std::string::npos ? shaderContent.size() : pos + 1;
+
+	shaderContent.insert(pos, defineLines);
+}
+
 bool ShaderProgram::includeLibraries(std::string& shaderContent)
 {
 	size_t pos = shaderContent.find(MODULE_HEADER);
@@ -325,3 +349,162 @@ bool ShaderProgram::loadFileContent(const std::string& filename, std::string& co
 
 	return true;
 }
+
+bool ShaderProgram::readShaderSource(const char* filename, const GLenum shaderType, std::string& source)
+{
+	if (!fileExists(filename))
+	{
+		if (shaderType != GL_GEOMETRY_SHADER)
+			fprintf(stderr, "Shader source file %s not found.\n", filename);
+
+		return false;
+	}
+
+	if (!loadFileContent(std::string(filename), source))									// Read shader code
+	{
+		fprintf(stderr, "Cannot open shader source file.\n");
+		return false;
+	}
+
+	if (!includeLibraries(source))															// Libraries code not found 
+	{
+		fprintf(stderr, "Cannot include the specified modules.\n");
+		return false;
+	}
+
+	this->injectDefines(source);
+
+	return true;
+}
+
+void ShaderProgram::resolveUniformLocations()
+{
+	GLint numUniforms = 0, maxNameLength = 0;
+	glGetProgramInterfaceiv(_handler, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+	glGetProgramInterfaceiv(_handler, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	std::vector<char> name(std::max(maxNameLength, 1));
+	_uniformLocation.clear();
+
+	for (GLint uniformIdx = 0; uniformIdx < numUniforms; ++uniformIdx)
+	{
+		glGetProgramResourceName(_handler, GL_UNIFORM, uniformIdx, GLsizei(name.size()), nullptr, name.data());
+
+		const GLint location = glGetProgramResourceLocation(_handler, GL_UNIFORM, name.data());
+		if (location < 0) continue;													// Member of a uniform block
+
+		std::string uniformName(name.data());
+		_uniformLocation[uniformName] = location;
+
+		// Arrays are reported as name[0], but they are also set through their plain name
+		const size_t arrayPos = uniformName.rfind("[0]");
+		if (arrayPos != std::string::npos && arrayPos + 3 == uniformName.size())
+		{
+			_uniformLocation[uniformName.substr(0, arrayPos)] = location;
+		}
+	}
+}
+
+GLuint ShaderProgram::submitShader(const std::string& source, const GLenum shaderType)
+{
+	GLuint shaderHandler = glCreateShader(shaderType);
+	if (shaderHandler == 0)
+	{
+		fprintf(stderr, "Cannot create shader object.\n");
+		return 0;
+	}
+
+	const char* shaderSourceCString = source.c_str();										// Compile shader code
+	glShaderSource(shaderHandler, 1, &shaderSourceCString, NULL);
+	glCompileShader(shaderHandler);
+
+	return shaderHandler;
+}
+
+bool ShaderProgram::submitLink(const std::vector<std::pair<GLenum, std::string>>& stages)
+{
+	ShaderCache* shaderCache = ShaderCache::getInstance();
+	std::vector<std::string> sources;
+
+	for (const auto& stage : stages) sources.push_back(stage.second);
+	_binaryKey = shaderCache->computeKey(sources);
+
+	if (shaderCache->load(_handler, _binaryKey))
+	{
+		_linked = true;
+		return true;
+	}
+
+	for (const auto& stage : stages)
+	{
+		const GLuint shaderHandler = this->submitShader(stage.second, stage.first);
+		if (shaderHandler == 0)
+		{
+			for (const GLuint pendingShader : _pendingShaders) glDeleteShader(pendingShader);
+			_pendingShaders.clear();
+
+			return false;
+		}
+
+		glAttachShader(_handler, shaderHandler);
+		_pendingShaders.push_back(shaderHandler);
+	}
+
+	if (shaderCache->isEnabled()) glProgramParameteri(_handler, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(_handler);
+
+	return true;
+}
+
+bool ShaderProgram::finishLink(const char* filename)
+{
+	if (_linked)																			// Loaded from the binary cache
+	{
+		this->resolveUniformLocations();
+		return true;
+	}
+
+	GLint linkSuccess = 0;
+	glGetProgramiv(_handler, GL_LINK_STATUS, &linkSuccess);
+
+	if (linkSuccess == GL_FALSE)
+	{
+		for (const GLuint shaderHandler : _pendingShaders)
+		{
+			GLint shaderType = 0;
+			glGetShaderiv(shaderHandler, GL_SHADER_TYPE, &shaderType);
+			this->checkCompileStatus(shaderHandler, GLenum(shaderType));
+		}
+
+		GLint logLen = 0;
+		glGetProgramiv(_handler, GL_INFO_LOG_LENGTH, &logLen);
+
+		if (logLen > 0)
+		{
+			char* cLogString = new char[logLen];
+			GLint written = 0;
+
+			glGetProgramInfoLog(_handler, logLen, &written, cLogString);
+			_logString.assign(cLogString);
+			delete[] cLogString;
+
+			std::cout << "Cannot link shader " << filename << ":" << std::endl << _logString << std::endl;
+		}
+	}
+	else
+	{
+		_linked = true;
+		ShaderCache::getInstance()->store(_handler, _binaryKey);
+		this->resolveUniformLocations();
+	}
+
+	for (const GLuint shaderHandler : _pendingShaders)										// Shader objects are not needed once the program is linked
+	{
+		glDetachShader(_handler, shaderHandler);
+		glDeleteShader(shaderHandler);
+	}
+
+	_pendingShaders.clear();
+
+	return _linked;
+}
@@ -23,6 +23,8 @@ public:
 		COMPUTE_SHADER
 	};
 
+	typedef std::map<std::string, std::string> ShaderDefines;					//!< Macros injected after the #version directive, sorted by name so that permutations are deterministic
+
 protected:
 	const static std::string MODULE_HEADER;
 	const static std::string MODULE_FILE_CHAR_1;
@@ -32,6 +34,14 @@ protected:
 	GLuint				_handler;												//!< Shader program id in GPU
 	bool				_linked;												//!< Flag which tell us if the shader has been linked correctly
 	std::string			_logString;												//!< Error message got from the last operation with the shader
+	ShaderDefines		_defines;												//!< Macros which define this permutation of the program
+
+	// [Uniforms]
+	std::unordered_map<std::string, GLint> _uniformLocation;					//!< Location of every active uniform, resolved once the program is linked
+
+	// [Binary cache]
+	uint64_t			_binaryKey;												//!< Key of the program within the binary cache
+	std::vector<GLuint>	_pendingShaders;										//!< Shader objects attached to a program whose linking has not been checked yet
 
 	// [Subroutines]
 	std::vector<GLuint> _activeSubroutineUniform[COMPUTE_SHADER + 1];			//!< Active uniform for each subroutine for each shader type
@@ -40,6 +50,12 @@ protected:
 	static std::unordered_map<std::string, std::string> _moduleCode;			//!< Modules that are already loaded
 
 protected:
+	/**
+	*	@brief Retrieves the compilation log of a shader if it failed.
+	*	@return True if the shader was compiled.
+	*/
+	bool checkCompileStatus(const GLuint shaderHandler, const GLenum shaderType);
+
 	/**
 	*	@brief Tries to compile a shader at a certain path.
 	*	@param filename Path of the shader we need to compile.
@@ -60,6 +76,11 @@ protected:
 	*/
 	ShaderTypes fromOpenGLToShaderTypes(const GLenum shaderType);
 
+	/**
+	*	@brief Inserts the program defines right after the #version directive, or at the beginning if there is none.
+	*/
+	void injectDefines(std::string& shaderContent);
+
 	/**
 	*	@brief Substitutes the libraries references by its code.
 	*	@param shaderContent Shader code to be modified.
@@ -73,6 +94,36 @@ protected:
 	*/
 	virtual bool loadFileContent(const std::string& filename, std::string& content);
 
+	/**
+	*	@brief Reads a shader and substitutes its libraries references.
+	*	@param shaderType Missing files are only reported if the shader is not a geometry shader, as that stage is optional.
+	*/
+	bool readShaderSource(const char* filename, const GLenum shaderType, std::string& source);
+
+	/**
+	*	@brief Fills the location table with the active uniforms of the linked program, so that no string lookup reaches the driver afterwards.
+	*	Uniforms within blocks are skipped, as they have no location.
+	*/
+	void resolveUniformLocations();
+
+	/**
+	*	@brief Requests the compilation of a shader without waiting for its result.
+	*	@return Assigned ID for the shader.
+	*/
+	GLuint submitShader(const std::string& source, const GLenum shaderType);
+
+	/**
+	*	@brief Links the program from the binary cache or, if it is not cached, requests the compilation of every stage and the linking of the program.
+	*	Results are not queried, so that the driver can compile several programs in parallel until finishLink is called.
+	*	@param stages Preprocessed source of each stage.
+	*/
+	bool submitLink(const std::vector<std::pair<GLenum, std::string>>& stages);
+
+	/**
+	*	@brief Waits for the linking requested by submitLink, reports any error and stores the program binary into the cache.
+	*/
+	bool finishLink(const char* filename);
+
 public:
 	/**
 	*	@brief Constructor.
@@ -95,6 +146,42 @@ public:
 	*/
 	virtual GLuint createShaderProgram(const char* filename) = 0;
 
+	/**
+	*	@brief Second half of createShaderProgram, which checks the linking and queries the program resources.
+	*	@return Shader program id, or zero if it could not be linked.
+	*/
+	virtual GLuint finishShaderProgram(const char* filename) = 0;
+
+	/**
+	*	@brief First half of createShaderProgram, which reads the shaders and requests their compilation without waiting for it.
+	*/
+	virtual bool submitShaderProgram(const char* filename) = 0;
+
+	/**
+	*	@return Macros which define this permutation of the program.
+	*/
+	const ShaderDefines& getDefines() const { return _defines; }
+
+	/**
+	*	@return Key of the program within the binary cache.
+	*/
+	uint64_t getBinaryKey() const { return _binaryKey; }
+
+	/**
+	*	@return Identifier of the program in GPU.
+	*/
+	GLuint getHandler() const { return _handler; }
+
+	/**
+	*	@return Location of an active uniform, or -1 if the program does not use it.
+	*/
+	GLint getUniformLocation(const std::string& name) const;
+
+	/**
+	*	@brief Defines the macros of the program, which must be set before it is created.
+	*/
+	void setDefines(const ShaderDefines& defines) { _defines = defines; }
+
 	/**
 	*	@brief Modifies the active uniform on a subroutine.
 	*	@param shaderType Shader type where we desire to modify the subroutine uniform.
@@ -145,6 +232,13 @@ public:
 	*/
 	bool setUniform(const std::string& name, const uvec2& value);
 
+	/**
+	*	@brief Modifies the value of an integer Vector2 uniform.
+	*	@param name Name of uniform.
+	*	@param value Value of uniform.
+	*/
+	bool setUniform(const std::string& name, const ivec2& value);
+
 	/**
 	*	@brief Modifies the value of a Vector3 uniform.
 	*	@param name Name of uniform.
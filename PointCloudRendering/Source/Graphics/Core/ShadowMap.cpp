@@ -3,10 +3,14 @@
 
 #include "Graphics/Application/Renderer.h"
 
+// [Static members initialization]
+
+const unsigned ShadowMap::TILES_PER_EDGE = 4;
+
 /// [Public methods]
 
 ShadowMap::ShadowMap(const uint16_t width, const uint16_t height):
-	FBO(width, height)
+	FBO(width, height), _dirtyTile(TILES_PER_EDGE * TILES_PER_EDGE, true)
 {
 	GLfloat border[] = { 1.0f, 1.0f, 1.0f, 1.0f };						// Color out of boundaries [0, 1]. 1 is the maximum depth, so no fragment can't be in shadow because of this
 
@@ -59,6 +63,63 @@ void ShadowMap::applyTexture(ShaderProgram* shader)
 	glBindTexture(GL_TEXTURE_2D, _depthBuffer);
 }
 
+mat4 ShadowMap::getTileCropMatrix(const unsigned tile) const
+{
+	const float tileSize = 2.0f / TILES_PER_EDGE;
+	const vec2 tileCenter = vec2(-1.0f) + tileSize * (vec2(tile % TILES_PER_EDGE, tile / TILES_PER_EDGE) + .5f);
+
+	return glm::scale(mat4(1.0f), vec3(TILES_PER_EDGE, TILES_PER_EDGE, 1.0f)) * glm::translate(mat4(1.0f), vec3(-tileCenter, .0f));
+}
+
+ivec4 ShadowMap::getTileViewport(const unsigned tile) const
+{
+	const ivec2 tileIndex = ivec2(tile % TILES_PER_EDGE, tile / TILES_PER_EDGE);
+	const ivec2 origin = tileIndex * _size / int(TILES_PER_EDGE), end = (tileIndex + 1) * _size / int(TILES_PER_EDGE);
+
+	return ivec4(origin, end - origin);
+}
+
+void ShadowMap::invalidate()
+{
+	std::fill(_dirtyTile.begin(), _dirtyTile.end(), true);
+}
+
+void ShadowMap::invalidate(const AABB& region, const mat4& viewProjection)
+{
+	if (region.empty() || !region.intersectsFrustum(viewProjection))
+	{
+		return;
+	}
+
+	const vec3 min = region.min(), max = region.max();
+	vec2 minNDC(1.0f), maxNDC(-1.0f);
+
+	for (unsigned corner = 0; corner < 8; ++corner)
+	{
+		const vec4 point = viewProjection * vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0f);
+
+		if (point.w <= .0f)					// Behind a perspective camera: its projection is unbounded
+		{
+			this->invalidate();
+			return;
+		}
+
+		minNDC = glm::min(minNDC, vec2(point) / point.w);
+		maxNDC = glm::max(maxNDC, vec2(point) / point.w);
+	}
+
+	const ivec2 minTile = glm::clamp(ivec2(glm::floor((minNDC + 1.0f) * .5f * float(TILES_PER_EDGE))), ivec2(0), ivec2(TILES_PER_EDGE - 1));
+	const ivec2 maxTile = glm::clamp(ivec2(glm::floor((maxNDC + 1.0f) * .5f * float(TILES_PER_EDGE))), ivec2(0), ivec2(TILES_PER_EDGE - 1));
+
+	for (int y = minTile.y; y <= maxTile.y; ++y)
+	{
+		for (int x = minTile.x; x <= maxTile.x; ++x)
+		{
+			_dirtyTile[y * TILES_PER_EDGE + x] = true;
+		}
+	}
+}
+
 void ShadowMap::modifySize(const uint16_t width, const uint16_t height)
 {
 	FBO::modifySize(width, height);
@@ -68,4 +129,6 @@ void ShadowMap::modifySize(const uint16_t width, const uint16_t height)
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, _size.x, _size.y, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, nullptr);
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	this->invalidate();
 }
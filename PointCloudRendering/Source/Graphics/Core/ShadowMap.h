@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Geometry/3D/AABB.h"
 #include "Graphics/Core/FBO.h"
 #include "Graphics/Core/ShaderProgram.h"
 
@@ -10,12 +11,17 @@
 */
 
 /**
-*	@brief FBO which contains a depth buffer with the scene seen from a light source.
+*	@brief FBO which contains a depth buffer with the scene seen from a light source. The buffer is split into tiles which are
+*	invalidated only where the scene changes, so that they can be rendered again separately.
 */
 class ShadowMap: public FBO
 {
 protected:
-	GLuint _depthBuffer;						//!< Identifier of depth buffer assigned to FBO
+	const static unsigned TILES_PER_EDGE;		//!< Number of tiles along each axis of the depth buffer
+
+protected:
+	GLuint				_depthBuffer;			//!< Identifier of depth buffer assigned to FBO
+	std::vector<bool>	_dirtyTile;				//!< Tiles which must be rendered again
 
 public:
 	/**
@@ -41,6 +47,47 @@ public:
 	*/
 	void applyTexture(ShaderProgram* shader);
 
+	/**
+	*	@return Number of tiles of the depth buffer.
+	*/
+	unsigned getNumTiles() const { return TILES_PER_EDGE * TILES_PER_EDGE; }
+
+	/**
+	*	@return Matrix which maps a tile to the whole clip space, so that it can be rendered (and its casters culled) with its own frustum.
+	*/
+	mat4 getTileCropMatrix(const unsigned tile) const;
+
+	/**
+	*	@return Origin (x, y) and size (z, w) of a tile in the depth buffer.
+	*/
+	ivec4 getTileViewport(const unsigned tile) const;
+
+	/**
+	*	@brief Marks every tile to be rendered again.
+	*/
+	void invalidate();
+
+	/**
+	*	@brief Marks the tiles covered by a region to be rendered again.
+	*	@param viewProjection View-projection matrix of the light camera.
+	*/
+	void invalidate(const AABB& region, const mat4& viewProjection);
+
+	/**
+	*	@return True if any tile must be rendered again.
+	*/
+	bool isDirty() const { return std::find(_dirtyTile.begin(), _dirtyTile.end(), true) != _dirtyTile.end(); }
+
+	/**
+	*	@return True if the tile must be rendered again.
+	*/
+	bool isTileDirty(const unsigned tile) const { return _dirtyTile[tile]; }
+
+	/**
+	*	@brief Marks a tile as up to date.
+	*/
+	void setTileUpdated(const unsigned tile) { _dirtyTile[tile] = false; }
+
 	/**
 	*	@brief Modifies the size specified in textures related to framebuffer.
 	*	@param width New width.
@@ -33,20 +33,20 @@ const std::unordered_map<uint16_t, std::string> Texture::SHADER_VARIABLE = std::
 */
 
 Texture::Texture(const std::string& filename, const GLuint wrapS, const GLuint wrapT, const GLuint minFilter, const GLuint magFilter)
-	: _id(-1)
+	: _id(-1), _color(.0f), _uniformColor(false)
 {
 	Image image (filename);
 	this->loadImage(&image, minFilter, magFilter, wrapS, wrapT);
 }
 
 Texture::Texture(Image* image, const GLuint wrapS, const GLuint wrapT, const GLuint minFilter, const GLuint magFilter)
-	: _id(-1)
+	: _id(-1), _color(.0f), _uniformColor(false)
 {
 	this->loadImage(image, minFilter, magFilter, wrapS, wrapT);
 }
 
 Texture::Texture(float* image, const int width, const int height, const GLuint wrapS, const GLuint wrapT, const GLuint minFilter, const GLuint magFilter, const bool rgba)
-	: _id(-1)
+	: _id(-1), _color(.0f), _uniformColor(false)
 {
 	glGenTextures(1, &_id);
 	glBindTexture(GL_TEXTURE_2D, _id);
@@ -68,7 +68,7 @@ Texture::Texture(float* image, const int width, const int height, const GLuint w
 }
 
 Texture::Texture(std::vector<Image*> images, const int width, const int height, const GLuint wrapS, const GLuint wrapT, const GLuint wrapR, const GLuint minFilter, const GLuint magFilter)
-	: _id(-1)
+	: _id(-1), _color(.0f), _uniformColor(false)
 {
 	glGenTextures(1, &_id);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, _id);
@@ -87,7 +87,7 @@ Texture::Texture(std::vector<Image*> images, const int width, const int height,
 }
 
 Texture::Texture(const vec4& color)
-	: _id(-1)
+	: _id(-1), _color(.0f), _uniformColor(false)
 {
 	this->loadColor(color);
 }
@@ -132,6 +132,9 @@ void Texture::applyTexture4ComputeShader(ComputeShader* shader, const GLint id,
 
 void Texture::loadColor(const vec4& color)
 {
+	_color = color;
+	_uniformColor = true;
+
 	const int width = 1, height = 1;
 	const unsigned char image[] = { 255.0f * color.x, 255.0f * color.y, 255.0f * color.z, 255.0f * color.a };
 
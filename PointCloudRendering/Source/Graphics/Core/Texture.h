@@ -43,6 +43,10 @@ protected:
 	// [OpenGL parameters]
 	GLuint	_id;						//!< Texture identifier in GPU
 
+	// [Single color textures]
+	vec4	_color;						//!< Color of the texture, if it is not an image
+	bool	_uniformColor;				//!< The texture was built from a single color
+
 private:
 	/**
 	*	@brief Generates the texture as an unique color.
@@ -124,9 +128,19 @@ public:
 
 	/// Getters
 
+	/**
+	*	@return Color of single color textures.
+	*/
+	vec4 getColor() const { return _color; }
+
 	/**
 	*	@return GPU ID of texture.
 	*/
 	unsigned getID() { return _id; }
+
+	/**
+	*	@return True if the texture was built from a single color, so that it can be replaced by such color.
+	*/
+	bool isUniformColor() const { return _uniformColor; }
 };
 
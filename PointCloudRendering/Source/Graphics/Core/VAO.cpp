@@ -1,9 +1,11 @@
 #include "stdafx.h"
 #include "VAO.h"
 
+#include "Graphics/Core/ComputeShader.h"
+
 /// [Public methods]
 
-VAO::VAO(bool gpuGeometry): _vao(-1), _vbo(RendEnum::numVBOTypes()), _ibo(RendEnum::numIBOTypes())
+VAO::VAO(bool gpuGeometry): _vao(-1), _vbo(RendEnum::numVBOTypes()), _ibo(RendEnum::numIBOTypes()), _iboOffset(RendEnum::numIBOTypes(), 0), _sharedIBO(RendEnum::numIBOTypes(), false), _sharedVBO(false)
 {
 	// [VAO]
 	glGenVertexArrays(1, &_vao);
@@ -29,6 +31,10 @@ VAO::VAO(bool gpuGeometry): _vao(-1), _vbo(RendEnum::numVBOTypes()), _ibo(RendEn
 
 VAO::~VAO()
 {
+	// Buffers owned by other VAOs are skipped, as zero names are ignored
+	if (_sharedVBO) _vbo[RendEnum::VBO_POSITION] = 0;
+	for (unsigned iboType = 0; iboType < _ibo.size(); ++iboType) if (_sharedIBO[iboType]) _ibo[iboType] = 0;
+
 	glDeleteBuffers(RendEnum::numVBOTypes(), _vbo.data());
 	glDeleteBuffers(RendEnum::numIBOTypes(), _ibo.data());
 	glDeleteVertexArrays(1, &_vao);
@@ -39,7 +45,8 @@ void VAO::drawObject(const RendEnum::IBOTypes iboType, const GLuint openGLPrimit
 	glBindVertexArray(_vao);
 	{
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo[iboType]);
-		glDrawElements(openGLPrimitive, numIndices, GL_UNSIGNED_INT, nullptr);
+		ComputeShader::synchronizeDraw();
+		glDrawElements(openGLPrimitive, numIndices, GL_UNSIGNED_INT, (const void*)_iboOffset[iboType]);
 	}
 }
 
@@ -48,7 +55,8 @@ void VAO::drawObject(const RendEnum::IBOTypes iboType, const GLuint openGLPrimit
 	glBindVertexArray(_vao);
 	{
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo[iboType]);
-		glDrawElementsInstanced(openGLPrimitive, numIndices, GL_UNSIGNED_INT, nullptr, numObjects);
+		ComputeShader::synchronizeDraw();
+		glDrawElementsInstanced(openGLPrimitive, numIndices, GL_UNSIGNED_INT, (const void*)_iboOffset[iboType], numObjects);
 	}
 }
 
@@ -56,10 +64,36 @@ void VAO::drawObject(const GLuint openGLPrimitive, const GLuint numVertices, con
 {
 	glBindVertexArray(_vao);
 	{
+		ComputeShader::synchronizeDraw();
 		glDrawArraysInstanced(openGLPrimitive, 0, numVertices, numObjects);
 	}
 }
 
+void VAO::drawObjectIndirect(const RendEnum::IBOTypes iboType, const GLuint openGLPrimitive, const GLuint firstCommand, const GLuint numCommands)
+{
+	glBindVertexArray(_vao);
+	{
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo[iboType]);
+		ComputeShader::synchronizeDraw();
+		glMultiDrawElementsIndirect(openGLPrimitive, GL_UNSIGNED_INT, (const void*)(firstCommand * sizeof(IndirectCommand)), numCommands, 0);
+	}
+}
+
+void VAO::shareGeometry(const VAO* source, const GLint baseVertex, const RendEnum::IBOTypes iboType, const GLuint firstIndex)
+{
+	if (!_sharedVBO) glDeleteBuffers(1, &_vbo[RendEnum::VBO_POSITION]);
+	if (!_sharedIBO[iboType]) glDeleteBuffers(1, &_ibo[iboType]);
+
+	_vbo[RendEnum::VBO_POSITION] = source->_vbo[RendEnum::VBO_POSITION];
+	_ibo[iboType] = source->_ibo[iboType];
+	_iboOffset[iboType] = GLintptr(firstIndex) * sizeof(GLuint);
+	_sharedVBO = _sharedIBO[iboType] = true;
+
+	glBindVertexArray(_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo[RendEnum::VBO_POSITION]);
+	this->setGPUGeometryPointers(GLintptr(baseVertex) * sizeof(Model3D::VertexGPUData));
+}
+
 void VAO::setVBOData(const std::vector<Model3D::VertexGPUData>& geometryData, const GLuint changeFrequency)
 {
 	glBindVertexArray(_vao);
@@ -118,15 +152,20 @@ void VAO::declareInterleavedVBO(const RendEnum::VBOTypes vboType, const GLsizei
 
 void VAO::genGPUGeometryVBO()
 {
-	size_t accumSize = 0;
-	const size_t structSize = sizeof(Model3D::VertexGPUData);
-
 	// VBOs
 	glGenBuffers(1, &_vbo[0]);
 	glBindBuffer(GL_ARRAY_BUFFER, _vbo[RendEnum::VBO_POSITION]);
 
+	this->setGPUGeometryPointers(0);
+}
+
+void VAO::setGPUGeometryPointers(const GLintptr offset)
+{
+	size_t accumSize = offset;
+	const size_t structSize = sizeof(Model3D::VertexGPUData);
+
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, sizeof(vec3) / sizeof(GLfloat), GL_FLOAT, GL_FALSE, structSize, ((GLubyte*)nullptr));
+	glVertexAttribPointer(0, sizeof(vec3) / sizeof(GLfloat), GL_FLOAT, GL_FALSE, structSize, ((GLubyte*)nullptr + accumSize));
 	accumSize += sizeof(vec4);
 
 	// Normals
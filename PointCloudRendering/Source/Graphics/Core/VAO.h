@@ -14,11 +14,24 @@
 */
 class VAO
 {
+public:
+	struct IndirectCommand
+	{
+		GLuint		_count;							//!< Number of indices
+		GLuint		_instanceCount;					//!< Number of instances
+		GLuint		_firstIndex;					//!< Offset of the first index in the IBO
+		GLint		_baseVertex;					//!< Offset added to every index
+		GLuint		_baseInstance;					//!< First instance, which is also readable from shaders to identify the command
+	};
+
 protected:
 	// [VAO, VBO and IBO identifiers]
 	GLuint				_vao;								//!< Identifier of wrapper of VBOs and IBOs
 	std::vector<GLuint> _vbo;								//!< One per defined geometry
 	std::vector<GLuint> _ibo;								//!< One per defined topology
+	std::vector<GLintptr> _iboOffset;						//!< Offset (bytes) of the topology within its IBO, which is not zero if it is shared
+	std::vector<bool>	_sharedIBO;							//!< IBOs owned by another VAO, so they are not deleted with this one
+	bool				_sharedVBO;							//!< The geometry VBO is owned by another VAO
 
 	int					_vboIndex;							//!< Controls index of next VBO
 
@@ -47,6 +60,11 @@ protected:
 	*/
 	void genGPUGeometryVBO();
 
+	/**
+	*	@brief Points the attributes of VertexGPUData to the buffer bound to GL_ARRAY_BUFFER, starting at the given offset (bytes).
+	*/
+	void setGPUGeometryPointers(const GLintptr offset);
+
 public:
 	/**
 	*	@brief Default constructor. Does not book any space in GPU for any geometry / topology.
@@ -94,6 +112,31 @@ public:
 	*/
 	void drawObject(const GLuint openGLPrimitive, const GLuint numIndices, const GLuint numObjects);
 
+	/**
+	*	@brief Draws several ranges of a topology with a single call, as described by the commands of the buffer bound to GL_DRAW_INDIRECT_BUFFER.
+	*	@param firstCommand Index of the first command to be drawn.
+	*	@param numCommands Number of consecutive commands to be drawn.
+	*/
+	void drawObjectIndirect(const RendEnum::IBOTypes iboType, const GLuint openGLPrimitive, const GLuint firstCommand, const GLuint numCommands);
+
+	/**
+	*	@return Identifier of an IBO.
+	*/
+	GLuint getIBO(const RendEnum::IBOTypes iboType) const { return _ibo[iboType]; }
+
+	/**
+	*	@return Identifier of a VBO.
+	*/
+	GLuint getVBO(const RendEnum::VBOTypes vboType) const { return _vbo[vboType]; }
+
+	/**
+	*	@brief Replaces the VertexGPUData geometry and a topology with ranges of the buffers of another VAO, deleting those of this one. 
+	*	Both VAOs must have been created for GPU geometry. The source VAO must outlive this one, or share its buffers again.
+	*	@param baseVertex First vertex of this object within the source VBO, so that its indices remain local.
+	*	@param firstIndex First index of this object within the source IBO.
+	*/
+	void shareGeometry(const VAO* source, const GLint baseVertex, const RendEnum::IBOTypes iboType, const GLuint firstIndex);
+
 	/**
 	*	@brief Sets data in the VBO.
 	*	@param vboType VBO to be modified.
@@ -3,6 +3,11 @@
 
 #include "Graphics/Application/PointCloudParameters.h"
 #include "Graphics/Application/Renderer.h"
+#include "Graphics/Core/ComputeShader.h"
+#include "Graphics/Core/GPUBufferPool.h"
+#include "Graphics/Core/GPUUploadRing.h"
+#include "Graphics/Core/SSAOFBO.h"
+#include "Graphics/Core/ShaderCache.h"
 #include "Interface/Fonts/font_awesome.hpp"
 #include "Interface/Fonts/lato.hpp"
 #include "Interface/Fonts/IconsFontAwesome5.h"
@@ -12,7 +17,7 @@
 
 GUI::GUI() :
 	_pointCloudPath(""), _showRenderingSettings(false), _showScreenshotSettings(false), _showAboutUs(false),
-	_showControls(false), _showFileDialog(false), _showPointCloudDialog(false)
+	_showControls(false), _showFileDialog(false), _showPointCloudDialog(false), _bvhBuilder(Group3D::GPU_CLUSTER_MERGING), _benchmarkBVH(true), _bvhBenchmark{}, _bvhBenchmarked(false)
 {
 	_renderer			= Renderer::getInstance();	
 	_renderingParams	= Renderer::getInstance()->getRenderingParameters();
@@ -29,6 +34,7 @@ void GUI::createMenu()
 	if (_showControls)				showControls();
 	if (_showFileDialog)			showFileDialog();
 	if (_showPointCloudDialog)		showPointCloudDialog();
+	if (_pointCloudScene->isLoadingPointCloud()) showLoadingProgress();
 
 	if (ImGui::BeginMainMenuBar())
 	{
@@ -118,7 +124,7 @@ void GUI::showControls()
 
 void GUI::showFileDialog()
 {
-	ImGuiFileDialog::Instance()->OpenDialog("Choose Point Cloud", "Choose File", ".ply", ".");
+	ImGuiFileDialog::Instance()->OpenDialog("Choose Point Cloud", "Choose File", "Point clouds (*.las *.ply *.pts *.txt *.xyz *.tiles){.las,.ply,.pts,.txt,.xyz,.tiles}", ".");
 
 	// display
 	if (ImGuiFileDialog::Instance()->Display("Choose Point Cloud"))
@@ -126,8 +132,7 @@ void GUI::showFileDialog()
 		// action if OK
 		if (ImGuiFileDialog::Instance()->IsOk())
 		{
-			std::string filePathName = ImGuiFileDialog::Instance()->GetFilePathName();
-			_pointCloudPath = filePathName.substr(0, filePathName.find_last_of("."));
+			_pointCloudPath = ImGuiFileDialog::Instance()->GetFilePathName();			// Extension is kept, as it determines the format
 			_showPointCloudDialog = true;
 		}
 
@@ -137,11 +142,29 @@ void GUI::showFileDialog()
 	}
 }
 
+void GUI::showLoadingProgress()
+{
+	if (ImGui::Begin("Loading Point Cloud", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		ImGui::Text("%s", _pointCloudPath.c_str());
+		ImGui::ProgressBar(_pointCloudScene->getLoadingProgress(), ImVec2(300.0f, .0f));
+
+		this->leaveSpace(1);
+
+		if (ImGui::Button("Cancel"))
+		{
+			_pointCloudScene->cancelPointCloudLoading();
+		}
+	}
+
+	ImGui::End();
+}
+
 void GUI::showPointCloudDialog()
 {
 	if (ImGui::Begin("Open Point Cloud Dialog", &_showPointCloudDialog))
 	{
-		GLuint minIterations = 1, maxIterations = 4;
+		GLuint minIterations = 1, maxIterations = 4, minPointBudget = 16, maxPointBudget = 2048;
 		
 		this->leaveSpace(1);
 
@@ -155,6 +178,14 @@ void GUI::showPointCloudDialog()
 		ImGui::SameLine(0, 80); ImGui::PushItemWidth(150.0f);
 		ImGui::SliderScalar("Iterations", ImGuiDataType_U16, &PointCloudParameters::_reduceIterations, &minIterations, &maxIterations);
 		ImGui::Checkbox("Update camera", &_renderingParams->_updateCamera);
+		ImGui::Checkbox("Compressed cache", &PointCloudParameters::_compressBinaryCache);
+		ImGui::SameLine(0, 10); this->renderHelpMarker("Caches are quantized and sorted along the Morton curve, so points are not restored exactly as they were read");
+		ImGui::Checkbox("GPU-resident", &PointCloudParameters::_gpuResident);
+		ImGui::SameLine(0, 10); this->renderHelpMarker("Points are released from main memory once uploaded, and read again from the cache when needed");
+		ImGui::SliderFloat("Upload budget (ms)", &PointCloudParameters::_uploadBudget, 1.0f, 33.0f);
+		ImGui::SameLine(0, 10); this->renderHelpMarker("Time per frame spent uploading points while the point cloud is being read");
+		ImGui::SliderScalar("Dataset budget (M points)", ImGuiDataType_U32, &PointCloudParameters::_datasetPointBudget, &minPointBudget, &maxPointBudget);
+		ImGui::SameLine(0, 10); this->renderHelpMarker("Points of dataset tiles kept in GPU. Tiles outside the view are evicted beyond it, farthest first");
 		ImGui::PopItemWidth();
 
 		ImGui::PushID(0);
@@ -210,6 +241,37 @@ void GUI::showRenderingSettings()
 					ImGui::SameLine(30, 0);
 					ImGui::Checkbox("Screen Space Ambient Occlusion", &_renderingParams->_ambientOcclusion);
 
+					const char* ssaoQualityTitles[] = { "Low (1/4)", "Medium (1/2)", "High" };
+					ImGui::NewLine();
+					ImGui::SameLine(30, 0);
+					ImGui::PushItemWidth(200.0f);
+					ImGui::Combo("SSAO quality", &_renderingParams->_ssaoQuality, ssaoQualityTitles, IM_ARRAYSIZE(ssaoQualityTitles));
+					ImGui::PopItemWidth();
+
+					ImGui::NewLine();
+					ImGui::SameLine(30, 0);
+					ImGui::Text("SSAO time (ms) - Low: %.3f, Medium: %.3f, High: %.3f", SSAOFBO::getSSAOTime(CGAppEnum::SSAO_LOW), SSAOFBO::getSSAOTime(CGAppEnum::SSAO_MEDIUM), SSAOFBO::getSSAOTime(CGAppEnum::SSAO_HIGH));
+
+					ImGui::NewLine();
+					ImGui::SameLine(30, 0);
+					ImGui::PushItemWidth(200.0f);
+					ImGui::SliderInt("Shadow tiles per frame (0: all)", &_renderingParams->_shadowTilesPerFrame, 0, 16);
+					ImGui::PopItemWidth();
+
+					ImGui::NewLine();
+					ImGui::SameLine(30, 0);
+					ImGui::Checkbox("Multi-draw indirect", &_renderingParams->_multiDrawIndirect);
+
+					ImGui::NewLine();
+					ImGui::SameLine(30, 0);
+					ImGui::Checkbox("GPU frustum culling", &_renderingParams->_gpuCulling);
+
+					ImGui::SameLine(0, 20);
+					ImGui::Checkbox("Hi-Z occlusion culling", &_renderingParams->_occlusionCulling);
+
+					ImGui::SameLine(0, 20);
+					ImGui::Checkbox("Meshlet back-face culling", &_renderingParams->_meshletConeCulling);
+
 					const char* visualizationTitles[] = { "Points", "Lines", "Triangles", "All" };
 					ImGui::NewLine();
 					ImGui::SameLine(30, 0);
@@ -226,6 +288,89 @@ void GUI::showRenderingSettings()
 			{
 				this->leaveSpace(1);
 
+				const GPUBufferPool::Statistics& poolStatistics = GPUBufferPool::getInstance()->getStatistics();
+				const float megabyte = 1024.0f * 1024.0f;
+
+				ImGui::Separator();
+				ImGui::Text(ICON_FA_MEMORY "GPU buffer pool");
+
+				ImGui::Text("Live: %.1f MB (%u buffers)", poolStatistics._liveBytes / megabyte, poolStatistics._numLiveBuffers);
+				ImGui::Text("Peak: %.1f MB", poolStatistics._peakLiveBytes / megabyte);
+				ImGui::Text("Idle: %.1f MB (%u buffers)", poolStatistics._idleBytes / megabyte, poolStatistics._numIdleBuffers);
+				ImGui::Text("Allocations: %u, reuses: %u", poolStatistics._numAllocations, poolStatistics._numReuses);
+
+				if (ImGui::Button("Release idle buffers")) GPUBufferPool::getInstance()->trim();
+				ImGui::SameLine(0, 10);
+				if (ImGui::Button("Reset peak")) GPUBufferPool::getInstance()->resetPeak();
+
+				const GPUUploadRing::Statistics& uploadStatistics = GPUUploadRing::getInstance()->getStatistics();
+
+				this->leaveSpace(1);
+				ImGui::Text("Streamed uploads: %.1f MB", uploadStatistics._uploadedBytes / megabyte);
+				ImGui::Text("Ring wraps: %u, stalls: %u, deferrals: %u", uploadStatistics._numWraps, uploadStatistics._numStalls, uploadStatistics._numDeferrals);
+				ImGui::Text("Uploads larger than a segment: %u", uploadStatistics._numTransientUploads);
+
+				const ComputeShader::BarrierStatistics& barrierStatistics = ComputeShader::getBarrierStatistics();
+				bool hazardTracking = ComputeShader::isHazardTrackingEnabled();
+
+				this->leaveSpace(1);
+				ImGui::Separator();
+				ImGui::Text(ICON_FA_MEMORY "Memory barriers");
+
+				if (ImGui::Checkbox("Hazard tracking", &hazardTracking)) ComputeShader::setHazardTracking(hazardTracking);
+				ImGui::Text("Dispatches: %zu", barrierStatistics._numDispatches);
+				ImGui::Text("Barriers: %zu, skipped: %zu", barrierStatistics._numBarriers, barrierStatistics._numSkippedBarriers);
+				ImGui::Text("Barriers before draw calls: %zu", barrierStatistics._numDrawBarriers);
+
+				if (ImGui::Button("Reset counters")) ComputeShader::resetBarrierStatistics();
+
+				ShaderCache* shaderCache = ShaderCache::getInstance();
+				const ShaderCache::Statistics& cacheStatistics = shaderCache->getStatistics();
+				bool shaderCacheEnabled = shaderCache->isEnabled();
+
+				this->leaveSpace(1);
+				ImGui::Separator();
+				ImGui::Text(ICON_FA_MEMORY "Shader binary cache");
+
+				if (ImGui::Checkbox("Enabled", &shaderCacheEnabled)) shaderCache->setEnabled(shaderCacheEnabled);
+				ImGui::Text("Hits: %u, misses: %u", cacheStatistics._numHits, cacheStatistics._numMisses);
+				ImGui::Text("Rejected: %u, stored: %u", cacheStatistics._numRejected, cacheStatistics._numStored);
+
+				if (ImGui::Button("Clear cache")) shaderCache->clear();
+
+				Group3D* sceneGroup = _renderer->getCurrentScene()->getRenderingGroup();
+
+				this->leaveSpace(1);
+				ImGui::Separator();
+				ImGui::Text(ICON_FA_MEMORY "Scene BVH");
+
+				// Component meshes are released once the tree is built, so it can only be built once
+				if (!sceneGroup->hasBVH())
+				{
+					const char* bvhBuilderTitles[] = { "GPU cluster merging", "CPU binned SAH" };
+					ImGui::PushItemWidth(200.0f);
+					ImGui::Combo("Builder", &_bvhBuilder, bvhBuilderTitles, IM_ARRAYSIZE(bvhBuilderTitles));
+					ImGui::PopItemWidth();
+
+					ImGui::Checkbox("Compare both builders", &_benchmarkBVH);
+
+					if (ImGui::Button("Build BVH"))
+					{
+						_bvhBenchmarked = sceneGroup->generateBVH(true, Group3D::BVHBuilder(_bvhBuilder), _benchmarkBVH ? &_bvhBenchmark : nullptr) && _benchmarkBVH;
+					}
+				}
+				else
+				{
+					ImGui::Text("Built: %u nodes", sceneGroup->getNumClusters());
+				}
+
+				if (_bvhBenchmarked)
+				{
+					ImGui::Text("Faces: %u", _bvhBenchmark._numFaces);
+					ImGui::Text("Cluster merging (GPU): %lld ms, SAH cost: %.2f", _bvhBenchmark._clusterMergingTime, _bvhBenchmark._clusterMergingCost);
+					ImGui::Text("Binned SAH (CPU): %lld ms, SAH cost: %.2f", _bvhBenchmark._sahTime, _bvhBenchmark._sahCost);
+				}
+
 				this->leaveSpace(1);
 
 				ImGui::EndTabItem();
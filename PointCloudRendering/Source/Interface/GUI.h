@@ -37,6 +37,12 @@ protected:
 	bool							_showRenderingSettings;				//!< Displays a window which allows the user to modify the rendering parameters
 	bool							_showScreenshotSettings;			//!< Shows a window which allows to take an screenshot at any size
 
+	// BVH
+	int								_bvhBuilder;						//!< Builder of the scene BVH (Group3D::BVHBuilder)
+	bool							_benchmarkBVH;						//!< Both builders are run and compared when the BVH is built
+	Group3D::BVHBenchmark			_bvhBenchmark;						//!< Results of the last comparison
+	bool							_bvhBenchmarked;					//!< The comparison has been run
+
 protected:
 	/**
 	*	@brief Constructor of GUI context provided by a graphics library (Dear ImGui).
@@ -83,6 +89,11 @@ protected:
 	*/
 	void showFileDialog();
 
+	/**
+	*	@brief Shows the progress of the point cloud which is being loaded, allowing the user to cancel it.
+	*/
+	void showLoadingProgress();
+
 	/**
 	*	@brief  
 	*/
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+
+/**
+*	@file BackgroundTask.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Job executed in a separate thread whose progress can be tracked and which can be cancelled. The job receives 
+*	the task itself, so that it can report its progress and check whether it must stop.
+*/
+class BackgroundTask
+{
+protected:
+	std::string						_description;					//!< Text to be shown while the task is running
+	std::atomic<float>				_progress;						//!< Progress in [0, 1]
+	std::atomic<bool>				_cancelled;						//!< The job is asked to stop as soon as possible
+	std::shared_future<bool>		_result;						//!< Result of the job: false if it failed or was cancelled
+
+public:
+	/**
+	*	@brief Constructor. The job is launched right away.
+	*	@param job Function to be executed, returning its success.
+	*/
+	BackgroundTask(const std::string& description, const std::function<bool(BackgroundTask&)>& job);
+
+	/**
+	*	@brief Deleted copy constructor, as the job keeps a reference to this task.
+	*/
+	BackgroundTask(const BackgroundTask& task) = delete;
+
+	/**
+	*	@brief Destructor. Cancels the job and waits for it, as it refers to this task.
+	*/
+	virtual ~BackgroundTask();
+
+	/**
+	*	@brief Deleted assignment operator.
+	*/
+	BackgroundTask& operator=(const BackgroundTask& task) = delete;
+
+	/**
+	*	@brief Asks the job to stop. The job is responsible of checking isCancelled() periodically.
+	*/
+	void cancel() { _cancelled = true; }
+
+	/**
+	*	@return Text describing the task.
+	*/
+	const std::string& getDescription() const { return _description; }
+
+	/**
+	*	@return Future which is ready once the job finishes.
+	*/
+	std::shared_future<bool> getFuture() const { return _result; }
+
+	/**
+	*	@return Progress in [0, 1].
+	*/
+	float getProgress() const { return _progress; }
+
+	/**
+	*	@return True if the job was asked to stop.
+	*/
+	bool isCancelled() const { return _cancelled; }
+
+	/**
+	*	@return True if the job already finished.
+	*/
+	bool isFinished() const { return _result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+	/**
+	*	@brief Updates the progress of the job. Meant to be called from the job.
+	*/
+	void setProgress(const float progress) { _progress = progress; }
+
+	/**
+	*	@brief Waits for the job to finish.
+	*	@return Result of the job.
+	*/
+	bool wait() const { return _result.get(); }
+};
+
+inline BackgroundTask::BackgroundTask(const std::string& description, const std::function<bool(BackgroundTask&)>& job) :
+	_description(description), _progress(.0f), _cancelled(false)
+{
+	_result = std::async(std::launch::async, [this, job]() 
+		{
+			bool success = false;
+
+			try
+			{
+				success = job(*this);
+			}
+			catch (const std::exception& exception)
+			{
+				std::cerr << _description << " failed: " << exception.what() << std::endl;
+			}
+
+			if (success) _progress = 1.0f;
+
+			return success;
+		}).share();
+}
+
+inline BackgroundTask::~BackgroundTask()
+{
+	this->cancel();
+	if (_result.valid()) _result.wait();
+}
+
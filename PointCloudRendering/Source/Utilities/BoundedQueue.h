@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+*	@file BoundedQueue.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Thread-safe FIFO queue with a maximum capacity. Producers are blocked while the queue is full, 
+*	whereas consumers never wait, so that it can be drained from the render loop.
+*/
+template<typename T>
+class BoundedQueue
+{
+protected:
+	std::deque<T>				_items;						//!< Queued items
+	size_t						_capacity;					//!< Maximum number of queued items
+	bool						_closed;					//!< Closed queues do not accept new items
+	std::mutex					_mutex;						//!< Protects every member
+	std::condition_variable		_notFull;					//!< Wakes up producers once an item is popped or the queue is closed
+
+public:
+	/**
+	*	@brief Constructor.
+	*	@param capacity Maximum number of items that can be queued at the same time.
+	*/
+	BoundedQueue(const size_t capacity);
+
+	/**
+	*	@brief Rejects any further item and wakes up blocked producers.
+	*/
+	void close();
+
+	/**
+	*	@return True if there is no queued item.
+	*/
+	bool empty();
+
+	/**
+	*	@brief Appends an item, waiting while the queue is full.
+	*	@return False if the queue was closed, so that the producer can stop.
+	*/
+	bool push(const T& item);
+
+	/**
+	*	@brief Retrieves the first item without waiting.
+	*	@return False if the queue is empty.
+	*/
+	bool tryPop(T& item);
+};
+
+template<typename T>
+inline BoundedQueue<T>::BoundedQueue(const size_t capacity) : _capacity(std::max(capacity, size_t(1))), _closed(false)
+{
+}
+
+template<typename T>
+inline void BoundedQueue<T>::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_closed = true;
+	}
+
+	_notFull.notify_all();
+}
+
+template<typename T>
+inline bool BoundedQueue<T>::empty()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _items.empty();
+}
+
+template<typename T>
+inline bool BoundedQueue<T>::push(const T& item)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_notFull.wait(lock, [this]() { return _closed || _items.size() < _capacity; });
+
+	if (_closed) return false;
+
+	_items.push_back(item);
+
+	return true;
+}
+
+template<typename T>
+inline bool BoundedQueue<T>::tryPop(T& item)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_items.empty()) return false;
+
+		item = _items.front();
+		_items.pop_front();
+	}
+
+	_notFull.notify_one();
+
+	return true;
+}
+
@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include "MemoryMappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// [Public methods]
+
+MemoryMappedFile::MemoryMappedFile() :
+	_data(nullptr), _size(0),
+#ifdef _WIN32
+	_fileHandle(INVALID_HANDLE_VALUE), _mappingHandle(nullptr)
+#else
+	_fileDescriptor(-1)
+#endif
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	this->close();
+}
+
+void MemoryMappedFile::close()
+{
+#ifdef _WIN32
+	if (_data) UnmapViewOfFile(_data);
+	if (_mappingHandle) CloseHandle(_mappingHandle);
+	if (_fileHandle != INVALID_HANDLE_VALUE) CloseHandle(_fileHandle);
+
+	_fileHandle = INVALID_HANDLE_VALUE;
+	_mappingHandle = nullptr;
+#else
+	if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+	if (_fileDescriptor >= 0) ::close(_fileDescriptor);
+
+	_fileDescriptor = -1;
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+bool MemoryMappedFile::open(const std::string& filename, const bool sequential)
+{
+	this->close();
+
+#ifdef _WIN32
+	const DWORD flags = sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+	_fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | flags, nullptr);
+	if (_fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		this->close();
+		return false;
+	}
+
+	_mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!_mappingHandle)
+	{
+		this->close();
+		return false;
+	}
+
+	_data = static_cast<const uint8_t*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	_size = size_t(fileSize.QuadPart);
+#else
+	_fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+	if (_fileDescriptor < 0) return false;
+
+	struct stat fileStats;
+	if (fstat(_fileDescriptor, &fileStats) != 0 || fileStats.st_size == 0)
+	{
+		this->close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, size_t(fileStats.st_size), PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+	if (data == MAP_FAILED)
+	{
+		this->close();
+		return false;
+	}
+
+	madvise(data, size_t(fileStats.st_size), sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+	_data = static_cast<const uint8_t*>(data);
+	_size = size_t(fileStats.st_size);
+#endif
+
+	if (!_data)
+	{
+		this->close();
+		return false;
+	}
+
+	return true;
+}
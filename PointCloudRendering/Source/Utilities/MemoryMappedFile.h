@@ -0,0 +1,73 @@
+#pragma once
+
+/**
+*	@file MemoryMappedFile.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Read-only view of a whole file mapped into the address space of the process.
+*/
+class MemoryMappedFile
+{
+protected:
+	const uint8_t*	_data;							//!< First byte of the mapped view, nullptr if no file is opened
+	size_t			_size;							//!< Size of the mapped file (bytes)
+
+#ifdef _WIN32
+	void*			_fileHandle;					//!< Handle to the file
+	void*			_mappingHandle;					//!< Handle to the file mapping object
+#else
+	int				_fileDescriptor;				//!< Descriptor of the opened file
+#endif
+
+public:
+	/**
+	*	@brief Constructor. No file is mapped until open() is called.
+	*/
+	MemoryMappedFile();
+
+	/**
+	*	@brief Deleted copy constructor, as the mapping is owned by a single instance.
+	*/
+	MemoryMappedFile(const MemoryMappedFile& file) = delete;
+
+	/**
+	*	@brief Destructor. Unmaps the file if it is still opened.
+	*/
+	virtual ~MemoryMappedFile();
+
+	/**
+	*	@brief Deleted assignment operator.
+	*/
+	MemoryMappedFile& operator=(const MemoryMappedFile& file) = delete;
+
+	/**
+	*	@brief Releases the mapped view and the handles to the file.
+	*/
+	void close();
+
+	/**
+	*	@return Pointer to the first byte of the file.
+	*/
+	const uint8_t* data() const { return _data; }
+
+	/**
+	*	@return True if a file is currently mapped.
+	*/
+	bool isOpen() const { return _data != nullptr; }
+
+	/**
+	*	@brief Maps the whole file as read-only memory. Pages are loaded on demand by the operating system.
+	*	@param sequential Hints the operating system that the file will be mostly read front to back.
+	*	@return True if the file could be mapped.
+	*/
+	bool open(const std::string& filename, const bool sequential = true);
+
+	/**
+	*	@return Size of the mapped file in bytes.
+	*/
+	size_t size() const { return _size; }
+};
+
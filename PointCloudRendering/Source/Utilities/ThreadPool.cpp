@@ -0,0 +1,153 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+
+// [Static variables initialization]
+
+thread_local ThreadPool* ThreadPool::_currentPool = nullptr;
+thread_local unsigned ThreadPool::_currentQueue = 0;
+
+/// [Public methods]
+
+ThreadPool::ThreadPool(const unsigned numThreads) :
+	_numQueuedTasks(0), _nextQueue(0), _stop(false)
+{
+	const unsigned numWorkers = numThreads ? numThreads : std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned queueIdx = 0; queueIdx < numWorkers; ++queueIdx)
+	{
+		_queue.push_back(std::unique_ptr<TaskQueue>(new TaskQueue));
+	}
+
+	for (unsigned queueIdx = 0; queueIdx < numWorkers; ++queueIdx)
+	{
+		_worker.push_back(std::thread(&ThreadPool::work, this, queueIdx));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_stop = true;
+	}
+
+	_wakeUp.notify_all();
+
+	for (std::thread& worker : _worker)
+	{
+		worker.join();
+	}
+}
+
+/// [Protected methods]
+
+void ThreadPool::push(const std::function<void()>& task)
+{
+	const unsigned queueIdx = _currentPool == this ? _currentQueue : _nextQueue++ % _queue.size();
+
+	// Counted before it is published, so that the thread which picks it never takes the counter below zero
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		++_numQueuedTasks;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_queue[queueIdx]->_mutex);
+		_queue[queueIdx]->_task.push_back(task);
+	}
+
+	_wakeUp.notify_one();
+}
+
+bool ThreadPool::tryRunTask()
+{
+	const bool isWorker = _currentPool == this;
+	const unsigned firstQueue = isWorker ? _currentQueue : 0;
+	std::function<void()> task;
+
+	for (unsigned queueOffset = 0; queueOffset < _queue.size() && !task; ++queueOffset)
+	{
+		TaskQueue* queue = _queue[(firstQueue + queueOffset) % _queue.size()].get();
+		std::lock_guard<std::mutex> lock(queue->_mutex);
+
+		if (queue->_task.empty()) continue;
+
+		// Own tasks are the most recent ones, whose data is still in cache, whereas stolen tasks are the oldest, i.e. the largest ones
+		if (isWorker && !queueOffset)
+		{
+			task = std::move(queue->_task.back());
+			queue->_task.pop_back();
+		}
+		else
+		{
+			task = std::move(queue->_task.front());
+			queue->_task.pop_front();
+		}
+	}
+
+	if (!task) return false;
+
+	--_numQueuedTasks;
+	task();
+
+	return true;
+}
+
+void ThreadPool::work(const unsigned queueIdx)
+{
+	_currentPool = this;
+	_currentQueue = queueIdx;
+
+	while (true)
+	{
+		if (this->tryRunTask()) continue;
+
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		_wakeUp.wait(lock, [this]() { return _stop || _numQueuedTasks > 0; });
+
+		if (_stop && !_numQueuedTasks) return;
+	}
+}
+
+/// [TaskGroup]
+
+ThreadPool::TaskGroup::TaskGroup(ThreadPool* pool) : _pool(pool), _numPendingTasks(0)
+{
+}
+
+ThreadPool::TaskGroup::~TaskGroup()
+{
+	this->wait();
+}
+
+void ThreadPool::TaskGroup::run(const std::function<void()>& task)
+{
+	ThreadPool* pool = _pool;
+	std::atomic<size_t>* numPendingTasks = &_numPendingTasks;
+
+	++_numPendingTasks;
+
+	// The group may be destroyed as soon as its last task is finished, so only the pool is accessed afterwards
+	pool->push([pool, numPendingTasks, task]()
+		{
+			task();
+
+			if (--*numPendingTasks == 0)
+			{
+				std::lock_guard<std::mutex> lock(pool->_sleepMutex);
+				pool->_wakeUp.notify_all();
+			}
+		});
+}
+
+void ThreadPool::TaskGroup::wait()
+{
+	while (_numPendingTasks > 0)
+	{
+		if (_pool->tryRunTask()) continue;
+
+		// Remaining tasks are being run by other threads, so this one sleeps until they finish or another task is queued
+		std::unique_lock<std::mutex> lock(_pool->_sleepMutex);
+		_pool->_wakeUp.wait(lock, [this]() { return _numPendingTasks == 0 || _pool->_numQueuedTasks > 0; });
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+*	@file ThreadPool.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 19/10/2026
+*/
+
+/**
+*	@brief Fixed set of worker threads with a task queue each. Workers run their own tasks in LIFO order and steal from the front 
+*	of other queues once theirs is empty, so that recursive jobs keep their data local while the pool stays balanced.
+*/
+class ThreadPool
+{
+public:
+	/**
+	*	@brief Set of tasks which can be waited for. Waiting threads run pending tasks meanwhile, so that tasks can spawn and wait 
+	*	for other tasks without blocking the workers, and sleep once there is nothing left to run.
+	*/
+	class TaskGroup
+	{
+	protected:
+		ThreadPool*						_pool;						//!< Pool where tasks are executed
+		std::atomic<size_t>				_numPendingTasks;			//!< Tasks of the group not finished yet
+
+	public:
+		/**
+		*	@brief Constructor.
+		*/
+		TaskGroup(ThreadPool* pool);
+
+		/**
+		*	@brief Destructor. Waits for the pending tasks, as they may refer to this group.
+		*/
+		virtual ~TaskGroup();
+
+		/**
+		*	@brief Queues a new task.
+		*/
+		void run(const std::function<void()>& task);
+
+		/**
+		*	@brief Runs queued tasks until every task of this group is finished, sleeping while the last ones are run by other threads.
+		*/
+		void wait();
+	};
+
+protected:
+	struct TaskQueue
+	{
+		std::deque<std::function<void()>>	_task;					//!< Pending tasks
+		std::mutex							_mutex;					//!< Protects the tasks
+	};
+
+protected:
+	static thread_local ThreadPool*		_currentPool;				//!< Pool of the calling worker, nullptr if it is not a worker
+	static thread_local unsigned		_currentQueue;				//!< Queue of the calling worker
+
+protected:
+	std::vector<std::unique_ptr<TaskQueue>>	_queue;					//!< Queue per worker
+	std::vector<std::thread>			_worker;					//!< Worker threads
+	std::atomic<size_t>					_numQueuedTasks;			//!< Tasks not picked by any thread yet
+	std::atomic<unsigned>				_nextQueue;					//!< Queue for tasks submitted from threads out of the pool
+	bool								_stop;						//!< Workers finish once there is no queued task
+	std::mutex							_sleepMutex;				//!< Protects the sleeping condition of workers
+	std::condition_variable				_wakeUp;					//!< Wakes up workers and waiting threads once a task is queued, a group is finished or the pool is destroyed
+
+protected:
+	/**
+	*	@brief Queues a task in the queue of the calling worker, or distributes it if submitted from another thread.
+	*/
+	void push(const std::function<void()>& task);
+
+	/**
+	*	@brief Runs a task from the queue of the calling thread or, if it is empty, from another queue.
+	*	@return False if there was no queued task.
+	*/
+	bool tryRunTask();
+
+	/**
+	*	@brief Main loop of a worker.
+	*/
+	void work(const unsigned queueIdx);
+
+public:
+	/**
+	*	@brief Constructor. Workers are launched right away.
+	*	@param numThreads Number of workers, as many as hardware threads if zero.
+	*/
+	ThreadPool(const unsigned numThreads = 0);
+
+	/**
+	*	@brief Deleted copy constructor, as workers refer to this pool.
+	*/
+	ThreadPool(const ThreadPool& pool) = delete;
+
+	/**
+	*	@brief Destructor. Queued tasks are finished before workers are joined.
+	*/
+	virtual ~ThreadPool();
+
+	/**
+	*	@brief Deleted assignment operator.
+	*/
+	ThreadPool& operator=(const ThreadPool& pool) = delete;
+
+	/**
+	*	@return Number of workers.
+	*/
+	unsigned getNumThreads() const { return unsigned(_worker.size()); }
+};
+